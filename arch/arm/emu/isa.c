@@ -30,8 +30,10 @@
 
 
 /* Debug categories */
+#ifndef NO_HOT_DEBUG
 int arm_isa_call_debug_category;
 int arm_isa_inst_debug_category;
+#endif
 
 
 /* Table including references to functions in machine.c
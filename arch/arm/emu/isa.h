@@ -24,8 +24,13 @@
 #define arm_isa_call_debug(...) debug(arm_isa_call_debug_category, __VA_ARGS__)
 #define arm_isa_inst_debug(...) debug(arm_isa_inst_debug_category, __VA_ARGS__)
 
+#ifdef NO_HOT_DEBUG
+#define arm_isa_call_debug_category 0
+#define arm_isa_inst_debug_category 0
+#else
 extern int arm_isa_call_debug_category;
 extern int arm_isa_inst_debug_category;
+#endif
 
 enum arm_isa_op2_cat_t
 {
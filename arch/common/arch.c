@@ -19,6 +19,7 @@
 
 
 #include <lib/esim/esim.h>
+#include <lib/esim/stats.h>
 #include <lib/mhandle/mhandle.h>
 #include <lib/util/debug.h>
 #include <lib/util/linked-list.h>
@@ -154,6 +155,10 @@ void arch_set_emu(struct arch_t *arch, Emu *emu)
 	arch->emu = emu;
 	if (emu)
 		emu->arch = arch;
+
+	/* Instructions are sampled together with cycles */
+	if (emu && arch->sim_kind == arch_sim_kind_detailed)
+		stats_register(&emu->instructions, "%s.inst", arch->prefix);
 }
 
 
@@ -161,7 +166,10 @@ void arch_set_timing(struct arch_t *arch, Timing *timing)
 {
 	arch->timing = timing;
 	if (timing)
+	{
 		timing->arch = arch;
+		stats_register(&timing->cycle, "%s.cycle", arch->prefix);
+	}
 }
 
 
@@ -46,7 +46,9 @@ struct repos_t *evg_isa_write_task_repos;
 evg_isa_inst_func_t *evg_isa_inst_func;
 
 /* Debug */
+#ifndef NO_HOT_DEBUG
 int evg_isa_debug_category;
+#endif
 
 
 
@@ -80,7 +80,11 @@ void evg_isa_write_task_commit(struct evg_work_item_t *work_item);
 /* Debugging */
 #define evg_isa_debugging() debug_status(evg_isa_debug_category)
 #define evg_isa_debug(...) debug(evg_isa_debug_category, __VA_ARGS__)
+#ifdef NO_HOT_DEBUG
+#define evg_isa_debug_category 0
+#else
 extern int evg_isa_debug_category;
+#endif
 
 
 /* Macros for unsupported parameters */
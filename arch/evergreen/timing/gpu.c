@@ -23,6 +23,7 @@
 #include <driver/opencl-old/evergreen/bin-file.h>
 #include <driver/opencl-old/evergreen/kernel.h>
 #include <lib/esim/esim.h>
+#include <lib/esim/stats.h>
 #include <lib/esim/trace.h>
 #include <lib/mhandle/mhandle.h>
 #include <lib/util/config.h>
@@ -639,6 +640,7 @@ void EvgGpuCreate(EvgGpu *self)
 		compute_unit = self->compute_units[compute_unit_id];
 		compute_unit->id = compute_unit_id;
 		DOUBLE_LINKED_LIST_INSERT_TAIL(self, ready, compute_unit);
+		stats_register(&compute_unit->inst_count, "evg.cu%d.inst", compute_unit_id);
 	}
 
 	/* Virtual functions */
@@ -87,6 +87,11 @@ struct frm_grid_t
 	void *inst_buffer;
 	unsigned int inst_buffer_size;
 
+	/* Kernel instructions decoded once at grid creation, indexed by
+	 * PC / 8 and shared by all warps */
+	struct frm_inst_t *insts;
+	int inst_count;
+
 	/* Local memory top to assign to local arguments.
 	 * Initially it is equal to the size of local variables in 
 	 * kernel function. */
@@ -33,7 +33,9 @@
 frm_isa_inst_func_t *frm_isa_inst_func;
 
 /* Debug */
+#ifndef NO_HOT_DEBUG
 int frm_isa_debug_category = 1;
+#endif
 
 
 /*
@@ -49,7 +49,11 @@ extern struct frm_inst_t *frm_isa_inst;
 /* Debugging */
 #define frm_isa_debugging() debug_status(frm_isa_debug_category)
 #define frm_isa_debug(...) debug(frm_isa_debug_category, __VA_ARGS__)
+#ifdef NO_HOT_DEBUG
+#define frm_isa_debug_category 0
+#else
 extern int frm_isa_debug_category;
+#endif
 
 
 /* Macros for unsupported parameters */
@@ -22,6 +22,7 @@
 #include <arch/fermi/emu/grid.h>
 #include <arch/fermi/emu/thread-block.h>
 #include <lib/esim/esim.h>
+#include <lib/esim/stats.h>
 #include <lib/esim/trace.h>
 #include <lib/mhandle/mhandle.h>
 #include <lib/util/config.h>
@@ -1073,6 +1074,7 @@ void FrmGpuCreate(FrmGpu *self)
 		sm = self->sms[sm_id];
 		sm->id = sm_id;
 		list_add(self->sm_ready_list, sm);
+		stats_register(&sm->inst_count, "frm.sm%d.inst", sm_id);
 	}
 
 	/* Virtual functions */
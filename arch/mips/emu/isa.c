@@ -26,8 +26,10 @@
 
 
 /* Debug categories */
+#ifndef NO_HOT_DEBUG
 int mips_isa_call_debug_category;
 int mips_isa_inst_debug_category;
+#endif
 
 /*
  * Instruction statistics
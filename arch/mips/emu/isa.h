@@ -26,8 +26,13 @@
 #define mips_isa_call_debug(...) debug(mips_isa_call_debug_category, __VA_ARGS__)
 #define mips_isa_inst_debug(...) debug(mips_isa_inst_debug_category, __VA_ARGS__)
 
+#ifdef NO_HOT_DEBUG
+#define mips_isa_call_debug_category 0
+#define mips_isa_inst_debug_category 0
+#else
 extern int mips_isa_call_debug_category;
 extern int mips_isa_inst_debug_category;
+#endif
 
 void mips_isa_syscall(struct mips_ctx_t *ctx);
 
@@ -18,6 +18,9 @@
  */
 
 
+#include <assert.h>
+#include <pthread.h>
+
 #include <driver/opencl/opencl.h>
 #include <lib/mhandle/mhandle.h>
 #include <lib/util/debug.h>
@@ -34,6 +37,162 @@
 #include "work-group.h"
 
 
+/*
+ * Private Functions
+ */
+
+/* Shared state of the host threads running a batch of work-groups. Threads
+ * take work-groups from array 'work_groups' in order, using 'next' as an
+ * index protected by 'lock'. */
+struct si_emu_worker_t
+{
+	struct si_work_group_t **work_groups;
+	int work_group_count;
+	int next;
+	pthread_mutex_t lock;
+};
+
+
+/* Execute a work-group to completion */
+static void si_emu_work_group_run(struct si_work_group_t *work_group)
+{
+	struct si_wavefront_t *wavefront;
+	int wavefront_id;
+
+	while (!work_group->finished_emu)
+	{
+		SI_FOREACH_WAVEFRONT_IN_WORK_GROUP(work_group, wavefront_id)
+		{
+			wavefront = work_group->wavefronts[wavefront_id];
+
+			if (wavefront->finished || wavefront->at_barrier)
+				continue;
+
+			/* Execute instruction in wavefront */
+			si_wavefront_execute(wavefront);
+		}
+	}
+}
+
+
+static void *si_emu_worker(void *data)
+{
+	struct si_emu_worker_t *worker = data;
+	int index;
+
+	for (;;)
+	{
+		/* Take next work-group */
+		pthread_mutex_lock(&worker->lock);
+		index = worker->next++;
+		pthread_mutex_unlock(&worker->lock);
+		if (index >= worker->work_group_count)
+			break;
+
+		/* Run it */
+		si_emu_work_group_run(worker->work_groups[index]);
+	}
+
+	return NULL;
+}
+
+
+/* Add the wavefront counters of a work-group run by a host thread to the
+ * emulator statistics. */
+static void si_emu_add_work_group_stats(SIEmu *self,
+	struct si_work_group_t *work_group)
+{
+	struct si_wavefront_t *wavefront;
+	int wavefront_id;
+
+	SI_FOREACH_WAVEFRONT_IN_WORK_GROUP(work_group, wavefront_id)
+	{
+		wavefront = work_group->wavefronts[wavefront_id];
+		asEmu(self)->instructions += wavefront->emu_inst_count;
+		self->scalar_alu_inst_count += wavefront->scalar_alu_inst_count;
+		self->scalar_mem_inst_count += wavefront->scalar_mem_inst_count;
+		self->branch_inst_count += wavefront->branch_inst_count;
+		self->vector_alu_inst_count += wavefront->vector_alu_inst_count;
+		self->lds_inst_count += wavefront->lds_inst_count;
+		self->vector_mem_inst_count += wavefront->vector_mem_inst_count;
+		self->export_inst_count += wavefront->export_inst_count;
+	}
+}
+
+
+/* Run a batch of up to 'SI_EMU_WORK_GROUPS_PER_THREAD' work-groups per host
+ * thread. Work-groups are created and freed by the main thread, and executed
+ * concurrently by 'si_emu_num_threads' threads sharing the global memory. */
+static int si_emu_run_parallel(SIEmu *self)
+{
+	struct si_emu_worker_t worker;
+	struct si_work_group_t *work_group;
+
+	pthread_t *threads;
+
+	long work_group_id;
+	int num_threads;
+	int i;
+
+	/* Exit here if there are no work-groups to run */
+	if (!list_count(self->waiting_work_groups))
+		return FALSE;
+	assert(self->ndrange);
+	assert(!list_count(self->running_work_groups));
+
+	/* Instantiate batch of work-groups */
+	memset(&worker, 0, sizeof worker);
+	worker.work_group_count = MIN(list_count(self->waiting_work_groups),
+		si_emu_num_threads * SI_EMU_WORK_GROUPS_PER_THREAD);
+	worker.work_groups = xcalloc(worker.work_group_count,
+		sizeof(struct si_work_group_t *));
+	pthread_mutex_init(&worker.lock, NULL);
+	for (i = 0; i < worker.work_group_count; i++)
+	{
+		work_group_id = (long) list_dequeue(self->waiting_work_groups);
+		list_enqueue(self->running_work_groups, (void *) work_group_id);
+		work_group = si_work_group_create(work_group_id, self->ndrange);
+		work_group->parallel_emu = 1;
+		work_group->lds_module->thread_safe = 1;
+		worker.work_groups[i] = work_group;
+	}
+
+	/* Run workers */
+	num_threads = MIN(si_emu_num_threads, worker.work_group_count);
+	threads = xcalloc(num_threads, sizeof(pthread_t));
+	self->global_mem->thread_safe = 1;
+	for (i = 0; i < num_threads; i++)
+		if (pthread_create(&threads[i], NULL, si_emu_worker, &worker))
+			fatal("%s: could not create thread", __FUNCTION__);
+	for (i = 0; i < num_threads; i++)
+		pthread_join(threads[i], NULL);
+	self->global_mem->thread_safe = 0;
+
+	/* Collect statistics and free work-groups */
+	for (i = 0; i < worker.work_group_count; i++)
+	{
+		work_group = worker.work_groups[i];
+		si_emu_add_work_group_stats(self, work_group);
+		list_dequeue(self->running_work_groups);
+		si_work_group_free(work_group);
+	}
+
+	/* Free */
+	pthread_mutex_destroy(&worker.lock);
+	free(worker.work_groups);
+	free(threads);
+
+	/* If there is not more work groups to run, let driver know */
+	if (!list_count(self->waiting_work_groups))
+		opencl_si_request_work();
+
+	/* Still emulating */
+	return TRUE;
+}
+
+
+
+
 /*
  * Class 'SIEmu'
  */
@@ -104,12 +263,14 @@ int SIEmuRun(Emu *self)
 	SIEmu *emu = asSIEmu(self);
 
 	struct si_ndrange_t *ndrange;
-	struct si_wavefront_t *wavefront;
 	struct si_work_group_t *work_group;
 
-	int wavefront_id;
 	long work_group_id;
 
+	/* Run independent work-groups on several host threads */
+	if (si_emu_num_threads > 1)
+		return si_emu_run_parallel(emu);
+
 	if (!list_count(emu->running_work_groups) &&
 		list_count(emu->waiting_work_groups))
 	{
@@ -130,19 +291,7 @@ int SIEmuRun(Emu *self)
 	work_group = si_work_group_create(work_group_id, ndrange);
 
 	/* Execute the work-group to completion */
-	while (!work_group->finished_emu)
-	{
-		SI_FOREACH_WAVEFRONT_IN_WORK_GROUP(work_group, wavefront_id)
-		{
-			wavefront = work_group->wavefronts[wavefront_id];
-
-			if (wavefront->finished || wavefront->at_barrier)
-				continue;
-
-			/* Execute instruction in wavefront */
-			si_wavefront_execute(wavefront);
-		}
-	}
+	si_emu_work_group_run(work_group);
 
 	/* Remove work group from running list */
 	list_dequeue(emu->running_work_groups);
@@ -178,6 +327,8 @@ FILE *si_emu_report_file = NULL;
 
 int si_emu_wavefront_size = 64;
 
+int si_emu_num_threads = 1;
+
 int si_emu_num_mapped_const_buffers = 2;  /* CB0, CB1 by default */
 
 
@@ -195,6 +346,23 @@ void si_emu_init(void)
 				"emulator", si_emu_report_file_name);
 	}
 
+	/* Work-groups are run on a single thread when memory debugging
+	 * is active, or when ISA traces are dumped. */
+#ifdef MHANDLE
+	if (si_emu_num_threads > 1)
+	{
+		warning("%s: memory debugging enabled, running Southern Islands "
+			"emulation on a single thread", __FUNCTION__);
+		si_emu_num_threads = 1;
+	}
+#endif
+	if (si_emu_num_threads > 1 && debug_status(si_isa_debug_category))
+	{
+		warning("%s: ISA debug enabled, running Southern Islands "
+			"emulation on a single thread", __FUNCTION__);
+		si_emu_num_threads = 1;
+	}
+
 	/* Create emulator */
 	si_emu = new(SIEmu);
 
@@ -244,6 +244,11 @@ extern FILE *si_emu_report_file;
 
 extern int si_emu_wavefront_size;
 
+/* Host threads running independent work-groups in functional emulation, and
+ * number of work-groups run per thread between synchronizations. */
+#define SI_EMU_WORK_GROUPS_PER_THREAD  8
+extern int si_emu_num_threads;
+
 extern SIEmu *si_emu;
 
 
@@ -36,7 +36,9 @@ struct repos_t *si_isa_write_task_repos;
 si_isa_inst_func_t *si_isa_inst_func;
 
 /* Debug */
+#ifndef NO_HOT_DEBUG
 int si_isa_debug_category;
+#endif
 
 
 
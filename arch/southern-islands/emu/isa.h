@@ -69,7 +69,11 @@ void si_isa_write_task_commit(void);
 
 /* Debugging */
 #define si_isa_debug(...) debug(si_isa_debug_category, __VA_ARGS__)
+#ifdef NO_HOT_DEBUG
+#define si_isa_debug_category 0
+#else
 extern int si_isa_debug_category;
+#endif
 
 
 /* Macros for unsupported parameters */
@@ -20,9 +20,11 @@
 
 #include <lib/mhandle/mhandle.h>
 #include <lib/util/debug.h>
+#include <lib/util/list.h>
 #include <mem-system/memory.h>
 
 #include "ndrange.h"
+#include "work-group.h"
 #include "work-item.h"
 
 
@@ -38,6 +40,7 @@ struct si_ndrange_t *si_ndrange_create()
 	/* Initialize */
 	ndrange = xcalloc(1, sizeof(struct si_ndrange_t));
 	ndrange->id = si_emu->ndrange_count++;
+	ndrange->work_group_pool = list_create();
 
 	/* Instruction histogram */
 	if (si_emu_report_file)
@@ -51,6 +54,9 @@ struct si_ndrange_t *si_ndrange_create()
 
 void si_ndrange_free(struct si_ndrange_t *ndrange)
 {
+	/* Free work-group pool */
+	si_work_group_pool_free(ndrange->work_group_pool);
+
 	/* Free instruction histogram */
 	if (ndrange->inst_histogram)
 		free(ndrange->inst_histogram);
@@ -58,6 +64,7 @@ void si_ndrange_free(struct si_ndrange_t *ndrange)
 	/* Free instruction buffer */
 	if (ndrange->inst_buffer)
 		free(ndrange->inst_buffer);
+	free(ndrange->insts);
 
 	/* Free ndrange */
 	memset(ndrange, 0, sizeof(struct si_ndrange_t));
@@ -140,6 +147,11 @@ void si_ndrange_setup_inst_mem(struct si_ndrange_t *ndrange, void *buf,
 	ndrange->inst_buffer = xmalloc(size);
 	ndrange->inst_buffer_size = size;
 	memcpy(ndrange->inst_buffer, buf, size);
+
+	/* Decoded instructions */
+	ndrange->inst_count = size / 4;
+	ndrange->insts = xcalloc(ndrange->inst_count,
+		sizeof(struct si_ndrange_inst_t));
 }
 
 void si_ndrange_setup_fs_mem(struct si_ndrange_t *ndrange, void *buf, 
@@ -162,6 +174,45 @@ void si_ndrange_setup_fs_mem(struct si_ndrange_t *ndrange, void *buf,
 	ndrange->fs_buffer_initialized = 1;
 	free(ndrange->inst_buffer);
 	ndrange->inst_buffer = buffer;
+
+	/* Decoded instructions, now covering the fetch shader */
+	free(ndrange->insts);
+	ndrange->inst_count = (ndrange->inst_buffer_size + size) / 4;
+	ndrange->insts = xcalloc(ndrange->inst_count,
+		sizeof(struct si_ndrange_inst_t));
+}
+
+
+/* Return the instruction at offset 'pc' of the instruction memory in 'inst',
+ * and its size in bytes. The instruction is decoded the first time it is
+ * requested. Several host threads may decode the same instruction at a time,
+ * producing the same result, so the entry is only published after it is
+ * complete. */
+int si_ndrange_get_inst(struct si_ndrange_t *ndrange, unsigned int pc,
+	struct si_inst_t *inst)
+{
+	struct si_ndrange_inst_t *entry;
+	struct si_inst_t decoded_inst;
+	int size;
+
+	/* Already decoded */
+	assert(!(pc & 3) && pc / 4 < ndrange->inst_count);
+	entry = &ndrange->insts[pc / 4];
+	if (entry->size)
+	{
+		*inst = entry->inst;
+		return entry->size;
+	}
+
+	/* Decode */
+	size = si_inst_decode(ndrange->inst_buffer + pc, &decoded_inst, pc);
+	entry->inst = decoded_inst;
+	__sync_synchronize();
+	entry->size = size;
+
+	/* Return */
+	*inst = decoded_inst;
+	return size;
 }
 
 void si_ndrange_insert_buffer_into_uav_table(struct si_ndrange_t *ndrange,
@@ -22,6 +22,7 @@
 
 #include <stdio.h>
 
+#include <arch/southern-islands/asm/asm.h>
 #include <arch/southern-islands/asm/bin-file.h>
 
 #include "emu.h"
@@ -40,6 +41,14 @@ struct si_ndrange_table_entry_t
         unsigned int size;
 };
 
+/* Decoded instruction in the instruction memory of an ND-Range. A size of 0
+ * means that the instruction has not been decoded yet. */
+struct si_ndrange_inst_t
+{
+	struct si_inst_t inst;
+	int size;
+};
+
 struct si_ndrange_t
 {
 	/* ID */
@@ -67,11 +76,21 @@ struct si_ndrange_t
 	void *inst_buffer;
 	unsigned int inst_buffer_size;
 
+	/* Decoded instructions, indexed by PC / 4 and shared by all
+	 * wavefronts. Each instruction is decoded the first time it is
+	 * executed, since instruction memory may contain data or
+	 * instructions that are never reached. */
+	struct si_ndrange_inst_t *insts;
+	int inst_count;
+
 	/* Fetch shader memory containing Fetch shader instructions */
 	int fs_buffer_initialized;
 	unsigned int fs_buffer_ptr;
 	unsigned int fs_buffer_size;
 
+	/* Released work-groups, reused by 'si_work_group_create' */
+	struct list_t *work_group_pool;
+
 	/* Local memory top to assign to local arguments.
 	 * Initially it is equal to the size of local variables in 
 	 * kernel function. */
@@ -122,6 +141,10 @@ void si_ndrange_setup_fs_mem(struct si_ndrange_t *ndrange, void *buf,
 void si_ndrange_setup_inst_mem(struct si_ndrange_t *ndrange, void *buf, 
 	int size, unsigned int pc);
 
+/* Access instruction memory */
+int si_ndrange_get_inst(struct si_ndrange_t *ndrange, unsigned int pc,
+	struct si_inst_t *inst);
+
 /* Access constant buffers */
 void si_ndrange_const_buf_write(struct si_ndrange_t *ndrange, 
 	int const_buf_num, int offset, void *pvalue, unsigned int size);
@@ -30,6 +30,14 @@
 
 
 
+/* Update an emulator statistic. Work-groups run concurrently by the
+ * functional emulator only update their wavefront counters, which are added
+ * to the emulator statistics by the main thread when the work-group ends. */
+#define SI_EMU_STAT_INC(work_group, stat) \
+	do { if (!(work_group)->parallel_emu) si_emu->stat++; } while (0)
+
+
+
 /*
  * Public Functions
  */
@@ -71,6 +79,24 @@ struct si_wavefront_t *si_wavefront_create(int wavefront_id,
 	return wavefront;
 }
 
+/* Bring a wavefront back to the state of a newly created one, keeping its
+ * work-items and work-group. */
+void si_wavefront_reset(struct si_wavefront_t *wavefront)
+{
+	struct si_work_group_t *work_group;
+	struct si_work_item_t *scalar_work_item;
+	struct si_work_item_t **work_items;
+
+	work_group = wavefront->work_group;
+	scalar_work_item = wavefront->scalar_work_item;
+	work_items = wavefront->work_items;
+	memset(wavefront, 0, sizeof(struct si_wavefront_t));
+	wavefront->work_group = work_group;
+	wavefront->scalar_work_item = scalar_work_item;
+	wavefront->work_items = work_items;
+	si_wavefront_sreg_init(wavefront);
+}
+
 /* Helper function for initializing the wavefront. */
 void si_wavefront_sreg_init(struct si_wavefront_t *wavefront)
 {
@@ -142,12 +168,12 @@ void si_wavefront_execute(struct si_wavefront_t *wavefront)
 	assert(!wavefront->finished);
 	
 	/* Grab the instruction at PC and update the pointer */
-	wavefront->inst_size = si_inst_decode(
-		ndrange->inst_buffer + wavefront->pc,
-		&wavefront->inst, 0);
+	wavefront->inst_size = si_ndrange_get_inst(ndrange, wavefront->pc,
+		&wavefront->inst);
 
 	/* Stats */
-	asEmu(si_emu)->instructions++;
+	if (!work_group->parallel_emu)
+		asEmu(si_emu)->instructions++;
 	wavefront->emu_inst_count++;
 	wavefront->inst_count++;
 
@@ -171,7 +197,7 @@ void si_wavefront_execute(struct si_wavefront_t *wavefront)
 		}
 
 		/* Stats */
-		si_emu->scalar_alu_inst_count++;
+		SI_EMU_STAT_INC(work_group, scalar_alu_inst_count);
 		wavefront->scalar_alu_inst_count++;
 
 		/* Only one work item executes the instruction */
@@ -198,7 +224,7 @@ void si_wavefront_execute(struct si_wavefront_t *wavefront)
 		}
 
 		/* Stats */
-		si_emu->scalar_alu_inst_count++;
+		SI_EMU_STAT_INC(work_group, scalar_alu_inst_count);
 		wavefront->scalar_alu_inst_count++;
 
 		/* Only one work item executes the instruction */
@@ -228,11 +254,11 @@ void si_wavefront_execute(struct si_wavefront_t *wavefront)
 		if (wavefront->inst.micro_inst.sopp.op > 1 &&
 			wavefront->inst.micro_inst.sopp.op < 10)
 		{
-			si_emu->branch_inst_count++;
+			SI_EMU_STAT_INC(work_group, branch_inst_count);
 			wavefront->branch_inst_count++;
 		} else
 		{
-			si_emu->scalar_alu_inst_count++;
+			SI_EMU_STAT_INC(work_group, scalar_alu_inst_count);
 			wavefront->scalar_alu_inst_count++;
 		}
 
@@ -260,7 +286,7 @@ void si_wavefront_execute(struct si_wavefront_t *wavefront)
 		}
 
 		/* Stats */
-		si_emu->scalar_alu_inst_count++;
+		SI_EMU_STAT_INC(work_group, scalar_alu_inst_count);
 		wavefront->scalar_alu_inst_count++;
 
 		/* Only one work item executes the instruction */
@@ -287,7 +313,7 @@ void si_wavefront_execute(struct si_wavefront_t *wavefront)
 		}
 
 		/* Stats */
-		si_emu->scalar_alu_inst_count++;
+		SI_EMU_STAT_INC(work_group, scalar_alu_inst_count);
 		wavefront->scalar_alu_inst_count++;
 
 		/* Only one work item executes the instruction */
@@ -315,7 +341,7 @@ void si_wavefront_execute(struct si_wavefront_t *wavefront)
 		}
 
 		/* Stats */
-		si_emu->scalar_mem_inst_count++;
+		SI_EMU_STAT_INC(work_group, scalar_mem_inst_count);
 		wavefront->scalar_mem_inst_count++;
 
 		/* Only one work item executes the instruction */
@@ -343,7 +369,7 @@ void si_wavefront_execute(struct si_wavefront_t *wavefront)
 		}
 
 		/* Stats */
-		si_emu->vector_alu_inst_count++;
+		SI_EMU_STAT_INC(work_group, vector_alu_inst_count);
 		wavefront->vector_alu_inst_count++;
 	
 		/* Execute the instruction */
@@ -378,7 +404,7 @@ void si_wavefront_execute(struct si_wavefront_t *wavefront)
 		}
 
 		/* Stats */
-		si_emu->vector_alu_inst_count++;
+		SI_EMU_STAT_INC(work_group, vector_alu_inst_count);
 		wavefront->vector_alu_inst_count++;
 
 		/* Special case: V_READFIRSTLANE_B32 */
@@ -449,7 +475,7 @@ void si_wavefront_execute(struct si_wavefront_t *wavefront)
 		}
 
 		/* Stats */
-		si_emu->vector_alu_inst_count++;
+		SI_EMU_STAT_INC(work_group, vector_alu_inst_count);
 		wavefront->vector_alu_inst_count++;
 	
 		/* Execute the instruction */
@@ -484,7 +510,7 @@ void si_wavefront_execute(struct si_wavefront_t *wavefront)
 		}
 
 		/* Stats */
-		si_emu->vector_alu_inst_count++;
+		SI_EMU_STAT_INC(work_group, vector_alu_inst_count);
 		wavefront->vector_alu_inst_count++;
 	
 		/* Execute the instruction */
@@ -519,7 +545,7 @@ void si_wavefront_execute(struct si_wavefront_t *wavefront)
 		}
 
 		/* Stats */
-		si_emu->vector_alu_inst_count++;
+		SI_EMU_STAT_INC(work_group, vector_alu_inst_count);
 		wavefront->vector_alu_inst_count++;
 	
 		/* Execute the instruction */
@@ -554,7 +580,7 @@ void si_wavefront_execute(struct si_wavefront_t *wavefront)
 		}
 
 		/* Stats */
-		si_emu->lds_inst_count++;
+		SI_EMU_STAT_INC(work_group, lds_inst_count);
 		wavefront->lds_inst_count++;
 
 		/* Record access type */
@@ -608,7 +634,7 @@ void si_wavefront_execute(struct si_wavefront_t *wavefront)
 		}
 
 		/* Stats */
-		si_emu->vector_mem_inst_count++;
+		SI_EMU_STAT_INC(work_group, vector_mem_inst_count);
 		wavefront->vector_mem_inst_count++;
 
 		/* Record access type */
@@ -651,7 +677,7 @@ void si_wavefront_execute(struct si_wavefront_t *wavefront)
 		}
 
 		/* Stats */
-		si_emu->vector_mem_inst_count++;
+		SI_EMU_STAT_INC(work_group, vector_mem_inst_count);
 		wavefront->vector_mem_inst_count++;
 
 		/* Record access type */
@@ -702,7 +728,7 @@ void si_wavefront_execute(struct si_wavefront_t *wavefront)
 		}
 
 		/* Stats */
-		si_emu->export_inst_count++;
+		SI_EMU_STAT_INC(work_group, export_inst_count);
 		wavefront->export_inst_count++;
 
 		/* Record access type */
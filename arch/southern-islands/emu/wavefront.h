@@ -93,6 +93,7 @@ struct si_wavefront_t
 struct si_wavefront_t *si_wavefront_create(int wavefront_id,
 	struct si_work_group_t *work_group);
 void si_wavefront_sreg_init(struct si_wavefront_t *wavefront);
+void si_wavefront_reset(struct si_wavefront_t *wavefront);
 void si_wavefront_free(struct si_wavefront_t *wavefront);
 void si_wavefront_dump(struct si_wavefront_t *wavefront, FILE *f);
 
@@ -20,6 +20,7 @@
 
 #include <lib/mhandle/mhandle.h>
 #include <lib/util/debug.h>
+#include <lib/util/list.h>
 #include <mem-system/memory.h>
 
 #include "isa.h"
@@ -31,28 +32,19 @@
 
 
 /*
- * Public Functions
+ * Private Functions
  */
 
-struct si_work_group_t *si_work_group_create(unsigned int work_group_id, 
-	struct si_ndrange_t *ndrange)
+/* Allocate a work-group with its wavefronts, work-items, and LDS, shaped for
+ * the work-group size of 'ndrange'. */
+static struct si_work_group_t *si_work_group_alloc(struct si_ndrange_t *ndrange)
 {
-	struct si_bin_enc_user_element_t *user_elements;
 	struct si_wavefront_t *wavefront;
 	struct si_work_group_t *work_group;
-	struct si_work_item_t *work_item;
 
-	int i;
-	int lid;
-	int lidx, lidy, lidz;
-	int tid;
-	int user_element_count;
 	int wavefront_id;
 	int wavefront_offset;
 	int work_item_id;
-	int work_item_gidx_start;
-	int work_item_gidy_start;
-	int work_item_gidz_start;
 
 	/* Number of in work-items in work-group */
 	unsigned int work_items_per_group = ndrange->local_size3[0] * 
@@ -66,7 +58,6 @@ struct si_work_group_t *si_work_group_create(unsigned int work_group_id,
 
 	/* Initialize */
 	work_group = xcalloc(1, sizeof(struct si_work_group_t));
-	work_group->id = work_group_id;
 	work_group->ndrange = ndrange;
 
 	/* Create LDS */
@@ -84,8 +75,7 @@ struct si_work_group_t *si_work_group_create(unsigned int work_group_id,
 	SI_FOREACH_WAVEFRONT_IN_WORK_GROUP(work_group, wavefront_id)
 	{
 		work_group->wavefronts[wavefront_id] = si_wavefront_create(
-			work_group->id * wavefronts_per_group + wavefront_id,
-			work_group);
+			wavefront_id, work_group);
 
 		wavefront = work_group->wavefronts[wavefront_id];
 
@@ -100,6 +90,146 @@ struct si_work_group_t *si_work_group_create(unsigned int work_group_id,
 		}
 	}
 
+	/* Return */
+	return work_group;
+}
+
+
+/* Bring a work-group taken from the pool of its ND-Range back to the state
+ * of a newly allocated one, keeping its wavefronts, work-items, and LDS. */
+static void si_work_group_reset(struct si_work_group_t *work_group)
+{
+	struct si_ndrange_t *ndrange;
+	struct si_wavefront_t *wavefront;
+	struct si_work_item_t *work_item;
+	struct si_work_item_t **work_items;
+	struct si_wavefront_t **wavefronts;
+	struct mem_t *lds_module;
+
+	int wavefront_count;
+	int wavefront_id;
+	int work_item_id;
+
+	/* Work-group */
+	ndrange = work_group->ndrange;
+	lds_module = work_group->lds_module;
+	work_items = work_group->work_items;
+	wavefronts = work_group->wavefronts;
+	wavefront_count = work_group->wavefront_count;
+	memset(work_group, 0, sizeof(struct si_work_group_t));
+	work_group->ndrange = ndrange;
+	work_group->lds_module = lds_module;
+	work_group->work_items = work_items;
+	work_group->wavefronts = wavefronts;
+	work_group->wavefront_count = wavefront_count;
+
+	/* LDS */
+	mem_clear(lds_module);
+	lds_module->thread_safe = 0;
+
+	/* Wavefronts and work-items */
+	SI_FOREACH_WAVEFRONT_IN_WORK_GROUP(work_group, wavefront_id)
+	{
+		wavefront = wavefronts[wavefront_id];
+		si_wavefront_reset(wavefront);
+
+		SI_FOREACH_WORK_ITEM_IN_WAVEFRONT(wavefront, work_item_id)
+		{
+			work_item = wavefront->work_items[work_item_id];
+			si_work_item_reset(work_item);
+		}
+		si_work_item_reset(wavefront->scalar_work_item);
+	}
+}
+
+
+/* Free a work-group and its wavefronts, work-items, and LDS */
+static void si_work_group_destroy(struct si_work_group_t *work_group)
+{
+	struct si_wavefront_t *wavefront;
+
+	int wavefront_id;
+	int work_item_id; 
+
+	assert(work_group);
+
+	/* Free wavefronts and work-items */
+	SI_FOREACH_WAVEFRONT_IN_WORK_GROUP(work_group, wavefront_id)
+	{
+		wavefront = work_group->wavefronts[wavefront_id];
+
+		SI_FOREACH_WORK_ITEM_IN_WAVEFRONT(wavefront, work_item_id)
+		{
+			si_work_item_free(wavefront->work_items[work_item_id]);
+		}
+
+		si_work_item_free(wavefront->scalar_work_item);
+		si_wavefront_free(wavefront);
+	}
+	free(work_group->wavefronts);
+	free(work_group->work_items);
+
+	/* Free LDS memory module */
+	mem_free(work_group->lds_module);
+
+	/* Free work-group */
+	memset(work_group, 0, sizeof(struct si_work_group_t));
+	free(work_group);
+	work_group = NULL;
+}
+
+
+
+
+/*
+ * Public Functions
+ */
+
+/* Create a work-group. Work-groups released with 'si_work_group_free' are
+ * recycled from the pool of the ND-Range, and only allocated when the pool is
+ * empty. All work-groups of an ND-Range have the same shape. */
+struct si_work_group_t *si_work_group_create(unsigned int work_group_id, 
+	struct si_ndrange_t *ndrange)
+{
+	struct si_bin_enc_user_element_t *user_elements;
+	struct si_wavefront_t *wavefront;
+	struct si_work_group_t *work_group;
+	struct si_work_item_t *work_item;
+
+	int i;
+	int lid;
+	int lidx, lidy, lidz;
+	int tid;
+	int user_element_count;
+	int wavefront_id;
+	int work_item_id;
+	int work_item_gidx_start;
+	int work_item_gidy_start;
+	int work_item_gidz_start;
+
+	/* Number of in work-items in work-group */
+	unsigned int work_items_per_group = ndrange->local_size3[0] * 
+		ndrange->local_size3[1] * ndrange->local_size3[2];
+
+	/* Take work-group from pool, or allocate a new one */
+	if (list_count(ndrange->work_group_pool))
+	{
+		work_group = list_pop(ndrange->work_group_pool);
+		si_work_group_reset(work_group);
+	}
+	else
+	{
+		work_group = si_work_group_alloc(ndrange);
+	}
+
+	/* Wavefront IDs */
+	SI_FOREACH_WAVEFRONT_IN_WORK_GROUP(work_group, wavefront_id)
+	{
+		wavefront = work_group->wavefronts[wavefront_id];
+		wavefront->id = work_group_id * work_group->wavefront_count +
+			wavefront_id;
+	}
+
 	/* Initialize work-group and work-item metadata */
 	work_group->id_3d[0] = work_group_id % ndrange->group_count3[0];
 	work_group->id_3d[1] = (work_group_id / ndrange->group_count3[0]) % 
@@ -298,36 +428,22 @@ struct si_work_group_t *si_work_group_create(unsigned int work_group_id,
 	return work_group;
 }
 
+/* Release a work-group. It is kept in the pool of its ND-Range, where it is
+ * reused by the next call to 'si_work_group_create'. The pool never grows
+ * beyond the peak number of work-groups in flight, that is, the occupancy
+ * limit of the compute units in detailed simulation. */
 void si_work_group_free(struct si_work_group_t *work_group)
 {
-	struct si_wavefront_t *wavefront;
-
-	int wavefront_id;
-	int work_item_id; 
-
 	assert(work_group);
+	assert(work_group->ndrange);
+	list_push(work_group->ndrange->work_group_pool, work_group);
+}
 
-	/* Free wavefronts and work-items */
-	SI_FOREACH_WAVEFRONT_IN_WORK_GROUP(work_group, wavefront_id)
-	{
-		wavefront = work_group->wavefronts[wavefront_id];
-
-		SI_FOREACH_WORK_ITEM_IN_WAVEFRONT(wavefront, work_item_id)
-		{
-			si_work_item_free(wavefront->work_items[work_item_id]);
-		}
-
-		si_work_item_free(wavefront->scalar_work_item);
-		si_wavefront_free(wavefront);
-	}
-	free(work_group->wavefronts);
-	free(work_group->work_items);
-
-	/* Free LDS memory module */
-	mem_free(work_group->lds_module);
 
-	/* Free work-group */
-	memset(work_group, 0, sizeof(struct si_work_group_t));
-	free(work_group);
-	work_group = NULL;
+/* Free the work-groups in the pool of an ND-Range */
+void si_work_group_pool_free(struct list_t *pool)
+{
+	while (list_count(pool))
+		si_work_group_destroy(list_pop(pool));
+	list_free(pool);
 }
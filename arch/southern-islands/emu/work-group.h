@@ -32,6 +32,7 @@ struct si_work_group_t
 	int wavefronts_completed_timing;
 	int finished_emu;
 	int finished_timing;
+	int parallel_emu;  /* Run by a host thread of the functional emulator */
 
 	/* ND-Range metadata */
 	struct si_ndrange_t *ndrange;
@@ -58,9 +59,12 @@ struct si_work_group_t
 	long long int vreg_write_count;
 };
 
+struct list_t;
+
 struct si_work_group_t *si_work_group_create(unsigned int work_group_id, 
 	struct si_ndrange_t *ndrange);
 void si_work_group_free(struct si_work_group_t *work_group);
+void si_work_group_pool_free(struct list_t *pool);
 void si_work_group_dump(struct si_work_group_t *work_group, FILE *f);
 
 #endif
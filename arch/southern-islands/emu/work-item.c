@@ -46,3 +46,21 @@ void si_work_item_free(struct si_work_item_t *work_item)
 	free(work_item);
 }
 
+
+/* Bring a work-item back to the state of a newly created one, keeping its
+ * position in the wavefront and work-group. */
+void si_work_item_reset(struct si_work_item_t *work_item)
+{
+	struct si_wavefront_t *wavefront;
+	struct si_work_group_t *work_group;
+	int id_in_wavefront;
+
+	wavefront = work_item->wavefront;
+	work_group = work_item->work_group;
+	id_in_wavefront = work_item->id_in_wavefront;
+	memset(work_item, 0, sizeof(struct si_work_item_t));
+	work_item->wavefront = wavefront;
+	work_item->work_group = work_group;
+	work_item->id_in_wavefront = id_in_wavefront;
+}
+
@@ -70,5 +70,6 @@ struct si_work_item_t
 
 struct si_work_item_t *si_work_item_create(void);
 void si_work_item_free(struct si_work_item_t *work_item);
+void si_work_item_reset(struct si_work_item_t *work_item);
 
 #endif
@@ -22,6 +22,7 @@
 #include <arch/southern-islands/emu/work-group.h>
 #include <driver/opencl/opencl.h>
 #include <lib/esim/esim.h>
+#include <lib/esim/stats.h>
 #include <lib/esim/trace.h>
 #include <lib/mhandle/mhandle.h>
 #include <lib/util/config.h>
@@ -1269,6 +1270,15 @@ void SIGpuCreate(SIGpu *self)
 		compute_unit->id = compute_unit_id;
 		self->compute_units[compute_unit_id] = compute_unit;
 		list_add(self->available_compute_units, compute_unit);
+
+		/* Interval statistics */
+		stats_register(&compute_unit->inst_count, "si.cu%d.inst", compute_unit_id);
+		stats_register(&compute_unit->scalar_alu_inst_count, "si.cu%d.scalar_alu_inst", compute_unit_id);
+		stats_register(&compute_unit->scalar_mem_inst_count, "si.cu%d.scalar_mem_inst", compute_unit_id);
+		stats_register(&compute_unit->branch_inst_count, "si.cu%d.branch_inst", compute_unit_id);
+		stats_register(&compute_unit->simd_inst_count, "si.cu%d.simd_inst", compute_unit_id);
+		stats_register(&compute_unit->vector_mem_inst_count, "si.cu%d.vector_mem_inst", compute_unit_id);
+		stats_register(&compute_unit->lds_inst_count, "si.cu%d.lds_inst", compute_unit_id);
 	}
 
 	/* Virtual functions */
@@ -53,7 +53,7 @@ static void save_memory(struct mem_t *mem);
 static void load_memory_data(struct mem_t *mem);
 static void save_memory_data(struct mem_t *mem);
 static void load_memory_range(struct mem_t *mem);
-static void save_memory_page(struct mem_page_t *page);
+static void save_memory_page(struct mem_t *mem, struct mem_page_t *page);
 static void load_fds(struct x86_file_desc_table_t *fdt);
 static void load_fd(struct x86_file_desc_table_t *fdt);
 static void save_fds(struct x86_file_desc_table_t *fdt);
@@ -304,7 +304,7 @@ static void save_memory_data(struct mem_t *mem)
 		struct mem_page_t *page;
 
 		for (page = mem->pages[i]; page; page = page->next)
-			save_memory_page(page);
+			save_memory_page(mem, page);
 	}
 
 	mem->safe = old_mem_safe;
@@ -351,8 +351,11 @@ static void load_memory_range(struct mem_t *mem)
 	}
 }
 
-static void save_memory_page(struct mem_page_t *page)
+static void save_memory_page(struct mem_t *mem, struct mem_page_t *page)
 {
+	/* Load contents of pages backed by a file */
+	mem_page_load(mem, page);
+
 	cfg_push_unique();
 
 	save_int32("addr", page->tag);
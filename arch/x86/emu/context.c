@@ -41,6 +41,7 @@
 #include "regs.h"
 #include "signal.h"
 #include "syscall.h"
+#include "uinst-trace.h"
 
 
 /*
@@ -128,6 +129,9 @@ void X86ContextCreate(X86Context *self, X86Emu *emu)
 	/* Signal handlers and file descriptor table */
 	self->signal_handler_table = x86_signal_handler_table_create();
 	self->file_desc_table = x86_file_desc_table_create();
+
+	/* Micro-instruction trace */
+	x86_uinst_trace_create(self);
 }
 
 
@@ -160,6 +164,9 @@ void X86ContextCreateAndClone(X86Context *self, X86Context *cloned)
 
 	/* Update other fields. */
 	self->parent = cloned;
+
+	/* Micro-instruction trace */
+	x86_uinst_trace_spawn(self, x86_uinst_trace_record_clone);
 }
 
 
@@ -190,6 +197,9 @@ void X86ContextCreateAndFork(X86Context *self, X86Context *forked)
 
 	/* Set parent */
 	self->parent = forked;
+
+	/* Micro-instruction trace */
+	x86_uinst_trace_spawn(self, x86_uinst_trace_record_fork);
 }
 
 
@@ -262,10 +272,9 @@ void X86ContextDump(Object *self, FILE *f)
 }
 
 
-void X86ContextExecute(X86Context *self)
+/* Fetch and decode the instruction at the current 'eip' into 'self->inst' */
+static void X86ContextFetch(X86Context *self)
 {
-	X86Emu *emu = self->emu;
-
 	struct x86_regs_t *regs = self->regs;
 	struct mem_t *mem = self->mem;
 
@@ -305,15 +314,72 @@ void X86ContextExecute(X86Context *self)
 		x86_emu_last_inst_size == self->inst.size &&
 		!memcmp(x86_emu_last_inst_bytes, buffer_ptr, x86_emu_last_inst_size))
 		esim_finish = esim_finish_x86_last_inst;
+}
 
-	/* Execute instruction */
+
+void X86ContextExecute(X86Context *self)
+{
+	X86Emu *emu = self->emu;
+
+	/* Fetch and execute instruction */
+	X86ContextFetch(self);
 	X86ContextExecuteInst(self);
 
+	/* Micro-instruction trace of non-speculative instructions */
+	if (x86_uinst_trace_active && !X86ContextGetState(self, X86ContextSpecMode))
+		x86_uinst_trace_inst(self);
+
 	/* Statistics */
 	asEmu(emu)->instructions++;
 }
 
 
+/* Execute up to 'max_inst' instructions. The batch ends before any instruction
+ * that enters the kernel or traps ('int', 'int3', 'into', 'hlt'), as soon as
+ * the context has pending unblocked signals or is no longer running, or when
+ * the simulation is requested to finish. All these events are left to the main
+ * thread. This function can be run by a host thread for a context that does
+ * not share its memory image with other contexts (see 'x86_emu_num_threads').
+ * The function returns the number of executed instructions, which are not
+ * added to the emulator statistics. */
+int X86ContextExecuteBatch(X86Context *self, int max_inst)
+{
+	struct x86_signal_mask_table_t *signal_mask_table;
+	int count;
+
+	signal_mask_table = self->signal_mask_table;
+	for (count = 0; count < max_inst && !esim_finish; count++)
+	{
+		/* Signals and state changes are handled by the main thread */
+		if (!X86ContextGetState(self, X86ContextRunning) ||
+				(signal_mask_table->pending & ~signal_mask_table->blocked))
+			break;
+
+		/* Leave instructions entering the kernel to the main thread,
+		 * which executes them again with 'X86ContextExecute'. This
+		 * 32-bit decoder has no 'sysenter' or 'syscall' opcodes. */
+		X86ContextFetch(self);
+		switch (self->inst.opcode)
+		{
+		case x86_inst_int_imm8:
+		case x86_inst_int_3:
+		case x86_inst_into:
+		case x86_inst_hlt:
+			return count;
+
+		default:
+			break;
+		}
+
+		/* Execute */
+		X86ContextExecuteInst(self);
+	}
+
+	/* Return number of instructions executed */
+	return count;
+}
+
+
 /* Force a new 'eip' value for the context. The forced value should be the same as
  * the current 'eip' under normal circumstances. If it is not, speculative execution
  * starts, which will end on the next call to 'x86_ctx_recover'. */
@@ -234,6 +234,7 @@ void X86ContextSuspend(X86Context *self,
 void X86ContextFinish(X86Context *self, int state);
 void X86ContextFinishGroup(X86Context *self, int state);
 void X86ContextExecute(X86Context *self);
+int X86ContextExecuteBatch(X86Context *self, int max_inst);
 
 void X86ContextSetEip(X86Context *self, unsigned int eip);
 void X86ContextRecover(X86Context *self);
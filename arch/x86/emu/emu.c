@@ -19,6 +19,7 @@
 
 #include <errno.h>
 #include <poll.h>
+#include <pthread.h>
 #include <unistd.h>
 
 #include <arch/x86/timing/cpu.h>
@@ -38,10 +39,12 @@
 #include "context.h"
 #include "emu.h"
 #include "file-desc.h"
+#include "isa.h"
 #include "loader.h"
 #include "regs.h"
 #include "signal.h"
 #include "syscall.h"
+#include "uinst-trace.h"
 
 
 /*
@@ -54,12 +57,124 @@ long long x86_emu_max_cycles = 0;
 char x86_emu_last_inst_bytes[20];
 int x86_emu_last_inst_size = 0;
 int x86_emu_process_prefetch_hints = 0;
+int x86_emu_num_threads = 1;
 
 X86Emu *x86_emu;
 
 
 
 
+/*
+ * Private Functions
+ */
+
+/* Shared state of the host threads running contexts in parallel. Threads take
+ * contexts from array 'contexts' in order, using 'next' as an index protected
+ * by 'lock'. */
+struct x86_emu_worker_t
+{
+	X86Context **contexts;
+	int *inst_counts;
+	int context_count;
+	int max_inst;
+	int next;
+	pthread_mutex_t lock;
+};
+
+
+static void *x86_emu_worker(void *data)
+{
+	struct x86_emu_worker_t *worker = data;
+	X86Context *ctx;
+	int index;
+
+	for (;;)
+	{
+		/* Take next context */
+		pthread_mutex_lock(&worker->lock);
+		index = worker->next++;
+		pthread_mutex_unlock(&worker->lock);
+		if (index >= worker->context_count)
+			break;
+
+		/* Run a batch of instructions */
+		ctx = worker->contexts[index];
+		worker->inst_counts[index] = X86ContextExecuteBatch(ctx,
+			worker->max_inst);
+	}
+
+	/* Instruction counts of this thread */
+	x86_isa_inst_stat_flush();
+	return NULL;
+}
+
+
+/* Run a batch of up to 'X86_EMU_BATCH_SIZE' instructions for every running
+ * context that does not share its memory image with other contexts, using
+ * 'x86_emu_num_threads' host threads. Contexts stop before system calls,
+ * which are executed later by the main thread. */
+static void X86EmuRunParallel(X86Emu *self)
+{
+	struct x86_emu_worker_t worker;
+	X86Context *ctx;
+
+	pthread_t *threads;
+
+	long long remaining;
+	int num_threads;
+	int i;
+
+	/* Independent contexts */
+	memset(&worker, 0, sizeof worker);
+	worker.contexts = xcalloc(self->running_list_count, sizeof(X86Context *));
+	worker.inst_counts = xcalloc(self->running_list_count, sizeof(int));
+	for (ctx = self->running_list_head; ctx; ctx = ctx->running_list_next)
+		if (!ctx->mem->num_links)
+			worker.contexts[worker.context_count++] = ctx;
+	if (!worker.context_count)
+	{
+		free(worker.contexts);
+		free(worker.inst_counts);
+		return;
+	}
+
+	/* Batch size, not to exceed the maximum number of instructions */
+	worker.max_inst = X86_EMU_BATCH_SIZE;
+	if (x86_emu_max_inst)
+	{
+		remaining = x86_emu_max_inst - asEmu(self)->instructions;
+		worker.max_inst = MAX(1, MIN(worker.max_inst,
+			remaining / worker.context_count));
+	}
+
+	/* Run workers. Memory images are flagged as thread-safe, since
+	 * pages can be shared copy-on-write among forked processes. */
+	pthread_mutex_init(&worker.lock, NULL);
+	num_threads = MIN(x86_emu_num_threads, worker.context_count);
+	threads = xcalloc(num_threads, sizeof(pthread_t));
+	for (i = 0; i < worker.context_count; i++)
+		worker.contexts[i]->mem->thread_safe = 1;
+	for (i = 0; i < num_threads; i++)
+		if (pthread_create(&threads[i], NULL, x86_emu_worker, &worker))
+			fatal("%s: could not create thread", __FUNCTION__);
+	for (i = 0; i < num_threads; i++)
+		pthread_join(threads[i], NULL);
+	for (i = 0; i < worker.context_count; i++)
+	{
+		worker.contexts[i]->mem->thread_safe = 0;
+		asEmu(self)->instructions += worker.inst_counts[i];
+	}
+
+	/* Free */
+	pthread_mutex_destroy(&worker.lock);
+	free(worker.contexts);
+	free(worker.inst_counts);
+	free(threads);
+}
+
+
+
+
 /*
  * Class 'X86Emu'
  */
@@ -574,6 +689,11 @@ int X86EmuRun(Emu *self)
 	if (esim_finish)
 		return TRUE;
 
+	/* Run batches of instructions from independent processes in parallel.
+	 * They stop before a system call, which is run next. */
+	if (x86_emu_num_threads > 1)
+		X86EmuRunParallel(emu);
+
 	/* Run an instruction from every running process */
 	for (ctx = emu->running_list_head; ctx; ctx = ctx->running_list_next)
 		X86ContextExecute(ctx);
@@ -728,12 +848,38 @@ void x86_emu_init(void)
 	M2S_HOST_GUEST_MATCH(sizeof(int), 4);
 	M2S_HOST_GUEST_MATCH(sizeof(short), 2);
 
+	/* Contexts are run on a single thread when memory debugging is
+	 * active, or when instructions are traced. */
+#ifdef MHANDLE
+	if (x86_emu_num_threads > 1)
+	{
+		warning("%s: memory debugging enabled, running x86 emulation "
+			"on a single thread", __FUNCTION__);
+		x86_emu_num_threads = 1;
+	}
+#endif
+	if (x86_emu_num_threads > 1 &&
+		(debug_status(x86_context_isa_debug_category) ||
+		debug_status(x86_context_call_debug_category)))
+	{
+		warning("%s: x86 ISA or call debug enabled, running x86 "
+			"emulation on a single thread", __FUNCTION__);
+		x86_emu_num_threads = 1;
+	}
+	if (x86_emu_num_threads > 1 && *x86_uinst_trace_file_name)
+	{
+		warning("%s: micro-instruction trace enabled, running x86 "
+			"emulation on a single thread", __FUNCTION__);
+		x86_emu_num_threads = 1;
+	}
+
 	/* Create x86 emulator */
 	x86_emu = new(X86Emu);
 
 	/* Initialize */
 	x86_asm_init();
 	x86_uinst_init();
+	x86_uinst_trace_init();
 
 #ifdef HAVE_OPENGL
 	/* GLUT */
@@ -763,6 +909,7 @@ void x86_emu_done(void)
 	opengl_done();
 
 	/* End */
+	x86_uinst_trace_done();
 	x86_uinst_done();
 	x86_asm_done();
 
@@ -120,6 +120,12 @@ extern char x86_emu_last_inst_bytes[20];
 extern int x86_emu_last_inst_size;
 extern int x86_emu_process_prefetch_hints;
 
+/* Host threads running independent contexts in functional simulation, and
+ * maximum number of instructions run by each context between synchronizations
+ * with the main thread. */
+#define X86_EMU_BATCH_SIZE  10000
+extern int x86_emu_num_threads;
+
 void x86_emu_init(void);
 void x86_emu_done(void);
 
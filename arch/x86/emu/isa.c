@@ -17,6 +17,7 @@
  *  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
  */
 
+#include <pthread.h>
 #include <stdarg.h>
 #include <string.h>
 
@@ -54,19 +55,43 @@ static X86ContextInstFunc x86_context_inst_func[x86_inst_opcode_count] =
 };
 
 /* Debug categories */
+#ifndef NO_HOT_DEBUG
 int x86_context_call_debug_category;
 int x86_context_isa_debug_category;
+#endif
 
-/* Variables used to preserve host state before running assembly */
-long x86_context_host_flags;
-unsigned char x86_context_host_fpenv[28];
+/* Variables used to preserve host state before running assembly. They are
+ * private to each host thread running contexts. */
+__thread long x86_context_host_flags;
+__thread unsigned char x86_context_host_fpenv[28];
 
+/* Instruction counts. Each host thread counts in its private table, so that
+ * contexts run in parallel do not contend for them, and adds it to the global
+ * table with 'x86_isa_inst_stat_flush'. */
 static long long x86_inst_freq[x86_inst_opcode_count];
+static __thread long long x86_inst_freq_thread[x86_inst_opcode_count];
+static pthread_mutex_t x86_inst_freq_lock = PTHREAD_MUTEX_INITIALIZER;
+
+
+void x86_isa_inst_stat_flush(void)
+{
+	int i;
+
+	pthread_mutex_lock(&x86_inst_freq_lock);
+	for (i = 1; i < x86_inst_opcode_count; i++)
+	{
+		x86_inst_freq[i] += x86_inst_freq_thread[i];
+		x86_inst_freq_thread[i] = 0;
+	}
+	pthread_mutex_unlock(&x86_inst_freq_lock);
+}
 
 
 void x86_isa_inst_stat_dump(FILE *f)
 {
 	int i;
+
+	x86_isa_inst_stat_flush();
 	for (i = 1; i < x86_inst_opcode_count; i++)
 	{
 		if (!x86_inst_freq[i])
@@ -79,8 +104,13 @@ void x86_isa_inst_stat_dump(FILE *f)
 void x86_isa_inst_stat_reset(void)
 {
 	int i;
+	pthread_mutex_lock(&x86_inst_freq_lock);
 	for (i = 1; i < x86_inst_opcode_count; i++)
+	{
 		x86_inst_freq[i] = 0;
+		x86_inst_freq_thread[i] = 0;
+	}
+	pthread_mutex_unlock(&x86_inst_freq_lock);
 }
 
 
@@ -828,8 +858,10 @@ void X86ContextExecuteInst(X86Context *self)
 
 	/* Clear existing list of microinstructions, though the architectural
 	 * simulator might have cleared it already.
-	 * A new list will be generated for the next executed x86 instruction. */
-	x86_uinst_clear();
+	 * A new list will be generated for the next executed x86 instruction.
+	 * Microinstructions are only produced for detailed simulation. */
+	if (x86_uinst_active)
+		x86_uinst_clear();
 
 	/* Set last, current, and target instruction addresses */
 	self->last_eip = self->curr_eip;
@@ -854,7 +886,7 @@ void X86ContextExecuteInst(X86Context *self)
 		x86_context_inst_func[self->inst.opcode](self);
 	
 	/* Statistics */
-	x86_inst_freq[self->inst.opcode]++;
+	x86_inst_freq_thread[self->inst.opcode]++;
 
 	/* Debug */
 	X86ContextDebugISA("\n");
@@ -111,13 +111,22 @@ void X86ContextExecuteInst(X86Context *ctx);
 #define X86ContextDebugCall(...) debug(x86_context_call_debug_category, __VA_ARGS__)
 #define X86ContextDebugISA(...) debug(x86_context_isa_debug_category, __VA_ARGS__)
 
+#ifdef NO_HOT_DEBUG
+#define x86_context_call_debug_category 0
+#define x86_context_isa_debug_category 0
+#else
 extern int x86_context_call_debug_category;
 extern int x86_context_isa_debug_category;
+#endif
 
 void x86_isa_trace_call_init(char *filename);
 void x86_isa_trace_call_done(void);
 
 void x86_isa_inst_stat_dump(FILE *f);
+
+/* Add the instruction counts of the calling host thread to the global ones.
+ * Called by every thread running contexts after each batch. */
+void x86_isa_inst_stat_flush(void);
 void x86_isa_inst_stat_reset(void);
 
 void X86ContextDoubleToExtended(double f, unsigned char *e);
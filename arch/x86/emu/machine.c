@@ -17,7 +17,6 @@
  *  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
  */
 
-#include <arch/common/arch.h>
 #include <lib/util/misc.h>
 
 #include "context.h"
@@ -1672,8 +1671,9 @@ void x86_isa_prefetcht0_m8_impl(X86Context *ctx)
 {
 	unsigned int eff_addr;
 
-	/* prefetching makes sense only in a detailed simulation */
-	if (arch_x86->sim_kind != arch_sim_kind_detailed)
+	/* prefetching makes sense only when micro-instructions are produced for
+	 * a detailed simulation or a micro-instruction trace */
+	if (!x86_uinst_active)
 		return;
 
 	if (!x86_emu_process_prefetch_hints)
@@ -2002,8 +2002,9 @@ static int x86_sys_mmap(X86Context *ctx, unsigned int addr, unsigned int len,
 	/* Allocation of memory */
 	mem_map(mem, addr, len_aligned, perm);
 
-	/* Host mapping */
-	if (host_fd >= 0)
+	/* Host mapping. File contents are paged in on demand if the file can
+	 * be mapped in the host, or read here otherwise. */
+	if (host_fd >= 0 && !mem_map_file(mem, addr, len_aligned, host_fd, offset))
 	{
 		char buf[MEM_PAGE_SIZE];
 
@@ -0,0 +1,578 @@
+/*
+ *  Multi2Sim
+ *  Copyright (C) 2012  Rafael Ubal (ubal@ece.neu.edu)
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include <assert.h>
+#include <string.h>
+#include <zlib.h>
+
+#include <lib/mhandle/mhandle.h>
+#include <lib/util/debug.h>
+#include <lib/util/list.h>
+#include <lib/util/misc.h>
+
+#include "context.h"
+#include "emu.h"
+#include "regs.h"
+#include "uinst.h"
+#include "uinst-trace.h"
+
+
+/*
+ * Global variables
+ */
+
+char *x86_uinst_trace_file_name = "";
+char *x86_uinst_replay_file_name = "";
+
+int x86_uinst_trace_active;
+
+
+/* Record read from a trace, waiting to be replayed by its context */
+struct x86_uinst_replay_record_t
+{
+	enum x86_uinst_trace_record_t kind;
+	int pid;  /* Context created by clone and fork records */
+
+	/* Instruction record */
+	unsigned int eip;
+	unsigned int neip;
+	unsigned int target;
+	int size;
+	int uinst_count;
+	struct x86_uinst_t **uinst_array;
+
+	struct x86_uinst_replay_record_t *next;
+};
+
+/* Per-context state, indexed by pid. Fields 'eip' and 'address' are the bases
+ * of the differences stored in the trace, both for capture and replay. */
+struct x86_uinst_trace_ctx_t
+{
+	unsigned int eip;
+	unsigned int address;
+
+	/* Replay - records read from the trace for this context */
+	struct x86_uinst_replay_record_t *head;
+	struct x86_uinst_replay_record_t *tail;
+};
+
+static struct x86_uinst_trace_ctx_t **x86_uinst_trace_ctx_array;
+static int x86_uinst_trace_ctx_array_size;
+
+/* Trace being captured */
+static gzFile x86_uinst_trace_file;
+
+/* Trace being replayed */
+static gzFile x86_uinst_replay_file;
+static X86Emu *x86_uinst_replay_emu;
+
+
+
+
+/*
+ * Private Functions
+ */
+
+static struct x86_uinst_trace_ctx_t *x86_uinst_trace_get_ctx(int pid)
+{
+	int size;
+
+	/* Grow array */
+	if (pid < 0)
+		fatal("%s: invalid pid %d in micro-instruction trace",
+			x86_uinst_replay_file_name, pid);
+	if (pid >= x86_uinst_trace_ctx_array_size)
+	{
+		size = MAX(pid + 1, x86_uinst_trace_ctx_array_size * 2);
+		x86_uinst_trace_ctx_array = xrealloc(x86_uinst_trace_ctx_array,
+			size * sizeof(struct x86_uinst_trace_ctx_t *));
+		memset(x86_uinst_trace_ctx_array + x86_uinst_trace_ctx_array_size,
+			0, (size - x86_uinst_trace_ctx_array_size) *
+			sizeof(struct x86_uinst_trace_ctx_t *));
+		x86_uinst_trace_ctx_array_size = size;
+	}
+
+	/* Create context state */
+	if (!x86_uinst_trace_ctx_array[pid])
+		x86_uinst_trace_ctx_array[pid] = xcalloc(1,
+			sizeof(struct x86_uinst_trace_ctx_t));
+	return x86_uinst_trace_ctx_array[pid];
+}
+
+
+static void x86_uinst_replay_record_free(struct x86_uinst_replay_record_t *record)
+{
+	int i;
+
+	for (i = 0; i < record->uinst_count; i++)
+		if (record->uinst_array[i])
+			x86_uinst_free(record->uinst_array[i]);
+	free(record->uinst_array);
+	free(record);
+}
+
+
+static void x86_uinst_trace_write_int(unsigned int value)
+{
+	while (value >= 0x80)
+	{
+		gzputc(x86_uinst_trace_file, (value & 0x7f) | 0x80);
+		value >>= 7;
+	}
+	gzputc(x86_uinst_trace_file, value);
+}
+
+
+static void x86_uinst_trace_write_diff(unsigned int value, unsigned int base)
+{
+	int diff = value - base;
+
+	x86_uinst_trace_write_int(((unsigned int) diff << 1) ^ (diff >> 31));
+}
+
+
+static unsigned int x86_uinst_replay_read_int(void)
+{
+	unsigned int value = 0;
+	int shift = 0;
+	int c;
+
+	do
+	{
+		c = gzgetc(x86_uinst_replay_file);
+		if (c < 0 || shift > 28)
+			fatal("%s: corrupt micro-instruction trace",
+				x86_uinst_replay_file_name);
+		value |= (unsigned int) (c & 0x7f) << shift;
+		shift += 7;
+	} while (c & 0x80);
+	return value;
+}
+
+
+static unsigned int x86_uinst_replay_read_diff(unsigned int base)
+{
+	unsigned int value;
+
+	value = x86_uinst_replay_read_int();
+	return base + ((value >> 1) ^ -(value & 1));
+}
+
+
+static void x86_uinst_replay_read_inst(struct x86_uinst_replay_record_t *record)
+{
+	struct x86_uinst_trace_ctx_t *trace_ctx;
+	struct x86_uinst_t *uinst;
+
+	unsigned int value;
+	int mask;
+	int i;
+	int j;
+
+	/* Instruction */
+	trace_ctx = x86_uinst_trace_get_ctx(record->pid);
+	record->eip = x86_uinst_replay_read_diff(trace_ctx->eip);
+	record->size = x86_uinst_replay_read_int();
+	record->neip = x86_uinst_replay_read_diff(record->eip + record->size);
+	value = x86_uinst_replay_read_int();
+	record->uinst_count = value >> 1;
+	if (value & 1)
+		record->target = x86_uinst_replay_read_diff(record->eip);
+	trace_ctx->eip = record->neip;
+
+	/* Micro-instructions */
+	record->uinst_array = xcalloc(record->uinst_count,
+		sizeof(struct x86_uinst_t *));
+	for (i = 0; i < record->uinst_count; i++)
+	{
+		uinst = x86_uinst_create();
+		record->uinst_array[i] = uinst;
+		uinst->opcode = x86_uinst_replay_read_int();
+		if (uinst->opcode >= x86_uinst_opcode_count)
+			fatal("%s: invalid micro-instruction opcode",
+				x86_uinst_replay_file_name);
+		mask = gzgetc(x86_uinst_replay_file);
+		if (mask < 0)
+			fatal("%s: corrupt micro-instruction trace",
+				x86_uinst_replay_file_name);
+		for (j = 0; j < X86_UINST_MAX_DEPS; j++)
+			if (mask & (1 << j))
+				uinst->dep[j] = x86_uinst_replay_read_int();
+		if (mask & 0x80)
+		{
+			uinst->address = x86_uinst_replay_read_diff(trace_ctx->address);
+			uinst->size = x86_uinst_replay_read_int();
+			trace_ctx->address = uinst->address;
+		}
+	}
+}
+
+
+/* Read the next record from the trace and queue it in its context. Contexts
+ * are created as soon as their create record is read. The function returns
+ * the record kind, or 0 at the end of the trace. */
+static int x86_uinst_replay_read_record(void)
+{
+	struct x86_uinst_replay_record_t *record;
+	struct x86_uinst_trace_ctx_t *trace_ctx;
+	X86Context *ctx;
+
+	int kind;
+	int pid;
+
+	/* Record kind */
+	if (!x86_uinst_replay_file)
+		return 0;
+	kind = gzgetc(x86_uinst_replay_file);
+	if (kind < 0)
+	{
+		gzclose(x86_uinst_replay_file);
+		x86_uinst_replay_file = NULL;
+		return 0;
+	}
+	pid = x86_uinst_replay_read_int();
+
+	/* Create record */
+	if (kind == x86_uinst_trace_record_create)
+	{
+		ctx = new(X86Context, x86_uinst_replay_emu);
+		if (ctx->pid != pid)
+			fatal("%s: context %d created with pid %d",
+				x86_uinst_replay_file_name, pid, ctx->pid);
+		return kind;
+	}
+
+	/* Record queued in the context */
+	record = xcalloc(1, sizeof(struct x86_uinst_replay_record_t));
+	record->kind = kind;
+	switch (kind)
+	{
+
+	case x86_uinst_trace_record_clone:
+	case x86_uinst_trace_record_fork:
+
+		record->pid = x86_uinst_replay_read_int();
+		break;
+
+	case x86_uinst_trace_record_inst:
+
+		record->pid = pid;
+		x86_uinst_replay_read_inst(record);
+		break;
+
+	case x86_uinst_trace_record_end:
+
+		break;
+
+	default:
+
+		fatal("%s: invalid record in micro-instruction trace",
+			x86_uinst_replay_file_name);
+	}
+
+	/* Queue */
+	trace_ctx = x86_uinst_trace_get_ctx(pid);
+	if (trace_ctx->tail)
+		trace_ctx->tail->next = record;
+	else
+		trace_ctx->head = record;
+	trace_ctx->tail = record;
+	return kind;
+}
+
+
+/* Return the next record for a context without removing it, reading the trace
+ * as needed, or NULL if there are no records left for the context. */
+static struct x86_uinst_replay_record_t *x86_uinst_replay_head(X86Context *ctx)
+{
+	struct x86_uinst_trace_ctx_t *trace_ctx;
+
+	trace_ctx = x86_uinst_trace_get_ctx(ctx->pid);
+	while (!trace_ctx->head && x86_uinst_replay_read_record())
+		trace_ctx = x86_uinst_trace_get_ctx(ctx->pid);
+	return trace_ctx->head;
+}
+
+
+static void x86_uinst_replay_pop(X86Context *ctx)
+{
+	struct x86_uinst_trace_ctx_t *trace_ctx;
+
+	trace_ctx = x86_uinst_trace_get_ctx(ctx->pid);
+	assert(trace_ctx->head);
+	trace_ctx->head = trace_ctx->head->next;
+	if (!trace_ctx->head)
+		trace_ctx->tail = NULL;
+}
+
+
+
+
+/*
+ * Public Functions
+ */
+
+void x86_uinst_trace_init(void)
+{
+	if (!*x86_uinst_trace_file_name)
+		return;
+	assert(!x86_uinst_trace_file);
+	x86_uinst_trace_file = gzopen(x86_uinst_trace_file_name, "wb");
+	if (!x86_uinst_trace_file)
+		fatal("%s: cannot write micro-instruction trace",
+			x86_uinst_trace_file_name);
+	gzwrite(x86_uinst_trace_file, X86_UINST_TRACE_MAGIC,
+		X86_UINST_TRACE_MAGIC_SIZE);
+	x86_uinst_trace_active = 1;
+}
+
+
+void x86_uinst_trace_done(void)
+{
+	struct x86_uinst_trace_ctx_t *trace_ctx;
+	struct x86_uinst_replay_record_t *record;
+	int i;
+
+	/* Capture */
+	if (x86_uinst_trace_file && gzclose(x86_uinst_trace_file) != Z_OK)
+		warning("%s: error writing micro-instruction trace",
+			x86_uinst_trace_file_name);
+	x86_uinst_trace_file = NULL;
+	x86_uinst_trace_active = 0;
+
+	/* Replay */
+	if (x86_uinst_replay_file)
+		gzclose(x86_uinst_replay_file);
+	x86_uinst_replay_file = NULL;
+
+	/* Free context states and records not replayed */
+	for (i = 0; i < x86_uinst_trace_ctx_array_size; i++)
+	{
+		trace_ctx = x86_uinst_trace_ctx_array[i];
+		if (!trace_ctx)
+			continue;
+		while ((record = trace_ctx->head))
+		{
+			trace_ctx->head = record->next;
+			x86_uinst_replay_record_free(record);
+		}
+		free(trace_ctx);
+	}
+	free(x86_uinst_trace_ctx_array);
+	x86_uinst_trace_ctx_array = NULL;
+	x86_uinst_trace_ctx_array_size = 0;
+}
+
+
+/* Record a context created by the loader or a checkpoint */
+void x86_uinst_trace_create(X86Context *ctx)
+{
+	if (!x86_uinst_trace_active)
+		return;
+	gzputc(x86_uinst_trace_file, x86_uinst_trace_record_create);
+	x86_uinst_trace_write_int(ctx->pid);
+}
+
+
+/* Record a context created by its parent with a clone or fork record */
+void x86_uinst_trace_spawn(X86Context *ctx, enum x86_uinst_trace_record_t kind)
+{
+	if (!x86_uinst_trace_active)
+		return;
+	assert(kind == x86_uinst_trace_record_clone ||
+		kind == x86_uinst_trace_record_fork);
+	assert(ctx->parent);
+	gzputc(x86_uinst_trace_file, kind);
+	x86_uinst_trace_write_int(ctx->parent->pid);
+	x86_uinst_trace_write_int(ctx->pid);
+}
+
+
+/* Record the instruction just executed by a context, with the micro-
+ * instructions found in 'x86_uinst_list'. */
+void x86_uinst_trace_inst(X86Context *ctx)
+{
+	struct x86_uinst_trace_ctx_t *trace_ctx;
+	struct x86_uinst_t *uinst;
+
+	unsigned int eip;
+	unsigned int neip;
+
+	int count;
+	int mask;
+	int i;
+	int j;
+
+	if (!x86_uinst_trace_active)
+		return;
+
+	/* Instruction */
+	trace_ctx = x86_uinst_trace_get_ctx(ctx->pid);
+	eip = ctx->curr_eip;
+	neip = ctx->regs->eip;
+	count = list_count(x86_uinst_list);
+	gzputc(x86_uinst_trace_file, x86_uinst_trace_record_inst);
+	x86_uinst_trace_write_int(ctx->pid);
+	x86_uinst_trace_write_diff(eip, trace_ctx->eip);
+	x86_uinst_trace_write_int(ctx->inst.size);
+	x86_uinst_trace_write_diff(neip, eip + ctx->inst.size);
+	x86_uinst_trace_write_int(count << 1 | (ctx->target_eip != 0));
+	if (ctx->target_eip)
+		x86_uinst_trace_write_diff(ctx->target_eip, eip);
+	trace_ctx->eip = neip;
+
+	/* Micro-instructions */
+	for (i = 0; i < count; i++)
+	{
+		uinst = list_get(x86_uinst_list, i);
+		mask = uinst->size ? 0x80 : 0;
+		for (j = 0; j < X86_UINST_MAX_DEPS; j++)
+			if (uinst->dep[j])
+				mask |= 1 << j;
+		x86_uinst_trace_write_int(uinst->opcode);
+		gzputc(x86_uinst_trace_file, mask);
+		for (j = 0; j < X86_UINST_MAX_DEPS; j++)
+			if (uinst->dep[j])
+				x86_uinst_trace_write_int(uinst->dep[j]);
+		if (uinst->size)
+		{
+			x86_uinst_trace_write_diff(uinst->address, trace_ctx->address);
+			x86_uinst_trace_write_int(uinst->size);
+			trace_ctx->address = uinst->address;
+		}
+	}
+
+	/* The instruction finished the context */
+	if (X86ContextGetState(ctx, X86ContextFinished | X86ContextZombie))
+	{
+		gzputc(x86_uinst_trace_file, x86_uinst_trace_record_end);
+		x86_uinst_trace_write_int(ctx->pid);
+	}
+}
+
+
+/* Open a trace for replay, and create the contexts present at the beginning
+ * of the captured simulation. */
+void x86_uinst_replay_init(X86Emu *emu)
+{
+	char magic[X86_UINST_TRACE_MAGIC_SIZE];
+
+	/* Open trace */
+	assert(!x86_uinst_replay_file);
+	x86_uinst_replay_emu = emu;
+	x86_uinst_replay_file = gzopen(x86_uinst_replay_file_name, "rb");
+	if (!x86_uinst_replay_file)
+		fatal("%s: cannot open micro-instruction trace",
+			x86_uinst_replay_file_name);
+	if (gzread(x86_uinst_replay_file, magic, sizeof magic) != sizeof magic ||
+			memcmp(magic, X86_UINST_TRACE_MAGIC, sizeof magic))
+		fatal("%s: not a micro-instruction trace",
+			x86_uinst_replay_file_name);
+
+	/* Contexts are created before any other record is captured */
+	while (x86_uinst_replay_read_record() == x86_uinst_trace_record_create)
+		continue;
+	if (!emu->context_list_head)
+		fatal("%s: no context in micro-instruction trace",
+			x86_uinst_replay_file_name);
+}
+
+
+/* Obtain the address of the next instruction to replay for a context.
+ * Contexts created by the context at this point of the trace are created now.
+ * If no instruction is left, the context is finished and the function returns
+ * false. */
+int x86_uinst_replay_next_eip(X86Context *ctx, unsigned int *eip_ptr)
+{
+	struct x86_uinst_replay_record_t *record;
+	X86Context *child;
+
+	while ((record = x86_uinst_replay_head(ctx)))
+	{
+		switch (record->kind)
+		{
+
+		case x86_uinst_trace_record_inst:
+
+			*eip_ptr = record->eip;
+			return 1;
+
+		case x86_uinst_trace_record_clone:
+		case x86_uinst_trace_record_fork:
+
+			child = record->kind == x86_uinst_trace_record_clone ?
+				new_ctor(X86Context, CreateAndClone, ctx) :
+				new_ctor(X86Context, CreateAndFork, ctx);
+			if (child->pid != record->pid)
+				fatal("%s: context %d created with pid %d",
+					x86_uinst_replay_file_name,
+					record->pid, child->pid);
+			x86_uinst_replay_pop(ctx);
+			x86_uinst_replay_record_free(record);
+			break;
+
+		default:
+
+			x86_uinst_replay_pop(ctx);
+			x86_uinst_replay_record_free(record);
+			X86ContextFinish(ctx, 0);
+			return 0;
+		}
+	}
+
+	/* End of trace */
+	X86ContextFinish(ctx, 0);
+	return 0;
+}
+
+
+/* Replay the next instruction of a context, producing the same effects on the
+ * context as its emulation with 'X86ContextExecute' as seen by the timing
+ * simulator. Its micro-instructions are placed in 'x86_uinst_list'. */
+void x86_uinst_replay_inst(X86Context *ctx)
+{
+	X86Emu *emu = ctx->emu;
+	struct x86_uinst_replay_record_t *record;
+	int i;
+
+	/* Get record */
+	record = x86_uinst_replay_head(ctx);
+	assert(record && record->kind == x86_uinst_trace_record_inst);
+	x86_uinst_replay_pop(ctx);
+
+	/* Instruction */
+	x86_uinst_clear();
+	ctx->last_eip = ctx->curr_eip;
+	ctx->curr_eip = record->eip;
+	ctx->target_eip = record->target;
+	ctx->inst.size = record->size;
+	ctx->regs->eip = record->neip;
+
+	/* Micro-instructions are moved to the list */
+	for (i = 0; i < record->uinst_count; i++)
+	{
+		list_add(x86_uinst_list, record->uinst_array[i]);
+		record->uinst_array[i] = NULL;
+	}
+	x86_uinst_replay_record_free(record);
+
+	/* Statistics */
+	asEmu(emu)->instructions++;
+}
+
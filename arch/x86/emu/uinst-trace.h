@@ -0,0 +1,99 @@
+/*
+ *  Multi2Sim
+ *  Copyright (C) 2012  Rafael Ubal (ubal@ece.neu.edu)
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef ARCH_X86_EMU_UINST_TRACE_H
+#define ARCH_X86_EMU_UINST_TRACE_H
+
+#include <lib/util/class.h>
+
+
+/*
+ * Binary trace of the micro-instructions of the non-speculative x86
+ * instructions executed by every context, compressed with gzip. A trace
+ * captured once can be replayed by the detailed x86 simulation without
+ * emulating the program again.
+ *
+ * The file starts with 'X86_UINST_TRACE_MAGIC', followed by records starting
+ * with a byte indicating the record kind. Integers are stored as unsigned
+ * variable-length quantities (7 bits per byte, least significant first).
+ * Signed differences are stored in zig-zag encoding (sign in the least
+ * significant bit).
+ *
+ * Create record:
+ *	<pid>
+ * Context created by the loader or a checkpoint.
+ *
+ * Clone and fork records:
+ *	<parent pid> <pid>
+ * Context created by a system call of its parent.
+ *
+ * Instruction record:
+ *	<pid> <eip> <size> <neip> <count> [<target>] <uinst>*
+ * Field <eip> is the difference with the address of the instruction following
+ * the previous instruction of the context, and <neip> is the difference
+ * between the address of the next executed instruction and the address
+ * following this instruction. Field <count> is the number of micro-
+ * instructions shifted left by one, plus one if the instruction has a branch
+ * target, given in <target> as a difference with <eip>. Each micro-instruction
+ * is stored as
+ *	<opcode> <mask> <dep>* [<address> <size>]
+ * where bits 0 to 6 of <mask> tell which dependences are present, and bit 7
+ * tells whether the memory access fields are present. Field <address> is the
+ * difference with the address of the previous memory access of the context.
+ *
+ * End record:
+ *	<pid>
+ * The last instruction of the context finished it.
+ */
+
+#define X86_UINST_TRACE_MAGIC  "M2S-UOP1"
+#define X86_UINST_TRACE_MAGIC_SIZE  8
+
+enum x86_uinst_trace_record_t
+{
+	x86_uinst_trace_record_invalid = 0,
+	x86_uinst_trace_record_create,
+	x86_uinst_trace_record_clone,
+	x86_uinst_trace_record_fork,
+	x86_uinst_trace_record_inst,
+	x86_uinst_trace_record_end
+};
+
+extern char *x86_uinst_trace_file_name;
+extern char *x86_uinst_replay_file_name;
+
+/* True if a trace is being captured. */
+extern int x86_uinst_trace_active;
+
+void x86_uinst_trace_init(void);
+void x86_uinst_trace_done(void);
+
+/* Capture */
+void x86_uinst_trace_create(X86Context *ctx);
+void x86_uinst_trace_spawn(X86Context *ctx, enum x86_uinst_trace_record_t kind);
+void x86_uinst_trace_inst(X86Context *ctx);
+
+/* Replay */
+void x86_uinst_replay_init(X86Emu *emu);
+int x86_uinst_replay_next_eip(X86Context *ctx, unsigned int *eip_ptr);
+void x86_uinst_replay_inst(X86Context *ctx);
+
+
+#endif
+
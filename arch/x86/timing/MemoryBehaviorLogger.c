@@ -18,6 +18,10 @@ void X86InsertInMBL(X86Thread *self, unsigned int address, Patterns pattern)
 
 	int index = (address >> ADDRESS_INDEX_SHIFT) % BUFFER_INDEX_SIZE;
 
+	/* Stores can issue after their context was evicted from the thread */
+	if (!Context)
+		return;
+
 	switch(pattern)
 	{
 		case DATA_Pattern:
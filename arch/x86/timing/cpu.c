@@ -20,7 +20,9 @@
 
 #include <arch/x86/emu/context.h>
 #include <arch/x86/emu/emu.h>
+#include <arch/x86/emu/uinst-trace.h>
 #include <lib/esim/esim.h>
+#include <lib/esim/stats.h>
 #include <lib/esim/trace.h>
 #include <lib/mhandle/mhandle.h>
 #include <lib/util/config.h>
@@ -343,6 +345,9 @@ void X86CpuReadConfig(void)
 	x86_cpu_num_threads = config_read_int(config, section, "Threads", x86_cpu_num_threads);
 
 	x86_cpu_fast_forward_count = config_read_llint(config, section, "FastForward", 0);
+	if (x86_cpu_fast_forward_count && *x86_uinst_replay_file_name)
+		fatal("%s: 'FastForward' not supported when replaying a "
+			"micro-instruction trace.", x86_config_file_name);
 
 	x86_cpu_context_quantum = config_read_int(config, section, "ContextQuantum", 100000);
 	x86_cpu_thread_quantum = config_read_int(config, section, "ThreadQuantum", 1000);
@@ -485,6 +490,29 @@ void X86CpuCreate(X86Cpu *self, X86Emu *emu)
 		}
 	}
 
+	/* Interval statistics */
+	stats_register(&self->num_committed_inst, "x86.committed_inst");
+	stats_register(&self->num_committed_uinst, "x86.committed_uinst");
+	stats_register(&self->num_squashed_uinst, "x86.squashed_uinst");
+	stats_register(&self->num_branch_uinst, "x86.branch_uinst");
+	stats_register(&self->num_mispred_branch_uinst, "x86.mispred_branch_uinst");
+	for (i = 0; i < x86_cpu_num_cores; i++)
+	{
+		for (j = 0; j < x86_cpu_num_threads; j++)
+		{
+			thread = self->cores[i]->threads[j];
+			stats_register(&thread->num_fetched_uinst, "x86.%s.fetched_uinst", thread->name);
+			stats_register(&thread->num_squashed_uinst, "x86.%s.squashed_uinst", thread->name);
+			stats_register(&thread->num_mispred_branch_uinst, "x86.%s.mispred_branch_uinst", thread->name);
+			if (!x86_cpu_occupancy_stats)
+				continue;
+			stats_register(&thread->rob_occupancy, "x86.%s.rob_occupancy", thread->name);
+			stats_register(&thread->rob_full, "x86.%s.rob_full", thread->name);
+			stats_register(&thread->iq_full, "x86.%s.iq_full", thread->name);
+			stats_register(&thread->lsq_full, "x86.%s.lsq_full", thread->name);
+		}
+	}
+
 	/* Virtual functions */
 	asObject(self)->Dump = X86CpuDump;
 	asTiming(self)->DumpSummary = X86CpuDumpSummary;
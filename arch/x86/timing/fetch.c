@@ -20,6 +20,7 @@
 
 #include <arch/x86/emu/context.h>
 #include <arch/x86/emu/regs.h>
+#include <arch/x86/emu/uinst-trace.h>
 #include <lib/esim/trace.h>
 #include <lib/util/debug.h>
 #include <lib/util/list.h>
@@ -49,7 +50,7 @@ static int X86ThreadCanFetch(X86Thread *self)
 	X86Cpu *cpu = self->cpu;
 	X86Context *ctx = self->ctx;
 
-	unsigned int phy_addr;
+	unsigned long long phy_addr;
 	unsigned int block;
 
 	/* Context must be running */
@@ -215,6 +216,44 @@ pattern->uinst_ctrl_count
        return 1;
 } 
 
+/* Replay the next instruction of the thread's context from a micro-instruction
+ * trace, instead of emulating it. Since the trace only contains the committed
+ * path, no instruction is fetched on the wrong path after a mispredicted
+ * branch until the pipeline recovers. The function returns false if no
+ * instruction was fetched. */
+static int X86ThreadReplayInst(X86Thread *self)
+{
+	X86Context *ctx = self->ctx;
+	unsigned int eip;
+
+	/* Wrong path, or end of the context */
+	ctx->inst.size = 0;
+	if (X86ContextGetState(ctx, X86ContextSpecMode))
+		return 0;
+	if (!x86_uinst_replay_next_eip(ctx, &eip))
+		return 0;
+
+	/* A change in the control flow not caused by the previous instruction,
+	 * such as the start of the context or a signal handler, redirects
+	 * fetch with no penalty. */
+	if (eip != ctx->regs->eip)
+	{
+		ctx->regs->eip = eip;
+		self->fetch_eip = eip;
+	}
+
+	/* Fetching from an address other than the next instruction in the
+	 * trace enters speculative mode. */
+	X86ContextSetEip(ctx, self->fetch_eip);
+	if (X86ContextGetState(ctx, X86ContextSpecMode))
+		return 0;
+
+	/* Replay */
+	x86_uinst_replay_inst(ctx);
+	return 1;
+}
+
+
 /* Run the emulation of one x86 macro-instruction and create its uops.
  * If any of the uops is a control uop, this uop will be the return value of
  * the function. Otherwise, the first decoded uop is returned. */
@@ -231,10 +270,18 @@ static struct x86_uop_t *X86ThreadFetchInst(X86Thread *self, int fetch_trace_cac
 	int uinst_count;
 	int uinst_index;
 
-	/* Functional simulation */
+	/* Functional simulation, or replay of a micro-instruction trace */
 	self->fetch_eip = self->fetch_neip;
-	X86ContextSetEip(ctx, self->fetch_eip);
-	X86ContextExecute(ctx);
+	if (*x86_uinst_replay_file_name)
+	{
+		if (!X86ThreadReplayInst(self))
+			return NULL;
+	}
+	else
+	{
+		X86ContextSetEip(ctx, self->fetch_eip);
+		X86ContextExecute(ctx);
+	}
 	self->fetch_neip = self->fetch_eip + ctx->inst.size;
 
 	/* If no micro-instruction was generated by this instruction, create a
@@ -293,38 +340,27 @@ static struct x86_uop_t *X86ThreadFetchInst(X86Thread *self, int fetch_trace_cac
 		/* Trace */
 		if (x86_tracing())
 		{
-			char str[MAX_STRING_SIZE];
 			char inst_name[MAX_STRING_SIZE];
 			char uinst_name[MAX_STRING_SIZE];
 
-			char *str_ptr;
+			int print_asm;
 
-			int str_size;
-
-			str_ptr = str;
-			str_size = sizeof str;
-
-			/* Command */
-			str_printf(&str_ptr, &str_size, "x86.new_inst id=%lld core=%d",
-				uop->id_in_core, core->id);
-
-			/* Speculative mode */
-			if (uop->specmode)
-				str_printf(&str_ptr, &str_size, " spec=\"t\"");
-
-			/* Macro-instruction name */
-			if (!uinst_index)
-			{
+			/* Macro-instruction name, not available when
+			 * replaying a micro-instruction trace */
+			print_asm = !uinst_index && !*x86_uinst_replay_file_name;
+			if (print_asm)
 				x86_inst_dump_buf(&ctx->inst, inst_name, sizeof inst_name);
-				str_printf(&str_ptr, &str_size, " asm=\"%s\"", inst_name);
-			}
-
-			/* Rest */
 			x86_uinst_dump_buf(uinst, uinst_name, sizeof uinst_name);
-			str_printf(&str_ptr, &str_size, " uasm=\"%s\" stg=\"fe\"", uinst_name);
 
-			/* Dump */
-			x86_trace("%s\n", str);
+			/* Fields are given as arguments of a single format
+			 * string, so that trace filters can find them. */
+			x86_trace("x86.new_inst id=%lld core=%d%s%s%s%s uasm=\"%s\" stg=\"fe\"\n",
+				uop->id_in_core, core->id,
+				uop->specmode ? " spec=\"t\"" : "",
+				print_asm ? " asm=\"" : "",
+				print_asm ? inst_name : "",
+				print_asm ? "\"" : "",
+				uinst_name);
 		}
 
 		/* Select as returned uop */
@@ -424,7 +460,7 @@ static void X86ThreadFetch(X86Thread *self)
 	X86Context *ctx = self->ctx;
 	struct x86_uop_t *uop;
 
-	unsigned int phy_addr;
+	unsigned long long phy_addr;
 	unsigned int block;
 	unsigned int target;
 
@@ -151,7 +151,7 @@ CLASS_BEGIN(X86Thread, Object)
 	int fetchq_occ;  /* Number of bytes occupied in the fetch queue */
 	int trace_cache_queue_occ;  /* Number of uops occupied in the trace cache queue */
 	unsigned int fetch_block;  /* Virtual address of last fetched block */
-	unsigned int fetch_address;  /* Physical address of last instruction fetch */
+	unsigned long long fetch_address;  /* Physical address of last instruction fetch */
 	long long fetch_access;  /* Module access ID of last instruction fetch */
 	long long fetch_stall_until;  /* Cycle until which fetching is stalled (inclussive) */
 
@@ -50,7 +50,7 @@ struct x86_uop_t
 	unsigned int pred_neip; /* Address of next predicted x86 macro-instruction (for branches) */
 	unsigned int target_neip;  /* Address of target x86 macro-instruction assuming branch taken (for branches) */
 	int specmode;
-	unsigned int fetch_address;  /* Physical address of memory access to fetch this instruction */
+	unsigned long long fetch_address;  /* Physical address of memory access to fetch this instruction */
 	long long fetch_access;  /* Access identifier to fetch this instruction */
 	int trace_cache;  /* Flag telling if uop came from trace cache */
 
@@ -89,7 +89,7 @@ struct x86_uop_t
 	int completed;
 
 	/* For memory uops */
-	unsigned int phy_addr;  /* ... corresponding to 'uop->uinst->address' */
+	unsigned long long phy_addr;  /* ... corresponding to 'uop->uinst->address' */
 
 	/* Cycles */
 	long long when;  /* cycle when ready */
@@ -0,0 +1,812 @@
+/*
+ *  Multi2Sim
+ *  Copyright (C) 2012  Rafael Ubal (ubal@ece.neu.edu)
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+
+#include <dirent.h>
+#include <fcntl.h>
+#include <string.h>
+#include <sys/wait.h>
+#include <time.h>
+#include <unistd.h>
+
+#include <lib/esim/esim.h>
+#include <lib/mhandle/mhandle.h>
+#include <lib/util/config.h>
+#include <lib/util/debug.h>
+#include <lib/util/file.h>
+#include <lib/util/list.h>
+#include <lib/util/misc.h>
+#include <lib/util/string.h>
+#include <lib/util/timer.h>
+#include <mem-system/cache.h>
+#include <mem-system/config.h>
+#include <mem-system/mem-sim.h>
+#include <mem-system/mem-system.h>
+#include <mem-system/memory.h>
+#include <mem-system/module.h>
+#include <network/net-system.h>
+#include <network/network.h>
+#include <network/node.h>
+
+#include "bench.h"
+
+
+/*
+ * Private Variables
+ */
+
+struct bench_result_t
+{
+	long long time;  /* Host time in microseconds */
+	long long ops;
+	long long cycles;
+	long long inst;
+};
+
+typedef void (*bench_func_t)(struct bench_result_t *result);
+
+struct bench_t
+{
+	char *name;
+	char *kind;
+	char *unit;
+	bench_func_t func;
+};
+
+/* Directory for generated inputs and logs */
+static char bench_dir[MAX_PATH_SIZE];
+
+static unsigned int bench_seed;
+
+
+
+
+/*
+ * Private Functions
+ */
+
+/* Deterministic pseudo-random numbers, so that every run of a benchmark
+ * simulates the same workload. */
+static unsigned int bench_random(void)
+{
+	bench_seed = bench_seed * 1103515245 + 12345;
+	return bench_seed >> 8;
+}
+
+
+/* Path of a file in the benchmark directory */
+static char *bench_path(char *name)
+{
+	static char path[MAX_PATH_SIZE];
+
+	if (snprintf(path, sizeof path, "%s/%s", bench_dir, name) >= sizeof path)
+		fatal("%s/%s: path too long", bench_dir, name);
+	return path;
+}
+
+
+/* Run the simulator in a child process with the given arguments, and
+ * return the host time taken in microseconds. The output of the child goes
+ * to the log of the current benchmark. */
+static long long bench_exec(char **argv)
+{
+	struct m2s_timer_t *timer;
+	long long time;
+
+	pid_t pid;
+	int status;
+
+	timer = m2s_timer_create("bench");
+	m2s_timer_start(timer);
+	fflush(NULL);
+	pid = fork();
+	if (pid < 0)
+		fatal("%s: cannot create process", __FUNCTION__);
+	if (!pid)
+	{
+		execv("/proc/self/exe", argv);
+		_exit(1);
+	}
+	if (waitpid(pid, &status, 0) != pid || !WIFEXITED(status) ||
+			WEXITSTATUS(status))
+		fatal("%s: simulation failed", argv[0]);
+	m2s_timer_stop(timer);
+	time = m2s_timer_get_value(timer);
+	m2s_timer_free(timer);
+	return time;
+}
+
+
+
+
+/*
+ * Microbenchmarks
+ */
+
+/* Event scheduling and dispatch. A constant population of events reschedule
+ * themselves with random delays. */
+
+#define BENCH_ESIM_EVENTS  4096
+#define BENCH_ESIM_MAX_DELAY  64
+#define BENCH_ESIM_CYCLES  50000
+
+static long long bench_esim_count;
+
+static void bench_esim_handler(int event, void *data)
+{
+	bench_esim_count++;
+	esim_schedule_event(event, data, bench_random() % BENCH_ESIM_MAX_DELAY + 1);
+}
+
+
+static void bench_esim(struct bench_result_t *result)
+{
+	struct m2s_timer_t *timer;
+	int event;
+	int i;
+
+	/* Initialize */
+	esim_init();
+	event = esim_register_event_with_name(bench_esim_handler,
+			esim_new_domain(1000), "bench");
+	for (i = 0; i < BENCH_ESIM_EVENTS; i++)
+		esim_schedule_event(event, NULL, bench_random() % BENCH_ESIM_MAX_DELAY + 1);
+
+	/* Run */
+	timer = m2s_timer_create("bench");
+	m2s_timer_start(timer);
+	for (i = 0; i < BENCH_ESIM_CYCLES; i++)
+		esim_process_events(TRUE);
+	m2s_timer_stop(timer);
+
+	/* Result */
+	result->time = m2s_timer_get_value(timer);
+	result->ops = bench_esim_count;
+	result->cycles = esim_cycle();
+}
+
+
+/* Cache lookups in a full 512KB cache, with addresses spread over twice its
+ * size, so that about half of the lookups hit. */
+
+#define BENCH_CACHE_SETS  1024
+#define BENCH_CACHE_ASSOC  8
+#define BENCH_CACHE_BLOCK_SIZE  64
+#define BENCH_CACHE_LOOKUPS  20000000
+
+static void bench_cache(struct bench_result_t *result)
+{
+	struct m2s_timer_t *timer;
+	struct cache_t *cache;
+
+	unsigned long long addr;
+	long long hits;
+
+	int set;
+	int way;
+	int i;
+
+	/* Fill cache */
+	cache = cache_create("bench", BENCH_CACHE_SETS, BENCH_CACHE_BLOCK_SIZE,
+			BENCH_CACHE_ASSOC, cache_policy_lru);
+	for (set = 0; set < BENCH_CACHE_SETS; set++)
+		for (way = 0; way < BENCH_CACHE_ASSOC; way++)
+			cache_set_block(cache, set, way, ((unsigned long long) way *
+					BENCH_CACHE_SETS + set) * BENCH_CACHE_BLOCK_SIZE, 1);
+
+	/* Run */
+	hits = 0;
+	timer = m2s_timer_create("bench");
+	m2s_timer_start(timer);
+	for (i = 0; i < BENCH_CACHE_LOOKUPS; i++)
+	{
+		addr = (unsigned long long) (bench_random() % (BENCH_CACHE_SETS *
+				BENCH_CACHE_ASSOC * 2)) * BENCH_CACHE_BLOCK_SIZE;
+		hits += cache_find_block(cache, addr, NULL, NULL, NULL);
+	}
+	m2s_timer_stop(timer);
+
+	/* Result */
+	if (!hits)
+		panic("%s: no cache hits", __FUNCTION__);
+	result->time = m2s_timer_get_value(timer);
+	result->ops = BENCH_CACHE_LOOKUPS;
+	cache_free(cache);
+}
+
+
+/* Guest memory reads and writes of 4 bytes over 16MB */
+
+#define BENCH_MEM_BASE  0x10000000
+#define BENCH_MEM_SIZE  (1 << 24)
+#define BENCH_MEM_ACCESSES  20000000
+
+static void bench_mem(struct bench_result_t *result)
+{
+	struct m2s_timer_t *timer;
+	struct mem_t *mem;
+
+	unsigned int addr;
+	unsigned int value;
+	int i;
+
+	/* Initialize */
+	mem = mem_create();
+	mem_map(mem, BENCH_MEM_BASE, BENCH_MEM_SIZE, mem_access_read | mem_access_write);
+
+	/* Run */
+	value = 0;
+	timer = m2s_timer_create("bench");
+	m2s_timer_start(timer);
+	for (i = 0; i < BENCH_MEM_ACCESSES; i++)
+	{
+		addr = BENCH_MEM_BASE + (bench_random() % BENCH_MEM_SIZE & ~3);
+		if (i & 1)
+			mem_access(mem, addr, 4, &value, mem_access_write);
+		else
+			mem_access(mem, addr, 4, &value, mem_access_read);
+	}
+	m2s_timer_stop(timer);
+
+	/* Result */
+	result->time = m2s_timer_get_value(timer);
+	result->ops = BENCH_MEM_ACCESSES;
+	mem_free(mem);
+}
+
+
+/* Accesses to a two-level cache hierarchy, with up to 16 in flight and
+ * addresses spread over 4MB. One in four accesses is a store. */
+
+#define BENCH_MOD_ACCESSES  100000
+#define BENCH_MOD_IN_FLIGHT  16
+#define BENCH_MOD_SIZE  (1 << 22)
+
+static void bench_mod(struct bench_result_t *result)
+{
+	struct m2s_timer_t *timer;
+	struct config_t *config;
+	struct mod_t *mod;
+
+	enum mod_access_kind_t kind;
+	unsigned long long addr;
+	int issued;
+	int completed;
+
+	/* Memory configuration */
+	config = config_create(bench_path("mem-config"));
+	config_write_int(config, "CacheGeometry bench-l1", "Sets", 64);
+	config_write_int(config, "CacheGeometry bench-l1", "Assoc", 4);
+	config_write_int(config, "CacheGeometry bench-l1", "BlockSize", 64);
+	config_write_int(config, "CacheGeometry bench-l1", "Latency", 2);
+	config_write_int(config, "CacheGeometry bench-l2", "Sets", 512);
+	config_write_int(config, "CacheGeometry bench-l2", "Assoc", 8);
+	config_write_int(config, "CacheGeometry bench-l2", "BlockSize", 64);
+	config_write_int(config, "CacheGeometry bench-l2", "Latency", 20);
+	config_write_string(config, "Module bench-l1", "Type", "Cache");
+	config_write_string(config, "Module bench-l1", "Geometry", "bench-l1");
+	config_write_string(config, "Module bench-l1", "LowNetwork", "bench-l1-l2");
+	config_write_string(config, "Module bench-l1", "LowModules", "bench-l2");
+	config_write_string(config, "Module bench-l2", "Type", "Cache");
+	config_write_string(config, "Module bench-l2", "Geometry", "bench-l2");
+	config_write_string(config, "Module bench-l2", "HighNetwork", "bench-l1-l2");
+	config_write_string(config, "Module bench-l2", "LowNetwork", "bench-l2-mm");
+	config_write_string(config, "Module bench-l2", "LowModules", "bench-mm");
+	config_write_string(config, "Module bench-mm", "Type", "MainMemory");
+	config_write_int(config, "Module bench-mm", "BlockSize", 64);
+	config_write_int(config, "Module bench-mm", "Latency", 100);
+	config_write_string(config, "Module bench-mm", "HighNetwork", "bench-l2-mm");
+	config_write_int(config, "Network bench-l1-l2", "DefaultInputBufferSize", 1024);
+	config_write_int(config, "Network bench-l1-l2", "DefaultOutputBufferSize", 1024);
+	config_write_int(config, "Network bench-l1-l2", "DefaultBandwidth", 256);
+	config_write_int(config, "Network bench-l2-mm", "DefaultInputBufferSize", 1024);
+	config_write_int(config, "Network bench-l2-mm", "DefaultOutputBufferSize", 1024);
+	config_write_int(config, "Network bench-l2-mm", "DefaultBandwidth", 256);
+	config_write_int(config, "Entry bench", "Core", 0);
+	config_write_string(config, "Entry bench", "Module", "bench-l1");
+	config_save(config);
+	config_free(config);
+
+	/* Initialize. The entry is read as in trace-driven simulation, with
+	 * accesses issued here instead of read from a trace. */
+	mem_config_file_name = bench_path("mem-config");
+	mem_sim_trace_file_name = mem_config_file_name;
+	debug_init();
+	esim_init();
+	net_init();
+	mem_system_init();
+	mod = mem_sim_get_entry(0);
+
+	/* Run */
+	issued = 0;
+	completed = 0;
+	timer = m2s_timer_create("bench");
+	m2s_timer_start(timer);
+	esim_process_events(TRUE);
+	while (completed < BENCH_MOD_ACCESSES)
+	{
+		while (issued < BENCH_MOD_ACCESSES && issued - completed < BENCH_MOD_IN_FLIGHT)
+		{
+			addr = bench_random() % BENCH_MOD_SIZE & ~63;
+			if (!mod_can_access(mod, addr))
+				break;
+			kind = bench_random() % 4 ? mod_access_load : mod_access_store;
+			mod_access(mod, kind, addr, &completed, NULL, NULL,
+					mod_client_info_create(mod));
+			issued++;
+		}
+		esim_process_events(TRUE);
+	}
+	m2s_timer_stop(timer);
+
+	/* Result */
+	result->time = m2s_timer_get_value(timer);
+	result->ops = completed;
+	result->cycles = esim_domain_cycle(mem_domain_index);
+}
+
+
+/* Messages of 16 bytes injected at random end nodes of an 8x8 mesh towards
+ * random destinations. Messages that cannot be injected are discarded. */
+
+#define BENCH_NET_SIZE  8
+#define BENCH_NET_CYCLES  20000
+#define BENCH_NET_MSG_SIZE  16
+#define BENCH_NET_INJECTION  8  /* Percentage */
+
+static void bench_net_write_config(char *file_name)
+{
+	struct config_t *config;
+	char *section = "Network.bench";
+
+	config = config_create(file_name);
+	config_write_int(config, section, "DefaultInputBufferSize", 64);
+	config_write_int(config, section, "DefaultOutputBufferSize", 64);
+	config_write_int(config, section, "DefaultBandwidth", 8);
+	config_write_string(config, section, "Topology", "Mesh2D");
+	config_write_int(config, section, "Width", BENCH_NET_SIZE);
+	config_write_int(config, section, "Height", BENCH_NET_SIZE);
+	config_save(config);
+	config_free(config);
+}
+
+
+static void bench_net(struct bench_result_t *result)
+{
+	struct m2s_timer_t *timer;
+	struct list_t *end_node_list;
+	struct net_node_t *src_node;
+	struct net_node_t *dst_node;
+	struct net_node_t *node;
+	struct net_t *net;
+
+	long long sent;
+	int cycle;
+	int i;
+
+	/* Initialize */
+	net_config_file_name = bench_path("net-config");
+	bench_net_write_config(net_config_file_name);
+	debug_init();
+	esim_init();
+	net_init();
+	net = net_find("bench");
+	end_node_list = list_create();
+	LIST_FOR_EACH(net->node_list, i)
+	{
+		node = list_get(net->node_list, i);
+		if (node->kind == net_node_end)
+			list_add(end_node_list, node);
+	}
+
+	/* Run */
+	sent = 0;
+	timer = m2s_timer_create("bench");
+	m2s_timer_start(timer);
+	esim_process_events(TRUE);
+	for (cycle = 0; cycle < BENCH_NET_CYCLES; cycle++)
+	{
+		LIST_FOR_EACH(end_node_list, i)
+		{
+			if (bench_random() % 100 >= BENCH_NET_INJECTION)
+				continue;
+			src_node = list_get(end_node_list, i);
+			dst_node = list_get(end_node_list, bench_random() %
+					list_count(end_node_list));
+			if (src_node == dst_node || !net_can_send(net, src_node,
+					dst_node, BENCH_NET_MSG_SIZE))
+				continue;
+			net_send(net, src_node, dst_node, BENCH_NET_MSG_SIZE);
+			sent++;
+		}
+		esim_process_events(TRUE);
+	}
+	m2s_timer_stop(timer);
+
+	/* Result */
+	result->time = m2s_timer_get_value(timer);
+	result->ops = sent;
+	result->cycles = esim_domain_cycle(net_domain_index);
+	list_free(end_node_list);
+}
+
+
+
+
+/*
+ * Reference Workloads
+ */
+
+/* Statically linked x86 program. Its only section '.text' contains
+ *
+ *	mov $125000, %ecx
+ *	xor %eax, %eax
+ *	mov $0x8049000, %esi  # 4KB in section '.bss'
+ * loop:
+ *	mov %ecx, %edx
+ *	and $0x3ff, %edx
+ *	mov (%esi,%edx,4), %ebx
+ *	add %ecx, %ebx
+ *	mov %ebx, (%esi,%edx,4)
+ *	add %ebx, %eax
+ *	dec %ecx
+ *	jne loop
+ *	mov $1, %eax  # exit(0)
+ *	xor %ebx, %ebx
+ *	int $0x80
+ *
+ * running one million instructions. */
+static unsigned char bench_x86_program[] =
+{
+	0x7f, 0x45, 0x4c, 0x46, 0x01, 0x01, 0x01, 0x00, 0x00, 0x00, 0x00, 0x00,
+	0x00, 0x00, 0x00, 0x00, 0x02, 0x00, 0x03, 0x00, 0x01, 0x00, 0x00, 0x00,
+	0x54, 0x80, 0x04, 0x08, 0x34, 0x00, 0x00, 0x00, 0x94, 0x00, 0x00, 0x00,
+	0x00, 0x00, 0x00, 0x00, 0x34, 0x00, 0x20, 0x00, 0x01, 0x00, 0x28, 0x00,
+	0x04, 0x00, 0x02, 0x00, 0x01, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+	0x00, 0x80, 0x04, 0x08, 0x00, 0x80, 0x04, 0x08, 0x7e, 0x00, 0x00, 0x00,
+	0x00, 0x30, 0x00, 0x00, 0x07, 0x00, 0x00, 0x00, 0x00, 0x10, 0x00, 0x00,
+	0xb9, 0x48, 0xe8, 0x01, 0x00, 0x31, 0xc0, 0xbe, 0x00, 0x90, 0x04, 0x08,
+	0x89, 0xca, 0x81, 0xe2, 0xff, 0x03, 0x00, 0x00, 0x8b, 0x1c, 0x96, 0x01,
+	0xcb, 0x89, 0x1c, 0x96, 0x01, 0xd8, 0x49, 0x75, 0xeb, 0xb8, 0x01, 0x00,
+	0x00, 0x00, 0x31, 0xdb, 0xcd, 0x80, 0x00, 0x2e, 0x74, 0x65, 0x78, 0x74,
+	0x00, 0x2e, 0x73, 0x68, 0x73, 0x74, 0x72, 0x74, 0x61, 0x62, 0x00, 0x2e,
+	0x62, 0x73, 0x73, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+	0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+	0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+	0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x01, 0x00, 0x00, 0x00,
+	0x01, 0x00, 0x00, 0x00, 0x06, 0x00, 0x00, 0x00, 0x54, 0x80, 0x04, 0x08,
+	0x54, 0x00, 0x00, 0x00, 0x2a, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+	0x00, 0x00, 0x00, 0x00, 0x10, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+	0x07, 0x00, 0x00, 0x00, 0x03, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+	0x00, 0x00, 0x00, 0x00, 0x7e, 0x00, 0x00, 0x00, 0x16, 0x00, 0x00, 0x00,
+	0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x01, 0x00, 0x00, 0x00,
+	0x00, 0x00, 0x00, 0x00, 0x11, 0x00, 0x00, 0x00, 0x08, 0x00, 0x00, 0x00,
+	0x03, 0x00, 0x00, 0x00, 0x00, 0x90, 0x04, 0x08, 0x00, 0x10, 0x00, 0x00,
+	0x00, 0x10, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+	0x04, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+};
+
+
+/* Detailed simulation of the x86 program. Simulated cycles and instructions
+ * are obtained from a statistics file with one sample. */
+static void bench_x86(struct bench_result_t *result)
+{
+	struct list_t *token_list;
+	FILE *f;
+
+	char program[MAX_PATH_SIZE];
+	char stats[MAX_PATH_SIZE];
+	char line[MAX_LONG_STRING_SIZE];
+
+	int cycle_index;
+	int inst_index;
+	int err;
+
+	char *argv[] = { "m2s", "--x86-sim", "detailed", "--stats", stats,
+			"--stats-interval", "1000000000000000", program, NULL };
+
+	/* Program */
+	snprintf(program, sizeof program, "%s", bench_path("x86-program"));
+	snprintf(stats, sizeof stats, "%s", bench_path("x86-stats.csv"));
+	f = file_open_for_write(program);
+	if (!f || fwrite(bench_x86_program, sizeof bench_x86_program, 1, f) != 1)
+		fatal("%s: cannot write file", program);
+	file_close(f);
+
+	/* Run */
+	result->time = bench_exec(argv);
+
+	/* Column names */
+	f = file_open_for_read(stats);
+	if (!f || !fgets(line, sizeof line, f) || !strchr(line, '\n'))
+		fatal("%s: cannot read statistics", stats);
+	token_list = str_token_list_create(line, ",\n");
+	cycle_index = str_token_list_find(token_list, "x86.cycle");
+	inst_index = str_token_list_find(token_list, "x86.inst");
+	str_token_list_free(token_list);
+	if (cycle_index < 0 || inst_index < 0)
+		fatal("%s: x86 counters not found", stats);
+
+	/* Add up samples */
+	while (fgets(line, sizeof line, f))
+	{
+		token_list = str_token_list_create(line, ",\n");
+		if (list_count(token_list) <= MAX(cycle_index, inst_index))
+			fatal("%s: invalid statistics", stats);
+		result->cycles += str_to_llint(list_get(token_list, cycle_index), &err);
+		if (!err)
+			result->inst += str_to_llint(list_get(token_list, inst_index), &err);
+		if (err)
+			fatal("%s: invalid statistics", stats);
+		str_token_list_free(token_list);
+	}
+	file_close(f);
+	result->ops = result->inst;
+}
+
+
+/* Synthetic uniform traffic with '--net-sim' in the network of the
+ * microbenchmark, taking the number of transfers from the report. */
+
+#define BENCH_NET_SIM_CYCLES  200000
+
+static void bench_net_sim(struct bench_result_t *result)
+{
+	struct config_t *config;
+
+	char net_config[MAX_PATH_SIZE];
+	char report[MAX_PATH_SIZE];
+	char cycles[MAX_STRING_SIZE];
+
+	char *argv[] = { "m2s", "--net-config", net_config, "--net-sim", "bench",
+			"--net-max-cycles", cycles, "--net-injection-rate", "0.02",
+			"--net-msg-size", "16", "--net-report", report, NULL };
+
+	/* Inputs */
+	snprintf(net_config, sizeof net_config, "%s", bench_path("net-config"));
+	snprintf(report, sizeof report, "%s", bench_path("net-report"));
+	snprintf(cycles, sizeof cycles, "%d", BENCH_NET_SIM_CYCLES);
+	bench_net_write_config(net_config);
+
+	/* Run */
+	result->time = bench_exec(argv);
+	result->cycles = BENCH_NET_SIM_CYCLES;
+
+	/* Transfers */
+	config = config_create(report);
+	config_load(config);
+	result->ops = config_read_llint(config, "Network.bench.General", "Transfers", 0);
+	config_free(config);
+}
+
+
+/* DRAM simulation of random reads and writes to two channels, with one
+ * request issued every other cycle. */
+
+#define BENCH_DRAM_REQUESTS  50000
+#define BENCH_DRAM_CYCLES  200000
+
+static void bench_dram_sim(struct bench_result_t *result)
+{
+	struct config_t *config;
+
+	char dram_config[MAX_PATH_SIZE];
+	char cycles[MAX_STRING_SIZE];
+	char var[MAX_STRING_SIZE];
+	char request[MAX_STRING_SIZE];
+
+	char *argv[] = { "m2s", "--dram-config", dram_config, "--dram-sim",
+			"bench", "--dram-max-cycles", cycles, NULL };
+
+	int i;
+
+	/* Configuration with two controllers of 256MB and the requests */
+	snprintf(dram_config, sizeof dram_config, "%s", bench_path("dram-config"));
+	snprintf(cycles, sizeof cycles, "%d", BENCH_DRAM_CYCLES);
+	config = config_create(dram_config);
+	config_write_int(config, "DRAMsystem.bench", "NumLogicalChannels", 2);
+	config_write_int(config, "DRAMsystem.bench.Controller.c0", "NumRanks", 2);
+	config_write_int(config, "DRAMsystem.bench.Controller.c0", "NumBanksPerDevice", 8);
+	config_write_int(config, "DRAMsystem.bench.Controller.c1", "NumRanks", 2);
+	config_write_int(config, "DRAMsystem.bench.Controller.c1", "NumBanksPerDevice", 8);
+	for (i = 0; i < BENCH_DRAM_REQUESTS; i++)
+	{
+		snprintf(var, sizeof var, "Request[%d]", i);
+		snprintf(request, sizeof request, "%d %s %x", i * 2 + 1,
+				bench_random() % 2 ? "READ" : "WRITE",
+				bench_random() % (1 << 29) & ~63);
+		config_write_string(config, "DRAMsystem.bench.Requests", var, request);
+	}
+	config_save(config);
+	config_free(config);
+
+	/* Run */
+	result->time = bench_exec(argv);
+	result->ops = BENCH_DRAM_REQUESTS;
+	result->cycles = BENCH_DRAM_CYCLES;
+}
+
+
+static struct bench_t bench_list[] =
+{
+	{ "esim_schedule_event", "micro", "events", bench_esim },
+	{ "cache_find_block", "micro", "lookups", bench_cache },
+	{ "mem_access", "micro", "accesses", bench_mem },
+	{ "mod_access", "micro", "accesses", bench_mod },
+	{ "net_send", "micro", "messages", bench_net },
+	{ "x86", "workload", "instructions", bench_x86 },
+	{ "net-sim", "workload", "transfers", bench_net_sim },
+	{ "dram-sim", "workload", "requests", bench_dram_sim },
+	{ NULL }
+};
+
+
+/* Run a benchmark in a child process with its output redirected to a log
+ * file, and return its result through a pipe. */
+static void bench_run_one(struct bench_t *bench, struct bench_result_t *result)
+{
+	char log[MAX_PATH_SIZE];
+	int pipe_fd[2];
+	int log_fd;
+	int status;
+	pid_t pid;
+
+	snprintf(log, sizeof log, "%s.log", bench->name);
+	snprintf(log, sizeof log, "%s", bench_path(log));
+	if (pipe(pipe_fd))
+		fatal("%s: cannot create pipe", __FUNCTION__);
+	fflush(NULL);
+	pid = fork();
+	if (pid < 0)
+		fatal("%s: cannot create process", __FUNCTION__);
+
+	/* Child */
+	if (!pid)
+	{
+		close(pipe_fd[0]);
+		log_fd = open(log, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+		if (log_fd < 0)
+			fatal("%s: cannot create file", log);
+		dup2(log_fd, 1);
+		dup2(log_fd, 2);
+		close(log_fd);
+		memset(result, 0, sizeof(struct bench_result_t));
+		bench_seed = 1;
+		bench->func(result);
+		if (write(pipe_fd[1], result, sizeof(struct bench_result_t)) !=
+				sizeof(struct bench_result_t))
+			_exit(1);
+		fflush(NULL);
+		_exit(0);
+	}
+
+	/* Parent */
+	close(pipe_fd[1]);
+	if (read(pipe_fd[0], result, sizeof(struct bench_result_t)) !=
+			sizeof(struct bench_result_t) || waitpid(pid, &status, 0) != pid ||
+			!WIFEXITED(status) || WEXITSTATUS(status))
+		fatal("benchmark '%s' failed.\n"
+			"\tPlease see the output of the benchmark in '%s'.",
+			bench->name, log);
+	close(pipe_fd[0]);
+}
+
+
+static void bench_dump(struct bench_t *bench, struct bench_result_t *result,
+		FILE *f)
+{
+	double time;
+
+	time = result->time ? (double) result->time / 1.0e6 : 1.0e-6;
+	fprintf(f, "\t\t{\n");
+	fprintf(f, "\t\t\t\"name\": \"%s\",\n", bench->name);
+	fprintf(f, "\t\t\t\"kind\": \"%s\",\n", bench->kind);
+	fprintf(f, "\t\t\t\"unit\": \"%s\",\n", bench->unit);
+	fprintf(f, "\t\t\t\"time\": %.6f,\n", time);
+	fprintf(f, "\t\t\t\"ops\": %lld,\n", result->ops);
+	fprintf(f, "\t\t\t\"ops_per_second\": %.0f", result->ops / time);
+	if (result->cycles)
+	{
+		fprintf(f, ",\n\t\t\t\"cycles\": %lld", result->cycles);
+		fprintf(f, ",\n\t\t\t\"cycles_per_second\": %.0f", result->cycles / time);
+	}
+	if (result->inst)
+	{
+		fprintf(f, ",\n\t\t\t\"inst\": %lld", result->inst);
+		fprintf(f, ",\n\t\t\t\"kips\": %.2f", result->inst / time / 1000.0);
+	}
+	fprintf(f, "\n\t\t}");
+}
+
+
+
+
+/*
+ * Public Functions
+ */
+
+void bench_run(char *file_name)
+{
+	struct bench_result_t result;
+	struct bench_t *bench;
+
+	struct dirent *entry;
+	DIR *dir;
+
+	char date[MAX_STRING_SIZE];
+	time_t now;
+	FILE *f;
+
+	/* Output file */
+	f = file_open_for_write(file_name);
+	if (!f)
+		fatal("%s: cannot open benchmark results file", file_name);
+
+	/* Directory for inputs */
+	snprintf(bench_dir, sizeof bench_dir, "/tmp/m2s-bench-XXXXXX");
+	if (!mkdtemp(bench_dir))
+		fatal("%s: cannot create directory", bench_dir);
+
+	/* Header */
+	now = time(NULL);
+	strftime(date, sizeof date, "%Y-%m-%dT%H:%M:%S", localtime(&now));
+	fprintf(f, "{\n");
+	fprintf(f, "\t\"version\": \"%s\",\n", VERSION);
+	fprintf(f, "\t\"date\": \"%s\",\n", date);
+	fprintf(f, "\t\"benchmarks\": [\n");
+
+	/* Run benchmarks */
+	fprintf(stderr, "%-20s %10s %27s %16s %12s\n", "Benchmark", "Time [s]",
+			"Operations/s", "Cycles/s", "KIPS");
+	for (bench = bench_list; bench->name; bench++)
+	{
+		bench_run_one(bench, &result);
+		bench_dump(bench, &result, f);
+		fprintf(f, "%s\n", bench[1].name ? "," : "");
+
+		/* Summary */
+		fprintf(stderr, "%-20s %10.2f %14.0f %-12s", bench->name,
+				(double) result.time / 1.0e6, result.ops * 1.0e6 /
+				MAX(result.time, 1), bench->unit);
+		if (result.cycles)
+			fprintf(stderr, " %16.0f", result.cycles * 1.0e6 / MAX(result.time, 1));
+		else
+			fprintf(stderr, " %16s", "-");
+		if (result.inst)
+			fprintf(stderr, " %12.2f", result.inst * 1.0e3 / MAX(result.time, 1));
+		else
+			fprintf(stderr, " %12s", "-");
+		fprintf(stderr, "\n");
+	}
+
+	/* Close */
+	fprintf(f, "\t]\n");
+	fprintf(f, "}\n");
+	file_close(f);
+	fprintf(stderr, "Results saved in '%s'\n", file_name);
+
+	/* Remove inputs and logs */
+	dir = opendir(bench_dir);
+	while (dir && (entry = readdir(dir)))
+		if (entry->d_name[0] != '.')
+			unlink(bench_path(entry->d_name));
+	if (dir)
+		closedir(dir);
+	rmdir(bench_dir);
+}
@@ -0,0 +1,68 @@
+/*
+ *  Multi2Sim
+ *  Copyright (C) 2012  Rafael Ubal (ubal@ece.neu.edu)
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+
+#ifndef BENCH_H
+#define BENCH_H
+
+
+/*
+ * Built-in benchmarks of the simulator, run with option '--bench'. The suite
+ * contains microbenchmarks of the hot paths of the event-driven library, the
+ * memory hierarchy, guest memory, and the network, which run the same
+ * deterministic workload in every execution, and reference workloads
+ * running complete simulations with inputs generated by the suite: an x86
+ * program in detailed simulation, a synthetic network simulation
+ * ('--net-sim'), and a DRAM simulation ('--dram-sim').
+ *
+ * Each benchmark runs in a separate process. Results are given as host time,
+ * operations per second of the benchmarked function, and simulated cycles
+ * per second and thousands of instructions per second (KIPS) where they
+ * apply, and saved in a JSON file with format
+ *
+ *	{
+ *		"version": "<version>",
+ *		"date": "<date>",
+ *		"benchmarks": [
+ *			{
+ *				"name": "<name>",
+ *				"kind": "micro" | "workload",
+ *				"unit": "<operation>",
+ *				"time": <seconds>,
+ *				"ops": <count>,
+ *				"ops_per_second": <value>,
+ *				"cycles": <count>,
+ *				"cycles_per_second": <value>,
+ *				"inst": <count>,
+ *				"kips": <value>
+ *			},
+ *			...
+ *		]
+ *	}
+ *
+ * Fields 'cycles' and 'cycles_per_second' are omitted in benchmarks without
+ * simulated time, and fields 'inst' and 'kips' in benchmarks without
+ * simulated instructions.
+ */
+
+void bench_run(char *file_name);
+
+
+#endif
+
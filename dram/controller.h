@@ -106,7 +106,7 @@ struct dram_controller_t
 	char *name;
 
 	unsigned int id;
-	unsigned int lowest_addr, highest_addr;
+	unsigned long long lowest_addr, highest_addr;
 	unsigned int num_physical_channels;
 	unsigned int request_queue_depth;
 	//unsigned int dram_controller_command_queue_depth;	//FIXME: figure out how to implement fixed size command queue
@@ -165,7 +165,7 @@ struct dram_system_t *dram_system_config_with_file(struct config_t *config, char
 {
 	int j;
 	int controller_sections = 0;
-	unsigned int highest_addr = 0;
+	unsigned long long highest_addr = 0;
 	char *section;
 	char section_str[MAX_STRING_SIZE];
 	char *row_buffer_policy_map[] = {"OpenPage", "ClosePage", "hybird"};
@@ -271,7 +271,7 @@ struct dram_system_t *dram_system_config_with_file(struct config_t *config, char
 		else
 			controller->lowest_addr = highest_addr + 1;
 
-		controller->highest_addr = controller->lowest_addr + ((dram_num_bits_per_column * dram_num_devices_per_rank) / 8 * dram_num_columns_per_row * dram_num_rows_per_bank * dram_num_banks_per_device * dram_num_ranks * num_physical_channels) - 1;
+		controller->highest_addr = controller->lowest_addr + ((unsigned long long) (dram_num_bits_per_column * dram_num_devices_per_rank) / 8 * dram_num_columns_per_row * dram_num_rows_per_bank * dram_num_banks_per_device * dram_num_ranks * num_physical_channels) - 1;
 
 		controller->dram_addr_bits_rank = log_base2(dram_num_ranks);
 		controller->dram_addr_bits_row = log_base2(dram_num_rows_per_bank);
@@ -406,7 +406,7 @@ void dram_system_process(struct dram_system_t *system)
 
 
 void dram_decode_address(struct dram_system_t *system,
-		unsigned int addr,
+		unsigned long long addr,
 		unsigned int *logical_channel_id_ptr,
 		unsigned int *rank_id_ptr,
 		unsigned int *row_id_ptr,
@@ -415,14 +415,14 @@ void dram_decode_address(struct dram_system_t *system,
 		unsigned int *physical_channel_id_ptr)
 {
 	int i;
-	unsigned int local_addr;
+	unsigned long long local_addr;
 	struct dram_controller_t *controller;
 
 	/* Look for the corresponding controller */
 	for (i = 0; i < system->num_logical_channels; i++)
 	{
 		controller = list_get(system->dram_controller_list, i);
-		if ((addr > controller->lowest_addr) && (addr < controller->highest_addr))
+		if ((addr >= controller->lowest_addr) && (addr <= controller->highest_addr))
 		{
 			local_addr = addr - controller->lowest_addr;
 
@@ -451,7 +451,7 @@ void dram_decode_address(struct dram_system_t *system,
 }
 
 
-unsigned int dram_encode_address(struct dram_system_t *system,
+unsigned long long dram_encode_address(struct dram_system_t *system,
 		unsigned int logical_channel_id,
 		unsigned int rank_id,
 		unsigned int row_id,
@@ -459,7 +459,7 @@ unsigned int dram_encode_address(struct dram_system_t *system,
 		unsigned int column_id,
 		unsigned int physical_channel_id)
 {
-	unsigned int addr;
+	unsigned long long addr;
 	struct dram_controller_t *controller;
 
 	/* Locate controller */
@@ -73,14 +73,14 @@ struct dram_system_t *dram_system_config_with_file(struct config_t *config,
 int dram_system_get_request(struct dram_system_t *system);
 void dram_system_process(struct dram_system_t *system);
 void dram_decode_address(struct dram_system_t *system,
-			unsigned int addr,
+			unsigned long long addr,
 			unsigned int *logical_channel_id_ptr,
 			unsigned int *rank_id_ptr,
 			unsigned int *row_id_ptr,
 			unsigned int *bank_id_ptr,
 			unsigned int *column_id_ptr,
 			unsigned int *physical_channel_id_ptr);
-unsigned int dram_encode_address(struct dram_system_t *system,
+unsigned long long dram_encode_address(struct dram_system_t *system,
 			unsigned int logical_channel_id,
 			unsigned int rank_id,
 			unsigned int row_id,
@@ -125,7 +125,7 @@ struct dram_request_t *request_file_accessor_get(struct request_file_accessor *a
 
 	/* Read Address */
 	str_token_list_shift(token_list);
-	sscanf(str_token_list_first(token_list), "%x", &request->addr);
+	sscanf(str_token_list_first(token_list), "%llx", &request->addr);
 
 	/* Assign request ID */
 	request->id = ++accessor->request_id_counter;
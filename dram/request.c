@@ -59,15 +59,15 @@ static long long dram_request_get_llint(struct list_t *token_list,
 	return request_cycle;
 }
 
-static unsigned int dram_request_get_hex_address(struct list_t *token_list,
+static unsigned long long dram_request_get_hex_address(struct list_t *token_list,
 		char *request_line)
 {
-	unsigned int request_address;
+	unsigned long long request_address;
 
 	/* Read cycle */
 	dram_request_expect(token_list, request_line);
 
-	sscanf(str_token_list_first(token_list), "%x", &request_address);
+	sscanf(str_token_list_first(token_list), "%llx", &request_address);
 	/* Shift token and return */
 	str_token_list_shift(token_list);
 	return request_address;
@@ -124,7 +124,7 @@ void dram_request_dump(struct dram_request_t *dram_request, FILE *f)
 
 	}
 
-	fprintf(f, "addr: %08X\n", dram_request->addr);
+	fprintf(f, "addr: %08llX\n", dram_request->addr);
 }
 
 void dram_request_handler (int event, void *data)
@@ -50,7 +50,7 @@ struct dram_request_t
 {
 	long long id;
 	long long cycle;
-	unsigned int addr;
+	unsigned long long addr;
 	enum dram_request_type_t type;
 	struct dram_system_t *system;
 };
@@ -487,7 +487,6 @@ int cuda_func_cuMemcpyHtoD(X86Context *ctx)
 	unsigned int dstDevice;
 	unsigned int srcHost;
 	unsigned int ByteCount;
-	void *buf;
 
 	dstDevice = regs->ecx;
 	srcHost = regs->edx;
@@ -498,10 +497,7 @@ int cuda_func_cuMemcpyHtoD(X86Context *ctx)
 	cuda_debug("\tin: ByteCount=%u\n", ByteCount);
 
 	/* Copy */
-	buf = xmalloc(ByteCount);
-	mem_read(mem, srcHost, ByteCount, buf);
-	mem_write(frm_emu->global_mem, dstDevice, ByteCount, buf);
-	free(buf);
+	mem_transfer(frm_emu->global_mem, dstDevice, mem, srcHost, ByteCount);
 
 	return 0;
 }
@@ -533,7 +529,6 @@ int cuda_func_cuMemcpyDtoH(X86Context *ctx)
 	unsigned int dstHost;
 	unsigned int srcDevice;
 	unsigned int ByteCount;
-	void *buf;
 
 	dstHost = regs->ecx;
 	srcDevice = regs->edx;
@@ -544,10 +539,7 @@ int cuda_func_cuMemcpyDtoH(X86Context *ctx)
 	cuda_debug("\tin: ByteCount=%u\n", ByteCount);
 
 	/* Copy */
-	buf = xmalloc(ByteCount);
-	mem_read(frm_emu->global_mem, srcDevice, ByteCount, buf);
-	mem_write(mem, dstHost, ByteCount, buf);
-	free(buf);
+	mem_transfer(mem, dstHost, frm_emu->global_mem, srcDevice, ByteCount);
 
 	return 0;
 }
@@ -678,7 +678,6 @@ int evg_opencl_clCreateBuffer_impl(X86Context *ctx, int *argv)
 
 	char flags_str[MAX_STRING_SIZE];
 	int zero = 0;
-	void *buf;
 
 	str_map_flags(&create_buffer_flags_map, flags, flags_str, sizeof(flags_str));
 	evg_opencl_debug("  context=0x%x, flags=%s, size=%d, host_ptr=0x%x, errcode_ret=0x%x\n",
@@ -708,10 +707,7 @@ int evg_opencl_clCreateBuffer_impl(X86Context *ctx, int *argv)
 
 	/* If 'host_ptr' was specified, copy buffer into device memory */
 	if (host_ptr) {
-		buf = xmalloc(size);
-		mem_read(mem, host_ptr, size, buf);
-		mem_write(evg_emu->global_mem, opencl_mem->device_ptr, size, buf);
-		free(buf);
+		mem_transfer(evg_emu->global_mem, opencl_mem->device_ptr, mem, host_ptr, size);
 	}
 
 	/* Return success */
@@ -1738,8 +1734,6 @@ void evg_opencl_clEnqueueReadBuffer_wakeup(X86Context *ctx, void *data)
 	struct evg_opencl_mem_t *opencl_mem;
 	struct evg_opencl_event_t *event;
 
-	void *buf;
-
 	int code;
 
 	/* Read function arguments again */
@@ -1756,10 +1750,7 @@ void evg_opencl_clEnqueueReadBuffer_wakeup(X86Context *ctx, void *data)
 				evg_err_opencl_param_note);
 
 	/* Copy buffer from device memory to host memory */
-	buf = xmalloc(argv.cb);
-	mem_read(evg_emu->global_mem, opencl_mem->device_ptr + argv.offset, argv.cb, buf);
-	mem_write(ctx->mem, argv.ptr, argv.cb, buf);
-	free(buf);
+	mem_transfer(ctx->mem, argv.ptr, evg_emu->global_mem, opencl_mem->device_ptr + argv.offset, argv.cb);
 
 	/* Event */
 	if (argv.event_ptr)
@@ -1839,8 +1830,6 @@ void evg_opencl_clEnqueueWriteBuffer_wakeup(X86Context *ctx, void *data)
 	struct evg_opencl_mem_t *opencl_mem;
 	struct evg_opencl_event_t *event;
 
-	void *buf;
-
 	int code;
 
 	/* Read function arguments again */
@@ -1857,10 +1846,7 @@ void evg_opencl_clEnqueueWriteBuffer_wakeup(X86Context *ctx, void *data)
 				evg_err_opencl_param_note);
 
 	/* Copy buffer from host memory to device memory */
-	buf = xmalloc(argv.cb);
-	mem_read(ctx->mem, argv.ptr, argv.cb, buf);
-	mem_write(evg_emu->global_mem, opencl_mem->device_ptr + argv.offset, argv.cb, buf);
-	free(buf);
+	mem_transfer(evg_emu->global_mem, opencl_mem->device_ptr + argv.offset, ctx->mem, argv.ptr, argv.cb);
 
 	/* Event */
 	if (argv.event_ptr)
@@ -1940,7 +1926,6 @@ void evg_opencl_clEnqueueCopyBuffer_wakeup(X86Context *ctx, void *data)
 	struct evg_opencl_mem_t *dst_mem;
 	struct evg_opencl_event_t *event;
 
-	void *buf;
 	int code;
 
 	/* Read function arguments again */
@@ -1958,10 +1943,7 @@ void evg_opencl_clEnqueueCopyBuffer_wakeup(X86Context *ctx, void *data)
 		fatal("%s: buffer storage exceeded\n%s", __FUNCTION__, evg_err_opencl_param_note);
 
 	/* Copy buffers */
-	buf = xmalloc(argv.cb);
-	mem_read(evg_emu->global_mem, src_mem->device_ptr + argv.src_offset, argv.cb, buf);
-	mem_write(evg_emu->global_mem, dst_mem->device_ptr + argv.dst_offset, argv.cb, buf);
-	free(buf);
+	mem_transfer(evg_emu->global_mem, dst_mem->device_ptr + argv.dst_offset, evg_emu->global_mem, src_mem->device_ptr + argv.src_offset, argv.cb);
 
 	/* Event */
 	if (argv.event_ptr)
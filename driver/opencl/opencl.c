@@ -275,8 +275,6 @@ static int opencl_abi_si_mem_read_impl(X86Context *ctx)
 	unsigned int device_ptr;
 	unsigned int size;
 
-	void *buf;
-
 	/* Arguments */
 	host_ptr = regs->ecx;
 	device_ptr = regs->edx;
@@ -290,10 +288,7 @@ static int opencl_abi_si_mem_read_impl(X86Context *ctx)
 				__FUNCTION__);
 
 	/* Read memory from device to host */
-	buf = xmalloc(size);
-	mem_read(si_emu->video_mem, device_ptr, size, buf);
-	mem_write(mem, host_ptr, size, buf);
-	free(buf);
+	mem_transfer(mem, host_ptr, si_emu->video_mem, device_ptr, size);
 
 	/* Return */
 	return 0;
@@ -333,8 +328,6 @@ static int opencl_abi_si_mem_write_impl(X86Context *ctx)
 	unsigned int host_ptr;
 	unsigned int size;
 
-	void *buf;
-
 	/* Arguments */
 	device_ptr = regs->ecx;
 	host_ptr = regs->edx;
@@ -348,10 +341,7 @@ static int opencl_abi_si_mem_write_impl(X86Context *ctx)
 				__FUNCTION__);
 
 	/* Write memory from host to device */
-	buf = xmalloc(size);
-	mem_read(mem, host_ptr, size, buf);
-	mem_write(si_emu->video_mem, device_ptr, size, buf);
-	free(buf);
+	mem_transfer(si_emu->video_mem, device_ptr, mem, host_ptr, size);
 
 	/* Return */
 	return 0;
@@ -391,8 +381,6 @@ static int opencl_abi_si_mem_copy_impl(X86Context *ctx)
 	unsigned int src_ptr;
 	unsigned int size;
 
-	void *buf;
-
 	/* Arguments */
 	dest_ptr = regs->ecx;
 	src_ptr = regs->edx;
@@ -407,10 +395,7 @@ static int opencl_abi_si_mem_copy_impl(X86Context *ctx)
 				__FUNCTION__);
 
 	/* Write memory from host to device */
-	buf = xmalloc(size);
-	mem_read(si_emu->video_mem, src_ptr, size, buf);
-	mem_write(si_emu->video_mem, dest_ptr, size, buf);
-	free(buf);
+	mem_transfer(si_emu->video_mem, dest_ptr, si_emu->video_mem, src_ptr, size);
 
 	/* Return */
 	return 0;
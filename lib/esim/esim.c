@@ -18,9 +18,11 @@
  */
 
 #include <assert.h>
+#include <time.h>
 
 #include <lib/mhandle/mhandle.h>
 #include <lib/util/debug.h>
+#include <lib/util/file.h>
 #include <lib/util/heap.h>
 #include <lib/util/linked-list.h>
 #include <lib/util/list.h>
@@ -39,6 +41,12 @@
  * queuing of events that will cause an infinite loop (1M events). */
 #define ESIM_MAX_FINALIZATION_EVENTS  10000000
 
+/* Number of buckets in the histogram of scheduling distances of the event
+ * profiler. Bucket 0 counts events scheduled for the current cycle, and bucket
+ * 'i' counts distances in [2^(i-1), 2^i). The last bucket counts all longer
+ * distances. */
+#define ESIM_PROFILE_DISTANCE_BUCKETS  16
+
 
 static char *esim_err_finalization =
 	"\tThe finalization process of the event-driven simulation is trying to\n"
@@ -120,6 +128,9 @@ int esim_frequency;
 /* Number of main loop iterations with no forwarded time */
 long long esim_no_forward_cycles;
 
+/* Event profiler report */
+char *esim_profile_file_name = "";
+
 
 
 /* List of registered events. Each element is of type 'struct
@@ -137,6 +148,16 @@ static struct linked_list_t *esim_end_event_list;
 /* Global timer */
 static struct m2s_timer_t *esim_timer;
 
+/* Event profiler. Host time is measured in time-stamp counter ticks, and
+ * converted into nanoseconds using the global timer when the report is
+ * dumped. Ticks spent in nested event handlers executed with
+ * 'esim_execute_event' are accumulated in 'esim_profile_child_ticks' and
+ * discounted from the caller. */
+static int esim_profile;
+static long long esim_profile_start_ticks;
+static long long esim_profile_child_ticks;
+static int esim_profile_max_heap_count;
+
 
 
 /*
@@ -259,6 +280,14 @@ struct esim_event_info_t
 	char *name;
 	esim_event_handler_t handler;
 	struct esim_domain_t *domain;
+
+	/* Profiler statistics */
+	long long dispatch_count;
+	long long dispatch_ticks;
+	long long schedule_count;
+	long long distance_hist[ESIM_PROFILE_DISTANCE_BUCKETS];
+	int in_flight_count;
+	int max_in_flight_count;
 };
 
 
@@ -322,10 +351,203 @@ void esim_event_free(struct esim_event_t *event)
 
 
 
+/*
+ * Event Profiler
+ */
+
+/* Return a host time stamp with the cheapest clock available. */
+static long long esim_profile_ticks(void)
+{
+#if defined(__i386__) || defined(__x86_64__)
+	unsigned int lo, hi;
+
+	__asm__ volatile ("rdtsc" : "=a" (lo), "=d" (hi));
+	return ((long long) hi << 32) | lo;
+#else
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (long long) ts.tv_sec * 1000000000ll + ts.tv_nsec;
+#endif
+}
+
+
+/* Record an event scheduled 'cycles' cycles ahead of the current cycle in its
+ * frequency domain. */
+static void esim_profile_schedule(struct esim_event_info_t *event_info, int cycles)
+{
+	int bucket;
+
+	/* Scheduling distance histogram */
+	bucket = 0;
+	while (cycles > 0 && bucket < ESIM_PROFILE_DISTANCE_BUCKETS - 1)
+	{
+		cycles >>= 1;
+		bucket++;
+	}
+	event_info->distance_hist[bucket]++;
+	event_info->schedule_count++;
+
+	/* In-flight events */
+	event_info->in_flight_count++;
+	event_info->max_in_flight_count = MAX(event_info->max_in_flight_count,
+		event_info->in_flight_count);
+	esim_profile_max_heap_count = MAX(esim_profile_max_heap_count,
+		esim_event_heap->count);
+}
+
+
+/* Compare events by decreasing host time, then by decreasing count */
+static int esim_profile_compare(const void *ptr1, const void *ptr2)
+{
+	struct esim_event_info_t *event_info1 = *(struct esim_event_info_t **) ptr1;
+	struct esim_event_info_t *event_info2 = *(struct esim_event_info_t **) ptr2;
+
+	if (event_info1->dispatch_ticks != event_info2->dispatch_ticks)
+		return event_info1->dispatch_ticks < event_info2->dispatch_ticks ? 1 : -1;
+	if (event_info1->dispatch_count != event_info2->dispatch_count)
+		return event_info1->dispatch_count < event_info2->dispatch_count ? 1 : -1;
+	return event_info1->id - event_info2->id;
+}
+
+
+static void esim_profile_dump(FILE *f)
+{
+	struct esim_event_info_t **event_info_array;
+	struct esim_event_info_t *event_info;
+
+	long long total_ticks;
+	long long total_count;
+	double ns_per_tick;
+	double time_ns;
+
+	int count;
+	int index;
+	int i;
+
+	/* Nanoseconds per tick, calibrated against the global timer */
+	total_ticks = esim_profile_ticks() - esim_profile_start_ticks;
+	ns_per_tick = total_ticks > 0 ? esim_real_time() * 1000.0 / total_ticks : 0.0;
+
+	/* Sort events with activity */
+	count = 0;
+	total_ticks = 0;
+	total_count = 0;
+	event_info_array = xcalloc(list_count(esim_event_info_list),
+		sizeof(struct esim_event_info_t *));
+	LIST_FOR_EACH(esim_event_info_list, index)
+	{
+		event_info = list_get(esim_event_info_list, index);
+		if (!event_info->dispatch_count && !event_info->schedule_count)
+			continue;
+		event_info_array[count++] = event_info;
+		total_ticks += event_info->dispatch_ticks;
+		total_count += event_info->dispatch_count;
+	}
+	qsort(event_info_array, count, sizeof(struct esim_event_info_t *),
+		esim_profile_compare);
+
+	/* Intro */
+	fprintf(f, "; Host time profile of event-driven simulation\n");
+	fprintf(f, ";    Count - Number of times the event handler was executed\n");
+	fprintf(f, ";    Time - Host time in the event handler in milliseconds, excluding\n");
+	fprintf(f, ";        nested handlers run with 'esim_execute_event'\n");
+	fprintf(f, ";    %%Time - Fraction of the total host time spent in event handlers\n");
+	fprintf(f, ";    ns/Event - Average host time per execution in nanoseconds\n");
+	fprintf(f, ";    MaxInFlight - Maximum number of events of this type in the heap\n");
+	fprintf(f, ";    Distance - Scheduling distances in cycles of the event's frequency\n");
+	fprintf(f, ";        domain, as 'range:count' pairs\n");
+	fprintf(f, "\n");
+
+	/* Summary */
+	fprintf(f, "SimulationTime = %.2f [s]\n", esim_real_time() / 1.0e6);
+	fprintf(f, "EventTime = %.2f [s]\n", total_ticks * ns_per_tick / 1.0e9);
+	fprintf(f, "Events = %lld\n", total_count);
+	fprintf(f, "MaxHeapEvents = %d\n", esim_profile_max_heap_count);
+	fprintf(f, "\n");
+
+	/* Table */
+	fprintf(f, "%-40s %12s %10s %6s %9s %11s  %s\n", "Event", "Count",
+		"Time", "%Time", "ns/Event", "MaxInFlight", "Distance");
+	for (i = 0; i < count; i++)
+	{
+		event_info = event_info_array[i];
+		time_ns = event_info->dispatch_ticks * ns_per_tick;
+		fprintf(f, "%-40s %12lld %10.2f %6.2f %9.1f %11d ",
+			event_info->name, event_info->dispatch_count,
+			time_ns / 1.0e6,
+			total_ticks ? 100.0 * event_info->dispatch_ticks / total_ticks : 0.0,
+			event_info->dispatch_count ? time_ns / event_info->dispatch_count : 0.0,
+			event_info->max_in_flight_count);
+		for (index = 0; index < ESIM_PROFILE_DISTANCE_BUCKETS; index++)
+		{
+			if (!event_info->distance_hist[index])
+				continue;
+			if (index <= 1)
+				fprintf(f, " %d", index);
+			else if (index == ESIM_PROFILE_DISTANCE_BUCKETS - 1)
+				fprintf(f, " %d+", 1 << (index - 1));
+			else
+				fprintf(f, " %d-%d", 1 << (index - 1), (1 << index) - 1);
+			fprintf(f, ":%lld", event_info->distance_hist[index]);
+		}
+		fprintf(f, "\n");
+	}
+
+	/* Free */
+	free(event_info_array);
+}
+
+
+
+
 /*
  * Private Functions
  */
 
+/* Run the handler of an event, recording its host time if the event profiler
+ * is active. */
+static void esim_dispatch_event(struct esim_event_info_t *event_info, int id,
+	void *data)
+{
+	long long child_ticks;
+	long long ticks;
+
+	/* Profiler not active */
+	assert(event_info && event_info->handler);
+	if (!esim_profile)
+	{
+		event_info->handler(id, data);
+		return;
+	}
+
+	/* Run handler */
+	child_ticks = esim_profile_child_ticks;
+	esim_profile_child_ticks = 0;
+	ticks = esim_profile_ticks();
+	event_info->handler(id, data);
+	ticks = esim_profile_ticks() - ticks;
+
+	/* Record */
+	event_info->dispatch_count++;
+	event_info->dispatch_ticks += ticks - esim_profile_child_ticks;
+	esim_profile_child_ticks = child_ticks + ticks;
+}
+
+
+/* Dispatch an event extracted from the heap or from the list of end events */
+static void esim_dispatch_scheduled_event(struct esim_event_t *event)
+{
+	struct esim_event_info_t *event_info;
+
+	event_info = list_get(esim_event_info_list, event->id);
+	if (esim_profile)
+		event_info->in_flight_count--;
+	esim_dispatch_event(event_info, event->id, event->data);
+	esim_event_free(event);
+}
+
+
 /* Drain events in the heap. If this operation stalls after exceeding a limit
  * in the number of events, return non-zero. Zero is success. */
 static int esim_drain_heap(void)
@@ -333,7 +555,6 @@ static int esim_drain_heap(void)
 	int count = 0;
 
 	struct esim_event_t *event;
-	struct esim_event_info_t *event_info;
 
 	long long when;
 
@@ -348,10 +569,7 @@ static int esim_drain_heap(void)
 		/* Process it */
 		count++;
 		esim_time = when;
-		event_info = list_get(esim_event_info_list, event->id);
-		assert(event_info && event_info->handler);
-		event_info->handler(event->id, event->data);
-		esim_event_free(event);
+		esim_dispatch_scheduled_event(event);
 
 		/* Interrupt heap draining after exceeding a given number of
 		 * events. This can happen if the event handlers of processed
@@ -397,14 +615,36 @@ void esim_init()
 	/* Register special events */
 	ESIM_EV_INVALID = esim_register_event_with_name(NULL, 0, "Invalid");
 	ESIM_EV_NONE = esim_register_event_with_name(NULL, 0, "None");
+
+	/* Event profiler */
+	if (*esim_profile_file_name)
+	{
+		if (!file_can_open_for_write(esim_profile_file_name))
+			fatal("%s: cannot open event profile file",
+				esim_profile_file_name);
+		esim_profile = 1;
+		esim_profile_start_ticks = esim_profile_ticks();
+	}
 }
 
 
 void esim_done()
 {
 	void *elem;
+	FILE *f;
 	int index;
 
+	/* Dump event profile */
+	if (esim_profile)
+	{
+		f = file_open_for_write(esim_profile_file_name);
+		if (f)
+		{
+			esim_profile_dump(f);
+			file_close(f);
+		}
+	}
+
 	/* Free list of frequency domains */
 	LIST_FOR_EACH(esim_domain_list, index)
 	{
@@ -558,6 +798,8 @@ void esim_schedule_event(int event_index, void *data, int cycles)
 	/* Create event and insert in heap */
 	event = esim_event_create(event_index, data);
 	heap_insert(esim_event_heap, when, event);
+	if (esim_profile)
+		esim_profile_schedule(event_info, cycles);
 
 	/* Warn when heap is overloaded */
 	if (!esim_overload_shown && esim_event_heap->count >= ESIM_OVERLOAD_EVENTS)
@@ -590,6 +832,8 @@ void esim_schedule_end_event(int id, void *data)
 	/* Initialize and insert */
 	event = esim_event_create(id, data);
 	linked_list_add(esim_end_event_list, event);
+	if (esim_profile)
+		esim_profile_schedule(list_get(esim_event_info_list, id), 0);
 }
 
 
@@ -611,8 +855,7 @@ void esim_execute_event(int id, void *data)
 	
 	/* Execute event handler */
 	event_info = list_get(esim_event_info_list, id);
-	assert(event_info && event_info->handler);
-	event_info->handler(id, data);
+	esim_dispatch_event(event_info, id, data);
 }
 
 
@@ -621,7 +864,6 @@ void esim_process_events(int forward)
 	long long when;
 
 	struct esim_event_t *event;
-	struct esim_event_info_t *event_info;
 	
 	/* Check if any action is actually needed. Events will be checked and
 	 * global time will be advanced only if argument 'forward' is set or
@@ -646,10 +888,7 @@ void esim_process_events(int forward)
 		
 		/* Process it */
 		heap_extract(esim_event_heap, NULL);
-		event_info = list_get(esim_event_info_list, event->id);
-		assert(event_info && event_info->handler);
-		event_info->handler(event->id, event->data);
-		esim_event_free(event);
+		esim_dispatch_scheduled_event(event);
 	}
 	
 	/* Next simulation cycle */
@@ -660,7 +899,6 @@ void esim_process_events(int forward)
 void esim_process_all_events(void)
 {
 	struct esim_event_t *event;
-	struct esim_event_info_t *event_info;
 	int err;
 
 	/* Drain all previous events */
@@ -680,10 +918,7 @@ void esim_process_all_events(void)
 		linked_list_remove(esim_end_event_list);
 
 		/* Process it */
-		event_info = list_get(esim_event_info_list, event->id);
-		assert(event_info && event_info->handler);
-		event_info->handler(event->id, event->data);
-		esim_event_free(event);
+		esim_dispatch_scheduled_event(event);
 	}
 	
 	/* Drain heap again with new events */
@@ -694,7 +929,6 @@ void esim_process_all_events(void)
 void esim_empty(void)
 {
 	struct esim_event_t *event;
-	struct esim_event_info_t *event_info;
 	
 	/* Lock event scheduling, so no event will be
 	 * inserted into the heap */
@@ -709,10 +943,7 @@ void esim_empty(void)
 			break;
 		
 		/* Process it */
-		event_info = list_get(esim_event_info_list, event->id);
-		assert(event_info && event_info->handler);
-		event_info->handler(event->id, event->data);
-		esim_event_free(event);
+		esim_dispatch_scheduled_event(event);
 	}
 	
 	/* Unlock event scheduling */
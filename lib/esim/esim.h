@@ -85,6 +85,10 @@ extern long long esim_cycle_time;
  * all architectures performing only a functional simulation. */
 extern long long esim_no_forward_cycles;
 
+/* File to dump a host time profile of event handlers. The profiler is only
+ * active if this variable is set before calling 'esim_init()'. */
+extern char *esim_profile_file_name;
+
 /* Empty event. When this event is scheduled, it will be ignored */
 extern int ESIM_EV_NONE;
 
@@ -0,0 +1,449 @@
+/*
+ *  Multi2Sim
+ *  Copyright (C) 2012  Rafael Ubal (ubal@ece.neu.edu)
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include <stdarg.h>
+#include <stdint.h>
+#include <string.h>
+#include <zlib.h>
+
+#include <lib/mhandle/mhandle.h>
+#include <lib/util/debug.h>
+#include <lib/util/file.h>
+#include <lib/util/list.h>
+#include <lib/util/string.h>
+
+#include "esim.h"
+#include "stats.h"
+
+
+/*
+ * Global Variables
+ */
+
+long long stats_interval = 10000;
+int stats_binary;
+int stats_active;
+
+
+
+
+/*
+ * Private Variables
+ */
+
+struct stats_counter_t
+{
+	char *name;
+	long long *counter;
+
+	/* Value in the previous sample */
+	long long last;
+};
+
+static char *stats_file_name;
+static FILE *stats_file;
+static gzFile stats_gz_file;
+
+/* List of counters, of type 'struct stats_counter_t' */
+static struct list_t *stats_counter_list;
+
+/* Number of samples taken, and cycle of the last one */
+static long long stats_num_samples;
+static long long stats_last_cycle;
+
+/* Next sample, in cycles and in simulated picoseconds */
+static long long stats_next_cycle;
+static long long stats_next_time;
+
+/* Samples not written yet in binary format, with one cycle and one
+ * increment per counter each. */
+static long long *stats_block;
+static int stats_block_count;
+
+/* Cycle of the last sample written in binary format, or 0 */
+static long long stats_block_cycle;
+
+
+
+
+/*
+ * Private Functions
+ */
+
+static void stats_write_int(unsigned long long value)
+{
+	unsigned char buf[10];
+	int size;
+
+	size = 0;
+	while (value >= 0x80)
+	{
+		buf[size++] = (value & 0x7f) | 0x80;
+		value >>= 7;
+	}
+	buf[size++] = value;
+	if (gzwrite(stats_gz_file, buf, size) != size)
+		fatal("%s: cannot write statistics file", stats_file_name);
+}
+
+
+static void stats_write_signed(long long value)
+{
+	stats_write_int(((unsigned long long) value << 1) ^ (value >> 63));
+}
+
+
+/* Column names, written when the first sample is taken */
+static void stats_write_header(void)
+{
+	struct stats_counter_t *counter;
+	int i;
+
+	if (stats_binary)
+	{
+		stats_write_int(list_count(stats_counter_list));
+		LIST_FOR_EACH(stats_counter_list, i)
+		{
+			counter = list_get(stats_counter_list, i);
+			stats_write_int(strlen(counter->name));
+			gzwrite(stats_gz_file, counter->name, strlen(counter->name));
+		}
+		stats_block = xcalloc(STATS_BLOCK_SIZE * (list_count(stats_counter_list) + 1),
+				sizeof(long long));
+		return;
+	}
+
+	fprintf(stats_file, "cycle");
+	LIST_FOR_EACH(stats_counter_list, i)
+	{
+		counter = list_get(stats_counter_list, i);
+		fprintf(stats_file, ",%s", counter->name);
+	}
+	fprintf(stats_file, "\n");
+}
+
+
+/* Write buffered samples of a binary file as one block */
+static void stats_write_block(void)
+{
+	long long cycle;
+
+	int num_columns;
+	int i;
+	int j;
+
+	if (!stats_block_count)
+		return;
+
+	/* Cycles */
+	num_columns = list_count(stats_counter_list) + 1;
+	stats_write_int(stats_block_count);
+	for (i = 0; i < stats_block_count; i++)
+	{
+		cycle = stats_block[i * num_columns];
+		stats_write_int(cycle - stats_block_cycle);
+		stats_block_cycle = cycle;
+	}
+
+	/* Increments */
+	for (j = 1; j < num_columns; j++)
+		for (i = 0; i < stats_block_count; i++)
+			stats_write_signed(stats_block[i * num_columns + j]);
+	stats_block_count = 0;
+}
+
+
+static void stats_sample(long long cycle)
+{
+	struct stats_counter_t *counter;
+	long long *row;
+	long long value;
+	int i;
+
+	/* First sample */
+	if (!stats_num_samples)
+		stats_write_header();
+	stats_num_samples++;
+	stats_last_cycle = cycle;
+
+	/* Binary sample */
+	if (stats_binary)
+	{
+		row = stats_block + stats_block_count *
+				(list_count(stats_counter_list) + 1);
+		row[0] = cycle;
+		LIST_FOR_EACH(stats_counter_list, i)
+		{
+			counter = list_get(stats_counter_list, i);
+			value = *counter->counter;
+			row[i + 1] = value - counter->last;
+			counter->last = value;
+		}
+		if (++stats_block_count == STATS_BLOCK_SIZE)
+			stats_write_block();
+		return;
+	}
+
+	/* CSV sample */
+	fprintf(stats_file, "%lld", cycle);
+	LIST_FOR_EACH(stats_counter_list, i)
+	{
+		counter = list_get(stats_counter_list, i);
+		value = *counter->counter;
+		fprintf(stats_file, ",%lld", value - counter->last);
+		counter->last = value;
+	}
+	fprintf(stats_file, "\n");
+}
+
+
+
+
+/*
+ * Public Functions
+ */
+
+void stats_init(char *file_name)
+{
+	/* No statistics */
+	if (!file_name || !*file_name)
+		return;
+
+	/* Open file */
+	if (stats_interval < 1)
+		fatal("%s: invalid statistics interval", __FUNCTION__);
+	stats_file_name = xstrdup(file_name);
+	if (stats_binary)
+	{
+		stats_gz_file = gzopen(file_name, "wb");
+		if (!stats_gz_file || gzwrite(stats_gz_file, STATS_MAGIC,
+				STATS_MAGIC_SIZE) != STATS_MAGIC_SIZE)
+			fatal("%s: cannot open statistics file", file_name);
+	}
+	else
+	{
+		stats_file = file_open_for_write(file_name);
+		if (!stats_file)
+			fatal("%s: cannot open statistics file", file_name);
+	}
+
+	/* Initialize */
+	stats_counter_list = list_create();
+	stats_next_cycle = stats_interval;
+	stats_active = 1;
+}
+
+
+void stats_done(void)
+{
+	struct stats_counter_t *counter;
+	int i;
+
+	/* Nothing if not active */
+	if (!stats_active)
+		return;
+
+	/* Last sample. Column names are written even if there is none. */
+	if (esim_cycle_time && esim_cycle() > stats_last_cycle)
+		stats_sample(esim_cycle());
+	if (!stats_num_samples)
+		stats_write_header();
+
+	/* Close file */
+	if (stats_binary)
+	{
+		stats_write_block();
+		gzclose(stats_gz_file);
+		free(stats_block);
+	}
+	else
+	{
+		file_close(stats_file);
+	}
+
+	/* Free counters */
+	LIST_FOR_EACH(stats_counter_list, i)
+	{
+		counter = list_get(stats_counter_list, i);
+		free(counter->name);
+		free(counter);
+	}
+	list_free(stats_counter_list);
+	free(stats_file_name);
+	stats_active = 0;
+}
+
+
+void stats_register(long long *counter, char *fmt, ...)
+{
+	struct stats_counter_t *stats_counter;
+	char name[MAX_STRING_SIZE];
+	va_list va;
+
+	/* Nothing if not active */
+	if (!stats_active)
+		return;
+
+	/* Columns cannot change once written */
+	if (stats_num_samples)
+		panic("%s: counter registered after first sample", __FUNCTION__);
+
+	/* Create */
+	va_start(va, fmt);
+	vsnprintf(name, sizeof name, fmt, va);
+	va_end(va);
+	stats_counter = xcalloc(1, sizeof(struct stats_counter_t));
+	stats_counter->name = xstrdup(name);
+	stats_counter->counter = counter;
+	stats_counter->last = *counter;
+	list_add(stats_counter_list, stats_counter);
+}
+
+
+void stats_update(void)
+{
+	long long cycle;
+
+	/* Compare simulated time first, avoiding a division in most calls */
+	if (esim_time < stats_next_time || !esim_cycle_time)
+		return;
+
+	/* Sample */
+	cycle = esim_cycle();
+	if (cycle >= stats_next_cycle)
+	{
+		stats_sample(cycle);
+		stats_next_cycle = (cycle / stats_interval + 1) * stats_interval;
+	}
+
+	/* Time of cycle 'stats_next_cycle' */
+	stats_next_time = (stats_next_cycle - 1) * esim_cycle_time;
+}
+
+
+
+
+/*
+ * Statistics Dump
+ */
+
+static unsigned long long stats_read_int(gzFile f, char *file_name)
+{
+	unsigned long long value;
+	int shift;
+	int c;
+
+	value = 0;
+	shift = 0;
+	do
+	{
+		c = gzgetc(f);
+		if (c < 0 || shift > 63)
+			fatal("%s: invalid statistics file", file_name);
+		value |= (unsigned long long) (c & 0x7f) << shift;
+		shift += 7;
+	} while (c & 0x80);
+	return value;
+}
+
+
+static long long stats_read_signed(gzFile f, char *file_name)
+{
+	unsigned long long value;
+
+	value = stats_read_int(f, file_name);
+	return (long long) (value >> 1) ^ -(long long) (value & 1);
+}
+
+
+void stats_dump(char *file_name, FILE *f)
+{
+	unsigned long long value;
+
+	long long *block;
+	long long cycle;
+
+	char magic[STATS_MAGIC_SIZE];
+	char name[MAX_STRING_SIZE];
+
+	int num_columns;
+	int num_samples;
+	int c;
+	int i;
+	int j;
+
+	gzFile gz_file;
+
+	/* Open */
+	gz_file = gzopen(file_name, "rb");
+	if (!gz_file)
+		fatal("%s: cannot open statistics file", file_name);
+	if (gzread(gz_file, magic, sizeof magic) != sizeof magic ||
+			memcmp(magic, STATS_MAGIC, STATS_MAGIC_SIZE))
+		fatal("%s: not a binary statistics file", file_name);
+
+	/* Column names */
+	value = stats_read_int(gz_file, file_name);
+	if (value > INT32_MAX / STATS_BLOCK_SIZE / sizeof(long long) - 1)
+		fatal("%s: invalid statistics file", file_name);
+	num_columns = value + 1;
+	fprintf(f, "cycle");
+	for (j = 1; j < num_columns; j++)
+	{
+		value = stats_read_int(gz_file, file_name);
+		if (value >= sizeof name || gzread(gz_file, name, value) != value)
+			fatal("%s: invalid statistics file", file_name);
+		name[value] = '\0';
+		fprintf(f, ",%s", name);
+	}
+	fprintf(f, "\n");
+
+	/* Blocks */
+	cycle = 0;
+	block = xcalloc(STATS_BLOCK_SIZE * num_columns, sizeof(long long));
+	while ((c = gzgetc(gz_file)) >= 0)
+	{
+		gzungetc(c, gz_file);
+		value = stats_read_int(gz_file, file_name);
+		if (!value || value > STATS_BLOCK_SIZE)
+			fatal("%s: invalid statistics file", file_name);
+		num_samples = value;
+		for (i = 0; i < num_samples; i++)
+		{
+			cycle += stats_read_int(gz_file, file_name);
+			block[i * num_columns] = cycle;
+		}
+		for (j = 1; j < num_columns; j++)
+			for (i = 0; i < num_samples; i++)
+				block[i * num_columns + j] = stats_read_signed(gz_file, file_name);
+
+		/* Print samples */
+		for (i = 0; i < num_samples; i++)
+		{
+			fprintf(f, "%lld", block[i * num_columns]);
+			for (j = 1; j < num_columns; j++)
+				fprintf(f, ",%lld", block[i * num_columns + j]);
+			fprintf(f, "\n");
+		}
+	}
+
+	/* Close */
+	free(block);
+	gzclose(gz_file);
+}
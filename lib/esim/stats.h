@@ -0,0 +1,79 @@
+/*
+ *  Multi2Sim
+ *  Copyright (C) 2012  Rafael Ubal (ubal@ece.neu.edu)
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef LIB_ESIM_STATS_H
+#define LIB_ESIM_STATS_H
+
+#include <stdio.h>
+
+
+/*
+ * Interval statistics. Components register their event counters once with
+ * 'stats_register', and all counters are sampled every 'stats_interval'
+ * cycles of the fastest frequency domain. Each sample contains the cycle when
+ * it was taken and the increment of every counter since the previous sample.
+ * A last sample is taken at the end of the simulation.
+ *
+ * In CSV format, the first line contains column names 'cycle,<counter>,...',
+ * followed by one line per sample.
+ *
+ * The binary format is a gzip-compressed file starting with 'STATS_MAGIC',
+ * and integers are stored as in the binary simulation trace (see 'trace.h').
+ *	<num_counters> (<length> <name>)*
+ * Then blocks of up to 'STATS_BLOCK_SIZE' samples stored by columns:
+ *	<num_samples> <cycle>* (<increment>*)*
+ * Cycles are stored as differences with the previous sample (or 0), and
+ * increments as signed integers.
+ */
+
+#define STATS_MAGIC  "M2S-STA1"
+#define STATS_MAGIC_SIZE  8
+
+#define STATS_BLOCK_SIZE  256
+
+/* Sampling interval in cycles */
+extern long long stats_interval;
+
+/* Write samples in binary format */
+extern int stats_binary;
+
+/* True if a statistics file was given in 'stats_init' */
+extern int stats_active;
+
+void stats_init(char *file_name);
+
+/* Take the last sample and close the file. Must be called before components
+ * holding registered counters are freed. */
+void stats_done(void);
+
+/* Register a counter under a name given as a format string. Ignored if
+ * statistics are not active. */
+void stats_register(long long *counter, char *fmt, ...)
+	__attribute__ ((format (printf, 2, 3)));
+
+/* Take a sample if the sampling interval elapsed. Must be called in every
+ * iteration of the simulation loop if statistics are active. */
+void stats_update(void);
+
+/* Print a binary statistics file in CSV format */
+void stats_dump(char *file_name, FILE *f);
+
+
+#endif
+
@@ -18,44 +18,916 @@
  */
 
 #include <assert.h>
+#include <ctype.h>
+#include <fcntl.h>
+#include <pthread.h>
 #include <stdarg.h>
+#include <stdint.h>
+#include <string.h>
+#include <unistd.h>
 #include <zlib.h>
 
 #include <lib/mhandle/mhandle.h>
 #include <lib/util/debug.h>
+#include <lib/util/hash-table.h>
 #include <lib/util/list.h>
+#include <lib/util/misc.h>
+#include <lib/util/string.h>
 
 #include "esim.h"
+#include "trace.h"
 
 
-static gzFile trace_file;
+int trace_text;
+int trace_enabled;
+
+static FILE *trace_file;
 static struct list_t *trace_category_list;
 
-enum trace_status_t
+enum trace_status_t
+{
+	trace_status_invalid = 0,
+	trace_status_on,
+	trace_status_off
+};
+
+struct trace_category_t
+{
+	enum trace_status_t status;
+};
+
+
+
+
+/*
+ * Format Strings
+ */
+
+/* Type of the argument consumed by a conversion */
+enum trace_arg_t
+{
+	trace_arg_none = 0,  /* Conversion '%%' */
+	trace_arg_int,
+	trace_arg_long,
+	trace_arg_long_long,
+	trace_arg_size,
+	trace_arg_double,
+	trace_arg_string,
+	trace_arg_pointer
+};
+
+struct trace_conv_t
+{
+	/* Position of the conversion in the format string, from 'begin'
+	 * to 'end' (not included). */
+	int begin;
+	int end;
+
+	enum trace_arg_t arg;
+
+	/* Precision of a string conversion, or -1 */
+	int precision;
+
+	/* Filter on the field printed by the conversion, or NULL */
+	struct trace_filter_t *filter;
+};
+
+struct trace_format_t
+{
+	int id;
+	char *fmt;
+
+	int num_convs;
+	struct trace_conv_t *convs;
+
+	/* Number of conversions with a filter */
+	int num_filters;
+};
+
+
+/* Parse the conversions in a format string. The string is not copied. */
+static struct trace_format_t *trace_format_create(char *fmt)
+{
+	struct trace_format_t *format;
+	struct trace_conv_t *conv;
+
+	int length;
+	int i;
+
+	/* Initialize */
+	format = xcalloc(1, sizeof(struct trace_format_t));
+	format->fmt = fmt;
+	for (i = 0; fmt[i]; i++)
+		if (fmt[i] == '%')
+			format->num_convs++;
+	format->convs = xcalloc(format->num_convs + 1, sizeof(struct trace_conv_t));
+
+	/* Conversions */
+	format->num_convs = 0;
+	for (i = 0; fmt[i]; i++)
+	{
+		if (fmt[i] != '%')
+			continue;
+
+		/* Flags and width */
+		conv = &format->convs[format->num_convs++];
+		conv->begin = i++;
+		conv->precision = -1;
+		while (fmt[i] && strchr("-+ #0", fmt[i]))
+			i++;
+		while (isdigit(fmt[i]))
+			i++;
+
+		/* Precision */
+		if (fmt[i] == '.')
+		{
+			conv->precision = 0;
+			for (i++; isdigit(fmt[i]); i++)
+				conv->precision = conv->precision * 10 + fmt[i] - '0';
+		}
+
+		/* Length modifier */
+		length = 0;
+		if (fmt[i] == 'h')
+		{
+			i += fmt[i + 1] == 'h' ? 2 : 1;
+		}
+		else if (fmt[i] == 'l')
+		{
+			length = fmt[i + 1] == 'l' ? 'L' : 'l';
+			i += length == 'L' ? 2 : 1;
+		}
+		else if (fmt[i] == 'z')
+		{
+			length = 'z';
+			i++;
+		}
+
+		/* Conversion */
+		switch (fmt[i])
+		{
+
+		case '%':
+
+			conv->arg = trace_arg_none;
+			break;
+
+		case 'd':
+		case 'i':
+		case 'o':
+		case 'u':
+		case 'x':
+		case 'X':
+		case 'c':
+
+			conv->arg = length == 'l' ? trace_arg_long :
+				length == 'L' ? trace_arg_long_long :
+				length == 'z' ? trace_arg_size :
+				trace_arg_int;
+			break;
+
+		case 'e':
+		case 'E':
+		case 'f':
+		case 'F':
+		case 'g':
+		case 'G':
+		case 'a':
+		case 'A':
+
+			if (length && length != 'l')
+				fatal("trace format '%s': invalid conversion", fmt);
+			conv->arg = trace_arg_double;
+			break;
+
+		case 's':
+
+			if (length)
+				fatal("trace format '%s': invalid conversion", fmt);
+			conv->arg = trace_arg_string;
+			break;
+
+		case 'p':
+
+			conv->arg = trace_arg_pointer;
+			break;
+
+		default:
+			fatal("trace format '%s': unsupported conversion", fmt);
+		}
+		conv->end = i + 1;
+	}
+
+	/* Return */
+	return format;
+}
+
+
+static void trace_format_free(struct trace_format_t *format)
+{
+	free(format->convs);
+	free(format);
+}
+
+
+
+
+/*
+ * Windows and Filters
+ */
+
+int trace_windowed;
+long long trace_trigger_length = 100000;
+
+struct trace_window_t
+{
+	enum trace_window_kind_t kind;
+	long long start;
+	long long end;
+};
+
+struct trace_filter_t
+{
+	char *key;
+	struct list_t *value_list;
+};
+
+static struct list_t *trace_window_list;
+static struct list_t *trace_filter_list;
+
+/* Cycle until which a trigger keeps the trace enabled */
+static long long trace_trigger_end;
+
+
+void trace_window_add(enum trace_window_kind_t kind, long long start, long long end)
+{
+	struct trace_window_t *window;
+
+	/* Initialize */
+	window = xcalloc(1, sizeof(struct trace_window_t));
+	window->kind = kind;
+	window->start = start;
+	window->end = end;
+
+	/* Add */
+	if (!trace_window_list)
+		trace_window_list = list_create();
+	list_add(trace_window_list, window);
+	trace_windowed = 1;
+}
+
+
+void trace_filter_add(char *key, char *values)
+{
+	struct trace_filter_t *filter;
+
+	/* Initialize */
+	filter = xcalloc(1, sizeof(struct trace_filter_t));
+	filter->key = xstrdup(key);
+	filter->value_list = str_token_list_create(values, ",");
+
+	/* Add */
+	if (!trace_filter_list)
+		trace_filter_list = list_create();
+	list_add(trace_filter_list, filter);
+}
+
+
+void trace_trigger(void)
+{
+	/* Nothing if trace is inactive */
+	if (!trace_file)
+		return;
+
+	/* Open or extend window */
+	trace_trigger_end = MAX(trace_trigger_end, esim_cycle() + trace_trigger_length);
+	trace_enabled = 1;
+}
+
+
+static void trace_update_cycle(long long cycle, long long inst)
+{
+	struct trace_window_t *window;
+	long long value;
+	int enabled;
+	int i;
+
+	/* Trigger */
+	enabled = cycle < trace_trigger_end;
+
+	/* Windows */
+	for (i = 0; trace_window_list && i < list_count(trace_window_list); i++)
+	{
+		window = list_get(trace_window_list, i);
+		value = window->kind == trace_window_inst ? inst : cycle;
+		if (value >= window->start && value < window->end)
+			enabled = 1;
+	}
+
+	/* Update */
+	trace_enabled = trace_file && enabled;
+}
+
+
+void trace_update(long long inst)
+{
+	trace_update_cycle(esim_cycle(), inst);
+}
+
+
+/* Find the filter on the field printed by conversion 'conv' of a format string,
+ * given as '<key>=%d' or '<key>="%s'. */
+static struct trace_filter_t *trace_format_find_filter(struct trace_format_t *format,
+		struct trace_conv_t *conv)
+{
+	struct trace_filter_t *filter;
+	char *fmt;
+	char key[64];
+	int begin;
+	int end;
+	int i;
+
+	/* Key */
+	fmt = format->fmt;
+	end = conv->begin;
+	if (end && fmt[end - 1] == '"')
+		end--;
+	if (!end || fmt[end - 1] != '=')
+		return NULL;
+	end--;
+	for (begin = end; begin && (isalnum(fmt[begin - 1]) || fmt[begin - 1] == '_'); begin--);
+	if (begin == end || end - begin >= sizeof key)
+		return NULL;
+	memcpy(key, fmt + begin, end - begin);
+	key[end - begin] = '\0';
+
+	/* Filter */
+	LIST_FOR_EACH(trace_filter_list, i)
+	{
+		filter = list_get(trace_filter_list, i);
+		if (!strcmp(filter->key, key))
+			return filter;
+		if (!strcmp(filter->key, "mod") && (!strcmp(key, "cache") ||
+				!strcmp(key, "dir")))
+			return filter;
+
+		/* Access states have the form '<module>:<state>' */
+		if (!strcmp(filter->key, "mod") && !strcmp(key, "state") &&
+				fmt[conv->end] == ':')
+			return filter;
+	}
+
+	/* Not found */
+	return NULL;
+}
+
+
+/* Return true if the arguments of a line pass all filters */
+static int trace_format_match(struct trace_format_t *format, va_list va)
+{
+	struct trace_conv_t *conv;
+	char buf[64];
+	char *value;
+	int i;
+
+	for (i = 0; i < format->num_convs; i++)
+	{
+		conv = &format->convs[i];
+		value = buf;
+		switch (conv->arg)
+		{
+
+		case trace_arg_none:
+			continue;
+
+		case trace_arg_int:
+			snprintf(buf, sizeof buf, "%d", va_arg(va, int));
+			break;
+
+		case trace_arg_long:
+			snprintf(buf, sizeof buf, "%ld", va_arg(va, long));
+			break;
+
+		case trace_arg_long_long:
+			snprintf(buf, sizeof buf, "%lld", va_arg(va, long long));
+			break;
+
+		case trace_arg_size:
+			snprintf(buf, sizeof buf, "%zu", va_arg(va, size_t));
+			break;
+
+		case trace_arg_double:
+			snprintf(buf, sizeof buf, "%g", va_arg(va, double));
+			break;
+
+		case trace_arg_string:
+			value = va_arg(va, char *);
+			break;
+
+		case trace_arg_pointer:
+			snprintf(buf, sizeof buf, "%p", va_arg(va, void *));
+			break;
+		}
+
+		/* Check value */
+		if (conv->filter && (!value || str_token_list_find(
+				conv->filter->value_list, value) < 0))
+			return 0;
+	}
+
+	/* All filters passed */
+	return 1;
+}
+
+
+
+
+/*
+ * Output Buffers
+ */
+
+/* Records are written into one of 'TRACE_BUFFER_COUNT' buffers, each holding
+ * one chunk of the trace. Full buffers are compressed into the trace file by
+ * the writer thread in order, while the simulation fills the next one. A
+ * buffer grows if a cycle does not fit in it. */
+#define TRACE_BUFFER_SIZE  (TRACE_CHUNK_SIZE + (1 << 16))
+#define TRACE_BUFFER_COUNT  8
+
+/* Space reserved for a line of a plain-text trace */
+#define TRACE_LINE_SIZE  4096
+
+struct trace_buffer_t
+{
+	int size;
+	int capacity;
+	unsigned char *data;
+
+	/* First cycle in the chunk, or -1 */
+	long long cycle;
+};
+
+static struct trace_buffer_t *trace_buffers[TRACE_BUFFER_COUNT];
+
+/* Buffer being filled */
+static struct trace_buffer_t *trace_buffer;
+
+/* Full buffers, starting at index 'trace_buffer_head' */
+static int trace_buffer_head;
+static int trace_buffer_count;
+
+static int trace_writer_finish;
+static pthread_t trace_writer;
+static pthread_mutex_t trace_writer_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t trace_writer_full_cond = PTHREAD_COND_INITIALIZER;
+static pthread_cond_t trace_writer_free_cond = PTHREAD_COND_INITIALIZER;
+
+/* Compression stream, and bytes written to the trace file */
+static z_stream trace_stream;
+static long long trace_file_size;
+
+/* Chunks written, as elements of type 'struct trace_chunk_t'. Only accessed
+ * by the writer thread until it finishes. */
+struct trace_chunk_t
+{
+	long long offset;
+	long long cycle;
+};
+
+static struct list_t *trace_chunk_list;
+
+
+/* Compress a buffer into a new gzip member of the trace file */
+static void trace_buffer_compress(struct trace_buffer_t *buffer)
+{
+	unsigned char data[1 << 16];
+	int count;
+	int err;
+
+	deflateReset(&trace_stream);
+	trace_stream.next_in = buffer->data;
+	trace_stream.avail_in = buffer->size;
+	do
+	{
+		trace_stream.next_out = data;
+		trace_stream.avail_out = sizeof data;
+		err = deflate(&trace_stream, Z_FINISH);
+		if (err != Z_OK && err != Z_STREAM_END)
+			fatal("%s: cannot compress trace", __FUNCTION__);
+		count = sizeof data - trace_stream.avail_out;
+		if (fwrite(data, 1, count, trace_file) != count)
+			fatal("%s: cannot write trace file", __FUNCTION__);
+		trace_file_size += count;
+	} while (err != Z_STREAM_END);
+}
+
+
+static void *trace_writer_func(void *arg)
+{
+	struct trace_buffer_t *buffer;
+	struct trace_chunk_t *chunk;
+
+	pthread_mutex_lock(&trace_writer_lock);
+	while (1)
+	{
+		/* Wait for a full buffer */
+		while (!trace_buffer_count && !trace_writer_finish)
+			pthread_cond_wait(&trace_writer_full_cond, &trace_writer_lock);
+		if (!trace_buffer_count)
+			break;
+
+		/* Compress it. The buffer is not released until written. */
+		buffer = trace_buffers[trace_buffer_head];
+		pthread_mutex_unlock(&trace_writer_lock);
+		if (buffer->size)
+		{
+			chunk = xcalloc(1, sizeof(struct trace_chunk_t));
+			chunk->offset = trace_file_size;
+			chunk->cycle = buffer->cycle;
+			list_add(trace_chunk_list, chunk);
+			trace_buffer_compress(buffer);
+		}
+		pthread_mutex_lock(&trace_writer_lock);
+
+		/* Release */
+		trace_buffer_head = (trace_buffer_head + 1) % TRACE_BUFFER_COUNT;
+		trace_buffer_count--;
+		pthread_cond_signal(&trace_writer_free_cond);
+	}
+	pthread_mutex_unlock(&trace_writer_lock);
+	return NULL;
+}
+
+
+/* Pass the current buffer to the writer thread and continue in the next one,
+ * waiting if all buffers are full. */
+static void trace_buffer_flush(void)
+{
+	int index;
+
+	pthread_mutex_lock(&trace_writer_lock);
+	trace_buffer_count++;
+	pthread_cond_signal(&trace_writer_full_cond);
+	while (trace_buffer_count == TRACE_BUFFER_COUNT)
+		pthread_cond_wait(&trace_writer_free_cond, &trace_writer_lock);
+	index = (trace_buffer_head + trace_buffer_count) % TRACE_BUFFER_COUNT;
+	pthread_mutex_unlock(&trace_writer_lock);
+
+	trace_buffer = trace_buffers[index];
+	trace_buffer->size = 0;
+	trace_buffer->cycle = -1;
+}
+
+
+/* Return a pointer to at least 'size' free bytes in the current buffer */
+static inline unsigned char *trace_buffer_reserve(int size)
+{
+	if (trace_buffer->size + size > trace_buffer->capacity)
+	{
+		trace_buffer->capacity = MAX(trace_buffer->capacity * 2,
+				trace_buffer->size + size);
+		trace_buffer->data = xrealloc(trace_buffer->data,
+				trace_buffer->capacity);
+	}
+	return trace_buffer->data + trace_buffer->size;
+}
+
+
+static void trace_write_int(unsigned long long value)
+{
+	unsigned char *start;
+	unsigned char *ptr;
+
+	start = trace_buffer_reserve(10);
+	ptr = start;
+	while (value >= 0x80)
+	{
+		*ptr++ = (value & 0x7f) | 0x80;
+		value >>= 7;
+	}
+	*ptr++ = value;
+	trace_buffer->size += ptr - start;
+}
+
+
+static void trace_write_signed(long long value)
+{
+	trace_write_int(((unsigned long long) value << 1) ^ (value >> 63));
+}
+
+
+static void trace_write_data(void *data, int size)
+{
+	memcpy(trace_buffer_reserve(size), data, size);
+	trace_buffer->size += size;
+}
+
+
+static inline void trace_write_byte(int byte)
+{
+	*trace_buffer_reserve(1) = byte;
+	trace_buffer->size++;
+}
+
+
+
+
+/*
+ * Binary Trace
+ */
+
+/* Format strings, indexed by their address. All calls to 'trace' use literal
+ * format strings, so the address identifies the string. In plain-text traces,
+ * formats are only kept if there are filters. */
+static struct trace_format_t **trace_format_table;
+static int trace_format_table_size;
+static int trace_format_count;
+
+/* Identifiers of strings, plus one */
+static struct hash_table_t *trace_string_table;
+
+
+static inline int trace_format_index(char *fmt, int size)
+{
+	uintptr_t key = (uintptr_t) fmt;
+
+	return (key ^ (key >> 12)) & (size - 1);
+}
+
+
+static struct trace_format_t *trace_format_get(char *fmt)
+{
+	struct trace_format_t **table;
+	struct trace_format_t *format;
+
+	int index;
+	int size;
+	int i;
+
+	/* Find format */
+	index = trace_format_index(fmt, trace_format_table_size);
+	while ((format = trace_format_table[index]))
+	{
+		if (format->fmt == fmt)
+			return format;
+		index = (index + 1) & (trace_format_table_size - 1);
+	}
+
+	/* New format */
+	format = trace_format_create(fmt);
+	format->id = trace_format_count++;
+	trace_format_table[index] = format;
+	if (!trace_text)
+	{
+		trace_write_byte(trace_record_format);
+		trace_write_int(format->id);
+		trace_write_int(strlen(fmt));
+		trace_write_data(fmt, strlen(fmt));
+	}
+
+	/* Filters */
+	for (i = 0; trace_filter_list && i < format->num_convs; i++)
+	{
+		format->convs[i].filter = trace_format_find_filter(format,
+				&format->convs[i]);
+		if (format->convs[i].filter)
+			format->num_filters++;
+	}
+
+	/* Grow table */
+	if (trace_format_count * 2 > trace_format_table_size)
+	{
+		size = trace_format_table_size * 2;
+		table = xcalloc(size, sizeof(struct trace_format_t *));
+		for (i = 0; i < trace_format_table_size; i++)
+		{
+			if (!trace_format_table[i])
+				continue;
+			index = trace_format_index(trace_format_table[i]->fmt, size);
+			while (table[index])
+				index = (index + 1) & (size - 1);
+			table[index] = trace_format_table[i];
+		}
+		free(trace_format_table);
+		trace_format_table = table;
+		trace_format_table_size = size;
+	}
+
+	/* Return */
+	return format;
+}
+
+
+static void trace_write_str(char *str, int precision)
+{
+	char buf[TRACE_STRING_MAX_LENGTH + 1];
+	char *key;
+
+	intptr_t id;
+	int len;
+
+	/* Length */
+	if (!str)
+		str = "(null)";
+	len = precision < 0 ? strlen(str) : strnlen(str, precision);
+
+	/* Previous string */
+	if (len <= TRACE_STRING_MAX_LENGTH)
+	{
+		key = str;
+		if (str[len])
+		{
+			memcpy(buf, str, len);
+			buf[len] = '\0';
+			key = buf;
+		}
+
+		id = (intptr_t) hash_table_get(trace_string_table, key);
+		if (id)
+		{
+			trace_write_int(((id - 1) << 1) | 1);
+			return;
+		}
+
+		id = hash_table_count(trace_string_table);
+		if (id < TRACE_STRING_MAX_COUNT)
+			hash_table_insert(trace_string_table, key, (void *) (id + 1));
+	}
+
+	/* New string */
+	trace_write_int((unsigned long long) len << 1);
+	trace_write_data(str, len);
+}
+
+
+static void trace_write_line(struct trace_format_t *format, va_list va)
+{
+	struct trace_conv_t *conv;
+
+	double value;
+	unsigned long long bits;
+
+	int i;
+
+	trace_write_byte(trace_record_line);
+	trace_write_int(format->id);
+	for (i = 0; i < format->num_convs; i++)
+	{
+		conv = &format->convs[i];
+		switch (conv->arg)
+		{
+
+		case trace_arg_none:
+			break;
+
+		case trace_arg_int:
+			trace_write_signed(va_arg(va, int));
+			break;
+
+		case trace_arg_long:
+			trace_write_signed(va_arg(va, long));
+			break;
+
+		case trace_arg_long_long:
+			trace_write_signed(va_arg(va, long long));
+			break;
+
+		case trace_arg_size:
+			trace_write_int(va_arg(va, size_t));
+			break;
+
+		case trace_arg_double:
+			value = va_arg(va, double);
+			memcpy(&bits, &value, sizeof bits);
+			trace_write_int(bits);
+			break;
+
+		case trace_arg_string:
+			trace_write_str(va_arg(va, char *), conv->precision);
+			break;
+
+		case trace_arg_pointer:
+			trace_write_int((uintptr_t) va_arg(va, void *));
+			break;
+		}
+	}
+}
+
+
+
+
+/* Finish the current chunk, and start a new one */
+static void trace_chunk_begin(void)
 {
-	trace_status_invalid = 0,
-	trace_status_on,
-	trace_status_off
-};
+	trace_buffer_flush();
+	if (!trace_text)
+	{
+		trace_write_byte(trace_record_chunk);
+		hash_table_clear(trace_string_table);
+	}
+}
 
-struct trace_category_t
+
+/* Cycle when last effective call to 'trace' was made */
+static long long trace_last_cycle = -1;
+
+/* Write the index record and the trailer of a binary trace, once the writer
+ * thread finished. */
+static void trace_write_index(void)
 {
-	enum trace_status_t status;
-};
+	struct trace_format_t **formats;
+	struct trace_format_t *format;
+	struct trace_chunk_t *chunk;
+
+	unsigned char trailer[TRACE_TRAILER_SIZE];
+	unsigned char *data;
 
+	long long index_offset;
+	long long offset;
+	long long cycle;
+	unsigned int crc;
+
+	int i;
+
+	/* Formats by identifier */
+	formats = xcalloc(trace_format_count, sizeof(struct trace_format_t *));
+	for (i = 0; i < trace_format_table_size; i++)
+		if ((format = trace_format_table[i]))
+			formats[format->id] = format;
+
+	/* Index record */
+	index_offset = trace_file_size;
+	trace_buffer->size = 0;
+	trace_write_byte(trace_record_index);
+	trace_write_int(trace_format_count);
+	for (i = 0; i < trace_format_count; i++)
+	{
+		trace_write_int(strlen(formats[i]->fmt));
+		trace_write_data(formats[i]->fmt, strlen(formats[i]->fmt));
+	}
+	trace_write_int(trace_last_cycle + 1);
+	trace_write_int(list_count(trace_chunk_list));
+	offset = 0;
+	cycle = -1;
+	LIST_FOR_EACH(trace_chunk_list, i)
+	{
+		chunk = list_get(trace_chunk_list, i);
+		trace_write_int(chunk->offset - offset);
+		trace_write_int(chunk->cycle - cycle);
+		offset = chunk->offset;
+		cycle = chunk->cycle;
+	}
+	trace_buffer_compress(trace_buffer);
+	free(formats);
+
+	/* Trailer, as a gzip member with one stored deflate block */
+	memset(trailer, 0, sizeof trailer);
+	trailer[0] = 0x1f;
+	trailer[1] = 0x8b;
+	trailer[2] = Z_DEFLATED;
+	trailer[9] = 0xff;
+	trailer[10] = 1;
+	trailer[11] = 16;
+	trailer[13] = ~16;
+	trailer[14] = 0xff;
+	data = trailer + 15;
+	memcpy(data, TRACE_INDEX_MAGIC, TRACE_INDEX_MAGIC_SIZE);
+	for (i = 0; i < 8; i++)
+		data[TRACE_INDEX_MAGIC_SIZE + i] = index_offset >> (i * 8);
+	crc = crc32(0, data, 16);
+	for (i = 0; i < 4; i++)
+	{
+		trailer[31 + i] = crc >> (i * 8);
+		trailer[35 + i] = 16 >> (i * 8);
+	}
+	if (fwrite(trailer, 1, sizeof trailer, trace_file) != sizeof trailer)
+		fatal("%s: cannot write trace file", __FUNCTION__);
+}
+
+
+
+
+/*
+ * Public Functions
+ */
 
 void trace_init(char *file_name)
 {
 	struct trace_category_t *c;
+	int i;
 
 	/* Do nothing is no file name was given */
 	if (!file_name || !*file_name)
 		return;
 
-	/* Open destination file */
-	trace_file = gzopen(file_name, "wt");
+	/* Open destination file. Binary records lose little by being
+	 * compressed at the fastest level. */
+	trace_file = fopen(file_name, "wb");
 	if (!trace_file)
 		fatal("%s: cannot open trace file", file_name);
+	if (deflateInit2(&trace_stream, trace_text ? Z_DEFAULT_COMPRESSION : 1,
+			Z_DEFLATED, 15 + 16, 8, Z_DEFAULT_STRATEGY) != Z_OK)
+		fatal("%s: cannot initialize compression", __FUNCTION__);
+	trace_chunk_list = list_create();
 
 	/* Initialize list of categories */
 	trace_category_list = list_create();
@@ -63,17 +935,103 @@ void trace_init(char *file_name)
 	/* Create an invalid category at index 0 */
 	c = xcalloc(1, sizeof(struct trace_category_t));
 	list_add(trace_category_list, c);
+
+	/* Buffers */
+	for (i = 0; i < TRACE_BUFFER_COUNT; i++)
+	{
+		trace_buffers[i] = xcalloc(1, sizeof(struct trace_buffer_t));
+		trace_buffers[i]->capacity = TRACE_BUFFER_SIZE;
+		trace_buffers[i]->data = xmalloc(TRACE_BUFFER_SIZE);
+	}
+	trace_buffer = trace_buffers[0];
+	trace_buffer->cycle = -1;
+
+	/* Formats */
+	trace_format_table_size = 256;
+	trace_format_table = xcalloc(trace_format_table_size,
+			sizeof(struct trace_format_t *));
+
+	/* Binary format */
+	if (!trace_text)
+	{
+		trace_string_table = hash_table_create(1024, 1);
+		trace_write_data(TRACE_MAGIC, TRACE_MAGIC_SIZE);
+	}
+
+	/* Writer thread */
+	if (pthread_create(&trace_writer, NULL, trace_writer_func, NULL))
+		fatal("%s: cannot create trace writer thread", __FUNCTION__);
+
+	/* Initial state of windows */
+	trace_enabled = 1;
+	if (trace_windowed)
+		trace_update_cycle(0, 0);
 }
 
 
 void trace_done(void)
 {
+	int i;
+
 	/* Nothing if trace is inactive */
 	if (!trace_file)
 		return;
 
+	/* Write last buffer and wait for writer thread */
+	pthread_mutex_lock(&trace_writer_lock);
+	trace_buffer_count++;
+	trace_writer_finish = 1;
+	pthread_cond_signal(&trace_writer_full_cond);
+	pthread_mutex_unlock(&trace_writer_lock);
+	pthread_join(trace_writer, NULL);
+
+	/* Index of binary traces */
+	if (!trace_text)
+		trace_write_index();
+
 	/* Close trace file */
-	gzclose(trace_file);
+	fclose(trace_file);
+	deflateEnd(&trace_stream);
+	for (i = 0; i < TRACE_BUFFER_COUNT; i++)
+	{
+		free(trace_buffers[i]->data);
+		free(trace_buffers[i]);
+	}
+	LIST_FOR_EACH(trace_chunk_list, i)
+		free(list_get(trace_chunk_list, i));
+	list_free(trace_chunk_list);
+
+	/* Free formats and strings */
+	for (i = 0; i < trace_format_table_size; i++)
+		if (trace_format_table[i])
+			trace_format_free(trace_format_table[i]);
+	free(trace_format_table);
+	if (!trace_text)
+		hash_table_free(trace_string_table);
+
+	/* Free windows */
+	if (trace_window_list)
+	{
+		LIST_FOR_EACH(trace_window_list, i)
+			free(list_get(trace_window_list, i));
+		list_free(trace_window_list);
+	}
+
+	/* Free filters */
+	if (trace_filter_list)
+	{
+		LIST_FOR_EACH(trace_filter_list, i)
+		{
+			struct trace_filter_t *filter;
+
+			filter = list_get(trace_filter_list, i);
+			str_token_list_free(filter->value_list);
+			free(filter->key);
+			free(filter);
+		}
+		list_free(trace_filter_list);
+	}
+	trace_enabled = 0;
 
 	/* Free categories */
 	while (trace_category_list->count)
@@ -114,14 +1072,13 @@ int __trace_status(int category)
 }
 
 
-/* Cycle when last effective call to 'trace' was made */
-static long long trace_last_cycle = -1;
-
 void __trace(int category, int print_cycle, char *fmt, ...)
 {
 	struct trace_category_t *c;
+	struct trace_format_t *format;
 	va_list va;
-	char buf[4096];
+	char *buf;
+	int match;
 	int len;
 	long long cycle;
 
@@ -133,13 +1090,18 @@ void __trace(int category, int print_cycle, char *fmt, ...)
 	if (c->status == trace_status_off)
 		return;
 
-	/* Print message */
-	va_start(va, fmt);
-	len = vsnprintf(buf, sizeof buf, fmt, va);
-
-	/* Message exceeded buffer */
-	if (len + 1 == sizeof buf)
-		fatal("%s: buffer too small", __FUNCTION__);
+	/* Filters */
+	format = NULL;
+	if (!trace_text || trace_filter_list)
+		format = trace_format_get(fmt);
+	if (format && format->num_filters)
+	{
+		va_start(va, fmt);
+		match = trace_format_match(format, va);
+		va_end(va);
+		if (!match)
+			return;
+	}
 
 	/* Dump current cycle */
 	if (print_cycle)
@@ -147,12 +1109,559 @@ void __trace(int category, int print_cycle, char *fmt, ...)
 		cycle = esim_cycle();
 		if (cycle > trace_last_cycle)
 		{
-			gzprintf(trace_file, "c clk=%lld\n", cycle);
+			/* New chunk */
+			if (trace_buffer->size >= TRACE_CHUNK_SIZE)
+				trace_chunk_begin();
+
+			/* Cycle record */
+			if (trace_text)
+			{
+				buf = (char *) trace_buffer_reserve(TRACE_LINE_SIZE);
+				trace_buffer->size += sprintf(buf, "c clk=%lld\n", cycle);
+			}
+			else
+			{
+				trace_write_byte(trace_record_cycle);
+				trace_write_int(cycle - (trace_buffer->cycle < 0 ?
+						-1 : trace_last_cycle));
+			}
+			if (trace_buffer->cycle < 0)
+				trace_buffer->cycle = cycle;
 			trace_last_cycle = cycle;
 		}
 	}
 
 	/* Dump message */
-	gzwrite(trace_file, buf, len);
+	va_start(va, fmt);
+	if (trace_text)
+	{
+		buf = (char *) trace_buffer_reserve(TRACE_LINE_SIZE);
+		len = vsnprintf(buf, TRACE_LINE_SIZE, fmt, va);
+		if (len >= TRACE_LINE_SIZE)
+			fatal("%s: buffer too small", __FUNCTION__);
+		trace_buffer->size += len;
+	}
+	else
+	{
+		trace_write_line(format, va);
+	}
+	va_end(va);
+}
+
+
+
+
+/*
+ * Trace Reader
+ */
+
+struct trace_reader_t
+{
+	char *name;
+	gzFile f;
+
+	/* Binary format */
+	int binary;
+	long long cycle;
+	struct list_t *format_list;
+	struct list_t *string_list;
+
+	/* Chunk of the last line read, and index record found */
+	int chunk;
+	int end;
+
+	/* Index, with 'num_chunks' elements in 'chunks', loaded on demand */
+	int index_loaded;
+	int num_chunks;
+	struct trace_chunk_t *chunks;
+	long long last_cycle;
+};
+
+
+struct trace_reader_t *trace_reader_create(char *file_name)
+{
+	struct trace_reader_t *reader;
+	char magic[TRACE_MAGIC_SIZE];
+
+	/* Initialize */
+	reader = xcalloc(1, sizeof(struct trace_reader_t));
+	reader->name = xstrdup(file_name);
+	reader->cycle = -1;
+	reader->format_list = list_create();
+	reader->string_list = list_create();
+
+	/* Open */
+	reader->f = gzopen(file_name, "rb");
+	if (!reader->f)
+		fatal("%s: cannot open trace file", file_name);
+
+	/* Plain-text traces have no magic string */
+	if (gzread(reader->f, magic, sizeof magic) == sizeof magic &&
+			!memcmp(magic, TRACE_MAGIC, TRACE_MAGIC_SIZE))
+		reader->binary = 1;
+	else
+		gzrewind(reader->f);
+
+	/* Return */
+	return reader;
+}
+
+
+void trace_reader_free(struct trace_reader_t *reader)
+{
+	struct trace_format_t *format;
+	int i;
+
+	LIST_FOR_EACH(reader->format_list, i)
+	{
+		format = list_get(reader->format_list, i);
+		free(format->fmt);
+		trace_format_free(format);
+	}
+	list_free(reader->format_list);
+
+	LIST_FOR_EACH(reader->string_list, i)
+		free(list_get(reader->string_list, i));
+	list_free(reader->string_list);
+
+	gzclose(reader->f);
+	free(reader->chunks);
+	free(reader->name);
+	free(reader);
+}
+
+
+/* Forget strings of the previous chunk */
+static void trace_reader_clear_strings(struct trace_reader_t *reader)
+{
+	int i;
+
+	LIST_FOR_EACH(reader->string_list, i)
+		free(list_get(reader->string_list, i));
+	list_clear(reader->string_list);
+}
+
+
+/* Open the trace file starting at a gzip member at position 'offset' */
+static gzFile trace_reader_open_at(struct trace_reader_t *reader, long long offset)
+{
+	gzFile f;
+	int fd;
+
+	fd = open(reader->name, O_RDONLY);
+	if (fd < 0)
+		fatal("%s: cannot open trace file", reader->name);
+	if (lseek(fd, offset, SEEK_SET) != offset)
+		fatal("%s: invalid trace format", reader->name);
+	f = gzdopen(fd, "rb");
+	if (!f)
+		fatal("%s: cannot open trace file", reader->name);
+	return f;
+}
+
+
+static unsigned long long trace_reader_read_int(struct trace_reader_t *reader)
+{
+	unsigned long long value;
+	int shift;
+	int c;
+
+	value = 0;
+	shift = 0;
+	do
+	{
+		c = gzgetc(reader->f);
+		if (c < 0 || shift > 63)
+			fatal("%s: invalid trace format", reader->name);
+		value |= (unsigned long long) (c & 0x7f) << shift;
+		shift += 7;
+	} while (c & 0x80);
+
+	return value;
+}
+
+
+static long long trace_reader_read_signed(struct trace_reader_t *reader)
+{
+	unsigned long long value;
+
+	value = trace_reader_read_int(reader);
+	return (long long) (value >> 1) ^ -(long long) (value & 1);
+}
+
+
+static char *trace_reader_read_data(struct trace_reader_t *reader,
+		unsigned long long len)
+{
+	char *str;
+
+	if (len > INT32_MAX)
+		fatal("%s: invalid trace format", reader->name);
+	str = xmalloc(len + 1);
+	if (gzread(reader->f, str, len) != len)
+		fatal("%s: invalid trace format", reader->name);
+	str[len] = '\0';
+	return str;
+}
+
+
+/* Read a string argument. If the returned string is not kept as a previous
+ * string, '*free_ptr' is set to TRUE and it must be freed by the caller. */
+static char *trace_reader_read_str(struct trace_reader_t *reader, int *free_ptr)
+{
+	unsigned long long value;
+	char *str;
+
+	/* Previous string */
+	value = trace_reader_read_int(reader);
+	*free_ptr = 0;
+	if (value & 1)
+	{
+		str = list_get(reader->string_list, value >> 1);
+		if (value >> 1 >= list_count(reader->string_list) || !str)
+			fatal("%s: invalid trace format", reader->name);
+		return str;
+	}
+
+	/* New string */
+	str = trace_reader_read_data(reader, value >> 1);
+	if ((value >> 1) <= TRACE_STRING_MAX_LENGTH &&
+			list_count(reader->string_list) < TRACE_STRING_MAX_COUNT)
+		list_add(reader->string_list, str);
+	else
+		*free_ptr = 1;
+	return str;
+}
+
+
+static void trace_reader_print_line(struct trace_reader_t *reader,
+		struct trace_format_t *format, char *buf, int size)
+{
+	struct trace_conv_t *conv;
+
+	char spec[32];
+	char *fmt;
+	char *str;
+
+	double value;
+	unsigned long long bits;
+
+	int must_free;
+	int last;
+	int pos;
+	int len;
+	int i;
+
+	/* Conversions */
+	fmt = format->fmt;
+	last = 0;
+	pos = 0;
+	for (i = 0; i <= format->num_convs; i++)
+	{
+		/* Text before conversion, or until the end */
+		conv = &format->convs[i];
+		len = (i < format->num_convs ? conv->begin : strlen(fmt)) - last;
+		if (pos + len >= size)
+			fatal("%s: buffer too small", __FUNCTION__);
+		memcpy(buf + pos, fmt + last, len);
+		pos += len;
+		buf[pos] = '\0';
+		if (i == format->num_convs)
+			break;
+		last = conv->end;
+
+		/* Conversion specification */
+		len = conv->end - conv->begin;
+		if (len >= sizeof spec)
+			fatal("%s: invalid trace format", reader->name);
+		memcpy(spec, fmt + conv->begin, len);
+		spec[len] = '\0';
+
+		/* Print value */
+		switch (conv->arg)
+		{
+
+		case trace_arg_none:
+			len = snprintf(buf + pos, size - pos, "%%");
+			break;
+
+		case trace_arg_int:
+			len = snprintf(buf + pos, size - pos, spec,
+				(int) trace_reader_read_signed(reader));
+			break;
+
+		case trace_arg_long:
+			len = snprintf(buf + pos, size - pos, spec,
+				(long) trace_reader_read_signed(reader));
+			break;
+
+		case trace_arg_long_long:
+			len = snprintf(buf + pos, size - pos, spec,
+				trace_reader_read_signed(reader));
+			break;
+
+		case trace_arg_size:
+			len = snprintf(buf + pos, size - pos, spec,
+				(size_t) trace_reader_read_int(reader));
+			break;
+
+		case trace_arg_double:
+			bits = trace_reader_read_int(reader);
+			memcpy(&value, &bits, sizeof value);
+			len = snprintf(buf + pos, size - pos, spec, value);
+			break;
+
+		case trace_arg_string:
+			str = trace_reader_read_str(reader, &must_free);
+			len = snprintf(buf + pos, size - pos, spec, str);
+			if (must_free)
+				free(str);
+			break;
+
+		case trace_arg_pointer:
+			len = snprintf(buf + pos, size - pos, spec,
+				(void *) (uintptr_t) trace_reader_read_int(reader));
+			break;
+
+		default:
+			panic("%s: invalid argument", __FUNCTION__);
+		}
+
+		/* Line too long */
+		if (len < 0 || pos + len >= size)
+			fatal("%s: buffer too small", __FUNCTION__);
+		pos += len;
+	}
+}
+
+
+char *trace_reader_gets(struct trace_reader_t *reader, char *buf, int size)
+{
+	struct trace_format_t *format;
+	unsigned long long id;
+	char *fmt;
+	int kind;
+
+	/* Plain-text trace */
+	if (!reader->binary)
+		return gzgets(reader->f, buf, size);
+
+	/* Binary trace */
+	while (!reader->end && (kind = gzgetc(reader->f)) >= 0)
+	{
+		switch (kind)
+		{
+
+		case trace_record_format:
+
+			/* Formats may be known from the index */
+			id = trace_reader_read_int(reader);
+			fmt = trace_reader_read_data(reader, trace_reader_read_int(reader));
+			if (id < list_count(reader->format_list))
+			{
+				free(fmt);
+				break;
+			}
+			if (id != list_count(reader->format_list))
+				fatal("%s: invalid trace format", reader->name);
+			format = trace_format_create(fmt);
+			format->id = id;
+			list_add(reader->format_list, format);
+			break;
+
+		case trace_record_chunk:
+
+			reader->chunk++;
+			reader->cycle = -1;
+			trace_reader_clear_strings(reader);
+			break;
+
+		case trace_record_index:
+
+			reader->end = 1;
+			break;
+
+		case trace_record_cycle:
+
+			reader->cycle += trace_reader_read_int(reader);
+			if (snprintf(buf, size, "c clk=%lld\n", reader->cycle) >= size)
+				fatal("%s: buffer too small", __FUNCTION__);
+			return buf;
+
+		case trace_record_line:
+
+			id = trace_reader_read_int(reader);
+			format = list_get(reader->format_list, id);
+			if (id >= list_count(reader->format_list) || !format)
+				fatal("%s: invalid trace format", reader->name);
+			trace_reader_print_line(reader, format, buf, size);
+			return buf;
+
+		default:
+			fatal("%s: invalid trace format", reader->name);
+		}
+	}
+
+	/* End of trace */
+	return NULL;
+}
+
+
+long int trace_reader_tell(struct trace_reader_t *reader)
+{
+	return gztell(reader->f);
+}
+
+
+/* Read the index from the trailer at the end of a binary trace, if any */
+static void trace_reader_load_index(struct trace_reader_t *reader)
+{
+	struct trace_format_t *format;
+	struct trace_chunk_t *chunk;
+
+	unsigned char trailer[TRACE_TRAILER_SIZE];
+	unsigned char *data;
+
+	unsigned long long value;
+	long long offset;
+	long long cycle;
+
+	gzFile f;
+	FILE *file;
+
+	char *fmt;
+
+	int count;
+	int i;
+
+	/* Load once */
+	if (reader->index_loaded)
+		return;
+	reader->index_loaded = 1;
+	if (!reader->binary)
+		return;
+
+	/* Trailer. Traces not closed properly have none. */
+	file = fopen(reader->name, "rb");
+	if (!file)
+		fatal("%s: cannot open trace file", reader->name);
+	count = 0;
+	if (!fseek(file, -TRACE_TRAILER_SIZE, SEEK_END))
+		count = fread(trailer, 1, sizeof trailer, file);
+	fclose(file);
+	data = trailer + 15;
+	if (count != sizeof trailer || trailer[0] != 0x1f || trailer[1] != 0x8b ||
+			trailer[10] != 1 || trailer[11] != 16 || trailer[12] ||
+			memcmp(data, TRACE_INDEX_MAGIC, TRACE_INDEX_MAGIC_SIZE))
+		return;
+	offset = 0;
+	for (i = 0; i < 8; i++)
+		offset |= (long long) data[TRACE_INDEX_MAGIC_SIZE + i] << (i * 8);
+
+	/* Read index record from its own stream */
+	f = reader->f;
+	reader->f = trace_reader_open_at(reader, offset);
+	if (gzgetc(reader->f) != trace_record_index)
+		fatal("%s: invalid trace index", reader->name);
+
+	/* Formats */
+	count = trace_reader_read_int(reader);
+	for (i = 0; i < count; i++)
+	{
+		fmt = trace_reader_read_data(reader, trace_reader_read_int(reader));
+		if (i < list_count(reader->format_list))
+		{
+			free(fmt);
+			continue;
+		}
+		format = trace_format_create(fmt);
+		format->id = i;
+		list_add(reader->format_list, format);
+	}
+
+	/* Chunks */
+	reader->last_cycle = (long long) trace_reader_read_int(reader) - 1;
+	value = trace_reader_read_int(reader);
+	if (!value || value > INT32_MAX / sizeof(struct trace_chunk_t))
+		fatal("%s: invalid trace index", reader->name);
+	reader->num_chunks = value;
+	reader->chunks = xcalloc(reader->num_chunks, sizeof(struct trace_chunk_t));
+	offset = 0;
+	cycle = -1;
+	for (i = 0; i < reader->num_chunks; i++)
+	{
+		chunk = &reader->chunks[i];
+		offset += trace_reader_read_int(reader);
+		cycle += trace_reader_read_int(reader);
+		chunk->offset = offset;
+		chunk->cycle = cycle;
+	}
+
+	/* Back to the trace */
+	gzclose(reader->f);
+	reader->f = f;
+}
+
+
+int trace_reader_get_num_chunks(struct trace_reader_t *reader)
+{
+	trace_reader_load_index(reader);
+	return reader->num_chunks;
+}
+
+
+long long trace_reader_get_chunk_cycle(struct trace_reader_t *reader, int chunk)
+{
+	trace_reader_load_index(reader);
+	if (chunk < 0 || chunk >= reader->num_chunks)
+		panic("%s: invalid chunk", __FUNCTION__);
+	return reader->chunks[chunk].cycle;
+}
+
+
+long long trace_reader_get_last_cycle(struct trace_reader_t *reader)
+{
+	trace_reader_load_index(reader);
+	return reader->last_cycle;
+}
+
+
+void trace_reader_seek_chunk(struct trace_reader_t *reader, int chunk)
+{
+	char magic[TRACE_MAGIC_SIZE];
+
+	/* Open at chunk. Its chunk record, or the magic string of the
+	 * first chunk, is consumed here. */
+	trace_reader_load_index(reader);
+	if (chunk < 0 || chunk >= reader->num_chunks)
+		panic("%s: invalid chunk", __FUNCTION__);
+	gzclose(reader->f);
+	reader->f = trace_reader_open_at(reader, reader->chunks[chunk].offset);
+	if (chunk ? gzgetc(reader->f) != trace_record_chunk :
+			gzread(reader->f, magic, sizeof magic) != sizeof magic)
+		fatal("%s: invalid trace format", reader->name);
+
+	/* State at the beginning of a chunk */
+	reader->chunk = chunk;
+	reader->cycle = -1;
+	reader->end = 0;
+	trace_reader_clear_strings(reader);
 }
 
+
+int trace_reader_get_chunk(struct trace_reader_t *reader)
+{
+	return reader->chunk;
+}
+
+
+void trace_dump(char *file_name, FILE *f)
+{
+	struct trace_reader_t *reader;
+	char buf[TRACE_LINE_SIZE];
+
+	reader = trace_reader_create(file_name);
+	while (trace_reader_gets(reader, buf, sizeof buf))
+		fputs(buf, f);
+	trace_reader_free(reader);
+}
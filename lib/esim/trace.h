@@ -20,15 +20,103 @@
 #ifndef LIB_ESIM_TRACE_H
 #define LIB_ESIM_TRACE_H
 
+#include <stdio.h>
+
+
+/*
+ * The simulation trace is a gzip-compressed file, in binary format by default,
+ * or in the plain-text format of previous versions if 'trace_text' is set.
+ * Each text line has the form '<command> <name>=<value> ...', and line
+ * 'c clk=<cycle>' precedes the lines traced in a new cycle.
+ *
+ * The trace is divided into chunks of about 'TRACE_CHUNK_SIZE' uncompressed
+ * bytes, each compressed into a separate gzip member, so that a chunk can be
+ * decompressed without reading the previous ones. All chunks but the first
+ * start with a new cycle.
+ *
+ * The binary file starts with 'TRACE_MAGIC', followed by records starting
+ * with a byte indicating the record kind. Integers are stored as unsigned
+ * variable-length quantities (7 bits per byte, least significant first), and
+ * signed integers in zig-zag encoding (sign in the least significant bit).
+ *
+ * Format record:
+ *	<id> <string>
+ * Defines a format string of a 'trace' call, with identifiers assigned in
+ * increasing order starting at 0.
+ *
+ * Cycle record:
+ *	<cycle>
+ * Difference between the current cycle and the cycle of the previous cycle
+ * record in the chunk (or -1).
+ *
+ * Line record:
+ *	<format> <arg>*
+ * One value per conversion in the format string. A string argument is stored
+ * as its length shifted left by one followed by its characters, or as the
+ * identifier of a previous string in the chunk shifted left by one, plus one.
+ * Strings up to 'TRACE_STRING_MAX_LENGTH' characters are assigned identifiers
+ * in order of appearance, until there are 'TRACE_STRING_MAX_COUNT' of them.
+ * Values of type 'double' are stored as the integer with the same bit
+ * representation.
+ *
+ * Chunk record:
+ * First record of every chunk but the first one.
+ *
+ * Index record:
+ *	<num_formats> <string>* <last_cycle+1>
+ *	<num_chunks> (<offset> <cycle+1>)*
+ * Last record of the trace, in a gzip member of its own. It contains all
+ * format strings by identifier, and the offset in the file of each chunk
+ * with the first cycle traced in it, both stored as differences with the
+ * previous chunk.
+ *
+ * The file ends with a gzip member of 'TRACE_TRAILER_SIZE' bytes, stored
+ * without compression, containing 'TRACE_INDEX_MAGIC' and the offset of the
+ * gzip member with the index record as a 64-bit little-endian integer.
+ *
+ * Records are written into a ring of buffers compressed by a separate host
+ * thread, so the simulation does not format or compress the trace.
+ */
+
+#define TRACE_MAGIC  "M2S-TRC1"
+#define TRACE_MAGIC_SIZE  8
+
+#define TRACE_INDEX_MAGIC  "M2S-IDX1"
+#define TRACE_INDEX_MAGIC_SIZE  8
+
+#define TRACE_CHUNK_SIZE  (1 << 20)
+#define TRACE_TRAILER_SIZE  39
+
+#define TRACE_STRING_MAX_LENGTH  256
+#define TRACE_STRING_MAX_COUNT  (1 << 16)
+
+enum trace_record_t
+{
+	trace_record_invalid = 0,
+	trace_record_format,
+	trace_record_cycle,
+	trace_record_line,
+	trace_record_chunk,
+	trace_record_index
+};
+
+/* Write trace in plain text */
+extern int trace_text;
+
+/* False while no trace window is open. Lines printed with 'trace_header' are
+ * not affected by windows. */
+extern int trace_enabled;
+
 void trace_init(char *file_name);
 void trace_done(void);
 
 int trace_new_category(void);
 
-#define trace_status(category) ((category) ? __trace_status((category)) : 0)
+#define trace_status(category) ((trace_enabled && (category)) ? \
+	__trace_status((category)) : 0)
 int __trace_status(int category);
 
-#define trace(category, ...) ((category) ? \
+#define trace(category, ...) ((trace_enabled && (category)) ? \
 	__trace((category), 1, __VA_ARGS__) : (void) 0)
 #define trace_header(category, ...) ((category) ? \
 	__trace((category), 0, __VA_ARGS__) : (void) 0)
@@ -36,5 +124,77 @@ void __trace(int category, int print_cycle, char *fmt, ...)
 	__attribute__ ((format (printf, 3, 4)));
 
 
+/*
+ * Trace windows and filters. If windows or a trigger are given, lines are
+ * traced only in the cycles or instructions covered by some window, or in the
+ * 'trace_trigger_length' cycles following a call to 'trace_trigger'.
+ */
+
+enum trace_window_kind_t
+{
+	trace_window_invalid = 0,
+	trace_window_cycle,
+	trace_window_inst
+};
+
+extern long long trace_trigger_length;
+
+/* Window from 'start' to 'end' (not included) */
+void trace_window_add(enum trace_window_kind_t kind, long long start, long long end);
+
+/* Trace only lines whose field 'key' has one of the values in the
+ * comma-separated 'values'. Lines without the field are not affected. Key
+ * 'mod' refers to fields 'cache', 'dir', and the module in access states
+ * 'state="<module>:<state>"'. */
+void trace_filter_add(char *key, char *values);
+
+/* Enable tracing for the next 'trace_trigger_length' cycles */
+void trace_trigger(void);
+
+/* True if windows or a trigger were given, and 'trace_update' must be called
+ * in every iteration of the simulation loop with the number of instructions
+ * executed so far. */
+extern int trace_windowed;
+
+void trace_update(long long inst);
+
+
+/*
+ * Trace reader, returning the lines of a binary or plain-text trace in
+ * plain-text format.
+ */
+
+struct trace_reader_t;
+
+struct trace_reader_t *trace_reader_create(char *file_name);
+void trace_reader_free(struct trace_reader_t *reader);
+
+/* Read next line into 'buf', including the trailing new-line character. Return
+ * 'buf', or NULL if the end of the trace was reached. */
+char *trace_reader_gets(struct trace_reader_t *reader, char *buf, int size);
+
+/* Position in the uncompressed trace of the next line */
+long int trace_reader_tell(struct trace_reader_t *reader);
+
+/* Number of chunks in the index of a binary trace, loaded on the first call.
+ * Return 0 if the trace has no index, e.g., in plain-text traces. */
+int trace_reader_get_num_chunks(struct trace_reader_t *reader);
+
+/* First cycle traced in a chunk, or -1 if none */
+long long trace_reader_get_chunk_cycle(struct trace_reader_t *reader, int chunk);
+
+/* Last cycle traced, or -1 if none */
+long long trace_reader_get_last_cycle(struct trace_reader_t *reader);
+
+/* Continue reading at the beginning of a chunk of an indexed trace */
+void trace_reader_seek_chunk(struct trace_reader_t *reader, int chunk);
+
+/* Chunk containing the last line read */
+int trace_reader_get_chunk(struct trace_reader_t *reader);
+
+/* Print a trace in plain text */
+void trace_dump(char *file_name, FILE *f);
+
+
 #endif
 
@@ -26,16 +26,10 @@
 #include "list.h"
 
 
-enum debug_status_t
-{
-	debug_status_invalid = 0,
-	debug_status_on,
-	debug_status_off
-};
+unsigned long long debug_mask;
 
 struct debug_category_t
 {
-	enum debug_status_t status;
 	int space_count;
 
 	/* File name and descriptor */
@@ -52,6 +46,7 @@ void debug_init(void)
 
 	/* Initialize list of categories */
 	debug_category_list = list_create();
+	debug_mask = 0;
 
 	/* Create an invalid category at index 0 */
 	c = xcalloc(1, sizeof(struct debug_category_t));
@@ -77,6 +72,7 @@ void debug_done(void)
 
 	/* Free list */
 	list_free(debug_category_list);
+	debug_mask = 0;
 }
 
 
@@ -89,8 +85,9 @@ int debug_new_category(char *file_name)
 		return 0;
 
 	/* Initialize */
+	if (list_count(debug_category_list) >= DEBUG_MAX_CATEGORIES)
+		fatal("%s: too many debug categories", file_name);
 	c = xcalloc(1, sizeof(struct debug_category_t));
-	c->status = debug_status_on;
 	c->file_name = xstrdup(file_name);
 
 	/* Assign file */
@@ -109,46 +106,24 @@ int debug_new_category(char *file_name)
 			fatal("%s: cannot open debug file", file_name);
 	}
 
-	/* Add to list and return index */
+	/* Add to list, switch on, and return index */
 	list_add(debug_category_list, c);
+	debug_mask |= 1ull << (list_count(debug_category_list) - 1);
 	return list_count(debug_category_list) - 1;
 }
 
 
 void __debug_on(int category)
 {
-	struct debug_category_t *c;
-
-	assert(category > 0);
-	c = list_get(debug_category_list, category);
-
-	assert(c);
-	c->status = debug_status_on;
+	assert(category > 0 && category < list_count(debug_category_list));
+	debug_mask |= 1ull << category;
 }
 
 
 void __debug_off(int category)
 {
-	struct debug_category_t *c;
-
-	assert(category > 0);
-	c = list_get(debug_category_list, category);
-
-	assert(c);
-	c->status = debug_status_off;
-}
-
-
-int __debug_status(int category)
-{
-	struct debug_category_t *c;
-
-	assert(category > 0);
-	c = list_get(debug_category_list, category);
-
-	/* Return TRUE if debug is on */
-	assert(c);
-	return c->status == debug_status_on;
+	assert(category > 0 && category < list_count(debug_category_list));
+	debug_mask &= ~(1ull << category);
 }
 
 
@@ -219,7 +194,7 @@ void __debug(int category, char *fmt, ...)
 	assert(category > 0);
 	c = list_get(debug_category_list, category);
 	assert(c);
-	if (c->status == debug_status_off)
+	if (!debug_status(category))
 		return;
 	
 	/* Print spaces */
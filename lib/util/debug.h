@@ -24,6 +24,22 @@
 #include <stdlib.h>
 
 
+/*
+ * Debug categories are identified by an index, with 0 for a category with no
+ * file. Bit 'n' of 'debug_mask' is set while category 'n' is on, so that the
+ * 'debug' macros check disabled categories inline without calling into the
+ * library.
+ *
+ * Categories of hot paths, such as instruction emulation and memory hierarchy
+ * events, are removed when the simulator is built with -DNO_HOT_DEBUG. Their
+ * variables are then defined as the constant 0 in the headers declaring them,
+ * and the compiler drops every statement using them.
+ */
+
+#define DEBUG_MAX_CATEGORIES  64
+
+extern unsigned long long debug_mask;
+
 /* Initialization and finalization */
 void debug_init(void);
 void debug_done(void);
@@ -42,8 +58,7 @@ void __debug_off(int category);
 
 /* Return true if a message to this debug category would be dumped, that is,
  * if debug is on and the file is not NULL. */
-#define debug_status(category) ((category) ? __debug_status((category)) : 0)
-int __debug_status(int category);
+#define debug_status(category) ((category) && ((debug_mask >> (category)) & 1))
 
 /* Return the file associated with a category. */
 #define debug_file(category) ((category) ? __debug_file((category)) : 0)
@@ -62,12 +77,14 @@ void __debug_tab_inc(int category, int space_count);
 void __debug_tab_dec(int category, int space_count);
 
 /* Dump a debugging message. */
-#define debug(category, ...) ((category) ? __debug((category), __VA_ARGS__) : (void) 0)
+#define debug(category, ...) (debug_status((category)) ? \
+	__debug((category), __VA_ARGS__) : (void) 0)
 void __debug(int category, char *fmt, ...) __attribute__ ((format (printf, 2, 3)));
 
 /* Dump a buffer */
 #define debug_buffer(category, buffer_name, buffer, size) \
-	((category) ? __debug_buffer((category), (buffer_name), (buffer), (size)) : (void) 0)
+	(debug_status((category)) ? \
+	__debug_buffer((category), (buffer_name), (buffer), (size)) : (void) 0)
 void __debug_buffer(int category, char *buffer_name, void *buffer, int size);
 
 /* Other messages */
@@ -24,6 +24,7 @@
 #include <arch/arm/emu/syscall.h>
 #include <arch/arm/timing/cpu.h>
 #include <arch/common/arch.h>
+#include <arch/common/emu.h>
 #include <arch/common/runtime.h>
 #include <arch/evergreen/emu/emu.h>
 #include <arch/evergreen/emu/isa.h>
@@ -48,6 +49,7 @@
 #include <arch/x86/emu/isa.h>
 #include <arch/x86/emu/loader.h>
 #include <arch/x86/emu/syscall.h>
+#include <arch/x86/emu/uinst-trace.h>
 #include <arch/x86/timing/cpu.h>
 #include <arch/x86/timing/trace-cache.h>
 #include <driver/cuda/cuda.h>
@@ -58,6 +60,7 @@
 #include <driver/opencl-old/evergreen/opencl.h>
 #include <driver/opengl/opengl.h>
 #include <lib/esim/esim.h>
+#include <lib/esim/stats.h>
 #include <lib/esim/trace.h>
 #include <lib/mhandle/mhandle.h>
 #include <lib/util/debug.h>
@@ -65,6 +68,7 @@
 #include <lib/util/misc.h>
 #include <lib/util/string.h>
 #include <mem-system/config.h>
+#include <mem-system/mem-sim.h>
 #include <mem-system/mem-system.h>
 #include <mem-system/mmu.h>
 #include <network/net-system.h>
@@ -72,11 +76,22 @@
 #include <sys/time.h>
 #include <visual/common/visual.h>
 
+#include "bench.h"
+#include "sweep.h"
+
 
 static char *visual_file_name = "";
+static char *bench_file_name = "";
 static char *ctx_config_file_name = "";
 static char *elf_debug_file_name = "";
+static char *stats_file_name = "";
+static char *stats_dump_file_name = "";
+static int m2s_stats_option;  /* Option '--stats-interval' or '--stats-binary' given */
 static char *trace_file_name = "";
+static char *trace_dump_file_name = "";
+static int m2s_trace_window_inst;  /* Instruction windows given */
+static int m2s_trace_trigger_length;  /* Option '--trace-trigger-length' given */
+static int m2s_trace_filter;  /* Option '--trace-filter' given */
 static char *glu_debug_file_name = "";
 static char *glut_debug_file_name = "";
 static char *glew_debug_file_name = "";
@@ -162,6 +177,15 @@ static char *m2s_help =
 		"General Options\n"
 		"================================================================================\n"
 		"\n"
+		"  --bench <file>.json\n"
+		"      Run the built-in benchmarks of the simulator, and save the results in\n"
+		"      <file> in JSON format. The suite contains microbenchmarks of the event-\n"
+		"      driven library, cache lookups, guest memory, the memory hierarchy, and\n"
+		"      the network, and reference workloads simulating an x86 program, a\n"
+		"      synthetic network ('--net-sim'), and a DRAM system ('--dram-sim').\n"
+		"      Results are given in operations, simulated cycles, and thousands of\n"
+		"      instructions (KIPS) per second of host time.\n"
+		"\n"
 		"  --ctx-config <file>\n"
 		"      Use <file> as the context configuration file. This file describes the\n"
 		"      initial set of running applications, their arguments, and environment\n"
@@ -177,16 +201,81 @@ static char *m2s_help =
 		"      an executable file is open (CPU program of GPU kernel binary), detailed\n"
 		"      information about its symbols, sections, strings, etc. is dumped here.\n"
 		"\n"
+		"  --esim-profile <file>\n"
+		"      Dump a profile of the host time spent in the event-driven simulation\n"
+		"      library into <file>. For each event type, the report shows the number of\n"
+		"      executions, the host time spent in its handler, the maximum number of\n"
+		"      in-flight events, and a histogram of scheduling distances.\n"
+		"\n"
 		"  --max-time <time>\n"
 		"      Maximum simulation time in seconds. The simulator will stop once this time\n"
 		"      is exceeded. A value of 0 (default) means no time limit.\n"
 		"\n"
+		"  --stats <file>\n"
+		"      Sample the event counters of the timing models, memory modules, and\n"
+		"      networks periodically, and dump in <file> the increment of each counter\n"
+		"      in every interval, as one CSV line per interval with one column per\n"
+		"      counter.\n"
+		"\n"
+		"  --stats-binary\n"
+		"      Generate the file given in option '--stats' in a compressed column-wise\n"
+		"      binary format, which can be printed as CSV with option '--stats-dump'.\n"
+		"\n"
+		"  --stats-dump <file>\n"
+		"      Print a file generated with options '--stats' and '--stats-binary' in\n"
+		"      CSV format, and exit.\n"
+		"\n"
+		"  --stats-interval <cycles>\n"
+		"      Interval between samples for option '--stats', in cycles of the fastest\n"
+		"      clock domain (default 10000).\n"
+		"\n"
+		"  --sweep <file>\n"
+		"      Simulate the x86 program once per configuration listed in <file>, each\n"
+		"      with its own x86 and memory configuration files. The program is loaded\n"
+		"      and fast-forwarded only once, and one child process per configuration\n"
+		"      continues the detailed simulation from that state. The summary and\n"
+		"      reports of all configurations are collected in one file. Requires\n"
+		"      option '--x86-sim detailed'. See 'sweep.h' for the file format.\n"
+		"\n"
+		"  --sweep-report <file>\n"
+		"      File to dump the summary of option '--sweep' into (default stderr).\n"
+		"\n"
 		"  --trace <file>.gz\n"
 		"      Generate a trace file with debug information on the configuration of the\n"
 		"      modeled CPUs, GPUs, and memory system, as well as their dynamic\n"
-		"      simulation. The trace is a compressed plain-text file in format. The user\n"
-		"      should watch the size of the generated trace as simulation runs, since\n"
-		"      the trace file can quickly become extremely large.\n"
+		"      simulation. The trace is a compressed binary file, which can be printed\n"
+		"      as plain text with option '--trace-dump'. The user should watch the size\n"
+		"      of the generated trace as simulation runs, since the trace file can\n"
+		"      quickly become extremely large.\n"
+		"\n"
+		"  --trace-dump <file>\n"
+		"      Print a trace generated with option '--trace' in plain text, and exit.\n"
+		"\n"
+		"  --trace-text\n"
+		"      Generate the trace given in option '--trace' as a compressed plain-text\n"
+		"      file, as in previous versions of Multi2Sim. Simulation is slower than\n"
+		"      with the default binary format.\n"
+		"\n"
+		"  --trace-window <start>:<end>\n"
+		"  --trace-window-inst <start>:<end>\n"
+		"      Generate the trace only from cycle (or emulated instruction) <start> up\n"
+		"      to, but not including, <end>. These options can be given multiple\n"
+		"      times. Trace headers describing the modeled hardware are always\n"
+		"      generated.\n"
+		"\n"
+		"  --trace-filter <key>=<value>[,<value>...]\n"
+		"      Discard trace lines with field <key> set to a value not in the list,\n"
+		"      e.g., 'core=0' or 'cu=2,3'. Key 'mod' selects memory modules, e.g.,\n"
+		"      'mod=x86-l2-0'. This option can be given multiple times.\n"
+		"\n"
+		"  --trace-trigger <module>:<cycles>\n"
+		"      Generate the trace only after an access to memory module <module>, or a\n"
+		"      request from another module serviced by it, takes more than <cycles>\n"
+		"      cycles. The trace is generated for the number of cycles given in option\n"
+		"      '--trace-trigger-length'. Every such access opens or extends a window.\n"
+		"\n"
+		"  --trace-trigger-length <cycles>\n"
+		"      Length of the trace window opened by a trigger (default 100000).\n"
 		"\n"
 		"  --visual <file>.gz\n"
 		"      Run the Multi2Sim Visualization Tool. This option consumes a file\n"
@@ -244,6 +333,12 @@ static char *m2s_help =
 		"      Disassemble the x86 ELF file provided in <file>, using the internal x86\n"
 		"      disassembler. This option is incompatible with any other option.\n"
 		"\n"
+		"  --x86-emu-threads <num>\n"
+		"      Number of host threads used by the functional x86 emulation. Contexts\n"
+		"      that do not share their memory image, such as separate processes, run\n"
+		"      batches of instructions in parallel, and synchronize before every system\n"
+		"      call. Default is 1.\n"
+		"\n"
 		"  --x86-help\n"
 		"      Display a help message describing the format of the x86 CPU context\n"
 		"      configuration file.\n"
@@ -284,6 +379,23 @@ static char *m2s_help =
 		"      Choose a functional simulation (emulation) of an x86 program, versus\n"
 		"      a detailed (architectural) simulation. Simulation is functional by\n" 	"      default.\n"
 		"\n"
+		"  --x86-uinst-replay <file>\n"
+		"      Run the detailed x86 simulation on a micro-instruction trace captured\n"
+		"      with option '--x86-uinst-trace', instead of emulating a program. No\n"
+		"      program can be given in the command line. Speculative instructions are\n"
+		"      not present in the trace, so fetch stalls after a mispredicted branch\n"
+		"      until the pipeline recovers. System calls are not emulated either, so\n"
+		"      contexts never suspend. This option is only valid for detailed x86\n"
+		"      simulation (option '--x86-sim detailed').\n"
+		"\n"
+		"  --x86-uinst-trace <file>\n"
+		"      Capture the micro-instructions of all non-speculative x86 instructions\n"
+		"      in a compressed binary trace, together with their dependences, memory\n"
+		"      addresses, and branch outcomes. The trace can be captured both in\n"
+		"      functional and detailed simulation, and then replayed with option\n"
+		"      '--x86-uinst-replay' to evaluate different CPU and memory hierarchy\n"
+		"      configurations without emulating the program again.\n"
+		"\n"
 		"\n"
 		"================================================================================\n"
 		"AMD Evergreen GPU Options\n"
@@ -388,6 +500,11 @@ static char *m2s_help =
 		"      Dumps the default GPU configuration file used for timing simulation.\n"
 		"      This cannot be used with any other option.\n"
 		"\n"
+		"  --si-emu-threads <num>\n"
+		"      Number of host threads used by the functional emulation of the Southern\n"
+		"      Islands GPU. Independent work-groups of an ND-Range are executed in\n"
+		"      parallel, sharing the GPU global memory. Default is 1.\n"
+		"\n"
 		"  --si-help\n"
 		"      Display a help message describing the format of the Southern Islands GPU\n"
 		"      configuration file, passed with option '--si-config <file>'.\n"
@@ -507,7 +624,23 @@ static char *m2s_help =
 		"  --mem-report\n"
 		"      File for a report on the memory hierarchy, including cache hits, misses,\n"
 		"      evictions, etc. This option must be used together with detailed simulation\n"
-		"      of any CPU/GPU architecture.\n"
+		"      of any CPU/GPU architecture, or with option '--mem-sim'.\n"
+		"\n"
+		"  --mem-sim <trace>\n"
+		"      Run a trace-driven simulation of the memory hierarchy, without any CPU or\n"
+		"      GPU model. Accesses in <trace> are issued into the entry modules given in\n"
+		"      the memory configuration file (option '--mem-config'), where each\n"
+		"      [Entry <name>] section associates a trace core (variable 'Core') with a\n"
+		"      module (variable 'Module'). The trace can be compressed with gzip, and\n"
+		"      contains one access per line with format\n"
+		"        <core> <gap> <pc> <address> {Load|Store|NCStore|Prefetch}\n"
+		"      where <gap> is the number of cycles since the previous access of the same\n"
+		"      core was issued. A compact binary format is also accepted, as described\n"
+		"      in 'mem-system/mem-sim.h'.\n"
+		"\n"
+		"  --mem-sim-max-in-flight <num>\n"
+		"      Maximum number of in-flight accesses per core in trace-driven simulation\n"
+		"      of the memory hierarchy (default 16).\n"
 		"\n"
 		"\n"
 		"================================================================================\n"
@@ -527,12 +660,37 @@ static char *m2s_help =
 		"      Print help message describing the network configuration file, passed to\n"
 		"      the simulator with option '--net-config <file>'.\n"
 		"\n"
+		"  --net-hotspot-fraction <fraction>\n"
+		"  --net-hotspot-node <node>\n"
+		"      For network simulation with 'hotspot' traffic, fraction of messages sent\n"
+		"      to the hotspot end node (default 0.1), and name of the hotspot node\n"
+		"      (default is the first end node in the network).\n"
+		"\n"
 		"  --net-injection-rate <rate>\n"
 		"      For network simulation, packet injection rate for nodes (e.g. 0.01 means\n"
 		"      one packet every 100 cycles on average. Nodes will inject packets into\n"
 		"      the network using random delays with exponential distribution with lambda\n"
 		"      = <rate>. This option must be used together with '--net-sim'.\n"
 		"\n"
+		"  --net-injection-sweep <first>:<last>:<step>\n"
+		"      For network simulation, run one load point for each injection rate from\n"
+		"      <first> to <last>, each one for the number of cycles given in option\n"
+		"      '--net-max-cycles' and followed by a drain of the network. The offered\n"
+		"      and accepted traffic, average latency, and saturation rate are dumped in\n"
+		"      the network report, or in the standard output if there is no report.\n"
+		"      A load point is saturated when the accepted traffic is below 90% of the\n"
+		"      offered traffic, or when its latency is over twice the latency of the\n"
+		"      first load point. Not valid with traffic patterns 'trace' and\n"
+		"      'command'.\n"
+		"\n"
+		"  --net-msg-trace <file>\n"
+		"      Capture all messages sent through networks into a compressed binary\n"
+		"      trace, including messages between modules of the memory hierarchy in\n"
+		"      a full-system simulation. The trace can be replayed in a network\n"
+		"      simulation with options '--net-traffic-pattern trace' and\n"
+		"      '--net-traffic-trace <file>', on a network with the same name and end\n"
+		"      node names.\n"
+		"\n"
 		"  --net-max-cycles <cycles>\n"
 		"      Maximum number of cycles for network simulation. This option must be used\n"
 		"      together with option '--net-sim'.\n"
@@ -543,6 +701,11 @@ static char *m2s_help =
 		"      depend on the message size and the link bandwidth. This option must be\n"
 		"      used together with '--net-sim'.\n"
 		"\n"
+		"  --net-routing-threads <num>\n"
+		"      Number of host threads used to calculate the routing tables of\n"
+		"      networks. Routes to different destinations are calculated in\n"
+		"      parallel, which speeds up the initialization of large networks.\n"
+		"\n"
 		"  --net-report <file>\n"
 		"      File to dump detailed statistics for each network defined in the network\n"
 		"      configuration file (option '--net-config'). The report includes statistics\n"
@@ -557,6 +720,39 @@ static char *m2s_help =
 		"      Runs a network simulation using synthetic traffic, where <network> is the\n"
 		"      name of a network specified in the network configuration file (option\n"
 		"      '--net-config').\n"
+		"\n"
+		"  --net-traffic-pattern <pattern>\n"
+		"      Traffic pattern for network simulation. Possible values are:\n"
+		"        uniform - Random destinations (default).\n"
+		"        transpose - Node (x, y) sends to node (y, x).\n"
+		"        bitcomp - Node i sends to node ~i.\n"
+		"        bitrev - Node i sends to the node with the bits of i reversed.\n"
+		"        tornado - Node (x, y) sends half way around each dimension.\n"
+		"        neighbor - Node (x, y) sends to node (x + 1, y + 1).\n"
+		"        hotspot - Uniform traffic, with a fraction of messages sent to one\n"
+		"          node (see option '--net-hotspot-fraction').\n"
+		"        trace - Messages read from a trace file (see '--net-traffic-trace').\n"
+		"        command - Messages injected with commands in the network\n"
+		"          configuration file.\n"
+		"      End nodes are numbered in the order they are created. If their number is\n"
+		"      a perfect square, they form a 2D grid in row-major order. Otherwise, they\n"
+		"      form a ring. Patterns 'bitcomp' and 'bitrev' require a power of 2 end\n"
+		"      nodes, and 'transpose' a square number of end nodes.\n"
+		"\n"
+		"  --net-traffic-trace <file>\n"
+		"      Trace file for network simulation with 'trace' traffic. The file can be a\n"
+		"      binary trace captured with option '--net-msg-trace', from which the\n"
+		"      messages of the simulated network are replayed, or a text file where\n"
+		"      each line contains a message with format '<cycle> <source> <destination>\n"
+		"      <size>'. Source and destination are end node names. Messages are queued\n"
+		"      in their source node until they can be injected.\n"
+		"\n"
+		"  --net-traffic-trace-deps {preserved|relaxed}\n"
+		"      Dependences between messages replayed from a binary trace. With\n"
+		"      preserved dependences (default), a message is injected after the last\n"
+		"      message received by its source node before it was captured, keeping the\n"
+		"      same number of cycles in between. With relaxed dependences, messages are\n"
+		"      injected in the cycle they were captured.\n"
 		"\n";
 
 
@@ -572,6 +768,36 @@ static void m2s_need_argument(int argc, char **argv, int argi)
 }
 
 
+/* Read value '<start>:<end>' of option '--trace-window' */
+static void m2s_read_trace_window(char *option, char *value,
+		enum trace_window_kind_t kind)
+{
+	long long start;
+	long long end;
+	char *sep;
+	int err;
+
+	/* Split */
+	sep = strchr(value, ':');
+	if (!sep)
+		fatal("option %s, value '%s': format <start>:<end> expected",
+				option, value);
+
+	/* Read bounds */
+	*sep = '\0';
+	start = str_to_llint(value, &err);
+	end = err ? 0 : str_to_llint(sep + 1, &err);
+	*sep = ':';
+	if (err)
+		fatal("option %s, value '%s': %s", option, value, str_error(err));
+	if (start < 0 || end <= start)
+		fatal("option %s, value '%s': invalid range", option, value);
+
+	/* Add window */
+	trace_window_add(kind, start, end);
+}
+
+
 static void m2s_read_command_line(int *argc_ptr, char **argv)
 {
 	int argc = *argc_ptr;
@@ -583,12 +809,22 @@ static void m2s_read_command_line(int *argc_ptr, char **argv)
 
 	char *dram_sim_last_option = NULL;
 
+	char *mem_sim_last_option = NULL;
+
 	for (argi = 1; argi < argc; argi++)
 	{
 		/*
 		 * General Options
 		 */
 
+		/* Benchmarks */
+		if (!strcmp(argv[argi], "--bench"))
+		{
+			m2s_need_argument(argc, argv, argi);
+			bench_file_name = argv[++argi];
+			continue;
+		}
+
 		/* Context configuration file */
 		if (!strcmp(argv[argi], "--ctx-config"))
 		{
@@ -612,6 +848,14 @@ static void m2s_read_command_line(int *argc_ptr, char **argv)
 			continue;
 		}
 
+		/* Event-driven simulation profile */
+		if (!strcmp(argv[argi], "--esim-profile"))
+		{
+			m2s_need_argument(argc, argv, argi);
+			esim_profile_file_name = argv[++argi];
+			continue;
+		}
+
 		/* Show help */
 		if (!strcmp(argv[argi], "--help"))
 		{
@@ -631,6 +875,54 @@ static void m2s_read_command_line(int *argc_ptr, char **argv)
 			continue;
 		}
 
+		/* Interval statistics */
+		if (!strcmp(argv[argi], "--stats"))
+		{
+			m2s_need_argument(argc, argv, argi);
+			stats_file_name = argv[++argi];
+			continue;
+		}
+		if (!strcmp(argv[argi], "--stats-binary"))
+		{
+			stats_binary = 1;
+			m2s_stats_option = 1;
+			continue;
+		}
+		if (!strcmp(argv[argi], "--stats-dump"))
+		{
+			m2s_need_argument(argc, argv, argi);
+			stats_dump_file_name = argv[++argi];
+			continue;
+		}
+		if (!strcmp(argv[argi], "--stats-interval"))
+		{
+			m2s_need_argument(argc, argv, argi);
+			stats_interval = str_to_llint(argv[argi + 1], &err);
+			if (err)
+				fatal("option %s, value '%s': %s", argv[argi],
+						argv[argi + 1], str_error(err));
+			if (stats_interval < 1)
+				fatal("option %s, value '%s': interval must be positive",
+						argv[argi], argv[argi + 1]);
+			m2s_stats_option = 1;
+			argi++;
+			continue;
+		}
+
+		/* Configuration sweep */
+		if (!strcmp(argv[argi], "--sweep"))
+		{
+			m2s_need_argument(argc, argv, argi);
+			sweep_file_name = argv[++argi];
+			continue;
+		}
+		if (!strcmp(argv[argi], "--sweep-report"))
+		{
+			m2s_need_argument(argc, argv, argi);
+			sweep_report_file_name = argv[++argi];
+			continue;
+		}
+
 		/* Simulation trace */
 		if (!strcmp(argv[argi], "--trace"))
 		{
@@ -639,6 +931,94 @@ static void m2s_read_command_line(int *argc_ptr, char **argv)
 			continue;
 		}
 
+		/* Print simulation trace */
+		if (!strcmp(argv[argi], "--trace-dump"))
+		{
+			m2s_need_argument(argc, argv, argi);
+			trace_dump_file_name = argv[++argi];
+			continue;
+		}
+
+		/* Plain-text simulation trace */
+		if (!strcmp(argv[argi], "--trace-text"))
+		{
+			trace_text = 1;
+			continue;
+		}
+
+		/* Trace windows */
+		if (!strcmp(argv[argi], "--trace-window"))
+		{
+			m2s_need_argument(argc, argv, argi);
+			m2s_read_trace_window(argv[argi], argv[argi + 1], trace_window_cycle);
+			argi++;
+			continue;
+		}
+		if (!strcmp(argv[argi], "--trace-window-inst"))
+		{
+			m2s_need_argument(argc, argv, argi);
+			m2s_read_trace_window(argv[argi], argv[argi + 1], trace_window_inst);
+			m2s_trace_window_inst = 1;
+			argi++;
+			continue;
+		}
+
+		/* Trace filter */
+		if (!strcmp(argv[argi], "--trace-filter"))
+		{
+			char *sep;
+
+			m2s_need_argument(argc, argv, argi);
+			sep = strchr(argv[argi + 1], '=');
+			if (!sep || sep == argv[argi + 1] || !sep[1])
+				fatal("option %s, value '%s': format <key>=<values> expected",
+						argv[argi], argv[argi + 1]);
+			*sep = '\0';
+			trace_filter_add(argv[argi + 1], sep + 1);
+			*sep = '=';
+			m2s_trace_filter = 1;
+			argi++;
+			continue;
+		}
+
+		/* Trace trigger */
+		if (!strcmp(argv[argi], "--trace-trigger"))
+		{
+			char *sep;
+
+			m2s_need_argument(argc, argv, argi);
+			sep = strrchr(argv[argi + 1], ':');
+			if (!sep || sep == argv[argi + 1])
+				fatal("option %s, value '%s': format <module>:<cycles> expected",
+						argv[argi], argv[argi + 1]);
+			mem_trace_trigger_latency = str_to_int(sep + 1, &err);
+			if (err)
+				fatal("option %s, value '%s': %s", argv[argi],
+						argv[argi + 1], str_error(err));
+			if (mem_trace_trigger_latency < 1)
+				fatal("option %s, value '%s': latency must be positive",
+						argv[argi], argv[argi + 1]);
+			mem_trace_trigger_mod_name = xstrdup(argv[argi + 1]);
+			mem_trace_trigger_mod_name[sep - argv[argi + 1]] = '\0';
+			trace_windowed = 1;
+			argi++;
+			continue;
+		}
+		if (!strcmp(argv[argi], "--trace-trigger-length"))
+		{
+			m2s_need_argument(argc, argv, argi);
+			trace_trigger_length = str_to_llint(argv[argi + 1], &err);
+			if (err)
+				fatal("option %s, value '%s': %s", argv[argi],
+						argv[argi + 1], str_error(err));
+			if (trace_trigger_length < 1)
+				fatal("option %s, value '%s': length must be positive",
+						argv[argi], argv[argi + 1]);
+			m2s_trace_trigger_length = 1;
+			argi++;
+			continue;
+		}
+
 		/* Visualization tool */
 		if (!strcmp(argv[argi], "--visual"))
 		{
@@ -800,6 +1180,18 @@ static void m2s_read_command_line(int *argc_ptr, char **argv)
 			continue;
 		}
 
+		/* x86 functional emulation threads */
+		if (!strcmp(argv[argi], "--x86-emu-threads"))
+		{
+			m2s_need_argument(argc, argv, argi);
+			x86_emu_num_threads = str_to_int(argv[argi + 1], &err);
+			if (err || x86_emu_num_threads < 1)
+				fatal("option %s, value '%s': invalid number of threads",
+						argv[argi], argv[argi + 1]);
+			argi++;
+			continue;
+		}
+
 		/* Maximum number of instructions */
 		if (!strcmp(argv[argi], "--x86-max-inst"))
 		{
@@ -837,6 +1229,22 @@ static void m2s_read_command_line(int *argc_ptr, char **argv)
 			continue;
 		}
 
+		/* Micro-instruction trace replay */
+		if (!strcmp(argv[argi], "--x86-uinst-replay"))
+		{
+			m2s_need_argument(argc, argv, argi);
+			x86_uinst_replay_file_name = argv[++argi];
+			continue;
+		}
+
+		/* Micro-instruction trace capture */
+		if (!strcmp(argv[argi], "--x86-uinst-trace"))
+		{
+			m2s_need_argument(argc, argv, argi);
+			x86_uinst_trace_file_name = argv[++argi];
+			continue;
+		}
+
 
 		/*
 		 * Evergreen GPU Options
@@ -1109,6 +1517,18 @@ static void m2s_read_command_line(int *argc_ptr, char **argv)
 			continue;
 		}
 
+		/* Southern Islands functional emulation threads */
+		if (!strcmp(argv[argi], "--si-emu-threads"))
+		{
+			m2s_need_argument(argc, argv, argi);
+			si_emu_num_threads = str_to_int(argv[argi + 1], &err);
+			if (err || si_emu_num_threads < 1)
+				fatal("option %s, value '%s': invalid number of threads",
+						argv[argi], argv[argi + 1]);
+			argi++;
+			continue;
+		}
+
 
 		/*
 		 * Fermi GPU Options
@@ -1337,6 +1757,27 @@ static void m2s_read_command_line(int *argc_ptr, char **argv)
 			continue;
 		}
 
+		/* Trace-driven memory hierarchy simulation */
+		if (!strcmp(argv[argi], "--mem-sim"))
+		{
+			m2s_need_argument(argc, argv, argi);
+			mem_sim_trace_file_name = argv[++argi];
+			continue;
+		}
+
+		/* Maximum in-flight accesses per core in trace-driven simulation */
+		if (!strcmp(argv[argi], "--mem-sim-max-in-flight"))
+		{
+			m2s_need_argument(argc, argv, argi);
+			mem_sim_last_option = argv[argi];
+			mem_sim_max_in_flight = str_to_int(argv[argi + 1], &err);
+			if (err || mem_sim_max_in_flight < 1)
+				fatal("option %s, value '%s': invalid number of accesses",
+						argv[argi], argv[argi + 1]);
+			argi++;
+			continue;
+		}
+
 
 
 
@@ -1368,6 +1809,26 @@ static void m2s_read_command_line(int *argc_ptr, char **argv)
 			continue;
 		}
 
+		/* Hotspot traffic */
+		if (!strcmp(argv[argi], "--net-hotspot-fraction"))
+		{
+			m2s_need_argument(argc, argv, argi);
+			net_sim_last_option = argv[argi];
+			argi++;
+			net_hotspot_fraction = atof(argv[argi]);
+			if (net_hotspot_fraction < 0.0 || net_hotspot_fraction > 1.0)
+				fatal("option %s: value must be between 0 and 1",
+						argv[argi - 1]);
+			continue;
+		}
+		if (!strcmp(argv[argi], "--net-hotspot-node"))
+		{
+			m2s_need_argument(argc, argv, argi);
+			net_sim_last_option = argv[argi];
+			net_hotspot_node_name = argv[++argi];
+			continue;
+		}
+
 		/* Injection rate for network simulation */
 		if (!strcmp(argv[argi], "--net-injection-rate"))
 		{
@@ -1378,6 +1839,15 @@ static void m2s_read_command_line(int *argc_ptr, char **argv)
 			continue;
 		}
 
+		/* Injection rate sweep */
+		if (!strcmp(argv[argi], "--net-injection-sweep"))
+		{
+			m2s_need_argument(argc, argv, argi);
+			net_sim_last_option = argv[argi];
+			net_injection_sweep = argv[++argi];
+			continue;
+		}
+
 		/* Traffic Pattern */
 		if (!strcmp(argv[argi], "--net-traffic-pattern"))
 		{
@@ -1386,6 +1856,23 @@ static void m2s_read_command_line(int *argc_ptr, char **argv)
 			net_traffic_pattern = argv[++argi];
 			continue;
 		}
+
+		/* Traffic trace */
+		if (!strcmp(argv[argi], "--net-traffic-trace"))
+		{
+			m2s_need_argument(argc, argv, argi);
+			net_sim_last_option = argv[argi];
+			net_traffic_trace_file_name = argv[++argi];
+			continue;
+		}
+		if (!strcmp(argv[argi], "--net-traffic-trace-deps"))
+		{
+			m2s_need_argument(argc, argv, argi);
+			net_sim_last_option = argv[argi];
+			net_traffic_trace_deps = argv[++argi];
+			continue;
+		}
+
 		/* Cycles for network simulation */
 		if (!strcmp(argv[argi], "--net-max-cycles"))
 		{
@@ -1399,6 +1886,14 @@ static void m2s_read_command_line(int *argc_ptr, char **argv)
 			continue;
 		}
 
+		/* Network message trace */
+		if (!strcmp(argv[argi], "--net-msg-trace"))
+		{
+			m2s_need_argument(argc, argv, argi);
+			net_msg_trace_file_name = argv[++argi];
+			continue;
+		}
+
 		/* Network message size */
 		if (!strcmp(argv[argi], "--net-msg-size"))
 		{
@@ -1409,6 +1904,18 @@ static void m2s_read_command_line(int *argc_ptr, char **argv)
 			continue;
 		}
 
+		/* Threads for routing table calculation */
+		if (!strcmp(argv[argi], "--net-routing-threads"))
+		{
+			m2s_need_argument(argc, argv, argi);
+			net_routing_threads = str_to_int(argv[argi + 1], &err);
+			if (err || net_routing_threads < 1)
+				fatal("option %s, value '%s': invalid number of threads",
+						argv[argi], argv[argi + 1]);
+			argi++;
+			continue;
+		}
+
 		/* Network report file */
 		if (!strcmp(argv[argi], "--net-report"))
 		{
@@ -1524,6 +2031,10 @@ static void m2s_read_command_line(int *argc_ptr, char **argv)
 			fatal(msg, "--x86-max-cycles");
 		if (*x86_cpu_report_file_name)
 			fatal(msg, "--x86-report");
+		if (*x86_uinst_replay_file_name)
+			fatal(msg, "--x86-uinst-replay");
+		if (*sweep_file_name)
+			fatal(msg, "--sweep");
 	}
 
 	/* Options that only make sense for GPU detailed simulation */
@@ -1587,12 +2098,59 @@ static void m2s_read_command_line(int *argc_ptr, char **argv)
 		fatal("option '--frm-disasm' is incompatible with any other options.");
 	if (*x86_disasm_file_name && argc > 3)
 		fatal("option '--x86-disasm' is incompatible with other options.");
+	if (*trace_dump_file_name && argc > 3)
+		fatal("option '--trace-dump' is incompatible with other options.");
+	if (*stats_dump_file_name && argc > 3)
+		fatal("option '--stats-dump' is incompatible with other options.");
+	if (*bench_file_name && argc > 3)
+		fatal("option '--bench' is incompatible with other options.");
+#ifdef NO_HOT_DEBUG
+	if (*x86_isa_debug_file_name || *x86_call_debug_file_name ||
+			*mem_debug_file_name || *evg_isa_debug_file_name ||
+			*si_isa_debug_file_name || *frm_isa_debug_file_name ||
+			*arm_isa_debug_file_name || *arm_call_debug_file_name ||
+			*mips_isa_debug_file_name || *mips_call_debug_file_name)
+		fatal("ISA, call, and memory hierarchy debug options are not available.\n"
+			"\tThe simulator was built with flag '-DNO_HOT_DEBUG'.");
+#endif
+	if (*sweep_report_file_name && !*sweep_file_name)
+		fatal("option '--sweep-report' requires '--sweep'");
+	if (*sweep_file_name && (*trace_file_name || *stats_file_name ||
+			*x86_cpu_report_file_name || *mem_report_file_name ||
+			*x86_uinst_trace_file_name || *x86_uinst_replay_file_name ||
+			*x86_save_checkpoint_file_name))
+		fatal("option '--sweep' is incompatible with options '--trace', "
+			"'--stats', '--x86-report', '--mem-report', '--x86-uinst-trace', "
+			"'--x86-uinst-replay', and '--x86-save-checkpoint'.");
+	if (m2s_stats_option && !*stats_file_name)
+		fatal("options '--stats-interval' and '--stats-binary' require '--stats'");
+	if (trace_text && !*trace_file_name)
+		fatal("option '--trace-text' requires '--trace'");
+	if ((trace_windowed || m2s_trace_filter) && !*trace_file_name)
+		fatal("trace windows, filters, and triggers require option '--trace'");
+	if (m2s_trace_trigger_length && !*mem_trace_trigger_mod_name)
+		fatal("option '--trace-trigger-length' requires '--trace-trigger'");
+	if (*x86_uinst_replay_file_name && (argi < argc || *ctx_config_file_name ||
+			*x86_load_checkpoint_file_name))
+		fatal("option '--x86-uinst-replay' is incompatible with a program, "
+			"a context configuration file, or a checkpoint.");
+	if (*x86_uinst_replay_file_name && *x86_uinst_trace_file_name)
+		fatal("options '--x86-uinst-replay' and '--x86-uinst-trace' are incompatible.");
 	if (!*net_sim_network_name && net_sim_last_option)
 		fatal("option '%s' requires '--net-sim'", net_sim_last_option);
 	if (*net_sim_network_name && !*net_config_file_name)
 		fatal("option '--net-sim' requires '--net-config'");
+	if (*net_injection_sweep && (!strcasecmp(net_traffic_pattern, "trace") ||
+			!strcasecmp(net_traffic_pattern, "command")))
+		fatal("option '--net-injection-sweep' is incompatible with traffic "
+			"pattern '%s'.\n\tThis pattern does not use an injection "
+			"rate.", net_traffic_pattern);
 	if(!*dram_sim_system_name && dram_sim_last_option)
 		fatal("option '%s' requires '--dram-sim'", dram_sim_last_option);
+	if (!*mem_sim_trace_file_name && mem_sim_last_option)
+		fatal("option '%s' requires '--mem-sim'", mem_sim_last_option);
+	if (*mem_sim_trace_file_name && !*mem_config_file_name)
+		fatal("option '--mem-sim' requires '--mem-config'");
 
 	/* Discard arguments used as options */
 	arg_discard = argi - 1;
@@ -1840,6 +2398,24 @@ static void m2s_init(void)
 }
 
 
+/* Number of instructions emulated by all architectures */
+static void m2s_add_inst_count(struct arch_t *arch, void *user_data)
+{
+	long long *inst_count_ptr = user_data;
+
+	if (arch->emu)
+		*inst_count_ptr += arch->emu->instructions;
+}
+
+static long long m2s_inst_count(void)
+{
+	long long inst_count = 0;
+
+	arch_for_each(m2s_add_inst_count, &inst_count);
+	return inst_count;
+}
+
+
 static void m2s_loop(void)
 {
 	int num_emu_active;
@@ -1864,6 +2440,14 @@ static void m2s_loop(void)
 		 * The argument 'num_timing_active' is interpreted as a flag TRUE/FALSE. */
 		esim_process_events(num_timing_active);
 
+		/* Sample interval statistics */
+		if (stats_active)
+			stats_update();
+
+		/* Open and close trace windows */
+		if (trace_windowed)
+			trace_update(m2s_trace_window_inst ? m2s_inst_count() : 0);
+
 		/* If neither functional nor timing simulation was performed for any architecture,
 		 * it means that all guest contexts finished execution - simulation can end. */
 		if (!num_emu_active && !num_timing_active)
@@ -1889,6 +2473,56 @@ static void m2s_loop(void)
 }
 
 
+/* Timing simulators, network, and memory system, created after the x86
+ * emulator */
+static void m2s_init_timing(void)
+{
+	long long inst;
+
+	if (x86_sim_kind == arch_sim_kind_detailed)
+	{
+		x86_cpu = new(X86Cpu, x86_emu);
+		arch_set_timing(arch_x86, asTiming(x86_cpu));
+
+		/* Instructions emulated before creating the CPU, in a
+		 * configuration sweep, count as fast-forwarded. */
+		inst = asEmu(x86_emu)->instructions;
+		if (x86_cpu_fast_forward_count < inst)
+		{
+			x86_cpu_fast_forward_count = inst;
+			x86_cpu->num_fast_forward_inst = inst;
+		}
+	}
+	net_init();
+	mem_system_init();
+}
+
+
+/* Configuration sweep. The parent process fast-forwards the loaded programs
+ * and does not return. Every child process continues here with the file names
+ * of one configuration. */
+static void m2s_sweep(void)
+{
+	unsigned int page_size;
+	int num_nodes;
+
+	page_size = mmu_page_size;
+	num_nodes = x86_cpu_num_cores * x86_cpu_num_threads;
+	sweep_run();
+
+	/* Configuration of the child */
+	X86CpuReadConfig();
+	if (x86_cpu_num_cores * x86_cpu_num_threads != num_nodes)
+		fatal("%s: number of x86 cores and threads differs from the "
+			"configuration used to load programs in the sweep",
+			x86_config_file_name);
+	m2s_init_timing();
+	if (mmu_page_size != page_size)
+		fatal("%s: MMU page size differs from the one used to load "
+			"programs in the sweep", mem_config_file_name);
+}
+
+
 int main(int argc, char **argv)
 {
 	/* Global initialization and welcome message */
@@ -1937,6 +2571,27 @@ int main(int argc, char **argv)
 	if (*visual_file_name)
 		visual_run(visual_file_name);
 
+	/* Trace printing tool */
+	if (*trace_dump_file_name)
+	{
+		trace_dump(trace_dump_file_name, stdout);
+		exit(0);
+	}
+
+	/* Statistics printing tool */
+	if (*stats_dump_file_name)
+	{
+		stats_dump(stats_dump_file_name, stdout);
+		exit(0);
+	}
+
+	/* Benchmarks */
+	if (*bench_file_name)
+	{
+		bench_run(bench_file_name);
+		exit(0);
+	}
+
 	/* Network simulation tool */
 	if (*net_sim_network_name)
 		net_sim(net_debug_file_name);
@@ -1945,6 +2600,10 @@ int main(int argc, char **argv)
 	if (*dram_sim_system_name)
 		dram_system_sim(dram_debug_file_name);
 
+	/* Trace-driven memory hierarchy simulation tool */
+	if (*mem_sim_trace_file_name)
+		mem_sim(mem_debug_file_name);
+
 	/* Southern Islands dump config file */
 	if (*si_gpu_dump_default_config_file_name)
 		si_gpu_dump_default_config(si_gpu_dump_default_config_file_name);
@@ -1961,26 +2620,30 @@ int main(int argc, char **argv)
 	opencl_debug_category = debug_new_category(opencl_debug_file_name);
 	cuda_debug_category = debug_new_category(cuda_debug_file_name);
 	x86_context_debug_category = debug_new_category(x86_ctx_debug_file_name);
-	x86_context_isa_debug_category = debug_new_category(x86_isa_debug_file_name);
-	x86_context_call_debug_category = debug_new_category(x86_call_debug_file_name);
 	x86_loader_debug_category = debug_new_category(x86_loader_debug_file_name);
 	x86_sys_debug_category = debug_new_category(x86_sys_debug_file_name);
 	x86_trace_cache_debug_category = debug_new_category(x86_trace_cache_debug_file_name);
-	mem_debug_category = debug_new_category(mem_debug_file_name);
 	evg_opencl_debug_category = debug_new_category(evg_opencl_debug_file_name);
-	evg_isa_debug_category = debug_new_category(evg_isa_debug_file_name);
 	evg_stack_debug_category = debug_new_category(evg_stack_debug_file_name);  /* GPU-REL */
 	evg_faults_debug_category = debug_new_category(evg_faults_debug_file_name);  /* GPU-REL */
+	arm_loader_debug_category = debug_new_category(arm_loader_debug_file_name);
+	arm_sys_debug_category = debug_new_category(arm_sys_debug_file_name);
+	mips_loader_debug_category = debug_new_category(mips_loader_debug_file_name);
+	mips_sys_debug_category = debug_new_category(mips_sys_debug_file_name);
+
+	/* Hot-path debug categories, see 'debug.h' */
+#ifndef NO_HOT_DEBUG
+	x86_context_isa_debug_category = debug_new_category(x86_isa_debug_file_name);
+	x86_context_call_debug_category = debug_new_category(x86_call_debug_file_name);
+	mem_debug_category = debug_new_category(mem_debug_file_name);
+	evg_isa_debug_category = debug_new_category(evg_isa_debug_file_name);
 	si_isa_debug_category = debug_new_category(si_isa_debug_file_name);
 	frm_isa_debug_category = debug_new_category(frm_isa_debug_file_name);
-	arm_loader_debug_category = debug_new_category(arm_loader_debug_file_name);
 	arm_isa_inst_debug_category = debug_new_category(arm_isa_debug_file_name);
-	arm_sys_debug_category = debug_new_category(arm_sys_debug_file_name);
 	arm_isa_call_debug_category = debug_new_category(arm_call_debug_file_name);
-	mips_loader_debug_category = debug_new_category(mips_loader_debug_file_name);
 	mips_isa_inst_debug_category = debug_new_category(mips_isa_debug_file_name);
-	mips_sys_debug_category = debug_new_category(mips_sys_debug_file_name);
 	mips_isa_call_debug_category = debug_new_category(mips_call_debug_file_name);
+#endif
 
 	/* Initialization of runtimes */
 	runtime_init();
@@ -2001,6 +2664,7 @@ int main(int argc, char **argv)
 	/* Initialization of libraries */
 	esim_init();
 	trace_init(trace_file_name);
+	stats_init(stats_file_name);
 
 	/* Initialization of architectures */
 	arch_arm = arch_register("ARM", "arm", arm_sim_kind,
@@ -2055,25 +2719,27 @@ int main(int argc, char **argv)
 	 * better once the process finish. But now we need to release 4.2...
 	 */
 	X86CpuInit();
-	if (x86_sim_kind == arch_sim_kind_detailed)
-	{
-		x86_cpu = new(X86Cpu, x86_emu);
-		arch_set_timing(arch_x86, asTiming(x86_cpu));
-	}
 	arch_set_emu(arch_x86, asEmu(x86_emu));
 
-
-	/* Network and memory system */
-	net_init();
-	mem_system_init();
+	/* Timing simulators, network, and memory system. In a configuration
+	 * sweep, they are created by each child process. */
+	if (!*sweep_file_name)
+		m2s_init_timing();
 	mmu_init();
 
 	/* Load architectural state checkpoint */
 	if (x86_load_checkpoint_file_name[0])
 		X86EmuLoadCheckpoint(x86_emu, x86_load_checkpoint_file_name);
 
-	/* Load programs */
-	m2s_load_programs(argc, argv);
+	/* Load programs, or contexts from a micro-instruction trace */
+	if (*x86_uinst_replay_file_name)
+		x86_uinst_replay_init(x86_emu);
+	else
+		m2s_load_programs(argc, argv);
+
+	/* Configuration sweep */
+	if (*sweep_file_name)
+		m2s_sweep();
 
 	/* Multi2Sim Central Simulation Loop */
 	m2s_loop();
@@ -2089,7 +2755,23 @@ int main(int argc, char **argv)
 		esim_process_all_events();
 
 	/* Dump statistics summary */
-	m2s_dump_summary(stderr);
+	if (*sweep_summary_file_name)
+	{
+		FILE *f;
+
+		f = file_open_for_write(sweep_summary_file_name);
+		if (!f)
+			fatal("%s: cannot write summary", sweep_summary_file_name);
+		m2s_dump_summary(f);
+		file_close(f);
+	}
+	else
+	{
+		m2s_dump_summary(stderr);
+	}
+
+	/* Last interval statistics sample, before counters are freed */
+	stats_done();
 
 	/* x86 */
 	if (x86_cpu)
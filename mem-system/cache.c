@@ -184,8 +184,8 @@ void cache_free(struct cache_t *cache)
 
 
 /* Return {set, tag, offset} for a given address */
-void cache_decode_address(struct cache_t *cache, unsigned int addr, int *set_ptr, int *tag_ptr, 
-	unsigned int *offset_ptr)
+void cache_decode_address(struct cache_t *cache, unsigned long long addr, int *set_ptr,
+	unsigned long long *tag_ptr, unsigned int *offset_ptr)
 {
 	PTR_ASSIGN(set_ptr, (addr >> cache->log_block_size) % cache->num_sets);
 	PTR_ASSIGN(tag_ptr, addr & ~cache->block_mask);
@@ -196,10 +196,11 @@ void cache_decode_address(struct cache_t *cache, unsigned int addr, int *set_ptr
 /* Look for a block in the cache. If it is found and its state is other than 0,
  * the function returns 1 and the state and way of the block are also returned.
  * The set where the address would belong is returned anyways. */
-int cache_find_block(struct cache_t *cache, unsigned int addr, int *set_ptr, int *way_ptr, 
+int cache_find_block(struct cache_t *cache, unsigned long long addr, int *set_ptr, int *way_ptr, 
 	int *state_ptr)
 {
-	int set, tag, way;
+	unsigned long long tag;
+	int set, way;
 
 	/* Locate block */
 	tag = addr & ~cache->block_mask;
@@ -224,12 +225,13 @@ int cache_find_block(struct cache_t *cache, unsigned int addr, int *set_ptr, int
 /* Set the tag and state of a block.
  * If replacement policy is FIFO, update linked list in case a new
  * block is brought to cache, i.e., a new tag is set. */
-void cache_set_block(struct cache_t *cache, int set, int way, int tag, int state)
+void cache_set_block(struct cache_t *cache, int set, int way, unsigned long long tag,
+	int state)
 {
 	assert(set >= 0 && set < cache->num_sets);
 	assert(way >= 0 && way < cache->assoc);
 
-	mem_trace("mem.set_block cache=\"%s\" set=%d way=%d tag=0x%x state=\"%s\"\n",
+	mem_trace("mem.set_block cache=\"%s\" set=%d way=%d tag=0x%llx state=\"%s\"\n",
 			cache->name, set, way, tag,
 			str_map_value(&cache_block_state_map, state));
 
@@ -243,7 +245,8 @@ void cache_set_block(struct cache_t *cache, int set, int way, int tag, int state
 }
 
 
-void cache_get_block(struct cache_t *cache, int set, int way, int *tag_ptr, int *state_ptr)
+void cache_get_block(struct cache_t *cache, int set, int way,
+	unsigned long long *tag_ptr, int *state_ptr)
 {
 	assert(set >= 0 && set < cache->num_sets);
 	assert(way >= 0 && way < cache->assoc);
@@ -306,7 +309,8 @@ int cache_replace_block(struct cache_t *cache, int set)
 }
 
 
-void cache_set_transient_tag(struct cache_t *cache, int set, int way, int tag)
+void cache_set_transient_tag(struct cache_t *cache, int set, int way,
+	unsigned long long tag)
 {
 	struct cache_block_t *block;
 
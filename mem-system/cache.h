@@ -47,8 +47,8 @@ struct cache_block_t
 	struct cache_block_t *way_next;
 	struct cache_block_t *way_prev;
 
-	int tag;
-	int transient_tag;
+	unsigned long long tag;
+	unsigned long long transient_tag;
 	int way;
 	int prefetched;
 
@@ -72,7 +72,7 @@ struct cache_t
 	enum cache_policy_t policy;
 
 	struct cache_set_t *sets;
-	unsigned int block_mask;
+	unsigned long long block_mask;
 	int log_block_size;
 
 	struct prefetcher_t *prefetcher;
@@ -83,16 +83,19 @@ struct cache_t *cache_create(char *name, unsigned int num_sets, unsigned int blo
 	unsigned int assoc, enum cache_policy_t policy);
 void cache_free(struct cache_t *cache);
 
-void cache_decode_address(struct cache_t *cache, unsigned int addr,
-	int *set_ptr, int *tag_ptr, unsigned int *offset_ptr);
-int cache_find_block(struct cache_t *cache, unsigned int addr, int *set_ptr, int *pway, 
+void cache_decode_address(struct cache_t *cache, unsigned long long addr,
+	int *set_ptr, unsigned long long *tag_ptr, unsigned int *offset_ptr);
+int cache_find_block(struct cache_t *cache, unsigned long long addr, int *set_ptr, int *pway, 
 	int *state_ptr);
-void cache_set_block(struct cache_t *cache, int set, int way, int tag, int state);
-void cache_get_block(struct cache_t *cache, int set, int way, int *tag_ptr, int *state_ptr);
+void cache_set_block(struct cache_t *cache, int set, int way, unsigned long long tag,
+	int state);
+void cache_get_block(struct cache_t *cache, int set, int way,
+	unsigned long long *tag_ptr, int *state_ptr);
 
 void cache_access_block(struct cache_t *cache, int set, int way);
 int cache_replace_block(struct cache_t *cache, int set);
-void cache_set_transient_tag(struct cache_t *cache, int set, int way, int tag);
+void cache_set_transient_tag(struct cache_t *cache, int set, int way,
+	unsigned long long tag);
 
 
 #endif
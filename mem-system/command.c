@@ -62,14 +62,14 @@ static void mem_system_command_end(struct list_t *token_list, char *command_line
 }
 
 
-static unsigned int mem_system_command_get_hex(struct list_t *token_list,
+static unsigned long long mem_system_command_get_hex(struct list_t *token_list,
 	char *command_line)
 {
-	unsigned int value;
+	unsigned long long value;
 
 	/* Get value */
 	mem_system_command_expect(token_list, command_line);
-	if (sscanf(str_token_list_first(token_list), "0x%x", &value) != 1)
+	if (sscanf(str_token_list_first(token_list), "0x%llx", &value) != 1)
 		fatal("%s: %s: invalid hex value.\n\t> %s",
 			__FUNCTION__, str_token_list_first(token_list),
 			command_line);
@@ -338,10 +338,10 @@ void mem_system_command_handler(int event, void *data)
 
 		int set;
 		int way;
-		int tag;
+		unsigned long long tag;
 
 		int set_check;
-		int tag_check;
+		unsigned long long tag_check;
 
 		int state;
 
@@ -353,13 +353,13 @@ void mem_system_command_handler(int event, void *data)
 
 		/* Check that module serves address */
 		if (!mod_serves_address(mod, tag))
-			fatal("%s: %s: module does not serve address 0x%x.\n\t> %s",
+			fatal("%s: %s: module does not serve address 0x%llx.\n\t> %s",
 				__FUNCTION__, mod->name, tag, command_line);
 
 		/* Check that tag goes to specified set */
 		mod_find_block(mod, tag, &set_check, NULL, &tag_check, NULL);
 		if (set != set_check)
-			fatal("%s: %s: tag 0x%x belongs to set %d.\n\t> %s",
+			fatal("%s: %s: tag 0x%llx belongs to set %d.\n\t> %s",
 				__FUNCTION__, mod->name, tag, set_check, command_line);
 		if (tag != tag_check)
 			fatal("%s: %s: tag should be multiple of block size.\n\t> %s",
@@ -442,7 +442,7 @@ void mem_system_command_handler(int event, void *data)
 	{
 		struct mod_t *mod;
 		enum mod_access_kind_t access_kind;
-		unsigned int addr;
+		unsigned long long addr;
 
 		long long command_cycle;
 		long long cycle;
@@ -519,8 +519,8 @@ void mem_system_end_command_handler(int event, void *data)
 
 		int set;
 		int way;
-		int tag;
-		int tag_check;
+		unsigned long long tag;
+		unsigned long long tag_check;
 
 		int state;
 		int state_check;
@@ -533,12 +533,12 @@ void mem_system_end_command_handler(int event, void *data)
 
 		/* Check that module serves address */
 		if (!mod_serves_address(mod, tag))
-			fatal("%s: %s: module does not serve address 0x%x.\n\t> %s",
+			fatal("%s: %s: module does not serve address 0x%llx.\n\t> %s",
 				__FUNCTION__, mod->name, tag, command_line);
 
 		/* Output */
 		str_printf(&msg_str, &msg_size,
-			"check module %s, set %d, way %d - state %s, tag 0x%x",
+			"check module %s, set %d, way %d - state %s, tag 0x%llx",
 			mod->name, set, way, str_map_value(&cache_block_state_map, state), tag);
 
 		/* Check */
@@ -547,7 +547,7 @@ void mem_system_end_command_handler(int event, void *data)
 		{
 			test_failed = 1;
 			str_printf(&msg_detail_str, &msg_detail_size,
-				"\ttag 0x%x found, but 0x%x expected\n",
+				"\ttag 0x%llx found, but 0x%llx expected\n",
 				tag_check, tag);
 		}
 		if (state != state_check)
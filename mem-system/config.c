@@ -35,6 +35,7 @@
 #include "cache.h"
 #include "command.h"
 #include "directory.h"
+#include "mem-sim.h"
 #include "mem-system.h"
 #include "mmu.h"
 #include "module.h"
@@ -100,7 +101,9 @@ char *mem_config_help =
 	"  LowNetworkNode = <node>\n"
 	"      If 'LowNetwork' points to an external network, node in the network\n"
 	"      that the module is mapped to. For internal networks, this variable\n"
-	"      should be omitted.\n"
+	"      should be omitted. In networks with a generated Ring, Mesh2D, or\n"
+	"      Torus2D topology, the node can also be given as '<x>,<y>', the\n"
+	"      coordinates of the switch the end node is attached to.\n"
 	"  HighNetwork = <net>\n"
 	"      Network connecting the module with other higher-level modules, i.e.,\n"
 	"      modules closer to CPU cores or GPU compute units. For highest level\n"
@@ -139,8 +142,8 @@ char *mem_config_help =
 	"      allowed for a main memory module.\n"
 	"  AddressRange = { BOUNDS <low> <high> | ADDR DIV <div> MOD <mod> EQ <eq> }\n"
 	"      Physical address range served by the module. If not specified, the\n"
-	"      entire address space is served by the module. There are two possible\n"
-	"      formats for the value of 'Range':\n"
+	"      entire 64-bit address space is served by the module. There are two\n"
+	"      possible formats for the value of 'Range':\n"
 	"      With the first format, the user can specify the lowest and highest\n"
 	"      byte included in the address range. The value in <low> must be a\n"
 	"      multiple of the module block size, and the value in <high> must be a\n"
@@ -170,9 +173,11 @@ char *mem_config_help =
 	"      Block replacement policy.\n"
 	"  MSHR = <size> (Default = 16)\n"
 	"      Miss status holding register (MSHR) size in number of entries. This\n"
-	"      value determines the maximum number of accesses that can be in flight\n"
-	"      for the cache, including the time since the access request is\n"
-	"      received, until a potential miss is resolved.\n"
+	"      value determines the maximum number of blocks that can have accesses\n"
+	"      in flight for the cache, including the time since the access request\n"
+	"      is received, until a potential miss is resolved. Accesses to a block\n"
+	"      with an allocated entry are merged into it. When all entries are\n"
+	"      busy, new accesses wait for an entry to be released.\n"
 	"  Ports = <num> (Default = 2)\n"
 	"      Number of ports. The number of ports in a cache limits the number of\n"
 	"      concurrent hits. If an access is a miss, it remains in the MSHR while\n"
@@ -196,6 +201,12 @@ char *mem_config_help =
 	"  PrefetcherLookupDepth = <num> (Default = 2)\n"
 	"      This option specifies the history (pattern) depth upto which the\n"
 	"      prefetcher looks at the history to decide when to prefetch.\n"
+	"  PrefetcherThrottleInterval = <cycles> (Default = 0)\n"
+	"      Enable feedback-directed prefetcher throttling, re-evaluated every\n"
+	"      <cycles> cycles. At the end of each interval, the prefetch distance\n"
+	"      and degree are adjusted based on the measured prefetch accuracy,\n"
+	"      lateness, and cache pollution. A value of 0 disables throttling,\n"
+	"      and only the next address of each detected pattern is prefetched.\n"
 	"\n"
 	"Section [Network <net>] defines an internal default interconnect, formed of\n"
 	"a single switch connecting all modules pointing to the network. For every\n"
@@ -209,6 +220,12 @@ char *mem_config_help =
 	"      Size of output buffers for end nodes and switch. \n"
 	"  DefaultBandwidth = <bandwidth>\n"
 	"      Bandwidth for links and switch crossbar in number of bytes per cycle.\n"
+	"  Switching = {StoreAndForward|VirtualCutThrough|Wormhole}\n"
+	"      (Default = StoreAndForward)\n"
+	"      Switching technique used in the network. See the network\n"
+	"      configuration help for details.\n"
+	"  FlitSize = <size> (Default = DefaultBandwidth)\n"
+	"      Flit size in bytes for virtual cut-through and wormhole switching.\n"
 	"\n"
 	"Section [Entry <name>] creates an entry into the memory system. An entry is\n"
 	"a connection between a CPU core/thread or a GPU compute unit with a module\n"
@@ -237,6 +254,11 @@ char *mem_config_help =
 	"      supporting separate data/instruction caches, this variable can be used\n"
 	"      instead of 'DataModule', 'InstModule', and 'ConstantDataModule' to\n"
 	"      indicate that data and instruction caches are unified.\n"
+	"\n"
+	"In a trace-driven simulation of the memory hierarchy (option '--mem-sim'),\n"
+	"each [Entry <name>] section associates a core of the trace, given in variable\n"
+	"'Core', with the module given in 'Module' or 'DataModule'. Variables 'Arch',\n"
+	"'Thread', and 'InstModule' are ignored.\n"
 	"\n";
 
 
@@ -343,6 +365,8 @@ static void mem_config_read_general(struct config_t *config)
 static void mem_config_read_networks(struct config_t *config)
 {
 	struct net_t *net;
+	int switching;
+	int flit_size;
 	int i;
 
 	char buf[MAX_STRING_SIZE];
@@ -384,6 +408,16 @@ static void mem_config_read_networks(struct config_t *config)
 		config_var_enforce(config, buf, "DefaultInputBufferSize");
 		config_var_enforce(config, buf, "DefaultOutputBufferSize");
 		config_var_enforce(config, buf, "DefaultBandwidth");
+
+		/* Switching */
+		switching = config_read_enum(config, buf, "Switching",
+			net_switching_store_and_forward, net_switching_map, 3);
+		flit_size = config_read_int(config, buf, "FlitSize",
+			config_read_int(config, buf, "DefaultBandwidth", 0));
+		if (flit_size < 1)
+			fatal("%s: %s: invalid value for 'FlitSize'.\n%s",
+				mem_config_file_name, net->name, mem_err_config_note);
+		net_set_switching(net, switching, flit_size);
 		config_section_check(config, buf);
 	}
 }
@@ -398,6 +432,8 @@ static void mem_config_insert_module_in_network(struct config_t *config,
 
 	int def_input_buffer_size;
 	int def_output_buffer_size;
+	int x;
+	int y;
 
 	char buf[MAX_STRING_SIZE];
 
@@ -478,8 +514,10 @@ try_external_network:
 			"network.\n%s%s", mem_config_file_name, mod->name,
 			mem_err_config_note, err_mem_config_net);
 
-	/* Get node */
+	/* Get node, given by name or by coordinates in a generated topology */
 	node = net_get_node_by_name(net, net_node_name);
+	if (!node && sscanf(net_node_name, "%d,%d", &x, &y) == 2)
+		node = net_topology_get_end_node(net, x, y);
 	if (!node)
 		fatal("%s: network %s: node %s: invalid node name.\n%s%s",
 			mem_config_file_name, net_name, net_node_name,
@@ -528,6 +566,7 @@ static struct mod_t *mem_config_read_cache(struct config_t *config,
 	int prefetcher_ghb_size;
 	int prefetcher_it_size;
 	int prefetcher_lookup_depth;
+	int prefetcher_throttle_interval;
 
 	char *net_name;
 	char *net_node_name;
@@ -566,6 +605,8 @@ static struct mod_t *mem_config_read_cache(struct config_t *config,
 		"PrefetcherITSize", 64);
 	prefetcher_lookup_depth = config_read_int(config, buf, 
 		"PrefetcherLookupDepth", 2);
+	prefetcher_throttle_interval = config_read_int(config, buf,
+		"PrefetcherThrottleInterval", 0);
 
 	/* Checks */
 	policy = str_map_string_case(&cache_policy_map, policy_str);
@@ -605,7 +646,8 @@ static struct mod_t *mem_config_read_cache(struct config_t *config,
 		if (prefetcher_ghb_size < 1 || prefetcher_it_size < 1 ||
 		    prefetcher_type == prefetcher_type_invalid || 
 		    prefetcher_lookup_depth < 2 || 
-		    prefetcher_lookup_depth > PREFETCHER_LOOKUP_DEPTH_MAX)
+		    prefetcher_lookup_depth > PREFETCHER_LOOKUP_DEPTH_MAX ||
+		    prefetcher_throttle_interval < 0)
 		{
 			fatal("%s: cache %s: invalid prefetcher "
 				"configuration.\n%s",
@@ -619,7 +661,7 @@ static struct mod_t *mem_config_read_cache(struct config_t *config,
 		block_size, latency);
 	
 	/* Initialize */
-	mod->mshr_size = mshr_size;
+	mod_set_mshr_size(mod, mshr_size);
 	mod->dir_assoc = assoc;
 	mod->dir_num_sets = num_sets;
 	mod->dir_size = num_sets * assoc;
@@ -652,7 +694,7 @@ static struct mod_t *mem_config_read_cache(struct config_t *config,
 	{
 		mod->cache->prefetcher = prefetcher_create(prefetcher_ghb_size, 
 			prefetcher_it_size, prefetcher_lookup_depth, 
-			prefetcher_type);
+			prefetcher_type, prefetcher_throttle_interval);
 	}
 
 	/* Return */
@@ -770,7 +812,7 @@ static void mem_config_read_module_address_range(struct config_t *config,
 		/* Low bound */
 		if (!(token = strtok(NULL, delim)))
 			goto invalid_format;
-		mod->range.bounds.low = str_to_int(token, &err);
+		mod->range.bounds.low = str_to_llint(token, &err);
 		if (err)
 			fatal("%s: %s: invalid value '%s' in 'AddressRange'",
 				mem_config_file_name, mod->name, token);
@@ -782,7 +824,7 @@ static void mem_config_read_module_address_range(struct config_t *config,
 		/* High bound */
 		if (!(token = strtok(NULL, delim)))
 			goto invalid_format;
-		mod->range.bounds.high = str_to_int(token, &err);
+		mod->range.bounds.high = str_to_llint(token, &err);
 		if (err)
 			fatal("%s: %s: invalid value '%s' in 'AddressRange'",
 				mem_config_file_name, mod->name, token);
@@ -1029,6 +1071,47 @@ static void mem_config_read_low_modules(struct config_t *config)
 }
 
 
+/* Read an [Entry <name>] section for trace-driven simulation, associating a
+ * trace core with a module. */
+static void mem_config_read_mem_sim_entry(struct config_t *config, char *section)
+{
+	struct mod_t *mod;
+
+	char *mod_name;
+	int core;
+
+	/* Variables used by CPU/GPU entries */
+	config_var_allow(config, section, "Arch");
+	config_var_allow(config, section, "Thread");
+	config_var_allow(config, section, "InstModule");
+
+	/* Core */
+	core = config_read_int(config, section, "Core", -1);
+	if (core < 0)
+		fatal("%s: section [%s]: invalid or missing value for 'Core'.\n%s",
+			mem_config_file_name, section, mem_err_config_note);
+	if (mem_sim_get_entry(core))
+		fatal("%s: section [%s]: entry from core %d already assigned.\n%s",
+			mem_config_file_name, section, core, mem_err_config_note);
+
+	/* Module */
+	mod_name = config_read_string(config, section, "Module", NULL);
+	if (!mod_name)
+		mod_name = config_read_string(config, section, "DataModule", NULL);
+	if (!mod_name)
+		fatal("%s: section [%s]: variable 'Module' is missing.\n%s",
+			mem_config_file_name, section, mem_err_config_note);
+	mod = mem_system_get_mod(mod_name);
+	if (!mod)
+		fatal("%s: section [%s]: '%s' is not a valid module name.\n%s",
+			mem_config_file_name, section, mod_name, mem_err_config_note);
+
+	/* Add entry */
+	mem_sim_add_entry(core, mod);
+	mem_debug("\tTrace core %d -> %s\n", core, mod->name);
+}
+
+
 static void mem_config_read_entries(struct config_t *config)
 {
 	char *section;
@@ -1061,6 +1144,13 @@ static void mem_config_read_entries(struct config_t *config)
 			fatal("%s: section [%s]: invalid entry name.\n%s",
 				mem_config_file_name, section, mem_err_config_note);
 
+		/* In trace-driven simulation, entries refer to trace cores */
+		if (*mem_sim_trace_file_name)
+		{
+			mem_config_read_mem_sim_entry(config, section);
+			continue;
+		}
+
 		/* Check if variable 'Type' is used in the section. This variable was used in
 		 * previous versions, now it is replaced with 'Arch'. */
 		if (config_var_exists(config, section, "Type"))
@@ -1164,7 +1254,7 @@ static void mem_config_create_switches(struct config_t *config)
 
 		/* Calculate routes */
 		net_routing_table_initiate(net->routing_table);
-		net_routing_table_floyd_warshall(net->routing_table);
+		net_routing_table_calculate(net->routing_table);
 
 		/* Debug */
 		mem_debug("\n");
@@ -1375,8 +1465,14 @@ static void mem_config_calculate_mod_levels(void)
 	int i;
 	
 	/* Start recursive level assignment with L1 modules (entries to memory)
-	 * for all architectures. */
+	 * for all architectures, or for all cores in trace-driven simulation. */
 	arch_for_each(mem_config_calculate_mod_levels_arch, NULL);
+	for (i = 0; i < mem_sim_entry_count(); i++)
+	{
+		mod = mem_sim_get_entry(i);
+		if (mod)
+			mem_config_set_mod_level(mod, 1);
+	}
 
 	/* Debug */
 	mem_debug("Calculating module levels:\n");
@@ -1404,8 +1500,9 @@ static void mem_config_trace(void)
 	struct net_t *net;
 	int i;
 
-	/* No need if not tracing */
-	if (!mem_tracing())
+	/* No need if not tracing. Headers are traced even if no trace window
+	 * is open. */
+	if (!mem_trace_category)
 		return;
 
 	/* Initialization */
@@ -279,7 +279,7 @@ int dir_entry_lock(struct dir_t *dir, int x, int y, int event, struct mod_stack_
 				lock_queue_iter->dir_lock_next = stack;
 			}
 		}
-		mem_debug("    0x%x access suspended\n", stack->tag);
+		mem_debug("    0x%llx access suspended\n", stack->tag);
 		return 0;
 	}
 
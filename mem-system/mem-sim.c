@@ -0,0 +1,509 @@
+/*
+ *  Multi2Sim
+ *  Copyright (C) 2012  Rafael Ubal (ubal@ece.neu.edu)
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include <assert.h>
+#include <limits.h>
+#include <string.h>
+#include <zlib.h>
+
+#include <lib/esim/esim.h>
+#include <lib/esim/trace.h>
+#include <lib/mhandle/mhandle.h>
+#include <lib/util/debug.h>
+#include <lib/util/list.h>
+#include <lib/util/misc.h>
+#include <lib/util/string.h>
+#include <network/net-system.h>
+
+#include "config.h"
+#include "mem-sim.h"
+#include "mem-system.h"
+#include "module.h"
+
+
+/*
+ * Global Variables
+ */
+
+char *mem_sim_trace_file_name = "";
+int mem_sim_max_in_flight = 16;
+
+
+
+
+/*
+ * Private Variables
+ */
+
+struct mem_sim_access_t
+{
+	enum mod_access_kind_t kind;
+	unsigned long long addr;
+	unsigned int pc;
+	int gap;
+};
+
+struct mem_sim_core_t
+{
+	int id;
+	struct mod_t *mod;
+
+	/* Accesses read from the trace and not issued yet, as a circular
+	 * queue. */
+	struct mem_sim_access_t queue[MEM_SIM_QUEUE_SIZE];
+	int queue_head;
+	int queue_count;
+
+	/* Address of the last access read from a binary trace */
+	unsigned long long last_addr;
+
+	/* Cycle when the last access was issued */
+	long long issue_cycle;
+
+	/* Issued and completed accesses. Completions are counted by the memory
+	 * hierarchy through the witness pointer of 'mod_access' in 'witness',
+	 * and moved into 'completed' before issuing. */
+	long long issued;
+	long long completed;
+	int witness;
+
+	/* Statistics */
+	long long loads;
+	long long stores;
+	long long stall_cycles;
+	long long finish_cycle;
+};
+
+/* Cores, indexed by their identifier. Positions without entry are NULL. */
+static struct list_t *mem_sim_core_list;
+
+/* Trace */
+static gzFile mem_sim_trace_file;
+static int mem_sim_trace_binary;
+static int mem_sim_trace_line;
+
+/* Access read from the trace that did not fit in the queue of its core */
+static struct mem_sim_core_t *mem_sim_pending_core;
+static struct mem_sim_access_t mem_sim_pending_access;
+
+
+
+
+/*
+ * Private Functions
+ */
+
+static int mem_sim_read_int(gzFile f, unsigned long long *value_ptr)
+{
+	unsigned long long value = 0;
+	int shift = 0;
+	int c;
+
+	do
+	{
+		c = gzgetc(f);
+		if (c < 0 || shift > 63)
+			return 0;
+		value |= (unsigned long long) (c & 0x7f) << shift;
+		shift += 7;
+	} while (c & 0x80);
+	*value_ptr = value;
+	return 1;
+}
+
+
+static struct mem_sim_core_t *mem_sim_get_core(int core_id)
+{
+	struct mem_sim_core_t *core;
+
+	core = core_id >= 0 ? list_get(mem_sim_core_list, core_id) : NULL;
+	if (!core)
+		fatal("%s: access from core %d, which has no entry in the memory "
+			"configuration file.\n"
+			"\tPlease add an [Entry <name>] section with variable 'Core = %d'\n"
+			"\tassociating this core with a memory module.\n",
+			mem_sim_trace_file_name, core_id, core_id);
+	return core;
+}
+
+
+/* Read the next access from a binary trace. The function returns 0 at the
+ * end of the trace. */
+static int mem_sim_read_binary(struct mem_sim_core_t **core_ptr,
+	struct mem_sim_access_t *access)
+{
+	struct mem_sim_core_t *core;
+	unsigned long long value[5];
+	long long delta;
+	int i;
+
+	/* Fields */
+	if (!mem_sim_read_int(mem_sim_trace_file, &value[0]))
+		return 0;
+	for (i = 1; i < 5; i++)
+		if (!mem_sim_read_int(mem_sim_trace_file, &value[i]))
+			fatal("%s: truncated trace", mem_sim_trace_file_name);
+
+	/* Core and address */
+	core = mem_sim_get_core(value[0] > INT_MAX ? -1 : value[0]);
+	delta = (value[4] >> 1) ^ -(long long) (value[4] & 1);
+	core->last_addr += delta;
+
+	/* Access */
+	if (value[1] < mod_access_load || value[1] > mod_access_prefetch)
+		fatal("%s: invalid access kind (%llu)", mem_sim_trace_file_name,
+			value[1]);
+	access->kind = value[1];
+	access->gap = MIN(value[2], INT_MAX);
+	access->pc = value[3];
+	access->addr = core->last_addr;
+	*core_ptr = core;
+	return 1;
+}
+
+
+/* Read the next access from a text trace. The function returns 0 at the end
+ * of the trace. */
+static int mem_sim_read_text(struct mem_sim_core_t **core_ptr,
+	struct mem_sim_access_t *access)
+{
+	struct list_t *token_list;
+
+	char line[MAX_STRING_SIZE];
+	char *token;
+
+	int core_id;
+	int err;
+
+	while (gzgets(mem_sim_trace_file, line, sizeof line))
+	{
+		/* Skip empty lines and comments */
+		mem_sim_trace_line++;
+		token_list = str_token_list_create(line, " \t\r\n");
+		token = str_token_list_first(token_list);
+		if (!*token || *token == '#')
+		{
+			str_token_list_free(token_list);
+			continue;
+		}
+
+		/* Parse access */
+		if (list_count(token_list) != 5)
+			fatal("%s: line %d: invalid format", mem_sim_trace_file_name,
+				mem_sim_trace_line);
+		core_id = str_to_int(list_get(token_list, 0), &err);
+		if (err)
+			fatal("%s: line %d: invalid core", mem_sim_trace_file_name,
+				mem_sim_trace_line);
+		access->gap = str_to_int(list_get(token_list, 1), &err);
+		if (err || access->gap < 0)
+			fatal("%s: line %d: invalid gap", mem_sim_trace_file_name,
+				mem_sim_trace_line);
+		access->pc = str_to_llint(list_get(token_list, 2), &err);
+		if (err)
+			fatal("%s: line %d: invalid PC", mem_sim_trace_file_name,
+				mem_sim_trace_line);
+		access->addr = str_to_llint(list_get(token_list, 3), &err);
+		if (err)
+			fatal("%s: line %d: invalid address", mem_sim_trace_file_name,
+				mem_sim_trace_line);
+		access->kind = str_map_string_case(&mod_access_kind_map,
+			list_get(token_list, 4));
+		if (!access->kind)
+			fatal("%s: line %d: invalid access kind", mem_sim_trace_file_name,
+				mem_sim_trace_line);
+		*core_ptr = mem_sim_get_core(core_id);
+
+		/* Done */
+		str_token_list_free(token_list);
+		return 1;
+	}
+
+	/* End of trace */
+	return 0;
+}
+
+
+/* Read accesses from the trace into the queues of their cores, until the
+ * queue of a core is full. The function returns true if there are accesses
+ * left in the trace. */
+static int mem_sim_read_trace(void)
+{
+	struct mem_sim_core_t *core;
+	struct mem_sim_access_t *access;
+
+	while (mem_sim_trace_file)
+	{
+		/* Read next access, or retry the last one */
+		if (!mem_sim_pending_core)
+		{
+			if (mem_sim_trace_binary ?
+				!mem_sim_read_binary(&mem_sim_pending_core, &mem_sim_pending_access) :
+				!mem_sim_read_text(&mem_sim_pending_core, &mem_sim_pending_access))
+			{
+				gzclose(mem_sim_trace_file);
+				mem_sim_trace_file = NULL;
+				break;
+			}
+		}
+
+		/* Queue it */
+		core = mem_sim_pending_core;
+		if (core->queue_count == MEM_SIM_QUEUE_SIZE)
+			return 1;
+		access = &core->queue[(core->queue_head + core->queue_count)
+			% MEM_SIM_QUEUE_SIZE];
+		*access = mem_sim_pending_access;
+		core->queue_count++;
+		mem_sim_pending_core = NULL;
+	}
+
+	/* End of trace */
+	return 0;
+}
+
+
+/* Issue the accesses of a core that are ready in 'cycle'. The function
+ * returns true if the core has accesses left to issue or complete. */
+static int mem_sim_issue(struct mem_sim_core_t *core, long long cycle)
+{
+	struct mem_sim_access_t *access;
+	struct mod_client_info_t *client_info;
+
+	/* Completed accesses. Every access increments the witness once. */
+	core->completed += core->witness;
+	core->witness = 0;
+	if (core->completed > core->issued)
+		panic("%s: core %d: more accesses completed than issued",
+			__FUNCTION__, core->id);
+
+	while (core->queue_count)
+	{
+		/* Wait for gap since last access */
+		access = &core->queue[core->queue_head];
+		if (cycle < core->issue_cycle + access->gap)
+			break;
+
+		/* Wait for in-flight accesses and entry module */
+		if (core->issued - core->completed >= mem_sim_max_in_flight ||
+				!mod_can_access(core->mod, access->addr))
+		{
+			core->stall_cycles++;
+			break;
+		}
+
+		/* Issue */
+		client_info = mod_client_info_create(core->mod);
+		client_info->prefetcher_eip = access->pc;
+		mod_access(core->mod, access->kind, access->addr, &core->witness,
+			NULL, NULL, client_info);
+		core->issued++;
+		core->issue_cycle = cycle;
+
+		/* Statistics */
+		if (access->kind == mod_access_load)
+			core->loads++;
+		else if (access->kind == mod_access_store ||
+				access->kind == mod_access_nc_store)
+			core->stores++;
+
+		/* Dequeue */
+		core->queue_head = (core->queue_head + 1) % MEM_SIM_QUEUE_SIZE;
+		core->queue_count--;
+	}
+
+	/* Core done */
+	if (!core->queue_count && core->issued == core->completed)
+	{
+		if (!core->finish_cycle)
+			core->finish_cycle = cycle;
+		return 0;
+	}
+
+	/* Still active */
+	core->finish_cycle = 0;
+	return 1;
+}
+
+
+static void mem_sim_dump_summary(FILE *f)
+{
+	struct mem_sim_core_t *core;
+	long long accesses;
+	long long cycles;
+	int index;
+
+	/* Header */
+	fprintf(f, "\n");
+	fprintf(f, ";\n");
+	fprintf(f, "; Simulation Statistics Summary\n");
+	fprintf(f, ";\n");
+	fprintf(f, "\n");
+
+	/* General statistics */
+	cycles = esim_domain_cycle(mem_domain_index);
+	fprintf(f, "[ General ]\n");
+	fprintf(f, "RealTime = %.2f [s]\n", esim_real_time() / 1.0e6);
+	fprintf(f, "Cycles = %lld\n", cycles);
+	fprintf(f, "\n");
+
+	/* Cores */
+	accesses = 0;
+	LIST_FOR_EACH(mem_sim_core_list, index)
+	{
+		core = list_get(mem_sim_core_list, index);
+		if (!core)
+			continue;
+		fprintf(f, "[ MemSim.Core%d ]\n", core->id);
+		fprintf(f, "Module = %s\n", core->mod->name);
+		fprintf(f, "Accesses = %lld\n", core->issued);
+		fprintf(f, "Loads = %lld\n", core->loads);
+		fprintf(f, "Stores = %lld\n", core->stores);
+		fprintf(f, "StallCycles = %lld\n", core->stall_cycles);
+		fprintf(f, "FinishCycle = %lld\n", core->finish_cycle);
+		fprintf(f, "\n");
+		accesses += core->issued;
+	}
+
+	/* Summary */
+	fprintf(f, "[ MemSim ]\n");
+	fprintf(f, "Accesses = %lld\n", accesses);
+	fprintf(f, "AccessesPerCycle = %.4g\n", cycles ? (double) accesses / cycles : 0.0);
+	fprintf(f, "AccessesPerSecond = %.0f\n", esim_real_time() ?
+		accesses / (esim_real_time() / 1.0e6) : 0.0);
+	fprintf(f, "\n");
+}
+
+
+
+
+/*
+ * Public Functions
+ */
+
+/* Associate trace core 'core' with entry module 'mod'. Called while reading
+ * the memory configuration file. */
+void mem_sim_add_entry(int core_id, struct mod_t *mod)
+{
+	struct mem_sim_core_t *core;
+
+	/* Create list */
+	if (!mem_sim_core_list)
+		mem_sim_core_list = list_create();
+	while (list_count(mem_sim_core_list) <= core_id)
+		list_add(mem_sim_core_list, NULL);
+
+	/* Create core */
+	assert(!list_get(mem_sim_core_list, core_id));
+	core = xcalloc(1, sizeof(struct mem_sim_core_t));
+	core->id = core_id;
+	core->mod = mod;
+	list_set(mem_sim_core_list, core_id, core);
+}
+
+
+int mem_sim_entry_count(void)
+{
+	return mem_sim_core_list ? list_count(mem_sim_core_list) : 0;
+}
+
+
+struct mod_t *mem_sim_get_entry(int core_id)
+{
+	struct mem_sim_core_t *core;
+
+	core = mem_sim_core_list ? list_get(mem_sim_core_list, core_id) : NULL;
+	return core ? core->mod : NULL;
+}
+
+
+void mem_sim(char *debug_file_name)
+{
+	struct mem_sim_core_t *core;
+
+	char magic[MEM_SIM_TRACE_MAGIC_SIZE];
+
+	long long cycle;
+	int active;
+	int index;
+
+	/* Initialize */
+	debug_init();
+	esim_init();
+#ifndef NO_HOT_DEBUG
+	mem_debug_category = debug_new_category(debug_file_name);
+#endif
+	net_init();
+	mem_system_init();
+	if (!mem_sim_entry_count())
+		fatal("%s: no entries for trace-driven simulation.\n"
+			"\tPlease add [Entry <name>] sections with variables 'Core' and\n"
+			"\t'Module' to associate trace cores with memory modules.\n",
+			mem_config_file_name);
+
+	/* Open trace, which can be compressed */
+	mem_sim_trace_file = gzopen(mem_sim_trace_file_name, "rb");
+	if (!mem_sim_trace_file)
+		fatal("%s: cannot open trace file", mem_sim_trace_file_name);
+	if (gzread(mem_sim_trace_file, magic, sizeof magic) == sizeof magic &&
+			!memcmp(magic, MEM_SIM_TRACE_MAGIC, sizeof magic))
+		mem_sim_trace_binary = 1;
+	else
+		gzrewind(mem_sim_trace_file);
+
+	/* Simulation loop */
+	esim_process_events(TRUE);
+	do
+	{
+		/* Read trace and issue accesses */
+		active = mem_sim_read_trace();
+		cycle = esim_domain_cycle(mem_domain_index);
+		LIST_FOR_EACH(mem_sim_core_list, index)
+		{
+			core = list_get(mem_sim_core_list, index);
+			if (core && mem_sim_issue(core, cycle))
+				active = 1;
+		}
+
+		/* Next cycle */
+		esim_process_events(TRUE);
+
+	} while (active && !esim_finish);
+
+	/* Drain events */
+	esim_process_all_events();
+	mem_sim_dump_summary(stderr);
+
+	/* Free */
+	if (mem_sim_trace_file)
+		gzclose(mem_sim_trace_file);
+	while (list_count(mem_sim_core_list))
+		free(list_pop(mem_sim_core_list));
+	list_free(mem_sim_core_list);
+
+	/* Finalize */
+	mem_system_done();
+	net_done();
+	esim_done();
+	debug_done();
+
+	/* Finish program */
+	mhandle_done();
+	exit(0);
+}
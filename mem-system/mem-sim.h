@@ -0,0 +1,68 @@
+/*
+ *  Multi2Sim
+ *  Copyright (C) 2012  Rafael Ubal (ubal@ece.neu.edu)
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef MEM_SYSTEM_MEM_SIM_H
+#define MEM_SYSTEM_MEM_SIM_H
+
+
+/*
+ * Trace-driven simulation of the memory hierarchy. Accesses from a trace are
+ * issued into the entry modules of the memory configuration file, where
+ * [Entry <name>] sections associate a trace core with a module using
+ * variables 'Core' and 'Module' (or 'DataModule').
+ *
+ * A trace can be compressed with gzip. A binary trace starts with
+ * 'MEM_SIM_TRACE_MAGIC', followed by one record per access with fields
+ *	<core> <kind> <gap> <pc> <address>
+ * stored as unsigned variable-length quantities (7 bits per byte, least
+ * significant first). Field <kind> is a value of 'enum mod_access_kind_t',
+ * and <address> is the difference with the address of the previous access of
+ * the same core, in zig-zag encoding (sign in the least significant bit).
+ *
+ * A text trace has one access per line with fields
+ *	<core> <gap> <pc> <address> {Load|Store|NCStore|Prefetch}
+ * Empty lines and lines starting with '#' are ignored.
+ *
+ * Field <gap> is the number of cycles between the issue of the previous
+ * access of the same core and this access. Each core issues its accesses in
+ * order, and an access waits for its gap to elapse, for the number of
+ * in-flight accesses of the core to fall below 'mem_sim_max_in_flight', and
+ * for its entry module to accept it.
+ */
+
+#define MEM_SIM_TRACE_MAGIC  "M2S-MEM1"
+#define MEM_SIM_TRACE_MAGIC_SIZE  8
+
+/* Maximum number of accesses read ahead from the trace for a core */
+#define MEM_SIM_QUEUE_SIZE  64
+
+extern char *mem_sim_trace_file_name;
+extern int mem_sim_max_in_flight;
+
+struct mod_t;
+
+void mem_sim_add_entry(int core, struct mod_t *mod);
+int mem_sim_entry_count(void);
+struct mod_t *mem_sim_get_entry(int core);
+
+void mem_sim(char *debug_file_name);
+
+
+#endif
+
@@ -18,6 +18,7 @@
 
 #include <arch/common/arch.h>
 #include <lib/esim/esim.h>
+#include <lib/esim/stats.h>
 #include <lib/esim/trace.h>
 #include <lib/mhandle/mhandle.h>
 #include <lib/util/debug.h>
@@ -29,16 +30,21 @@
 #include "cache.h"
 #include "config.h"
 #include "local-mem-protocol.h"
+#include "mem-sim.h"
 #include "mem-system.h"
 #include "module.h"
+#include "mshr.h"
 #include "nmoesi-protocol.h"
+#include "prefetcher.h"
 
 
 /*
  * Global Variables
  */
 
+#ifndef NO_HOT_DEBUG
 int mem_debug_category;
+#endif
 int mem_trace_category;
 int mem_peer_transfers;
 
@@ -50,6 +56,9 @@ struct mem_system_t *mem_system;
 
 char *mem_report_file_name = "";
 
+char *mem_trace_trigger_mod_name = "";
+int mem_trace_trigger_latency;
+
 
 
 /*
@@ -99,14 +108,48 @@ static char *mem_err_timing =
 	"\tPlease specify at least one detailed simulation (e.g., with option\n"
 	"\t'--x86-sim detailed'.\n";
 
+static void mem_system_register_stats(void)
+{
+	struct mod_t *mod;
+	struct net_t *net;
+
+	int i;
+
+	/* Modules */
+	LIST_FOR_EACH(mem_system->mod_list, i)
+	{
+		mod = list_get(mem_system->mod_list, i);
+		stats_register(&mod->accesses, "mem.%s.accesses", mod->name);
+		stats_register(&mod->hits, "mem.%s.hits", mod->name);
+		stats_register(&mod->reads, "mem.%s.reads", mod->name);
+		stats_register(&mod->read_hits, "mem.%s.read_hits", mod->name);
+		stats_register(&mod->writes, "mem.%s.writes", mod->name);
+		stats_register(&mod->write_hits, "mem.%s.write_hits", mod->name);
+		stats_register(&mod->nc_writes, "mem.%s.nc_writes", mod->name);
+		stats_register(&mod->nc_write_hits, "mem.%s.nc_write_hits", mod->name);
+		stats_register(&mod->evictions, "mem.%s.evictions", mod->name);
+		stats_register(&mod->prefetches, "mem.%s.prefetches", mod->name);
+	}
+
+	/* Networks */
+	LIST_FOR_EACH(mem_system->net_list, i)
+	{
+		net = list_get(mem_system->net_list, i);
+		net_register_stats(net);
+	}
+}
+
+
 void mem_system_init(void)
 {
 	int count;
 
 	/* If any file name was specific for a command-line option related with the
 	 * memory hierarchy, make sure that at least one architecture is running
-	 * timing simulation. */
+	 * timing simulation, or that the memory hierarchy is driven by a trace. */
 	count = arch_get_sim_kind_detailed_count();
+	if (*mem_sim_trace_file_name)
+		count++;
 	if (mem_report_file_name && *mem_report_file_name && !count)
 		fatal("memory report file given, but no timing simulation.\n%s",
 				mem_err_timing);
@@ -128,6 +171,21 @@ void mem_system_init(void)
 	/* Read memory configuration file */
 	mem_config_read();
 
+	/* Module opening trace windows */
+	if (*mem_trace_trigger_mod_name)
+	{
+		struct mod_t *mod;
+
+		mod = mem_system_get_mod(mem_trace_trigger_mod_name);
+		if (!mod)
+			fatal("%s: invalid module in option '--trace-trigger'",
+				mem_trace_trigger_mod_name);
+		mod->trace_trigger_latency = mem_trace_trigger_latency;
+	}
+
+	/* Interval statistics */
+	mem_system_register_stats();
+
 	/* Try to open report file */
 	if (*mem_report_file_name && !file_can_open_for_write(mem_report_file_name))
 		fatal("%s: cannot open GPU cache report file",
@@ -374,6 +432,13 @@ void mem_system_dump_report(void)
 		fprintf(f, "Ports = %d\n", mod->num_ports);
 		fprintf(f, "\n");
 
+		/* MSHR */
+		if (cache)
+		{
+			mshr_dump_report(mod->mshr, f);
+			fprintf(f, "\n");
+		}
+
 		/* Statistics */
 		fprintf(f, "Accesses = %lld\n", mod->accesses);
 		fprintf(f, "Hits = %lld\n", mod->hits);
@@ -407,6 +472,8 @@ void mem_system_dump_report(void)
 		fprintf(f, "Prefetches = %lld\n", mod->prefetches);
 		fprintf(f, "PrefetchAborts = %lld\n", mod->prefetch_aborts);
 		fprintf(f, "UselessPrefetches = %lld\n", mod->useless_prefetches);
+		if (cache && cache->prefetcher)
+			prefetcher_dump_report(cache->prefetcher, f);
 		fprintf(f, "\n");
 		fprintf(f, "NoRetryAccesses = %lld\n", mod->no_retry_accesses);
 		fprintf(f, "NoRetryHits = %lld\n", mod->no_retry_hits);
@@ -42,9 +42,17 @@ struct mem_system_t
 
 extern char *mem_report_file_name;
 
+/* Module and latency of accesses opening trace windows */
+extern char *mem_trace_trigger_mod_name;
+extern int mem_trace_trigger_latency;
+
 #define mem_debugging() debug_status(mem_debug_category)
 #define mem_debug(...) debug(mem_debug_category, __VA_ARGS__)
+#ifdef NO_HOT_DEBUG
+#define mem_debug_category 0
+#else
 extern int mem_debug_category;
+#endif
 
 #define mem_tracing() trace_status(mem_trace_category)
 #define mem_trace(...) trace(mem_trace_category, __VA_ARGS__)
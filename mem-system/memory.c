@@ -18,6 +18,9 @@
  */
 
 #include <assert.h>
+#include <pthread.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
 
 #include <lib/mhandle/mhandle.h>
 #include <lib/util/misc.h>
@@ -33,6 +36,14 @@ unsigned long mem_max_mapped_space = 0;
 /* Safe mode */
 int mem_safe_mode = 1;
 
+/* Page data is allocated with a trailing reference count, since it can be
+ * shared copy-on-write by pages of cloned memories (see 'mem_clone'). */
+#define MEM_PAGE_DATA_REFS(data)  (* (int *) ((data) + MEM_PAGE_SIZE))
+
+/* Lock protecting page creation, page data allocation, and the mapped space
+ * counters for memories accessed concurrently by several host threads. */
+static pthread_mutex_t mem_thread_safe_lock = PTHREAD_MUTEX_INITIALIZER;
+
 
 /* Return mem page corresponding to an address. */
 struct mem_page_t *mem_page_get(struct mem_t *mem, unsigned int addr)
@@ -52,8 +63,9 @@ struct mem_page_t *mem_page_get(struct mem_t *mem, unsigned int addr)
 		page = page->next;
 	}
 	
-	/* Place page into list head */
-	if (prev && page)
+	/* Place page into list head. This is skipped for memories shared
+	 * among host threads, since other threads may be traversing the list. */
+	if (prev && page && !mem->thread_safe)
 	{
 		prev->next = page->next;
 		page->next = mem->pages[index];
@@ -112,6 +124,19 @@ static struct mem_page_t *mem_page_create(struct mem_t *mem, unsigned int addr,
 	unsigned int index, tag;
 	struct mem_page_t *page;
 
+	/* In a memory shared among host threads, the page might have been
+	 * created by another thread since the caller looked it up. */
+	if (mem->thread_safe)
+	{
+		pthread_mutex_lock(&mem_thread_safe_lock);
+		page = mem_page_get(mem, addr);
+		if (page)
+		{
+			pthread_mutex_unlock(&mem_thread_safe_lock);
+			return page;
+		}
+	}
+
 	/* Initialize */
 	page = xcalloc(1, sizeof(struct mem_page_t));
 	tag = addr & ~(MEM_PAGE_SIZE - 1);
@@ -119,17 +144,137 @@ static struct mem_page_t *mem_page_create(struct mem_t *mem, unsigned int addr,
 	page->tag = tag;
 	page->perm = perm;
 	
-	/* Insert in pages hash table */
+	/* Insert in pages hash table. The page is fully initialized before
+	 * it becomes visible to threads traversing the list lock-free. */
 	page->next = mem->pages[index];
+	if (mem->thread_safe)
+		__sync_synchronize();
 	mem->pages[index] = page;
 	mem_mapped_space += MEM_PAGE_SIZE;
 	mem_max_mapped_space = MAX(mem_max_mapped_space, mem_mapped_space);
 
 	/* Return */
+	if (mem->thread_safe)
+		pthread_mutex_unlock(&mem_thread_safe_lock);
 	return page;
 }
 
 
+/* Drop a reference to a host file mapping, unmapping it with the last one */
+static void mem_file_free(struct mem_file_t *file)
+{
+	if (__sync_sub_and_fetch(&file->num_pages, 1))
+		return;
+	munmap(file->host_addr, file->host_size);
+	free(file);
+}
+
+
+/* Allocate zeroed page data with a reference count of 1 */
+static unsigned char *mem_page_data_create(void)
+{
+	unsigned char *data;
+
+	data = xcalloc(1, MEM_PAGE_SIZE + sizeof(int));
+	MEM_PAGE_DATA_REFS(data) = 1;
+	return data;
+}
+
+
+/* Drop a reference to page data, freeing it with the last one */
+static void mem_page_data_free(unsigned char *data)
+{
+	if (!__sync_sub_and_fetch(&MEM_PAGE_DATA_REFS(data), 1))
+		free(data);
+}
+
+
+/* Release the data and file backing of a page, leaving it as a page that
+ * reads as zeros. */
+static void mem_page_discard(struct mem_page_t *page)
+{
+	if (page->data)
+		mem_page_data_free(page->data);
+	if (page->file)
+		mem_file_free(page->file);
+	page->data = NULL;
+	page->file = NULL;
+	page->file_data = NULL;
+}
+
+
+/* Load the contents of a page backed by a host file. This is done on the
+ * first access to the page, so that file mappings are paged in on demand. */
+void mem_page_load(struct mem_t *mem, struct mem_page_t *page)
+{
+	unsigned char *data;
+
+	/* Not backed by a file */
+	if (!page->file)
+		return;
+
+	/* Copy contents */
+	if (mem->thread_safe)
+		pthread_mutex_lock(&mem_thread_safe_lock);
+	if (page->file)
+	{
+		assert(!page->data);
+		data = mem_page_data_create();
+		memcpy(data, page->file_data, MEM_PAGE_SIZE);
+		mem_file_free(page->file);
+		page->data = data;
+		if (mem->thread_safe)
+			__sync_synchronize();
+		page->file = NULL;
+		page->file_data = NULL;
+	}
+	if (mem->thread_safe)
+		pthread_mutex_unlock(&mem_thread_safe_lock);
+}
+
+
+/* Return the data of a memory page for writing. The data is allocated if it
+ * does not exist yet, and copied if it is shared with other pages. */
+static unsigned char *mem_page_get_data(struct mem_t *mem, struct mem_page_t *page)
+{
+	unsigned char *data;
+
+	/* Private data */
+	data = page->data;
+	if (data && MEM_PAGE_DATA_REFS(data) == 1)
+		return data;
+
+	/* Load file contents */
+	mem_page_load(mem, page);
+
+	/* Allocate or copy, serialized in memories shared among host
+	 * threads. Data shared with other pages is copied before dropping
+	 * the reference, so that it is not freed while being copied. */
+	if (mem->thread_safe)
+		pthread_mutex_lock(&mem_thread_safe_lock);
+	data = page->data;
+	if (!data)
+	{
+		data = mem_page_data_create();
+	}
+	else if (MEM_PAGE_DATA_REFS(data) > 1)
+	{
+		data = mem_page_data_create();
+		memcpy(data, page->data, MEM_PAGE_SIZE);
+		mem_page_data_free(page->data);
+	}
+	if (data != page->data)
+	{
+		if (mem->thread_safe)
+			__sync_synchronize();
+		page->data = data;
+	}
+	if (mem->thread_safe)
+		pthread_mutex_unlock(&mem_thread_safe_lock);
+	return data;
+}
+
+
 /* Free mem pages */
 static void mem_page_free(struct mem_t *mem, unsigned int addr)
 {
@@ -156,8 +301,7 @@ static void mem_page_free(struct mem_t *mem, unsigned int addr)
 	else
 		mem->pages[index] = page->next;
 	mem_mapped_space -= MEM_PAGE_SIZE;
-	if (page->data)
-		free(page->data);
+	mem_page_discard(page);
 	free(page);
 }
 
@@ -184,18 +328,14 @@ void mem_copy(struct mem_t *mem, unsigned int dest, unsigned int src, int size)
 		page_src = mem_page_get(mem, src);
 		assert(page_src && page_dest);
 		
-		/* Different actions depending on whether source and
-		 * destination page data are allocated. */
+		/* Share source data with the destination page. It is copied
+		 * on the first write to any of them. */
+		mem_page_load(mem, page_src);
+		mem_page_discard(page_dest);
 		if (page_src->data)
 		{
-			if (!page_dest->data)
-				page_dest->data = xmalloc(MEM_PAGE_SIZE);
-			memcpy(page_dest->data, page_src->data, MEM_PAGE_SIZE);
-		}
-		else
-		{
-			if (page_dest->data)
-				memset(page_dest->data, 0, MEM_PAGE_SIZE);
+			page_dest->data = page_src->data;
+			__sync_add_and_fetch(&MEM_PAGE_DATA_REFS(page_dest->data), 1);
 		}
 
 		/* Advance pointers */
@@ -208,7 +348,12 @@ void mem_copy(struct mem_t *mem, unsigned int dest, unsigned int src, int size)
 
 /* Return the buffer corresponding to address 'addr' in the simulated
  * mem. The returned buffer is null if addr+size exceeds the page
- * boundaries. */
+ * boundaries.
+ * For read and execute accesses, the buffer can point to page data shared
+ * copy-on-write with other memories. It is only valid until the next write
+ * to 'mem' or to any memory sharing the page, which can replace or free the
+ * data. Callers must use it right away, as the instruction fetch of the
+ * emulators does before executing the instruction. */
 void *mem_get_buffer(struct mem_t *mem, unsigned int addr, int size,
 	enum mem_access_t access)
 {
@@ -229,12 +374,13 @@ void *mem_get_buffer(struct mem_t *mem, unsigned int addr, int size,
 	if ((page->perm & access) != access && mem->safe)
 		fatal("mem_get_buffer: permission denied at 0x%x", addr);
 	
-	/* Allocate and initialize page data if it does not exist yet. */
-	if (!page->data)
-		page->data = xcalloc(1, MEM_PAGE_SIZE);
-	
-	/* Return pointer to page data */
-	return page->data + offset;
+	/* Data shared with other pages can be returned for read-only
+	 * accesses. Otherwise, get private data, allocating it if it does
+	 * not exist yet. */
+	mem_page_load(mem, page);
+	if (page->data && !(access & (mem_access_write | mem_access_init)))
+		return page->data + offset;
+	return mem_page_get_data(mem, page) + offset;
 }
 
 
@@ -282,6 +428,7 @@ static void mem_access_page_boundary(struct mem_t *mem, unsigned int addr,
 	/* Read/execute access */
 	if (access == mem_access_read || access == mem_access_exec)
 	{
+		mem_page_load(mem, page);
 		if (page->data)
 			memcpy(buf, page->data + offset, size);
 		else
@@ -292,9 +439,7 @@ static void mem_access_page_boundary(struct mem_t *mem, unsigned int addr,
 	/* Write/initialize access */
 	if (access == mem_access_write || access == mem_access_init)
 	{
-		if (!page->data)
-			page->data = xcalloc(1, MEM_PAGE_SIZE);
-		memcpy(page->data + offset, buf, size);
+		memcpy(mem_page_get_data(mem, page) + offset, buf, size);
 		return;
 	}
 
@@ -311,7 +456,8 @@ void mem_access(struct mem_t *mem, unsigned int addr, int size, void *buf,
 	unsigned int offset;
 	int chunksize;
 
-	mem->last_address = addr;
+	if (!mem->thread_safe)
+		mem->last_address = addr;
 	while (size)
 	{
 		offset = addr & (MEM_PAGE_SIZE - 1);
@@ -337,6 +483,136 @@ void mem_write(struct mem_t *mem, unsigned int addr, int size, void *buf)
 }
 
 
+/* Return the page at 'addr' for a read access in a transfer, checking
+ * permissions. NULL is returned for nonexistent pages in unsafe mode, which
+ * read as zeros. */
+static struct mem_page_t *mem_transfer_src_page(struct mem_t *mem, unsigned int addr)
+{
+	struct mem_page_t *page;
+
+	page = mem_page_get(mem, addr);
+	if (!page)
+	{
+		if (mem->safe)
+			fatal("illegal access at 0x%x: page not allocated", addr);
+		return NULL;
+	}
+	if (mem->safe && (page->perm & mem_access_read) != mem_access_read)
+		fatal("mem_access: permission denied at 0x%x", addr);
+	mem_page_load(mem, page);
+	return page;
+}
+
+
+/* Return the page at 'addr' for a write access in a transfer, creating it in
+ * unsafe mode and checking permissions. */
+static struct mem_page_t *mem_transfer_dest_page(struct mem_t *mem, unsigned int addr)
+{
+	struct mem_page_t *page;
+
+	page = mem_page_get(mem, addr);
+	if (!page)
+	{
+		if (mem->safe)
+			fatal("illegal access at 0x%x: page not allocated", addr);
+		page = mem_page_create(mem, addr, mem_access_read |
+			mem_access_write | mem_access_exec | mem_access_init);
+	}
+	page->perm |= mem_access_modif;
+	if (mem->safe && (page->perm & mem_access_write) != mem_access_write)
+		fatal("mem_access: permission denied at 0x%x", addr);
+	return page;
+}
+
+
+/* Copy a chunk that does not cross page boundaries neither in the source nor
+ * in the destination. */
+static void mem_transfer_page_boundary(struct mem_t *dst_mem, unsigned int dst_addr,
+	struct mem_t *src_mem, unsigned int src_addr, int size)
+{
+	struct mem_page_t *dst_page;
+	struct mem_page_t *src_page;
+
+	unsigned char *dst_data;
+	unsigned int dst_offset;
+	unsigned int src_offset;
+
+	/* Get pages */
+	dst_offset = dst_addr & (MEM_PAGE_SIZE - 1);
+	src_offset = src_addr & (MEM_PAGE_SIZE - 1);
+	assert(dst_offset + size <= MEM_PAGE_SIZE);
+	assert(src_offset + size <= MEM_PAGE_SIZE);
+	src_page = mem_transfer_src_page(src_mem, src_addr);
+	dst_page = mem_transfer_dest_page(dst_mem, dst_addr);
+
+	/* Full page. Source data is shared with the destination page and
+	 * copied on the first write to any of them. */
+	if (size == MEM_PAGE_SIZE)
+	{
+		if (src_page == dst_page)
+			return;
+		if (src_page && src_page->data)
+			__sync_add_and_fetch(&MEM_PAGE_DATA_REFS(src_page->data), 1);
+		mem_page_discard(dst_page);
+		if (src_page)
+			dst_page->data = src_page->data;
+		return;
+	}
+
+	/* Partial page. Destination data is obtained first, since it may be
+	 * a private copy of the source data if both pages are the same. */
+	dst_data = mem_page_get_data(dst_mem, dst_page) + dst_offset;
+	if (src_page && src_page->data)
+		memmove(dst_data, src_page->data + src_offset, size);
+	else
+		memset(dst_data, 0, size);
+}
+
+
+/* Copy 'size' bytes from address 'src_addr' of memory 'src_mem' into address
+ * 'dst_addr' of memory 'dst_mem', without an intermediate buffer. Both memories
+ * can be the same object and regions can overlap. Page-aligned full pages are
+ * shared copy-on-write instead of copied. */
+void mem_transfer(struct mem_t *dst_mem, unsigned int dst_addr,
+	struct mem_t *src_mem, unsigned int src_addr, int size)
+{
+	unsigned int dst_offset;
+	unsigned int src_offset;
+	int chunksize;
+
+	/* Overlapping regions with the destination after the source are
+	 * copied backwards, so that source data is not overwritten before
+	 * being read. */
+	if (dst_mem == src_mem && dst_addr > src_addr && dst_addr < src_addr + size)
+	{
+		while (size)
+		{
+			dst_offset = ((dst_addr + size - 1) & (MEM_PAGE_SIZE - 1)) + 1;
+			src_offset = ((src_addr + size - 1) & (MEM_PAGE_SIZE - 1)) + 1;
+			chunksize = MIN(size, MIN(dst_offset, src_offset));
+			size -= chunksize;
+			mem_transfer_page_boundary(dst_mem, dst_addr + size,
+				src_mem, src_addr + size, chunksize);
+		}
+		return;
+	}
+
+	/* Copy forward */
+	while (size)
+	{
+		dst_offset = dst_addr & (MEM_PAGE_SIZE - 1);
+		src_offset = src_addr & (MEM_PAGE_SIZE - 1);
+		chunksize = MIN(size, MEM_PAGE_SIZE - MAX(dst_offset, src_offset));
+		mem_transfer_page_boundary(dst_mem, dst_addr, src_mem, src_addr,
+			chunksize);
+
+		size -= chunksize;
+		dst_addr += chunksize;
+		src_addr += chunksize;
+	}
+}
+
+
 /* Creation and destruction */
 struct mem_t *mem_create()
 {
@@ -623,26 +899,36 @@ void mem_load(struct mem_t *mem, char *file_name, unsigned int start)
 
 
 /* Copy the entire content of a memory image into another. Any previously existing
- * content in the destination memory image is removed. */
+ * content in the destination memory image is removed. Pages are shared
+ * copy-on-write between both memory images. */
 void mem_clone(struct mem_t *dst_mem, struct mem_t *src_mem)
 {
 	struct mem_page_t *page;
+	struct mem_page_t *dst_page;
 
 	int i;
 
 	/* Clear destination memory */
 	mem_clear(dst_mem);
 
-	/* Copy pages */
-	dst_mem->safe = 0;
+	/* Share pages. Page data is copied on the first write from either
+	 * memory, and file contents are loaded on the first access. */
 	for (i = 0; i < MEM_PAGE_COUNT; i++)
 	{
 		for (page = src_mem->pages[i]; page; page = page->next)
 		{
-			mem_page_create(dst_mem, page->tag, page->perm);
+			dst_page = mem_page_create(dst_mem, page->tag, page->perm);
 			if (page->data)
-				mem_access(dst_mem, page->tag, MEM_PAGE_SIZE,
-					page->data, mem_access_init);
+			{
+				dst_page->data = page->data;
+				__sync_add_and_fetch(&MEM_PAGE_DATA_REFS(page->data), 1);
+			}
+			if (page->file)
+			{
+				dst_page->file = page->file;
+				dst_page->file_data = page->file_data;
+				__sync_add_and_fetch(&page->file->num_pages, 1);
+			}
 		}
 	}
 
@@ -650,3 +936,62 @@ void mem_clone(struct mem_t *dst_mem, struct mem_t *src_mem)
 	dst_mem->safe = src_mem->safe;
 	dst_mem->heap_break = src_mem->heap_break;
 }
+
+
+/* Back the pages in range ['addr', 'addr' + 'size') with the contents of host
+ * file 'host_fd' starting at 'offset'. The pages must be mapped already. The
+ * file is mapped read-only in the host, and each page is copied from it on its
+ * first access. Pages past the end of the file read as zeros. The function
+ * returns 0 if the file cannot be mapped in the host, in which case the caller
+ * should read its contents instead. */
+int mem_map_file(struct mem_t *mem, unsigned int addr, int size, int host_fd,
+	unsigned int offset)
+{
+	struct mem_file_t *file;
+	struct mem_page_t *page;
+	struct stat st;
+
+	unsigned int file_size;
+	unsigned int pos;
+
+	void *host_addr;
+
+	/* Size of the mapped file region */
+	assert(!(addr & (MEM_PAGE_SIZE - 1)));
+	assert(!(offset & (MEM_PAGE_SIZE - 1)));
+	if (fstat(host_fd, &st) || !S_ISREG(st.st_mode))
+		return 0;
+	file_size = st.st_size > offset ? st.st_size - offset : 0;
+	file_size = MIN(file_size, size);
+
+	/* Discard previous contents */
+	for (pos = 0; pos < size; pos += MEM_PAGE_SIZE)
+	{
+		page = mem_page_get(mem, addr + pos);
+		assert(page);
+		mem_page_discard(page);
+	}
+	if (!file_size)
+		return 1;
+
+	/* Host mapping */
+	host_addr = mmap(NULL, file_size, PROT_READ, MAP_PRIVATE, host_fd, offset);
+	if (host_addr == MAP_FAILED)
+		return 0;
+	file = xcalloc(1, sizeof(struct mem_file_t));
+	file->host_addr = host_addr;
+	file->host_size = file_size;
+
+	/* Back pages. The host mapping is zero-filled past the end of the file
+	 * up to the end of the last host page. */
+	for (pos = 0; pos < file_size; pos += MEM_PAGE_SIZE)
+	{
+		page = mem_page_get(mem, addr + pos);
+		page->file = file;
+		page->file_data = host_addr + pos;
+		file->num_pages++;
+	}
+
+	/* Success */
+	return 1;
+}
@@ -40,13 +40,30 @@ enum mem_access_t
 /* Safe mode */
 extern int mem_safe_mode;
 
+/* Host file mapped read-only, backing the pages of a guest file mapping until
+ * they are first accessed. */
+struct mem_file_t
+{
+	void *host_addr;
+	unsigned int host_size;
+	int num_pages;  /* Pages still backed by the mapping */
+};
+
 /* A 4KB page of memory */
 struct mem_page_t
 {
 	unsigned int tag;
 	enum mem_access_t perm;  /* Access permissions; combination of flags */
 	struct mem_page_t *next;
+
+	/* Page contents, or NULL if the page has never been written. Data is
+	 * reference-counted and copied on write when shared after a clone. */
 	unsigned char *data;
+
+	/* File backing the page until its first access. Pages with a file
+	 * have no data. */
+	struct mem_file_t *file;
+	unsigned char *file_data;
 };
 
 struct mem_t
@@ -60,6 +77,10 @@ struct mem_t
 	/* Safe mode */
 	int safe;
 
+	/* Memory accessed concurrently by several host threads. Lookups do
+	 * not reorder the page lists, and page creation is serialized. */
+	int thread_safe;
+
 	/* Heap break for CPU contexts */
 	unsigned int heap_break;
 
@@ -80,11 +101,14 @@ void mem_clear(struct mem_t *mem);
 
 struct mem_page_t *mem_page_get(struct mem_t *mem, unsigned int addr);
 struct mem_page_t *mem_page_get_next(struct mem_t *mem, unsigned int addr);
+void mem_page_load(struct mem_t *mem, struct mem_page_t *page);
 
 unsigned int mem_map_space(struct mem_t *mem, unsigned int addr, int size);
 unsigned int mem_map_space_down(struct mem_t *mem, unsigned int addr, int size);
 
 void mem_map(struct mem_t *mem, unsigned int addr, int size, enum mem_access_t perm);
+int mem_map_file(struct mem_t *mem, unsigned int addr, int size, int host_fd,
+	unsigned int offset);
 void mem_unmap(struct mem_t *mem, unsigned int addr, int size);
 
 void mem_protect(struct mem_t *mem, unsigned int addr, int size, enum mem_access_t perm);
@@ -93,10 +117,15 @@ void mem_copy(struct mem_t *mem, unsigned int dest, unsigned int src, int size);
 void mem_access(struct mem_t *mem, unsigned int addr, int size, void *buf, enum mem_access_t access);
 void mem_read(struct mem_t *mem, unsigned int addr, int size, void *buf);
 void mem_write(struct mem_t *mem, unsigned int addr, int size, void *buf);
+void mem_transfer(struct mem_t *dst_mem, unsigned int dst_addr,
+	struct mem_t *src_mem, unsigned int src_addr, int size);
 
 void mem_zero(struct mem_t *mem, unsigned int addr, int size);
 int mem_read_string(struct mem_t *mem, unsigned int addr, int size, char *str);
 void mem_write_string(struct mem_t *mem, unsigned int addr, char *str);
+
+/* Buffer for read-only accesses is only valid until the next write to any
+ * memory sharing the page (see 'memory.c'). */
 void *mem_get_buffer(struct mem_t *mem, unsigned int addr, int size, enum mem_access_t access);
 
 void mem_dump(struct mem_t *mem, char *filename, unsigned int start, unsigned int end);
@@ -56,7 +56,7 @@ struct mmu_page_t
 
 	int address_space_index;  /* Memory map ID */
 	unsigned int vtl_addr;  /* Virtual address of page */
-	unsigned int phy_addr;  /* Physical address */
+	unsigned long long phy_addr;  /* Physical address */
 
 	/* Statistics */
 	long long num_read_accesses;
@@ -112,7 +112,8 @@ static struct mmu_page_t *mmu_get_page(int address_space_index, unsigned int vtl
 		page = xcalloc(1, sizeof(struct mmu_page_t));
 		page->vtl_addr = tag;
 		page->address_space_index = address_space_index;
-		page->phy_addr = list_count(mmu->page_list) << mmu_log_page_size;
+		page->phy_addr = (unsigned long long) list_count(mmu->page_list)
+			<< mmu_log_page_size;
 
 		/* Insert in page list */
 		list_add(mmu->page_list, page);
@@ -219,9 +220,9 @@ void mmu_dump_report(void)
 	list_sort(mmu->page_list, mmu_page_compare);
 
 	/* Header */
-	fprintf(f, "%5s %5s %9s %9s %10s %10s %10s %10s\n", "Idx", "MemID", "VtlAddr",
+	fprintf(f, "%5s %5s %9s %12s %10s %10s %10s %10s\n", "Idx", "MemID", "VtlAddr",
 		"PhyAddr", "Accesses", "Read", "Write", "Exec");
-	for (i = 0; i < 77; i++)
+	for (i = 0; i < 80; i++)
 		fprintf(f, "-");
 	fprintf(f, "\n");
 
@@ -231,7 +232,7 @@ void mmu_dump_report(void)
 		page = list_get(mmu->page_list, i);
 		num_accesses = page->num_read_accesses + page->num_write_accesses
 			+ page->num_execute_accesses;
-		fprintf(f, "%5d %5d %9x %9x %10lld %10lld %10lld %10lld\n",
+		fprintf(f, "%5d %5d %9x %12llx %10lld %10lld %10lld %10lld\n",
 			i + 1, page->address_space_index, page->vtl_addr, page->phy_addr, num_accesses,
 			page->num_read_accesses, page->num_write_accesses,
 			page->num_execute_accesses);
@@ -249,12 +250,12 @@ int mmu_address_space_new(void)
 }
 
 
-unsigned int mmu_translate(int address_space_index, unsigned int vtl_addr)
+unsigned long long mmu_translate(int address_space_index, unsigned int vtl_addr)
 {
 	struct mmu_page_t *page;
 
+	unsigned long long phy_addr;
 	unsigned int offset;
-	unsigned int phy_addr;
 
 	offset = vtl_addr & mmu_page_mask;
 	page = mmu_get_page(address_space_index, vtl_addr);
@@ -264,21 +265,23 @@ unsigned int mmu_translate(int address_space_index, unsigned int vtl_addr)
 }
 
 
-int mmu_valid_phy_addr(unsigned int phy_addr)
+int mmu_valid_phy_addr(unsigned long long phy_addr)
 {
-	int index;
+	unsigned long long index;
 
 	index = phy_addr >> mmu_log_page_size;
-	return index < mmu->page_list->count;
+	return index < list_count(mmu->page_list);
 }
 
 
-void mmu_access_page(unsigned int phy_addr, enum mmu_access_t access)
+void mmu_access_page(unsigned long long phy_addr, enum mmu_access_t access)
 {
 	struct mmu_page_t *page;
 	int index;
 
 	/* Get page */
+	if (!mmu_valid_phy_addr(phy_addr))
+		return;
 	index = phy_addr >> mmu_log_page_size;
 	page = list_get(mmu->page_list, index);
 	if (!page)
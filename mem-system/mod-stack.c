@@ -32,7 +32,7 @@
 long long mod_stack_id;
 
 struct mod_stack_t *mod_stack_create(long long id, struct mod_t *mod,
-	unsigned int addr, int ret_event, struct mod_stack_t *ret_stack)
+	unsigned long long addr, int ret_event, struct mod_stack_t *ret_stack)
 {
 	struct mod_stack_t *stack;
 
@@ -48,6 +48,7 @@ struct mod_stack_t *mod_stack_create(long long id, struct mod_t *mod,
 	stack->way = -1;
 	stack->set = -1;
 	stack->tag = -1;
+	stack->create_time = esim_time;
 
 	/* Return */
 	return stack;
@@ -56,9 +57,14 @@ struct mod_stack_t *mod_stack_create(long long id, struct mod_t *mod,
 
 void mod_stack_return(struct mod_stack_t *stack)
 {
+	struct mod_t *target_mod = stack->target_mod;
 	int ret_event = stack->ret_event;
 	void *ret_stack = stack->ret_stack;
 
+	/* Request serviced by a lower- or upper-level module */
+	if (target_mod)
+		mod_check_trace_trigger(target_mod, stack);
+
 	/* Wake up dependent accesses */
 	mod_stack_wakeup_stack(stack);
 
@@ -145,7 +151,7 @@ void mod_stack_wakeup_stack(struct mod_stack_t *master_stack)
 		return;
 
 	/* Debug */
-	mem_debug("  %lld %lld 0x%x wake up accesses:", esim_time,
+	mem_debug("  %lld %lld 0x%llx wake up accesses:", esim_time,
 		master_stack->id, master_stack->addr);
 
 	/* Wake up all coalesced accesses */
@@ -56,6 +56,7 @@ struct mod_stack_t
 {
 	long long id;
 	enum mod_access_kind_t access_kind;
+	long long create_time;
 	int *witness_ptr;
 
 	struct linked_list_t *event_queue;
@@ -69,15 +70,15 @@ struct mod_stack_t
 
 	struct mod_port_t *port;
 
-	unsigned int addr;
-	int tag;
+	unsigned long long addr;
+	unsigned long long tag;
 	int set;
 	int way;
 	int state;
 
 	int src_set;
 	int src_way;
-	int src_tag;
+	unsigned long long src_tag;
 
 	enum mod_request_dir_t request_dir;
 	enum mod_message_type_t message;
@@ -94,9 +95,10 @@ struct mod_stack_t
 	struct mod_stack_t *write_access_list_prev;
 	struct mod_stack_t *write_access_list_next;
 
-	/* Bucket list of accesses in hash table in 'mod' */
-	struct mod_stack_t *bucket_list_prev;
-	struct mod_stack_t *bucket_list_next;
+	/* Linked list of accesses in MSHR entry of 'mod' */
+	struct mshr_entry_t *mshr_entry;
+	struct mod_stack_t *target_list_prev;
+	struct mod_stack_t *target_list_next;
 
 	/* Flags */
 	int hit : 1;
@@ -106,6 +108,7 @@ struct mod_stack_t
 	int write : 1;
 	int nc_write : 1;
 	int prefetch : 1;
+	int late_prefetch : 1;
 	int blocking : 1;
 	int writeback : 1;
 	int eviction : 1;
@@ -148,7 +151,7 @@ struct mod_stack_t
 };
 
 struct mod_stack_t *mod_stack_create(long long id, struct mod_t *mod,
-		unsigned int addr, int ret_event, struct mod_stack_t *ret_stack);
+		unsigned long long addr, int ret_event, struct mod_stack_t *ret_stack);
 void mod_stack_return(struct mod_stack_t *stack);
 
 void mod_stack_wait_in_mod(struct mod_stack_t *stack,
@@ -19,6 +19,7 @@
 #include <assert.h>
 
 #include <lib/esim/esim.h>
+#include <lib/esim/trace.h>
 #include <lib/mhandle/mhandle.h>
 #include <lib/util/debug.h>
 #include <lib/util/linked-list.h>
@@ -31,13 +32,14 @@
 #include "local-mem-protocol.h"
 #include "mem-system.h"
 #include "mod-stack.h"
+#include "mshr.h"
 #include "nmoesi-protocol.h"
 
 
 /* String map for access type */
 struct str_map_t mod_access_kind_map =
 {
-	3, {
+	4, {
 		{ "Load", mod_access_load },
 		{ "Store", mod_access_store },
 		{ "NCStore", mod_access_nc_store },
@@ -78,6 +80,9 @@ struct mod_t *mod_create(char *name, enum mod_kind_t kind, int num_ports,
 
 	mod->client_info_repos = repos_create(sizeof(struct mod_client_info_t), mod->name);
 
+	/* Unbounded MSHR file until a size is given */
+	mod->mshr = mshr_create(mod->name, 0, mod->log_block_size);
+
 	return mod;
 }
 
@@ -91,6 +96,7 @@ void mod_free(struct mod_t *mod)
 	if (mod->dir)
 		dir_free(mod->dir);
 	free(mod->ports);
+	mshr_free(mod->mshr);
 	repos_free(mod->client_info_repos);
 	free(mod->name);
 	free(mod);
@@ -102,12 +108,24 @@ void mod_dump(struct mod_t *mod, FILE *f)
 }
 
 
+/* Set the number of MSHR entries of a module. A value of 0 means that the
+ * number of in-flight misses is unbounded. This function must be called
+ * before the first access to the module. */
+void mod_set_mshr_size(struct mod_t *mod, int mshr_size)
+{
+	assert(!mod->mshr->count);
+	mshr_free(mod->mshr);
+	mod->mshr = mshr_create(mod->name, mshr_size, mod->log_block_size);
+	mod->mshr_size = mshr_size;
+}
+
+
 /* Access a memory module.
  * Variable 'witness', if specified, will be increased when the access completes.
  * The function returns a unique access ID.
  */
 long long mod_access(struct mod_t *mod, enum mod_access_kind_t access_kind, 
-	unsigned int addr, int *witness_ptr, struct linked_list_t *event_queue,
+	unsigned long long addr, int *witness_ptr, struct linked_list_t *event_queue,
 	void *event_queue_item, struct mod_client_info_t *client_info)
 {
 	struct mod_stack_t *stack;
@@ -168,6 +186,16 @@ long long mod_access(struct mod_t *mod, enum mod_access_kind_t access_kind,
 		panic("%s: invalid mod kind", __FUNCTION__);
 	}
 
+	/* Wait for a free MSHR entry */
+	if (!mod_can_allocate_mshr(mod, addr))
+	{
+		mem_debug("%lld %lld 0x%llx %s wait for free MSHR\n", esim_time,
+			stack->id, addr, mod->name);
+		mod->mshr->stalls++;
+		mod_stack_wait_in_mod(stack, mod, event);
+		return stack->id;
+	}
+
 	/* Schedule */
 	esim_execute_event(event, stack);
 
@@ -177,31 +205,34 @@ long long mod_access(struct mod_t *mod, enum mod_access_kind_t access_kind,
 
 
 /* Return true if module can be accessed. */
-int mod_can_access(struct mod_t *mod, unsigned int addr)
+int mod_can_access(struct mod_t *mod, unsigned long long addr)
 {
-	int non_coalesced_accesses;
-
 	/* There must be a free port */
 	assert(mod->num_locked_ports <= mod->num_ports);
 	if (mod->num_locked_ports == mod->num_ports)
 		return 0;
 
-	/* If no MSHR is given, module can be accessed */
-	if (!mod->mshr_size)
-		return 1;
+	/* There must be an MSHR entry for the access */
+	return mod_can_allocate_mshr(mod, addr);
+}
+
 
-	/* Module can be accessed if number of non-coalesced in-flight
-	 * accesses is smaller than the MSHR size. */
-	non_coalesced_accesses = mod->access_list_count -
-		mod->access_list_coalesced_count;
-	return non_coalesced_accesses < mod->mshr_size;
+/* Return true if an access to 'addr' can be given an MSHR entry right away.
+ * An access to a block with an in-flight miss can always be merged into its
+ * entry. Otherwise, there must be a free entry that no older access is
+ * waiting for. */
+int mod_can_allocate_mshr(struct mod_t *mod, unsigned long long addr)
+{
+	if (mshr_lookup(mod->mshr, addr))
+		return 1;
+	return !mod->waiting_list_count && mshr_can_allocate(mod->mshr, addr);
 }
 
 
 /* Return {set, way, tag, state} for an address.
  * The function returns TRUE on hit, FALSE on miss. */
-int mod_find_block(struct mod_t *mod, unsigned int addr, int *set_ptr,
-	int *way_ptr, int *tag_ptr, int *state_ptr)
+int mod_find_block(struct mod_t *mod, unsigned long long addr, int *set_ptr,
+	int *way_ptr, unsigned long long *tag_ptr, int *state_ptr)
 {
 	struct cache_t *cache = mod->cache;
 	struct cache_block_t *blk;
@@ -209,7 +240,7 @@ int mod_find_block(struct mod_t *mod, unsigned int addr, int *set_ptr,
 
 	int set;
 	int way;
-	int tag;
+	unsigned long long tag;
 
 	/* A transient tag is considered a hit if the block is
 	 * locked in the corresponding directory. */
@@ -260,7 +291,7 @@ int mod_find_block(struct mod_t *mod, unsigned int addr, int *set_ptr,
 	return 1;
 }
 
-void mod_block_set_prefetched(struct mod_t *mod, unsigned int addr, int val)
+void mod_block_set_prefetched(struct mod_t *mod, unsigned long long addr, int val)
 {
 	int set, way;
 
@@ -271,7 +302,7 @@ void mod_block_set_prefetched(struct mod_t *mod, unsigned int addr, int val)
 	}
 }
 
-int mod_block_get_prefetched(struct mod_t *mod, unsigned int addr)
+int mod_block_get_prefetched(struct mod_t *mod, unsigned long long addr)
 {
 	int set, way;
 
@@ -367,11 +398,35 @@ void mod_unlock_port(struct mod_t *mod, struct mod_port_t *port,
 }
 
 
+/* Wake up accesses waiting for a free MSHR entry, in order, as long as there
+ * are entries available for them. An entry is allocated right away for each
+ * woken up access, so that it is not taken by a newer access. */
+static void mod_wakeup_mshr(struct mod_t *mod)
+{
+	struct mod_stack_t *stack;
+	int event;
+
+	while (mod->waiting_list_head)
+	{
+		stack = mod->waiting_list_head;
+		if (!mshr_lookup(mod->mshr, stack->addr))
+		{
+			if (!mshr_can_allocate(mod->mshr, stack->addr))
+				break;
+			mshr_allocate(mod->mshr, stack->addr);
+		}
+
+		/* Wake up */
+		event = stack->waiting_list_event;
+		DOUBLE_LINKED_LIST_REMOVE(mod, waiting, stack);
+		esim_schedule_event(event, stack, 0);
+	}
+}
+
+
 void mod_access_start(struct mod_t *mod, struct mod_stack_t *stack,
 	enum mod_access_kind_t access_kind)
 {
-	int index;
-
 	/* Record access kind */
 	stack->access_kind = access_kind;
 
@@ -382,16 +437,13 @@ void mod_access_start(struct mod_t *mod, struct mod_stack_t *stack,
 	if (access_kind == mod_access_store)
 		DOUBLE_LINKED_LIST_INSERT_TAIL(mod, write_access, stack);
 
-	/* Insert in access hash table */
-	index = (stack->addr >> mod->log_block_size) % MOD_ACCESS_HASH_TABLE_SIZE;
-	DOUBLE_LINKED_LIST_INSERT_TAIL(&mod->access_hash_table[index], bucket, stack);
+	/* Insert in MSHR file */
+	mshr_add_target(mod->mshr, stack);
 }
 
 
 void mod_access_finish(struct mod_t *mod, struct mod_stack_t *stack)
 {
-	int index;
-
 	/* Remove from access list */
 	DOUBLE_LINKED_LIST_REMOVE(mod, access, stack);
 
@@ -400,9 +452,10 @@ void mod_access_finish(struct mod_t *mod, struct mod_stack_t *stack)
 	if (stack->access_kind == mod_access_store)
 		DOUBLE_LINKED_LIST_REMOVE(mod, write_access, stack);
 
-	/* Remove from hash table */
-	index = (stack->addr >> mod->log_block_size) % MOD_ACCESS_HASH_TABLE_SIZE;
-	DOUBLE_LINKED_LIST_REMOVE(&mod->access_hash_table[index], bucket, stack);
+	/* Remove from MSHR file. If the entry was released, accesses waiting
+	 * for a free entry may proceed. */
+	if (mshr_remove_target(mod->mshr, stack))
+		mod_wakeup_mshr(mod);
 
 	/* If this was a coalesced access, update counter */
 	if (stack->coalesced)
@@ -410,21 +463,42 @@ void mod_access_finish(struct mod_t *mod, struct mod_stack_t *stack)
 		assert(mod->access_list_coalesced_count > 0);
 		mod->access_list_coalesced_count--;
 	}
+
+	/* Long-latency access opens a trace window */
+	mod_check_trace_trigger(mod, stack);
+}
+
+
+void mod_check_trace_trigger(struct mod_t *mod, struct mod_stack_t *stack)
+{
+	long long cycles;
+
+	/* Trigger disabled */
+	if (!mod->trace_trigger_latency)
+		return;
+
+	/* Open trace window if the access took too long */
+	cycles = (esim_time - stack->create_time) /
+		esim_domain_cycle_time(mem_domain_index);
+	if (cycles > mod->trace_trigger_latency)
+		trace_trigger();
 }
 
 
 /* Return true if the access with identifier 'id' is in flight.
  * The address of the access is passed as well because this lookup is done on the
- * access truth table, indexed by the access address.
+ * MSHR file, indexed by the access address.
  */
-int mod_in_flight_access(struct mod_t *mod, long long id, unsigned int addr)
+int mod_in_flight_access(struct mod_t *mod, long long id, unsigned long long addr)
 {
+	struct mshr_entry_t *entry;
 	struct mod_stack_t *stack;
-	int index;
 
 	/* Look for access */
-	index = (addr >> mod->log_block_size) % MOD_ACCESS_HASH_TABLE_SIZE;
-	for (stack = mod->access_hash_table[index].bucket_list_head; stack; stack = stack->bucket_list_next)
+	entry = mshr_lookup(mod->mshr, addr);
+	if (!entry)
+		return 0;
+	DOUBLE_LINKED_LIST_FOR_EACH(entry, target, stack)
 		if (stack->id == id)
 			return 1;
 
@@ -437,24 +511,25 @@ int mod_in_flight_access(struct mod_t *mod, long long id, unsigned int addr)
  * If 'older_than_stack' is NULL, return the youngest in-flight access containing 'addr'.
  * The function returns NULL if there is no in-flight access to block containing 'addr'.
  */
-struct mod_stack_t *mod_in_flight_address(struct mod_t *mod, unsigned int addr,
+struct mod_stack_t *mod_in_flight_address(struct mod_t *mod, unsigned long long addr,
 	struct mod_stack_t *older_than_stack)
 {
+	struct mshr_entry_t *entry;
 	struct mod_stack_t *stack;
-	int index;
 
-	/* Look for address */
-	index = (addr >> mod->log_block_size) % MOD_ACCESS_HASH_TABLE_SIZE;
-	for (stack = mod->access_hash_table[index].bucket_list_head; stack;
-		stack = stack->bucket_list_next)
+	/* Look for address. All accesses in the MSHR entry are accesses to
+	 * the same block. */
+	entry = mshr_lookup(mod->mshr, addr);
+	if (!entry)
+		return NULL;
+	DOUBLE_LINKED_LIST_FOR_EACH(entry, target, stack)
 	{
 		/* This stack is not older than 'older_than_stack' */
 		if (older_than_stack && stack->id >= older_than_stack->id)
 			continue;
 
 		/* Address matches */
-		if (stack->addr >> mod->log_block_size == addr >> mod->log_block_size)
-			return stack;
+		return stack;
 	}
 
 	/* Not found */
@@ -485,7 +560,7 @@ struct mod_stack_t *mod_in_flight_write(struct mod_t *mod,
 }
 
 
-int mod_serves_address(struct mod_t *mod, unsigned int addr)
+int mod_serves_address(struct mod_t *mod, unsigned long long addr)
 {
 	/* Address bounds */
 	if (mod->range_kind == mod_range_bounds)
@@ -505,7 +580,7 @@ int mod_serves_address(struct mod_t *mod, unsigned int addr)
 
 
 /* Return the low module serving a given address. */
-struct mod_t *mod_get_low_mod(struct mod_t *mod, unsigned int addr)
+struct mod_t *mod_get_low_mod(struct mod_t *mod, unsigned long long addr)
 {
 	struct mod_t *low_mod;
 	struct mod_t *server_mod;
@@ -529,7 +604,7 @@ struct mod_t *mod_get_low_mod(struct mod_t *mod, unsigned int addr)
 
 		/* Address served by more than one module */
 		if (server_mod)
-			fatal("%s: low modules %s and %s both serve address 0x%x",
+			fatal("%s: low modules %s and %s both serve address 0x%llx",
 				mod->name, server_mod->name, low_mod->name, addr);
 
 		/* Assign server */
@@ -538,7 +613,7 @@ struct mod_t *mod_get_low_mod(struct mod_t *mod, unsigned int addr)
 
 	/* Error if no low module serves address */
 	if (!server_mod)
-		fatal("module %s: no lower module serves address 0x%x",
+		fatal("module %s: no lower module serves address 0x%llx",
 			mod->name, addr);
 
 	/* Return server module */
@@ -558,14 +633,14 @@ int mod_get_retry_latency(struct mod_t *mod)
  * If it can, return the access that it would be coalesced with. Otherwise,
  * return NULL. */
 struct mod_stack_t *mod_can_coalesce(struct mod_t *mod,
-	enum mod_access_kind_t access_kind, unsigned int addr,
+	enum mod_access_kind_t access_kind, unsigned long long addr,
 	struct mod_stack_t *older_than_stack)
 {
 	struct mod_stack_t *stack;
 	struct mod_stack_t *tail;
 
-	/* For efficiency, first check in the hash table of accesses
-	 * whether there is an access in flight to the same block. */
+	/* For efficiency, first check in the MSHR file whether there
+	 * is an access in flight to the same block. */
 	assert(access_kind);
 	if (!mod_in_flight_address(mod, addr, older_than_stack))
 		return NULL;
@@ -668,7 +743,7 @@ void mod_coalesce(struct mod_t *mod, struct mod_stack_t *master_stack,
 	struct mod_stack_t *stack)
 {
 	/* Debug */
-	mem_debug("  %lld %lld 0x%x %s coalesce with %lld\n", esim_time,
+	mem_debug("  %lld %lld 0x%llx %s coalesce with %lld\n", esim_time,
 		stack->id, stack->addr, mod->name, master_stack->id);
 
 	/* Master stack must not have a parent. We only want one level of
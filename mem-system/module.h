@@ -78,8 +78,6 @@ enum mod_range_kind_t
 	mod_range_interleaved
 };
 
-#define MOD_ACCESS_HASH_TABLE_SIZE  17
-
 /* Memory module */
 struct mod_t
 {
@@ -102,8 +100,8 @@ struct mod_t
 		/* For range_kind = mod_range_bounds */
 		struct
 		{
-			unsigned int low;
-			unsigned int high;
+			unsigned long long low;
+			unsigned long long high;
 		} bounds;
 
 		/* For range_kind = mod_range_interleaved */
@@ -132,7 +130,7 @@ struct mod_t
 	int dir_assoc;
 	int dir_num_sets;
 
-	/* Waiting list of events */
+	/* Waiting list of events. Accesses wait here for a free MSHR. */
 	struct mod_stack_t *waiting_list_head;
 	struct mod_stack_t *waiting_list_tail;
 	int waiting_list_count;
@@ -177,20 +175,19 @@ struct mod_t
 	 * Using a repos_t memory allocator for these structures. */
 	struct repos_t *client_info_repos;
 
-	/* Hash table of accesses */
-	struct
-	{
-		struct mod_stack_t *bucket_list_head;
-		struct mod_stack_t *bucket_list_tail;
-		int bucket_list_count;
-		int bucket_list_max;
-	} access_hash_table[MOD_ACCESS_HASH_TABLE_SIZE];
+	/* MSHR file, tracking in-flight accesses by block. Its size is
+	 * given by 'mshr_size', with 0 meaning unbounded. */
+	struct mshr_t *mshr;
 
 	/* Architecture accessing this module. For versions of Multi2Sim where it is
 	 * allowed to have multiple architectures sharing the same subset of the
 	 * memory hierarchy, the field is used to check this restriction. */
 	struct arch_t *arch;
 
+	/* Accesses to the module, or requests serviced by it, taking more than
+	 * this number of cycles open a trace window. 0 if disabled. */
+	int trace_trigger_latency;
+
 	/* Statistics */
 	long long accesses;
 	long long hits;
@@ -237,19 +234,21 @@ struct mod_t *mod_create(char *name, enum mod_kind_t kind, int num_ports,
 	int block_size, int latency);
 void mod_free(struct mod_t *mod);
 void mod_dump(struct mod_t *mod, FILE *f);
+void mod_set_mshr_size(struct mod_t *mod, int mshr_size);
 void mod_stack_set_reply(struct mod_stack_t *stack, int reply);
 struct mod_t *mod_stack_set_peer(struct mod_t *peer, int state);
 
 long long mod_access(struct mod_t *mod, enum mod_access_kind_t access_kind, 
-	unsigned int addr, int *witness_ptr, struct linked_list_t *event_queue,
+	unsigned long long addr, int *witness_ptr, struct linked_list_t *event_queue,
 	void *event_queue_item, struct mod_client_info_t *client_info);
-int mod_can_access(struct mod_t *mod, unsigned int addr);
+int mod_can_access(struct mod_t *mod, unsigned long long addr);
+int mod_can_allocate_mshr(struct mod_t *mod, unsigned long long addr);
 
-int mod_find_block(struct mod_t *mod, unsigned int addr, int *set_ptr, int *way_ptr, 
-	int *tag_ptr, int *state_ptr);
+int mod_find_block(struct mod_t *mod, unsigned long long addr, int *set_ptr, int *way_ptr, 
+	unsigned long long *tag_ptr, int *state_ptr);
 
-void mod_block_set_prefetched(struct mod_t *mod, unsigned int addr, int val);
-int mod_block_get_prefetched(struct mod_t *mod, unsigned int addr);
+void mod_block_set_prefetched(struct mod_t *mod, unsigned long long addr, int val);
+int mod_block_get_prefetched(struct mod_t *mod, unsigned long long addr);
 
 void mod_lock_port(struct mod_t *mod, struct mod_stack_t *stack, int event);
 void mod_unlock_port(struct mod_t *mod, struct mod_port_t *port,
@@ -259,19 +258,23 @@ void mod_access_start(struct mod_t *mod, struct mod_stack_t *stack,
 	enum mod_access_kind_t access_kind);
 void mod_access_finish(struct mod_t *mod, struct mod_stack_t *stack);
 
-int mod_in_flight_access(struct mod_t *mod, long long id, unsigned int addr);
-struct mod_stack_t *mod_in_flight_address(struct mod_t *mod, unsigned int addr,
+/* Open a trace window if the access or request in 'stack' took longer than
+ * the trigger latency of 'mod' */
+void mod_check_trace_trigger(struct mod_t *mod, struct mod_stack_t *stack);
+
+int mod_in_flight_access(struct mod_t *mod, long long id, unsigned long long addr);
+struct mod_stack_t *mod_in_flight_address(struct mod_t *mod, unsigned long long addr,
 	struct mod_stack_t *older_than_stack);
 struct mod_stack_t *mod_in_flight_write(struct mod_t *mod,
 	struct mod_stack_t *older_than_stack);
 
-int mod_serves_address(struct mod_t *mod, unsigned int addr);
-struct mod_t *mod_get_low_mod(struct mod_t *mod, unsigned int addr);
+int mod_serves_address(struct mod_t *mod, unsigned long long addr);
+struct mod_t *mod_get_low_mod(struct mod_t *mod, unsigned long long addr);
 
 int mod_get_retry_latency(struct mod_t *mod);
 
 struct mod_stack_t *mod_can_coalesce(struct mod_t *mod,
-	enum mod_access_kind_t access_kind, unsigned int addr,
+	enum mod_access_kind_t access_kind, unsigned long long addr,
 	struct mod_stack_t *older_than_stack);
 void mod_coalesce(struct mod_t *mod, struct mod_stack_t *master_stack,
 	struct mod_stack_t *stack);
@@ -0,0 +1,325 @@
+/*
+ *  Multi2Sim
+ *  Copyright (C) 2012  Rafael Ubal (ubal@ece.neu.edu)
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include <assert.h>
+
+#include <lib/esim/esim.h>
+#include <lib/mhandle/mhandle.h>
+#include <lib/util/misc.h>
+
+#include "mem-system.h"
+#include "mod-stack.h"
+#include "mshr.h"
+
+
+
+/*
+ * Private Functions
+ */
+
+static int mshr_hash_index(struct mshr_t *mshr, unsigned long long block)
+{
+	return block & (mshr->hash_table_size - 1);
+}
+
+
+/* Account the cycles elapsed since the last change in the number of
+ * allocated entries. Must be called before every change. */
+static void mshr_update_occupancy(struct mshr_t *mshr)
+{
+	long long cycle;
+
+	if (!mshr->occupancy)
+		return;
+
+	cycle = esim_domain_cycle(mem_domain_index);
+	assert(mshr->count <= mshr->size);
+	mshr->occupancy[mshr->count] += cycle - mshr->occupancy_cycle;
+	mshr->occupancy_cycle = cycle;
+}
+
+
+/* Double the number of buckets of an unbounded MSHR file */
+static void mshr_grow_hash_table(struct mshr_t *mshr)
+{
+	struct mshr_entry_t **hash_table;
+	struct mshr_entry_t *entry;
+
+	int hash_table_size;
+	int index;
+	int i;
+
+	/* Save old table */
+	hash_table = mshr->hash_table;
+	hash_table_size = mshr->hash_table_size;
+
+	/* Rehash entries into new table */
+	mshr->hash_table_size = hash_table_size * 2;
+	mshr->hash_table = xcalloc(mshr->hash_table_size, sizeof(struct mshr_entry_t *));
+	for (i = 0; i < hash_table_size; i++)
+	{
+		while ((entry = hash_table[i]))
+		{
+			hash_table[i] = entry->bucket_next;
+			index = mshr_hash_index(mshr, entry->block);
+			entry->bucket_next = mshr->hash_table[index];
+			mshr->hash_table[index] = entry;
+		}
+	}
+
+	/* Free old table */
+	free(hash_table);
+}
+
+
+static void mshr_release(struct mshr_t *mshr, struct mshr_entry_t *entry)
+{
+	struct mshr_entry_t **entry_ptr;
+	int index;
+
+	/* Remove from bucket */
+	assert(!entry->target_list_count);
+	index = mshr_hash_index(mshr, entry->block);
+	for (entry_ptr = &mshr->hash_table[index]; *entry_ptr != entry;
+			entry_ptr = &(*entry_ptr)->bucket_next)
+		assert(*entry_ptr);
+	*entry_ptr = entry->bucket_next;
+
+	/* Return to free list */
+	mshr_update_occupancy(mshr);
+	mshr->count--;
+	entry->bucket_next = mshr->free_list;
+	mshr->free_list = entry;
+}
+
+
+
+
+/*
+ * Public Functions
+ */
+
+struct mshr_t *mshr_create(char *name, int size, int log_block_size)
+{
+	struct mshr_t *mshr;
+	struct mshr_entry_t *entry;
+
+	int i;
+
+	/* Initialize */
+	assert(size >= 0);
+	mshr = xcalloc(1, sizeof(struct mshr_t));
+	mshr->name = xstrdup(name);
+	mshr->size = size;
+	mshr->log_block_size = log_block_size;
+
+	/* Hash table with at least twice as many buckets as entries */
+	mshr->hash_table_size = MSHR_HASH_TABLE_MIN_SIZE;
+	while (mshr->hash_table_size < size * 2)
+		mshr->hash_table_size *= 2;
+	mshr->hash_table = xcalloc(mshr->hash_table_size, sizeof(struct mshr_entry_t *));
+
+	/* A bounded MSHR file allocates all its entries upfront */
+	for (i = 0; i < size; i++)
+	{
+		entry = xcalloc(1, sizeof(struct mshr_entry_t));
+		entry->bucket_next = mshr->free_list;
+		mshr->free_list = entry;
+	}
+
+	/* Occupancy histogram */
+	if (size)
+		mshr->occupancy = xcalloc(size + 1, sizeof(long long));
+
+	/* Return */
+	return mshr;
+}
+
+
+void mshr_free(struct mshr_t *mshr)
+{
+	struct mshr_entry_t *entry;
+	int i;
+
+	/* Free allocated entries */
+	for (i = 0; i < mshr->hash_table_size; i++)
+	{
+		while ((entry = mshr->hash_table[i]))
+		{
+			mshr->hash_table[i] = entry->bucket_next;
+			free(entry);
+		}
+	}
+
+	/* Free entries in free list */
+	while ((entry = mshr->free_list))
+	{
+		mshr->free_list = entry->bucket_next;
+		free(entry);
+	}
+
+	/* Free MSHR file */
+	free(mshr->hash_table);
+	free(mshr->occupancy);
+	free(mshr->name);
+	free(mshr);
+}
+
+
+void mshr_dump_report(struct mshr_t *mshr, FILE *f)
+{
+	long long cycles;
+	double average;
+	int i;
+
+	fprintf(f, "MSHR = %d\n", mshr->size);
+	fprintf(f, "MSHRAllocations = %lld\n", mshr->allocations);
+	fprintf(f, "MSHRMerges = %lld\n", mshr->merges);
+	fprintf(f, "MSHRStalls = %lld\n", mshr->stalls);
+	fprintf(f, "MSHRMaxOccupancy = %d\n", mshr->max_count);
+	if (!mshr->occupancy)
+		return;
+
+	/* Occupancy histogram */
+	mshr_update_occupancy(mshr);
+	cycles = 0;
+	average = 0.0;
+	for (i = 0; i <= mshr->size; i++)
+	{
+		cycles += mshr->occupancy[i];
+		average += (double) i * mshr->occupancy[i];
+	}
+	fprintf(f, "MSHRAverageOccupancy = %.4g\n", cycles ? average / cycles : 0.0);
+	fprintf(f, "MSHROccupancy =");
+	for (i = 0; i <= mshr->size; i++)
+		fprintf(f, " %lld", mshr->occupancy[i]);
+	fprintf(f, "\n");
+}
+
+
+/* Return the entry tracking the block containing 'addr', or NULL if there is
+ * no in-flight access to that block. */
+struct mshr_entry_t *mshr_lookup(struct mshr_t *mshr, unsigned long long addr)
+{
+	struct mshr_entry_t *entry;
+	unsigned long long block;
+
+	block = addr >> mshr->log_block_size;
+	for (entry = mshr->hash_table[mshr_hash_index(mshr, block)]; entry;
+			entry = entry->bucket_next)
+		if (entry->block == block)
+			return entry;
+
+	/* Not found */
+	return NULL;
+}
+
+
+/* Return true if an access to 'addr' can be accepted, either because it can
+ * be merged into an existing entry, or because there is a free entry. */
+int mshr_can_allocate(struct mshr_t *mshr, unsigned long long addr)
+{
+	if (!mshr->size || mshr->count < mshr->size)
+		return 1;
+	return mshr_lookup(mshr, addr) != NULL;
+}
+
+
+/* Allocate an empty entry for the block containing 'addr'. There must not be
+ * an entry for the block already, and the MSHR file must not be full. */
+struct mshr_entry_t *mshr_allocate(struct mshr_t *mshr, unsigned long long addr)
+{
+	struct mshr_entry_t *entry;
+	int index;
+
+	/* Get free entry */
+	assert(!mshr_lookup(mshr, addr));
+	assert(!mshr->size || mshr->count < mshr->size);
+	if (mshr->free_list)
+	{
+		entry = mshr->free_list;
+		mshr->free_list = entry->bucket_next;
+	}
+	else
+	{
+		assert(!mshr->size);
+		entry = xcalloc(1, sizeof(struct mshr_entry_t));
+	}
+
+	/* Keep unbounded hash tables sparse */
+	if (!mshr->size && mshr->count >= mshr->hash_table_size)
+		mshr_grow_hash_table(mshr);
+
+	/* Insert in hash table */
+	entry->block = addr >> mshr->log_block_size;
+	index = mshr_hash_index(mshr, entry->block);
+	entry->bucket_next = mshr->hash_table[index];
+	mshr->hash_table[index] = entry;
+
+	/* Update occupancy */
+	mshr_update_occupancy(mshr);
+	mshr->count++;
+	mshr->max_count = MAX(mshr->max_count, mshr->count);
+
+	/* Return */
+	return entry;
+}
+
+
+/* Record an in-flight access. If this is the first access to its block, it
+ * allocates the entry. Otherwise, it is merged into the existing entry. */
+void mshr_add_target(struct mshr_t *mshr, struct mod_stack_t *stack)
+{
+	struct mshr_entry_t *entry;
+
+	/* Find or allocate entry. An entry may have been allocated empty for
+	 * an access that was waiting for a free entry. */
+	assert(!stack->mshr_entry);
+	entry = mshr_lookup(mshr, stack->addr);
+	if (!entry)
+		entry = mshr_allocate(mshr, stack->addr);
+	if (entry->target_list_count)
+		mshr->merges++;
+	else
+		mshr->allocations++;
+
+	/* Add target */
+	DOUBLE_LINKED_LIST_INSERT_TAIL(entry, target, stack);
+	stack->mshr_entry = entry;
+}
+
+
+/* Remove an access from its entry. The function returns true if the entry
+ * was released as a consequence. */
+int mshr_remove_target(struct mshr_t *mshr, struct mod_stack_t *stack)
+{
+	struct mshr_entry_t *entry;
+
+	/* Remove target */
+	entry = stack->mshr_entry;
+	assert(entry);
+	DOUBLE_LINKED_LIST_REMOVE(entry, target, stack);
+	stack->mshr_entry = NULL;
+
+	/* Release entry */
+	if (entry->target_list_count)
+		return 0;
+	mshr_release(mshr, entry);
+	return 1;
+}
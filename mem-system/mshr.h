@@ -0,0 +1,97 @@
+/*
+ *  Multi2Sim
+ *  Copyright (C) 2012  Rafael Ubal (ubal@ece.neu.edu)
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef MEM_SYSTEM_MSHR_H
+#define MEM_SYSTEM_MSHR_H
+
+#include <stdio.h>
+
+
+/*
+ * Miss status holding registers. The MSHR file of a module has one entry per
+ * block with in-flight accesses. The first access to a block allocates the
+ * entry (primary miss), and later accesses to the same block are merged into
+ * the entry's target list (secondary misses). An MSHR file with size 0 has an
+ * unbounded number of entries, and is only used to track in-flight accesses.
+ */
+
+/* Initial number of hash table buckets for unbounded MSHR files */
+#define MSHR_HASH_TABLE_MIN_SIZE  64
+
+struct mshr_entry_t
+{
+	/* Block address, that is, address shifted by log2 of block size */
+	unsigned long long block;
+
+	/* Next entry in hash table bucket or in free list */
+	struct mshr_entry_t *bucket_next;
+
+	/* In-flight accesses to the block in order of arrival. The head of
+	 * the list is the oldest access. */
+	struct mod_stack_t *target_list_head;
+	struct mod_stack_t *target_list_tail;
+	int target_list_count;
+	int target_list_max;
+};
+
+struct mshr_t
+{
+	char *name;
+
+	/* Maximum number of entries, or 0 for unbounded */
+	int size;
+	int log_block_size;
+
+	/* Hash table of entries indexed by block address. The number of
+	 * buckets is always a power of 2. */
+	struct mshr_entry_t **hash_table;
+	int hash_table_size;
+
+	/* Allocated and free entries */
+	int count;
+	struct mshr_entry_t *free_list;
+
+	/* Occupancy histogram. Element 'i' is the number of cycles during
+	 * which exactly 'i' entries were allocated. Only for bounded files. */
+	long long *occupancy;
+	long long occupancy_cycle;
+
+	/* Statistics */
+	long long allocations;
+	long long merges;
+	long long stalls;
+	int max_count;
+};
+
+struct mod_stack_t;
+
+struct mshr_t *mshr_create(char *name, int size, int log_block_size);
+void mshr_free(struct mshr_t *mshr);
+void mshr_dump_report(struct mshr_t *mshr, FILE *f);
+
+struct mshr_entry_t *mshr_lookup(struct mshr_t *mshr, unsigned long long addr);
+int mshr_can_allocate(struct mshr_t *mshr, unsigned long long addr);
+struct mshr_entry_t *mshr_allocate(struct mshr_t *mshr, unsigned long long addr);
+
+void mshr_add_target(struct mshr_t *mshr, struct mod_stack_t *stack);
+int mshr_remove_target(struct mshr_t *mshr, struct mod_stack_t *stack);
+
+
+#endif
+
@@ -134,10 +134,10 @@ void mod_handler_nmoesi_load(int event, void *data)
 	{
 		struct mod_stack_t *master_stack;
 
-		mem_debug("%lld %lld 0x%x %s load\n", esim_time, stack->id,
+		mem_debug("%lld %lld 0x%llx %s load\n", esim_time, stack->id,
 			stack->addr, mod->name);
 		mem_trace("mem.new_access name=\"A-%lld\" type=\"load\" "
-			"state=\"%s:load\" addr=0x%x\n",
+			"state=\"%s:load\" addr=0x%llx\n",
 			stack->id, mod->name, stack->addr);
 
 		/* Record access */
@@ -147,6 +147,11 @@ void mod_handler_nmoesi_load(int event, void *data)
 		master_stack = mod_can_coalesce(mod, mod_access_load, stack->addr, stack);
 		if (master_stack)
 		{
+			/* The prefetcher may be interested in a prefetch that
+			 * did not arrive on time for this access. */
+			if (master_stack->access_kind == mod_access_prefetch)
+				prefetcher_access_late(stack, mod, master_stack);
+
 			mod->reads++;
 			mod_coalesce(mod, master_stack, stack);
 			mod_stack_wait_in_stack(stack, master_stack, EV_MOD_NMOESI_LOAD_FINISH);
@@ -162,7 +167,7 @@ void mod_handler_nmoesi_load(int event, void *data)
 	{
 		struct mod_stack_t *older_stack;
 
-		mem_debug("  %lld %lld 0x%x %s load lock\n", esim_time, stack->id,
+		mem_debug("  %lld %lld 0x%llx %s load lock\n", esim_time, stack->id,
 			stack->addr, mod->name);
 		mem_trace("mem.access name=\"A-%lld\" state=\"%s:load_lock\"\n",
 			stack->id, mod->name);
@@ -202,7 +207,7 @@ void mod_handler_nmoesi_load(int event, void *data)
 	{
 		int retry_lat;
 
-		mem_debug("  %lld %lld 0x%x %s load action\n", esim_time, stack->id,
+		mem_debug("  %lld %lld 0x%llx %s load action\n", esim_time, stack->id,
 			stack->addr, mod->name);
 		mem_trace("mem.access name=\"A-%lld\" state=\"%s:load_action\"\n",
 			stack->id, mod->name);
@@ -249,7 +254,7 @@ void mod_handler_nmoesi_load(int event, void *data)
 	{
 		int retry_lat;
 
-		mem_debug("  %lld %lld 0x%x %s load miss\n", esim_time, stack->id,
+		mem_debug("  %lld %lld 0x%llx %s load miss\n", esim_time, stack->id,
 			stack->addr, mod->name);
 		mem_trace("mem.access name=\"A-%lld\" state=\"%s:load_miss\"\n",
 			stack->id, mod->name);
@@ -278,7 +283,7 @@ void mod_handler_nmoesi_load(int event, void *data)
 
 	if (event == EV_MOD_NMOESI_LOAD_UNLOCK)
 	{
-		mem_debug("  %lld %lld 0x%x %s load unlock\n", esim_time, stack->id,
+		mem_debug("  %lld %lld 0x%llx %s load unlock\n", esim_time, stack->id,
 			stack->addr, mod->name);
 		mem_trace("mem.access name=\"A-%lld\" state=\"%s:load_unlock\"\n",
 			stack->id, mod->name);
@@ -294,7 +299,7 @@ void mod_handler_nmoesi_load(int event, void *data)
 
 	if (event == EV_MOD_NMOESI_LOAD_FINISH)
 	{
-		mem_debug("%lld %lld 0x%x %s load finish\n", esim_time, stack->id,
+		mem_debug("%lld %lld 0x%llx %s load finish\n", esim_time, stack->id,
 			stack->addr, mod->name);
 		mem_trace("mem.access name=\"A-%lld\" state=\"%s:load_finish\"\n",
 			stack->id, mod->name);
@@ -337,10 +342,10 @@ void mod_handler_nmoesi_store(int event, void *data)
 	{
 		struct mod_stack_t *master_stack;
 
-		mem_debug("%lld %lld 0x%x %s store\n", esim_time, stack->id,
+		mem_debug("%lld %lld 0x%llx %s store\n", esim_time, stack->id,
 			stack->addr, mod->name);
 		mem_trace("mem.new_access name=\"A-%lld\" type=\"store\" "
-			"state=\"%s:store\" addr=0x%x\n",
+			"state=\"%s:store\" addr=0x%llx\n",
 			stack->id, mod->name, stack->addr);
 
 		/* Record access */
@@ -371,7 +376,7 @@ void mod_handler_nmoesi_store(int event, void *data)
 	{
 		struct mod_stack_t *older_stack;
 
-		mem_debug("  %lld %lld 0x%x %s store lock\n", esim_time, stack->id,
+		mem_debug("  %lld %lld 0x%llx %s store lock\n", esim_time, stack->id,
 			stack->addr, mod->name);
 		mem_trace("mem.access name=\"A-%lld\" state=\"%s:store_lock\"\n",
 			stack->id, mod->name);
@@ -406,7 +411,7 @@ void mod_handler_nmoesi_store(int event, void *data)
 	{
 		int retry_lat;
 
-		mem_debug("  %lld %lld 0x%x %s store action\n", esim_time, stack->id,
+		mem_debug("  %lld %lld 0x%llx %s store action\n", esim_time, stack->id,
 			stack->addr, mod->name);
 		mem_trace("mem.access name=\"A-%lld\" state=\"%s:store_action\"\n",
 			stack->id, mod->name);
@@ -454,7 +459,7 @@ void mod_handler_nmoesi_store(int event, void *data)
 	{
 		int retry_lat;
 
-		mem_debug("  %lld %lld 0x%x %s store unlock\n", esim_time, stack->id,
+		mem_debug("  %lld %lld 0x%llx %s store unlock\n", esim_time, stack->id,
 			stack->addr, mod->name);
 		mem_trace("mem.access name=\"A-%lld\" state=\"%s:store_unlock\"\n",
 			stack->id, mod->name);
@@ -484,7 +489,7 @@ void mod_handler_nmoesi_store(int event, void *data)
 
 	if (event == EV_MOD_NMOESI_STORE_FINISH)
 	{
-		mem_debug("%lld %lld 0x%x %s store finish\n", esim_time, stack->id,
+		mem_debug("%lld %lld 0x%llx %s store finish\n", esim_time, stack->id,
 			stack->addr, mod->name);
 		mem_trace("mem.access name=\"A-%lld\" state=\"%s:store_finish\"\n",
 			stack->id, mod->name);
@@ -522,10 +527,10 @@ void mod_handler_nmoesi_nc_store(int event, void *data)
 	{
 		struct mod_stack_t *master_stack;
 
-		mem_debug("%lld %lld 0x%x %s nc store\n", esim_time, stack->id,
+		mem_debug("%lld %lld 0x%llx %s nc store\n", esim_time, stack->id,
 			stack->addr, mod->name);
 		mem_trace("mem.new_access name=\"A-%lld\" type=\"nc_store\" "
-			"state=\"%s:nc store\" addr=0x%x\n", stack->id, mod->name, stack->addr);
+			"state=\"%s:nc store\" addr=0x%llx\n", stack->id, mod->name, stack->addr);
 
 		/* Record access */
 		mod_access_start(mod, stack, mod_access_nc_store);
@@ -549,7 +554,7 @@ void mod_handler_nmoesi_nc_store(int event, void *data)
 	{
 		struct mod_stack_t *older_stack;
 
-		mem_debug("  %lld %lld 0x%x %s nc store lock\n", esim_time, stack->id,
+		mem_debug("  %lld %lld 0x%llx %s nc store lock\n", esim_time, stack->id,
 			stack->addr, mod->name);
 		mem_trace("mem.access name=\"A-%lld\" state=\"%s:nc_store_lock\"\n",
 			stack->id, mod->name);
@@ -587,7 +592,7 @@ void mod_handler_nmoesi_nc_store(int event, void *data)
 	{
 		int retry_lat;
 
-		mem_debug("  %lld %lld 0x%x %s nc store writeback\n", esim_time, stack->id,
+		mem_debug("  %lld %lld 0x%llx %s nc store writeback\n", esim_time, stack->id,
 			stack->addr, mod->name);
 		mem_trace("mem.access name=\"A-%lld\" state=\"%s:nc_store_writeback\"\n",
 			stack->id, mod->name);
@@ -624,7 +629,7 @@ void mod_handler_nmoesi_nc_store(int event, void *data)
 	{
 		int retry_lat;
 
-		mem_debug("  %lld %lld 0x%x %s nc store action\n", esim_time, stack->id,
+		mem_debug("  %lld %lld 0x%llx %s nc store action\n", esim_time, stack->id,
 			stack->addr, mod->name);
 		mem_trace("mem.access name=\"A-%lld\" state=\"%s:nc_store_action\"\n",
 			stack->id, mod->name);
@@ -687,7 +692,7 @@ void mod_handler_nmoesi_nc_store(int event, void *data)
 	{
 		int retry_lat;
 
-		mem_debug("  %lld %lld 0x%x %s nc store miss\n", esim_time, stack->id,
+		mem_debug("  %lld %lld 0x%llx %s nc store miss\n", esim_time, stack->id,
 			stack->addr, mod->name);
 		mem_trace("mem.access name=\"A-%lld\" state=\"%s:nc_store_miss\"\n",
 			stack->id, mod->name);
@@ -711,7 +716,7 @@ void mod_handler_nmoesi_nc_store(int event, void *data)
 
 	if (event == EV_MOD_NMOESI_NC_STORE_UNLOCK)
 	{
-		mem_debug("  %lld %lld 0x%x %s nc store unlock\n", esim_time, stack->id,
+		mem_debug("  %lld %lld 0x%llx %s nc store unlock\n", esim_time, stack->id,
 			stack->addr, mod->name);
 		mem_trace("mem.access name=\"A-%lld\" state=\"%s:nc_store_unlock\"\n",
 			stack->id, mod->name);
@@ -732,7 +737,7 @@ void mod_handler_nmoesi_nc_store(int event, void *data)
 
 	if (event == EV_MOD_NMOESI_NC_STORE_FINISH)
 	{
-		mem_debug("%lld %lld 0x%x %s nc store finish\n", esim_time, stack->id,
+		mem_debug("%lld %lld 0x%llx %s nc store finish\n", esim_time, stack->id,
 			stack->addr, mod->name);
 		mem_trace("mem.access name=\"A-%lld\" state=\"%s:nc_store_finish\"\n",
 			stack->id, mod->name);
@@ -774,10 +779,10 @@ void mod_handler_nmoesi_prefetch(int event, void *data)
 	{
 		struct mod_stack_t *master_stack;
 
-		mem_debug("%lld %lld 0x%x %s prefetch\n", esim_time, stack->id,
+		mem_debug("%lld %lld 0x%llx %s prefetch\n", esim_time, stack->id,
 			stack->addr, mod->name);
 		mem_trace("mem.new_access name=\"A-%lld\" type=\"store\" "
-			"state=\"%s:prefetch\" addr=0x%x\n",
+			"state=\"%s:prefetch\" addr=0x%llx\n",
 			stack->id, mod->name, stack->addr);
 
 		/* Record access */
@@ -788,16 +793,12 @@ void mod_handler_nmoesi_prefetch(int event, void *data)
 		if (master_stack)
 		{
 			/* Doesn't make sense to prefetch as the block is already being fetched */
-			mem_debug("  %lld %lld 0x%x %s useless prefetch - already being fetched\n",
+			mem_debug("  %lld %lld 0x%llx %s useless prefetch - already being fetched\n",
 				  esim_time, stack->id, stack->addr, mod->name);
 
+			/* The witness variable is incremented in the finish event */
 			mod->useless_prefetches++;
 			esim_schedule_event(EV_MOD_NMOESI_PREFETCH_FINISH, stack, 0);
-
-			/* Increment witness variable */
-			if (stack->witness_ptr)
-				(*stack->witness_ptr)++;
-
 			return;
 		}
 
@@ -811,7 +812,7 @@ void mod_handler_nmoesi_prefetch(int event, void *data)
 	{
 		struct mod_stack_t *older_stack;
 
-		mem_debug("  %lld %lld 0x%x %s prefetch lock\n", esim_time, stack->id,
+		mem_debug("  %lld %lld 0x%llx %s prefetch lock\n", esim_time, stack->id,
 			stack->addr, mod->name);
 		mem_trace("mem.access name=\"A-%lld\" state=\"%s:prefetch_lock\"\n",
 			stack->id, mod->name);
@@ -832,19 +833,16 @@ void mod_handler_nmoesi_prefetch(int event, void *data)
 		new_stack->blocking = 0;
 		new_stack->prefetch = 1;
 		new_stack->retry = 0;
-		new_stack->witness_ptr = stack->witness_ptr;
 		esim_schedule_event(EV_MOD_NMOESI_FIND_AND_LOCK, new_stack, 0);
 
-		/* Set witness variable to NULL so that retries from the same
-		 * stack do not increment it multiple times */
-		stack->witness_ptr = NULL;
-
+		/* Prefetches are never retried, so the witness variable stays in
+		 * this stack and is incremented once in the finish event. */
 		return;
 	}
 
 	if (event == EV_MOD_NMOESI_PREFETCH_ACTION)
 	{
-		mem_debug("  %lld %lld 0x%x %s prefetch action\n", esim_time, stack->id,
+		mem_debug("  %lld %lld 0x%llx %s prefetch action\n", esim_time, stack->id,
 			stack->addr, mod->name);
 		mem_trace("mem.access name=\"A-%lld\" state=\"%s:prefetch_action\"\n",
 			stack->id, mod->name);
@@ -866,7 +864,7 @@ void mod_handler_nmoesi_prefetch(int event, void *data)
 		if (stack->state)
 		{
 			/* block already in the cache */
-			mem_debug("  %lld %lld 0x%x %s useless prefetch - cache hit\n",
+			mem_debug("  %lld %lld 0x%llx %s useless prefetch - cache hit\n",
 				  esim_time, stack->id, stack->addr, mod->name);
 
 			mod->useless_prefetches++;
@@ -886,7 +884,7 @@ void mod_handler_nmoesi_prefetch(int event, void *data)
 	}
 	if (event == EV_MOD_NMOESI_PREFETCH_MISS)
 	{
-		mem_debug("  %lld %lld 0x%x %s prefetch miss\n", esim_time, stack->id,
+		mem_debug("  %lld %lld 0x%llx %s prefetch miss\n", esim_time, stack->id,
 			stack->addr, mod->name);
 		mem_trace("mem.access name=\"A-%lld\" state=\"%s:prefetch_miss\"\n",
 			stack->id, mod->name);
@@ -914,8 +912,10 @@ void mod_handler_nmoesi_prefetch(int event, void *data)
 		 * is aware of all misses as they would be without the prefetcher. 
 		 * TODO: The lower caches that will be filled because of this prefetch
 		 * do not know if it was a prefetch or not. Need to have a way to mark
-		 * them as prefetched too. */
-		mod_block_set_prefetched(mod, stack->addr, 1);
+		 * them as prefetched too. A late prefetch was already consumed by
+		 * the demand access coalesced with it. */
+		if (!stack->late_prefetch)
+			mod_block_set_prefetched(mod, stack->addr, 1);
 
 		/* Continue */
 		esim_schedule_event(EV_MOD_NMOESI_PREFETCH_UNLOCK, stack, 0);
@@ -924,7 +924,7 @@ void mod_handler_nmoesi_prefetch(int event, void *data)
 
 	if (event == EV_MOD_NMOESI_PREFETCH_UNLOCK)
 	{
-		mem_debug("  %lld %lld 0x%x %s prefetch unlock\n", esim_time, stack->id,
+		mem_debug("  %lld %lld 0x%llx %s prefetch unlock\n", esim_time, stack->id,
 			stack->addr, mod->name);
 		mem_trace("mem.access name=\"A-%lld\" state=\"%s:prefetch_unlock\"\n",
 			stack->id, mod->name);
@@ -939,7 +939,7 @@ void mod_handler_nmoesi_prefetch(int event, void *data)
 
 	if (event == EV_MOD_NMOESI_PREFETCH_FINISH)
 	{
-		mem_debug("%lld %lld 0x%x %s prefetch\n", esim_time, stack->id,
+		mem_debug("%lld %lld 0x%llx %s prefetch\n", esim_time, stack->id,
 			stack->addr, mod->name);
 		mem_trace("mem.access name=\"A-%lld\" state=\"%s:prefetch_finish\"\n",
 			stack->id, mod->name);
@@ -980,7 +980,7 @@ void mod_handler_nmoesi_find_and_lock(int event, void *data)
 
 	if (event == EV_MOD_NMOESI_FIND_AND_LOCK)
 	{
-		mem_debug("  %lld %lld 0x%x %s find and lock (blocking=%d)\n",
+		mem_debug("  %lld %lld 0x%llx %s find and lock (blocking=%d)\n",
 			esim_time, stack->id, stack->addr, mod->name, stack->blocking);
 		mem_trace("mem.access name=\"A-%lld\" state=\"%s:find_and_lock\"\n",
 			stack->id, mod->name);
@@ -1002,7 +1002,7 @@ void mod_handler_nmoesi_find_and_lock(int event, void *data)
 		struct dir_lock_t *dir_lock;
 
 		assert(stack->port);
-		mem_debug("  %lld %lld 0x%x %s find and lock port\n", esim_time, stack->id,
+		mem_debug("  %lld %lld 0x%llx %s find and lock port\n", esim_time, stack->id,
 			stack->addr, mod->name);
 		mem_trace("mem.access name=\"A-%lld\" state=\"%s:find_and_lock_port\"\n",
 			stack->id, mod->name);
@@ -1018,7 +1018,7 @@ void mod_handler_nmoesi_find_and_lock(int event, void *data)
 
 		/* Debug */
 		if (stack->hit)
-			mem_debug("    %lld 0x%x %s hit: set=%d, way=%d, state=%s\n", stack->id,
+			mem_debug("    %lld 0x%llx %s hit: set=%d, way=%d, state=%s\n", stack->id,
 				stack->tag, mod->name, stack->set, stack->way,
 				str_map_value(&cache_block_state_map, stack->state));
 
@@ -1125,7 +1125,7 @@ void mod_handler_nmoesi_find_and_lock(int event, void *data)
 		dir_lock = dir_lock_get(mod->dir, stack->set, stack->way);
 		if (dir_lock->lock && !stack->blocking)
 		{
-			mem_debug("    %lld 0x%x %s block locked at set=%d, way=%d by A-%lld - aborting\n",
+			mem_debug("    %lld 0x%llx %s block locked at set=%d, way=%d by A-%lld - aborting\n",
 				stack->id, stack->tag, mod->name, stack->set, stack->way, dir_lock->stack_id);
 			ret->err = 1;
 			mod_unlock_port(mod, port, stack);
@@ -1140,7 +1140,7 @@ void mod_handler_nmoesi_find_and_lock(int event, void *data)
 		if (!dir_entry_lock(mod->dir, stack->set, stack->way, EV_MOD_NMOESI_FIND_AND_LOCK, 
 			stack))
 		{
-			mem_debug("    %lld 0x%x %s block locked at set=%d, way=%d by A-%lld - waiting\n",
+			mem_debug("    %lld 0x%llx %s block locked at set=%d, way=%d by A-%lld - waiting\n",
 				stack->id, stack->tag, mod->name, stack->set, stack->way, dir_lock->stack_id);
 			mod_unlock_port(mod, port, stack);
 			ret->port_locked = 0;
@@ -1154,7 +1154,7 @@ void mod_handler_nmoesi_find_and_lock(int event, void *data)
 			cache_get_block(mod->cache, stack->set, stack->way, NULL, &stack->state);
 			assert(stack->state || !dir_entry_group_shared_or_owned(mod->dir,
 				stack->set, stack->way));
-			mem_debug("    %lld 0x%x %s miss -> lru: set=%d, way=%d, state=%s\n",
+			mem_debug("    %lld 0x%llx %s miss -> lru: set=%d, way=%d, state=%s\n",
 				stack->id, stack->tag, mod->name, stack->set, stack->way,
 				str_map_value(&cache_block_state_map, stack->state));
 		}
@@ -1176,7 +1176,7 @@ void mod_handler_nmoesi_find_and_lock(int event, void *data)
 		struct mod_port_t *port = stack->port;
 
 		assert(port);
-		mem_debug("  %lld %lld 0x%x %s find and lock action\n", esim_time, stack->id,
+		mem_debug("  %lld %lld 0x%llx %s find and lock action\n", esim_time, stack->id,
 			stack->tag, mod->name);
 		mem_trace("mem.access name=\"A-%lld\" state=\"%s:find_and_lock_action\"\n",
 			stack->id, mod->name);
@@ -1188,6 +1188,11 @@ void mod_handler_nmoesi_find_and_lock(int event, void *data)
 		/* On miss, evict if victim is a valid block. */
 		if (!stack->hit && stack->state)
 		{
+			/* The prefetcher tracks blocks replaced by prefetches */
+			if (stack->prefetch)
+				prefetcher_evict(mod, mod->cache->sets[stack->set].
+					blocks[stack->way].tag);
+
 			stack->eviction = 1;
 			new_stack = mod_stack_create(stack->id, mod, 0,
 				EV_MOD_NMOESI_FIND_AND_LOCK_FINISH, stack);
@@ -1204,7 +1209,7 @@ void mod_handler_nmoesi_find_and_lock(int event, void *data)
 
 	if (event == EV_MOD_NMOESI_FIND_AND_LOCK_FINISH)
 	{
-		mem_debug("  %lld %lld 0x%x %s find and lock finish (err=%d)\n", esim_time, stack->id,
+		mem_debug("  %lld %lld 0x%llx %s find and lock finish (err=%d)\n", esim_time, stack->id,
 			stack->tag, mod->name, stack->err);
 		mem_trace("mem.access name=\"A-%lld\" state=\"%s:find_and_lock_finish\"\n",
 			stack->id, mod->name);
@@ -1264,7 +1269,8 @@ void mod_handler_nmoesi_evict(int event, void *data)
 	struct dir_t *dir;
 	struct dir_entry_t *dir_entry;
 
-	uint32_t dir_entry_tag, z;
+	unsigned long long dir_entry_tag;
+	uint32_t z;
 
 
 	if (event == EV_MOD_NMOESI_EVICT)
@@ -1276,7 +1282,7 @@ void mod_handler_nmoesi_evict(int event, void *data)
 		cache_get_block(mod->cache, stack->set, stack->way, &stack->tag, &stack->state);
 		assert(stack->state || !dir_entry_group_shared_or_owned(mod->dir,
 			stack->set, stack->way));
-		mem_debug("  %lld %lld 0x%x %s evict (set=%d, way=%d, state=%s)\n", esim_time, stack->id,
+		mem_debug("  %lld %lld 0x%llx %s evict (set=%d, way=%d, state=%s)\n", esim_time, stack->id,
 			stack->tag, mod->name, stack->set, stack->way,
 			str_map_value(&cache_block_state_map, stack->state));
 		mem_trace("mem.access name=\"A-%lld\" state=\"%s:evict\"\n",
@@ -1299,7 +1305,7 @@ void mod_handler_nmoesi_evict(int event, void *data)
 
 	if (event == EV_MOD_NMOESI_EVICT_INVALID)
 	{
-		mem_debug("  %lld %lld 0x%x %s evict invalid\n", esim_time, stack->id,
+		mem_debug("  %lld %lld 0x%llx %s evict invalid\n", esim_time, stack->id,
 			stack->tag, mod->name);
 		mem_trace("mem.access name=\"A-%lld\" state=\"%s:evict_invalid\"\n",
 			stack->id, mod->name);
@@ -1325,7 +1331,7 @@ void mod_handler_nmoesi_evict(int event, void *data)
 		struct net_node_t *low_node;
 		int msg_size;
 
-		mem_debug("  %lld %lld 0x%x %s evict action\n", esim_time, stack->id,
+		mem_debug("  %lld %lld 0x%llx %s evict action\n", esim_time, stack->id,
 			stack->tag, mod->name);
 		mem_trace("mem.access name=\"A-%lld\" state=\"%s:evict_action\"\n",
 			stack->id, mod->name);
@@ -1371,7 +1377,7 @@ void mod_handler_nmoesi_evict(int event, void *data)
 
 	if (event == EV_MOD_NMOESI_EVICT_RECEIVE)
 	{
-		mem_debug("  %lld %lld 0x%x %s evict receive\n", esim_time, stack->id,
+		mem_debug("  %lld %lld 0x%llx %s evict receive\n", esim_time, stack->id,
 			stack->tag, target_mod->name);
 		mem_trace("mem.access name=\"A-%lld\" state=\"%s:evict_receive\"\n",
 			stack->id, target_mod->name);
@@ -1401,7 +1407,7 @@ void mod_handler_nmoesi_evict(int event, void *data)
 
 	if (event == EV_MOD_NMOESI_EVICT_PROCESS)
 	{
-		mem_debug("  %lld %lld 0x%x %s evict process\n", esim_time, stack->id,
+		mem_debug("  %lld %lld 0x%llx %s evict process\n", esim_time, stack->id,
 			stack->tag, target_mod->name);
 		mem_trace("mem.access name=\"A-%lld\" state=\"%s:evict_process\"\n",
 			stack->id, target_mod->name);
@@ -1475,7 +1481,7 @@ void mod_handler_nmoesi_evict(int event, void *data)
 
 	if (event == EV_MOD_NMOESI_EVICT_PROCESS_NONCOHERENT)
 	{
-		mem_debug("  %lld %lld 0x%x %s evict process noncoherent\n", esim_time, stack->id,
+		mem_debug("  %lld %lld 0x%llx %s evict process noncoherent\n", esim_time, stack->id,
 			stack->tag, target_mod->name);
 		mem_trace("mem.access name=\"A-%lld\" state=\"%s:evict_process_noncoherent\"\n",
 			stack->id, target_mod->name);
@@ -1552,7 +1558,7 @@ void mod_handler_nmoesi_evict(int event, void *data)
 
 	if (event == EV_MOD_NMOESI_EVICT_REPLY)
 	{
-		mem_debug("  %lld %lld 0x%x %s evict reply\n", esim_time, stack->id,
+		mem_debug("  %lld %lld 0x%llx %s evict reply\n", esim_time, stack->id,
 			stack->tag, target_mod->name);
 		mem_trace("mem.access name=\"A-%lld\" state=\"%s:evict_reply\"\n",
 			stack->id, target_mod->name);
@@ -1567,7 +1573,7 @@ void mod_handler_nmoesi_evict(int event, void *data)
 
 	if (event == EV_MOD_NMOESI_EVICT_REPLY_RECEIVE)
 	{
-		mem_debug("  %lld %lld 0x%x %s evict reply receive\n", esim_time, stack->id,
+		mem_debug("  %lld %lld 0x%llx %s evict reply receive\n", esim_time, stack->id,
 			stack->tag, mod->name);
 		mem_trace("mem.access name=\"A-%lld\" state=\"%s:evict_reply_receive\"\n",
 			stack->id, mod->name);
@@ -1587,7 +1593,7 @@ void mod_handler_nmoesi_evict(int event, void *data)
 
 	if (event == EV_MOD_NMOESI_EVICT_FINISH)
 	{
-		mem_debug("  %lld %lld 0x%x %s evict finish\n", esim_time, stack->id,
+		mem_debug("  %lld %lld 0x%llx %s evict finish\n", esim_time, stack->id,
 			stack->tag, mod->name);
 		mem_trace("mem.access name=\"A-%lld\" state=\"%s:evict_finish\"\n",
 			stack->id, mod->name);
@@ -1612,7 +1618,8 @@ void mod_handler_nmoesi_read_request(int event, void *data)
 	struct dir_t *dir;
 	struct dir_entry_t *dir_entry;
 
-	uint32_t dir_entry_tag, z;
+	unsigned long long dir_entry_tag;
+	uint32_t z;
 
 	if (event == EV_MOD_NMOESI_READ_REQUEST)
 	{
@@ -1620,7 +1627,7 @@ void mod_handler_nmoesi_read_request(int event, void *data)
 		struct net_node_t *src_node;
 		struct net_node_t *dst_node;
 
-		mem_debug("  %lld %lld 0x%x %s read request\n", esim_time, stack->id,
+		mem_debug("  %lld %lld 0x%llx %s read request\n", esim_time, stack->id,
 			stack->addr, mod->name);
 		mem_trace("mem.access name=\"A-%lld\" state=\"%s:read_request\"\n",
 			stack->id, mod->name);
@@ -1658,7 +1665,7 @@ void mod_handler_nmoesi_read_request(int event, void *data)
 
 	if (event == EV_MOD_NMOESI_READ_REQUEST_RECEIVE)
 	{
-		mem_debug("  %lld %lld 0x%x %s read request receive\n", esim_time, stack->id,
+		mem_debug("  %lld %lld 0x%llx %s read request receive\n", esim_time, stack->id,
 			stack->addr, target_mod->name);
 		mem_trace("mem.access name=\"A-%lld\" state=\"%s:read_request_receive\"\n",
 			stack->id, target_mod->name);
@@ -1681,7 +1688,7 @@ void mod_handler_nmoesi_read_request(int event, void *data)
 
 	if (event == EV_MOD_NMOESI_READ_REQUEST_ACTION)
 	{
-		mem_debug("  %lld %lld 0x%x %s read request action\n", esim_time, stack->id,
+		mem_debug("  %lld %lld 0x%llx %s read request action\n", esim_time, stack->id,
 			stack->tag, target_mod->name);
 		mem_trace("mem.access name=\"A-%lld\" state=\"%s:read_request_action\"\n",
 			stack->id, target_mod->name);
@@ -1706,7 +1713,7 @@ void mod_handler_nmoesi_read_request(int event, void *data)
 	{
 		struct mod_t *owner;
 
-		mem_debug("  %lld %lld 0x%x %s read request updown\n", esim_time, stack->id,
+		mem_debug("  %lld %lld 0x%llx %s read request updown\n", esim_time, stack->id,
 			stack->tag, target_mod->name);
 		mem_trace("mem.access name=\"A-%lld\" state=\"%s:read_request_updown\"\n",
 			stack->id, target_mod->name);
@@ -1807,7 +1814,7 @@ void mod_handler_nmoesi_read_request(int event, void *data)
 
 	if (event == EV_MOD_NMOESI_READ_REQUEST_UPDOWN_MISS)
 	{
-		mem_debug("  %lld %lld 0x%x %s read request updown miss\n", esim_time, stack->id,
+		mem_debug("  %lld %lld 0x%llx %s read request updown miss\n", esim_time, stack->id,
 			stack->tag, target_mod->name);
 		mem_trace("mem.access name=\"A-%lld\" state=\"%s:read_request_updown_miss\"\n",
 			stack->id, target_mod->name);
@@ -1846,7 +1853,7 @@ void mod_handler_nmoesi_read_request(int event, void *data)
 			return;
 
 		/* Trace */
-		mem_debug("  %lld %lld 0x%x %s read request updown finish\n", esim_time, stack->id,
+		mem_debug("  %lld %lld 0x%llx %s read request updown finish\n", esim_time, stack->id,
 			stack->tag, target_mod->name);
 		mem_trace("mem.access name=\"A-%lld\" state=\"%s:read_request_updown_finish\"\n",
 			stack->id, target_mod->name);
@@ -1930,7 +1937,7 @@ void mod_handler_nmoesi_read_request(int event, void *data)
 	{
 		struct mod_t *owner;
 
-		mem_debug("  %lld %lld 0x%x %s read request downup\n", esim_time, stack->id,
+		mem_debug("  %lld %lld 0x%llx %s read request downup\n", esim_time, stack->id,
 			stack->tag, target_mod->name);
 		mem_trace("mem.access name=\"A-%lld\" state=\"%s:read_request_downup\"\n",
 			stack->id, target_mod->name);
@@ -1986,7 +1993,7 @@ void mod_handler_nmoesi_read_request(int event, void *data)
 		if (stack->pending)
 			return;
 
-		mem_debug("  %lld %lld 0x%x %s read request downup wait for reqs\n", 
+		mem_debug("  %lld %lld 0x%llx %s read request downup wait for reqs\n", 
 			esim_time, stack->id, stack->tag, target_mod->name);
 		mem_trace("mem.access name=\"A-%lld\" state=\"%s:read_request_downup_wait_for_reqs\"\n",
 			stack->id, target_mod->name);
@@ -2011,7 +2018,7 @@ void mod_handler_nmoesi_read_request(int event, void *data)
 
 	if (event == EV_MOD_NMOESI_READ_REQUEST_DOWNUP_FINISH)
 	{
-		mem_debug("  %lld %lld 0x%x %s read request downup finish\n", 
+		mem_debug("  %lld %lld 0x%llx %s read request downup finish\n", 
 			esim_time, stack->id, stack->tag, target_mod->name);
 		mem_trace("mem.access name=\"A-%lld\" state=\"%s:read_request_downup_finish\"\n",
 			stack->id, target_mod->name);
@@ -2185,7 +2192,7 @@ void mod_handler_nmoesi_read_request(int event, void *data)
 		struct net_node_t *src_node;
 		struct net_node_t *dst_node;
 
-		mem_debug("  %lld %lld 0x%x %s read request reply\n", esim_time, stack->id,
+		mem_debug("  %lld %lld 0x%llx %s read request reply\n", esim_time, stack->id,
 			stack->tag, target_mod->name);
 		mem_trace("mem.access name=\"A-%lld\" state=\"%s:read_request_reply\"\n",
 			stack->id, target_mod->name);
@@ -2218,7 +2225,7 @@ void mod_handler_nmoesi_read_request(int event, void *data)
 
 	if (event == EV_MOD_NMOESI_READ_REQUEST_FINISH)
 	{
-		mem_debug("  %lld %lld 0x%x %s read request finish\n", esim_time, stack->id,
+		mem_debug("  %lld %lld 0x%llx %s read request finish\n", esim_time, stack->id,
 			stack->tag, mod->name);
 		mem_trace("mem.access name=\"A-%lld\" state=\"%s:read_request_finish\"\n",
 			stack->id, mod->name);
@@ -2250,7 +2257,8 @@ void mod_handler_nmoesi_write_request(int event, void *data)
 	struct dir_t *dir;
 	struct dir_entry_t *dir_entry;
 
-	uint32_t dir_entry_tag, z;
+	unsigned long long dir_entry_tag;
+	uint32_t z;
 
 
 	if (event == EV_MOD_NMOESI_WRITE_REQUEST)
@@ -2259,7 +2267,7 @@ void mod_handler_nmoesi_write_request(int event, void *data)
 		struct net_node_t *src_node;
 		struct net_node_t *dst_node;
 
-		mem_debug("  %lld %lld 0x%x %s write request\n", esim_time, stack->id,
+		mem_debug("  %lld %lld 0x%llx %s write request\n", esim_time, stack->id,
 			stack->addr, mod->name);
 		mem_trace("mem.access name=\"A-%lld\" state=\"%s:write_request\"\n",
 			stack->id, mod->name);
@@ -2303,7 +2311,7 @@ void mod_handler_nmoesi_write_request(int event, void *data)
 
 	if (event == EV_MOD_NMOESI_WRITE_REQUEST_RECEIVE)
 	{
-		mem_debug("  %lld %lld 0x%x %s write request receive\n", esim_time, stack->id,
+		mem_debug("  %lld %lld 0x%llx %s write request receive\n", esim_time, stack->id,
 			stack->addr, target_mod->name);
 		mem_trace("mem.access name=\"A-%lld\" state=\"%s:write_request_receive\"\n",
 			stack->id, target_mod->name);
@@ -2326,7 +2334,7 @@ void mod_handler_nmoesi_write_request(int event, void *data)
 
 	if (event == EV_MOD_NMOESI_WRITE_REQUEST_ACTION)
 	{
-		mem_debug("  %lld %lld 0x%x %s write request action\n", esim_time, stack->id,
+		mem_debug("  %lld %lld 0x%llx %s write request action\n", esim_time, stack->id,
 			stack->tag, target_mod->name);
 		mem_trace("mem.access name=\"A-%lld\" state=\"%s:write_request_action\"\n",
 			stack->id, target_mod->name);
@@ -2355,7 +2363,7 @@ void mod_handler_nmoesi_write_request(int event, void *data)
 
 	if (event == EV_MOD_NMOESI_WRITE_REQUEST_EXCLUSIVE)
 	{
-		mem_debug("  %lld %lld 0x%x %s write request exclusive\n", esim_time, stack->id,
+		mem_debug("  %lld %lld 0x%llx %s write request exclusive\n", esim_time, stack->id,
 			stack->tag, target_mod->name);
 		mem_trace("mem.access name=\"A-%lld\" state=\"%s:write_request_exclusive\"\n",
 			stack->id, target_mod->name);
@@ -2369,7 +2377,7 @@ void mod_handler_nmoesi_write_request(int event, void *data)
 
 	if (event == EV_MOD_NMOESI_WRITE_REQUEST_UPDOWN)
 	{
-		mem_debug("  %lld %lld 0x%x %s write request updown\n", esim_time, stack->id,
+		mem_debug("  %lld %lld 0x%llx %s write request updown\n", esim_time, stack->id,
 			stack->tag, target_mod->name);
 		mem_trace("mem.access name=\"A-%lld\" state=\"%s:write_request_updown\"\n",
 			stack->id, target_mod->name);
@@ -2416,7 +2424,7 @@ void mod_handler_nmoesi_write_request(int event, void *data)
 
 	if (event == EV_MOD_NMOESI_WRITE_REQUEST_UPDOWN_FINISH)
 	{
-		mem_debug("  %lld %lld 0x%x %s write request updown finish\n", esim_time, stack->id,
+		mem_debug("  %lld %lld 0x%llx %s write request updown finish\n", esim_time, stack->id,
 			stack->tag, target_mod->name);
 		mem_trace("mem.access name=\"A-%lld\" state=\"%s:write_request_updown_finish\"\n",
 			stack->id, target_mod->name);
@@ -2481,7 +2489,7 @@ void mod_handler_nmoesi_write_request(int event, void *data)
 
 	if (event == EV_MOD_NMOESI_WRITE_REQUEST_DOWNUP)
 	{
-		mem_debug("  %lld %lld 0x%x %s write request downup\n", esim_time, stack->id,
+		mem_debug("  %lld %lld 0x%llx %s write request downup\n", esim_time, stack->id,
 			stack->tag, target_mod->name);
 		mem_trace("mem.access name=\"A-%lld\" state=\"%s:write_request_downup\"\n",
 			stack->id, target_mod->name);
@@ -2546,7 +2554,7 @@ void mod_handler_nmoesi_write_request(int event, void *data)
 
 	if (event == EV_MOD_NMOESI_WRITE_REQUEST_DOWNUP_FINISH)
 	{
-		mem_debug("  %lld %lld 0x%x %s write request downup complete\n", esim_time, stack->id,
+		mem_debug("  %lld %lld 0x%llx %s write request downup complete\n", esim_time, stack->id,
 			stack->tag, target_mod->name);
 		mem_trace("mem.access name=\"A-%lld\" state=\"%s:write_request_downup_finish\"\n",
 			stack->id, target_mod->name);
@@ -2566,7 +2574,7 @@ void mod_handler_nmoesi_write_request(int event, void *data)
 		struct net_node_t *src_node;
 		struct net_node_t *dst_node;
 
-		mem_debug("  %lld %lld 0x%x %s write request reply\n", esim_time, stack->id,
+		mem_debug("  %lld %lld 0x%llx %s write request reply\n", esim_time, stack->id,
 			stack->tag, target_mod->name);
 		mem_trace("mem.access name=\"A-%lld\" state=\"%s:write_request_reply\"\n",
 			stack->id, target_mod->name);
@@ -2597,7 +2605,7 @@ void mod_handler_nmoesi_write_request(int event, void *data)
 
 	if (event == EV_MOD_NMOESI_WRITE_REQUEST_FINISH)
 	{
-		mem_debug("  %lld %lld 0x%x %s write request finish\n", esim_time, stack->id,
+		mem_debug("  %lld %lld 0x%llx %s write request finish\n", esim_time, stack->id,
 			stack->tag, mod->name);
 		mem_trace("mem.access name=\"A-%lld\" state=\"%s:write_request_finish\"\n",
 			stack->id, mod->name);
@@ -2630,7 +2638,7 @@ void mod_handler_nmoesi_peer(int event, void *data)
 
 	if (event == EV_MOD_NMOESI_PEER_SEND) 
 	{
-		mem_debug("  %lld %lld 0x%x %s %s peer send\n", esim_time, stack->id,
+		mem_debug("  %lld %lld 0x%llx %s %s peer send\n", esim_time, stack->id,
 			stack->tag, src->name, peer->name);
 		mem_trace("mem.access name=\"A-%lld\" state=\"%s:peer\"\n",
 			stack->id, src->name);
@@ -2644,7 +2652,7 @@ void mod_handler_nmoesi_peer(int event, void *data)
 
 	if (event == EV_MOD_NMOESI_PEER_RECEIVE) 
 	{
-		mem_debug("  %lld %lld 0x%x %s %s peer receive\n", esim_time, stack->id,
+		mem_debug("  %lld %lld 0x%llx %s %s peer receive\n", esim_time, stack->id,
 			stack->tag, src->name, peer->name);
 		mem_trace("mem.access name=\"A-%lld\" state=\"%s:peer_receive\"\n",
 			stack->id, peer->name);
@@ -2659,7 +2667,7 @@ void mod_handler_nmoesi_peer(int event, void *data)
 
 	if (event == EV_MOD_NMOESI_PEER_REPLY) 
 	{
-		mem_debug("  %lld %lld 0x%x %s %s peer reply ack\n", esim_time, stack->id,
+		mem_debug("  %lld %lld 0x%llx %s %s peer reply ack\n", esim_time, stack->id,
 			stack->tag, src->name, peer->name);
 		mem_trace("mem.access name=\"A-%lld\" state=\"%s:peer_reply_ack\"\n",
 			stack->id, peer->name);
@@ -2673,7 +2681,7 @@ void mod_handler_nmoesi_peer(int event, void *data)
 
 	if (event == EV_MOD_NMOESI_PEER_FINISH) 
 	{
-		mem_debug("  %lld %lld 0x%x %s %s peer finish\n", esim_time, stack->id,
+		mem_debug("  %lld %lld 0x%llx %s %s peer finish\n", esim_time, stack->id,
 			stack->tag, src->name, peer->name);
 		mem_trace("mem.access name=\"A-%lld\" state=\"%s:peer_finish\"\n",
 			stack->id, src->name);
@@ -2699,7 +2707,7 @@ void mod_handler_nmoesi_invalidate(int event, void *data)
 	struct dir_t *dir;
 	struct dir_entry_t *dir_entry;
 
-	uint32_t dir_entry_tag;
+	unsigned long long dir_entry_tag;
 	uint32_t z;
 
 	if (event == EV_MOD_NMOESI_INVALIDATE)
@@ -2709,7 +2717,7 @@ void mod_handler_nmoesi_invalidate(int event, void *data)
 
 		/* Get block info */
 		cache_get_block(mod->cache, stack->set, stack->way, &stack->tag, &stack->state);
-		mem_debug("  %lld %lld 0x%x %s invalidate (set=%d, way=%d, state=%s)\n", esim_time, stack->id,
+		mem_debug("  %lld %lld 0x%llx %s invalidate (set=%d, way=%d, state=%s)\n", esim_time, stack->id,
 			stack->tag, mod->name, stack->set, stack->way,
 			str_map_value(&cache_block_state_map, stack->state));
 		mem_trace("mem.access name=\"A-%lld\" state=\"%s:invalidate\"\n",
@@ -2761,7 +2769,7 @@ void mod_handler_nmoesi_invalidate(int event, void *data)
 
 	if (event == EV_MOD_NMOESI_INVALIDATE_FINISH)
 	{
-		mem_debug("  %lld %lld 0x%x %s invalidate finish\n", esim_time, stack->id,
+		mem_debug("  %lld %lld 0x%llx %s invalidate finish\n", esim_time, stack->id,
 			stack->tag, mod->name);
 		mem_trace("mem.access name=\"A-%lld\" state=\"%s:invalidate_finish\"\n",
 			stack->id, mod->name);
@@ -2801,7 +2809,7 @@ void mod_handler_nmoesi_message(int event, void *data)
 		struct net_node_t *src_node;
 		struct net_node_t *dst_node;
 
-		mem_debug("  %lld %lld 0x%x %s message\n", esim_time, stack->id,
+		mem_debug("  %lld %lld 0x%llx %s message\n", esim_time, stack->id,
 			stack->addr, mod->name);
 
 		stack->reply_size = 8;
@@ -2826,7 +2834,7 @@ void mod_handler_nmoesi_message(int event, void *data)
 
 	if (event == EV_MOD_NMOESI_MESSAGE_RECEIVE)
 	{
-		mem_debug("  %lld %lld 0x%x %s message receive\n", esim_time, stack->id,
+		mem_debug("  %lld %lld 0x%llx %s message receive\n", esim_time, stack->id,
 			stack->addr, target_mod->name);
 
 		/* Receive message */
@@ -2844,7 +2852,7 @@ void mod_handler_nmoesi_message(int event, void *data)
 
 	if (event == EV_MOD_NMOESI_MESSAGE_ACTION)
 	{
-		mem_debug("  %lld %lld 0x%x %s clear owner action\n", esim_time, stack->id,
+		mem_debug("  %lld %lld 0x%llx %s clear owner action\n", esim_time, stack->id,
 			stack->tag, target_mod->name);
 
 		assert(stack->message);
@@ -2895,7 +2903,7 @@ void mod_handler_nmoesi_message(int event, void *data)
 		struct net_node_t *src_node;
 		struct net_node_t *dst_node;
 
-		mem_debug("  %lld %lld 0x%x %s message reply\n", esim_time, stack->id,
+		mem_debug("  %lld %lld 0x%llx %s message reply\n", esim_time, stack->id,
 			stack->tag, target_mod->name);
 
 		/* Checks */
@@ -2915,7 +2923,7 @@ void mod_handler_nmoesi_message(int event, void *data)
 
 	if (event == EV_MOD_NMOESI_MESSAGE_FINISH)
 	{
-		mem_debug("  %lld %lld 0x%x %s message finish\n", esim_time, stack->id,
+		mem_debug("  %lld %lld 0x%llx %s message finish\n", esim_time, stack->id,
 			stack->tag, mod->name);
 
 		/* Receive message */
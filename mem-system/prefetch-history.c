@@ -29,9 +29,10 @@
 int prefetch_history_size;
 
 int prefetch_history_is_redundant(struct prefetch_history_t *ph, struct mod_t *mod, 
-				  unsigned int phy_addr)
+				  unsigned long long phy_addr)
 {
-	int i, tag1, tag2, set1, set2;
+	unsigned long long tag1, tag2;
+	int i, set1, set2;
 
 	if(mod->kind != mod_kind_cache)
 	{
@@ -57,7 +58,7 @@ int prefetch_history_is_redundant(struct prefetch_history_t *ph, struct mod_t *m
 	return 0;
 }
 
-void prefetch_history_record(struct prefetch_history_t *ph, unsigned int phy_addr)
+void prefetch_history_record(struct prefetch_history_t *ph, unsigned long long phy_addr)
 {
 	/* A 0 sized table means do not track history. */
 	if (ph->size == 0)
@@ -78,7 +79,7 @@ struct prefetch_history_t *prefetch_history_create(void)
 	assert(prefetch_history_size >= 0);
 	ph->size = prefetch_history_size;
 	if (prefetch_history_size > 0)
-		ph->table = xcalloc(prefetch_history_size, sizeof(unsigned));
+		ph->table = xcalloc(prefetch_history_size, sizeof(unsigned long long));
 
 	/* Return */
 	return ph;
@@ -39,14 +39,14 @@ extern int prefetch_history_size;
 
 struct prefetch_history_t
 {
-	unsigned int *table;
+	unsigned long long *table;
 	int size;
 	int hindex;
 };
 
 int prefetch_history_is_redundant(struct prefetch_history_t *ph, struct mod_t *mod, 
-				  unsigned int phy_addr);
-void prefetch_history_record(struct prefetch_history_t *ph, unsigned int phy_addr);
+				  unsigned long long phy_addr);
+void prefetch_history_record(struct prefetch_history_t *ph, unsigned long long phy_addr);
 struct prefetch_history_t *prefetch_history_create();
 void prefetch_history_free(struct prefetch_history_t *pf);
 
@@ -19,8 +19,11 @@
 
 #include <assert.h>
 
+#include <lib/esim/esim.h>
 #include <lib/mhandle/mhandle.h>
+#include <lib/util/bit-map.h>
 #include <lib/util/debug.h>
+#include <lib/util/misc.h>
 #include <lib/util/string.h>
 
 #include "mem-system.h"
@@ -37,8 +40,21 @@ struct str_map_t prefetcher_type_map =
 	}
 };
 
+/* Prefetch distance and degree for each throttling level */
+static int prefetcher_throttle_distance[PREFETCHER_THROTTLE_LEVELS] = { 1, 2, 4, 8, 16 };
+static int prefetcher_throttle_degree[PREFETCHER_THROTTLE_LEVELS] = { 1, 1, 2, 2, 4 };
+
+static void prefetcher_set_throttle_level(struct prefetcher_t *pref, int level)
+{
+	assert(level >= 0 && level < PREFETCHER_THROTTLE_LEVELS);
+	pref->throttle_level = level;
+	pref->distance = prefetcher_throttle_distance[level];
+	pref->degree = prefetcher_throttle_degree[level];
+}
+
 struct prefetcher_t *prefetcher_create(int prefetcher_ghb_size, int prefetcher_it_size,
-				       int prefetcher_lookup_depth, enum prefetcher_type_t type)
+				       int prefetcher_lookup_depth, enum prefetcher_type_t type,
+				       int prefetcher_throttle_interval)
 {
 	struct prefetcher_t *pref;
 
@@ -54,6 +70,22 @@ struct prefetcher_t *prefetcher_create(int prefetcher_ghb_size, int prefetcher_i
 	pref->ghb = xcalloc(prefetcher_ghb_size, sizeof(struct prefetcher_ghb_t));
 	pref->index_table = xcalloc(prefetcher_it_size, sizeof(struct prefetcher_it_t));
 	pref->ghb_head = -1;
+	pref->pollution_filter = bit_map_create(PREFETCHER_POLLUTION_FILTER_SIZE);
+
+	/* Aggressiveness. Without throttling, only the next address in the
+	 * detected pattern is prefetched. */
+	assert(prefetcher_throttle_interval >= 0);
+	pref->throttle_interval = prefetcher_throttle_interval;
+	pref->throttle_interval_end = prefetcher_throttle_interval;
+	if (prefetcher_throttle_interval)
+	{
+		prefetcher_set_throttle_level(pref, PREFETCHER_THROTTLE_LEVEL_INIT);
+	}
+	else
+	{
+		pref->distance = 1;
+		pref->degree = 1;
+	}
 
 	/* Return */
 	return pref;
@@ -61,11 +93,110 @@ struct prefetcher_t *prefetcher_create(int prefetcher_ghb_size, int prefetcher_i
 
 void prefetcher_free(struct prefetcher_t *pref)
 {
+	bit_map_free(pref->pollution_filter);
 	free(pref->ghb);
 	free(pref->index_table);
 	free(pref);
 }
 
+void prefetcher_dump_report(struct prefetcher_t *pref, FILE *f)
+{
+	int level;
+
+	fprintf(f, "PrefetchesIssued = %lld\n", pref->issued);
+	fprintf(f, "UsefulPrefetches = %lld\n", pref->useful);
+	fprintf(f, "LatePrefetches = %lld\n", pref->late);
+	fprintf(f, "PrefetchPollution = %lld\n", pref->pollution);
+	fprintf(f, "PrefetchAccuracy = %.4g\n", pref->issued ?
+		(double) pref->useful / pref->issued : 0.0);
+	if (!pref->throttle_interval)
+		return;
+
+	fprintf(f, "PrefetchThrottleLevel = %d\n", pref->throttle_level);
+	fprintf(f, "PrefetchThrottleIntervals =");
+	for (level = 0; level < PREFETCHER_THROTTLE_LEVELS; level++)
+		fprintf(f, " %lld", pref->throttle_level_intervals[level]);
+	fprintf(f, "\n");
+}
+
+static unsigned int prefetcher_pollution_filter_index(struct mod_t *mod,
+	unsigned long long addr)
+{
+	return (addr >> mod->log_block_size) % PREFETCHER_POLLUTION_FILTER_SIZE;
+}
+
+/* Called at every prefetcher activation. If the current throttling interval
+ * is over, the feedback counters are evaluated to choose a new aggressiveness
+ * level for the next interval. */
+static void prefetcher_throttle_update(struct mod_t *mod)
+{
+	struct prefetcher_t *pref = mod->cache->prefetcher;
+	long long cycle;
+	int level;
+
+	double accuracy;
+	double lateness;
+	double pollution;
+
+	/* Throttling disabled, or interval not over yet */
+	if (!pref->throttle_interval)
+		return;
+	cycle = esim_domain_cycle(mem_domain_index);
+	if (cycle < pref->throttle_interval_end)
+		return;
+
+	/* Feedback metrics */
+	accuracy = pref->interval_issued ? (double) pref->interval_useful /
+		pref->interval_issued : 0.0;
+	lateness = pref->interval_useful ? (double) pref->interval_late /
+		pref->interval_useful : 0.0;
+	pollution = pref->interval_misses ? (double) pref->interval_pollution /
+		pref->interval_misses : 0.0;
+
+	/* Accurate prefetches arriving late should be issued further ahead.
+	 * Inaccurate prefetches that pollute the cache or do not make it on
+	 * time are only wasting bandwidth. */
+	level = pref->throttle_level;
+	if (accuracy >= PREFETCHER_THROTTLE_ACCURACY_HIGH)
+	{
+		if (lateness > PREFETCHER_THROTTLE_LATENESS)
+			level++;
+	}
+	else if (accuracy >= PREFETCHER_THROTTLE_ACCURACY_LOW)
+	{
+		if (pollution > PREFETCHER_THROTTLE_POLLUTION)
+			level--;
+		else if (lateness > PREFETCHER_THROTTLE_LATENESS)
+			level++;
+	}
+	else if (pref->interval_issued)
+	{
+		if (pollution > PREFETCHER_THROTTLE_POLLUTION ||
+				lateness > PREFETCHER_THROTTLE_LATENESS)
+			level--;
+	}
+	level = MAX(0, MIN(PREFETCHER_THROTTLE_LEVELS - 1, level));
+
+	/* Debug */
+	mem_debug("  %lld %s prefetcher throttle: accuracy=%.3f, lateness=%.3f, "
+		"pollution=%.3f, level %d -> %d (distance=%d, degree=%d)\n",
+		cycle, mod->name, accuracy, lateness, pollution,
+		pref->throttle_level, level, prefetcher_throttle_distance[level],
+		prefetcher_throttle_degree[level]);
+
+	/* Record interval and set new level */
+	pref->throttle_level_intervals[pref->throttle_level]++;
+	prefetcher_set_throttle_level(pref, level);
+
+	/* Halve counters for next interval */
+	pref->interval_issued /= 2;
+	pref->interval_useful /= 2;
+	pref->interval_late /= 2;
+	pref->interval_misses /= 2;
+	pref->interval_pollution /= 2;
+	pref->throttle_interval_end = cycle + pref->throttle_interval;
+}
+
 static void get_it_index_tag(struct prefetcher_t *pref, struct mod_stack_t *stack, 
 			     int *it_index, unsigned *tag)
 {
@@ -86,7 +217,7 @@ static int prefetcher_update_tables(struct mod_stack_t *stack, struct mod_t *tar
 {
 	struct prefetcher_t *pref = target_mod->cache->prefetcher;
 	int ghb_index;
-	unsigned int addr = stack->addr;
+	unsigned long long addr = stack->addr;
 	int it_index, prev;
 	unsigned it_tag;
 
@@ -188,18 +319,21 @@ static int prefetcher_update_tables(struct mod_stack_t *stack, struct mod_t *tar
 }
 
 static void prefetcher_do_prefetch(struct mod_t *mod, struct mod_stack_t *stack,
-				   unsigned int prefetch_addr)
+				   unsigned long long prefetch_addr)
 {
-	int set1, tag1, set2, tag2;
+	unsigned long long tag1, tag2;
+	int set1, set2;
 
-	assert(prefetch_addr > 0);
+	/* Address wrapped around */
+	if (!prefetch_addr)
+		return;
 
 	/* Predicted prefetch_addr can go horribly wrong
 	 * sometimes. Since prefetches aren't supposed to
 	 * cause any kind of faults/exceptions, return. */
 	if (!mod_serves_address(mod, prefetch_addr))
 	{
-		mem_debug("  miss_addr 0x%x, prefetch_addr 0x%x, %s : illegal prefetch\n", stack->addr,
+		mem_debug("  miss_addr 0x%llx, prefetch_addr 0x%llx, %s : illegal prefetch\n", stack->addr,
 			  prefetch_addr, mod->name);
 		return;
 	}
@@ -214,15 +348,39 @@ static void prefetcher_do_prefetch(struct mod_t *mod, struct mod_stack_t *stack,
 	if (set1 == set2 && tag1 == tag2)
 		return;
 
+	/* Prefetches are dropped rather than waiting for a free MSHR entry,
+	 * so that they never delay demand accesses. */
+	if (!mod_can_allocate_mshr(mod, prefetch_addr))
+	{
+		mem_debug("  miss_addr 0x%llx, prefetch_addr 0x%llx, %s : MSHR full\n",
+			stack->addr, prefetch_addr, mod->name);
+		return;
+	}
+
 	/* I'm not passing back the mod_client_info structure. If this needs to be 
 	 * passed in the future, make sure a copy is made (since the one that is
 	 * pointed to by stack->client_info may be freed early. */
-	mem_debug("  miss_addr 0x%x, prefetch_addr 0x%x, %s : prefetcher\n", stack->addr,
+	mem_debug("  miss_addr 0x%llx, prefetch_addr 0x%llx, %s : prefetcher\n", stack->addr,
 		  prefetch_addr, mod->name);
 
+	mod->cache->prefetcher->issued++;
+	mod->cache->prefetcher->interval_issued++;
 	mod_access(mod, mod_access_prefetch, prefetch_addr, NULL, NULL, NULL, NULL);
 }
 
+/* Issue 'degree' prefetches following a detected 'stride', starting
+ * 'distance' strides ahead of the address accessed by 'stack'. */
+static void prefetcher_issue(struct mod_t *mod, struct mod_stack_t *stack,
+				long long stride)
+{
+	struct prefetcher_t *pref = mod->cache->prefetcher;
+	int i;
+
+	for (i = 0; i < pref->degree; i++)
+		prefetcher_do_prefetch(mod, stack, stack->addr +
+			stride * (pref->distance + i));
+}
+
 /* This function implements the GHB based PC/CS prefetching as described in the
  * 2005 paper by Nesbit and Smith. The index table lookup is based on the PC
  * of the instruction causing the miss. The GHB entries are looked at for finding
@@ -230,8 +388,9 @@ static void prefetcher_do_prefetch(struct mod_t *mod, struct mod_stack_t *stack,
 static void prefetcher_ghb_pc_cs(struct mod_t *mod, struct mod_stack_t *stack, int it_index)
 {
 	struct prefetcher_t *pref;
-	int chain, stride, i;
-	unsigned int prev_addr, cur_addr, prefetch_addr = 0;
+	unsigned long long prev_addr, cur_addr;
+	long long stride;
+	int chain, i;
 
 	assert(mod->kind == mod_kind_cache && mod->cache != NULL);
 	pref = mod->cache->prefetcher;
@@ -275,11 +434,11 @@ static void prefetcher_ghb_pc_cs(struct mod_t *mod, struct mod_stack_t *stack, i
 		/* If this is the last iteration (we've seen as much history as
 		 * the lookup depth specified), then do a prefetch. */
 		if (i == pref->lookup_depth)
-			prefetch_addr = stack->addr + stride;
+		{
+			prefetcher_issue(mod, stack, stride);
+			break;
+		}
 	}
-
-	if (prefetch_addr > 0)
-		prefetcher_do_prefetch(mod, stack, prefetch_addr);
 }
 
 /* This function implements the GHB based PC/DC prefetching as described in the
@@ -291,8 +450,9 @@ static void prefetcher_ghb_pc_cs(struct mod_t *mod, struct mod_stack_t *stack, i
 static void prefetcher_ghb_pc_dc(struct mod_t *mod, struct mod_stack_t *stack, int it_index)
 {
 	struct prefetcher_t *pref;
-	int chain, chain2, stride[PREFETCHER_LOOKUP_DEPTH_MAX], i, pref_stride;
-	unsigned int prev_addr, cur_addr, prefetch_addr = 0;
+	unsigned long long prev_addr, cur_addr;
+	long long stride[PREFETCHER_LOOKUP_DEPTH_MAX], pref_stride;
+	int chain, chain2, i;
 
 	assert(mod->kind == mod_kind_cache && mod->cache != NULL);
 	pref = mod->cache->prefetcher;
@@ -357,28 +517,23 @@ static void prefetcher_ghb_pc_dc(struct mod_t *mod, struct mod_stack_t *stack, i
 		    chain = pref->ghb[chain].prev;
 		    prev_addr = pref->ghb[chain].addr;
 		    pref_stride = prev_addr - cur_addr;
-		    prefetch_addr = stack->addr + pref_stride;
+		    prefetcher_issue(mod, stack, pref_stride);
 		    break;
 		}
 
 		chain = pref->ghb[chain].next;
 	}
-
-	if (prefetch_addr > 0)
-		prefetcher_do_prefetch(mod, stack, prefetch_addr);
 }
 
-void prefetcher_access_miss(struct mod_stack_t *stack, struct mod_t *target_mod)
+/* Record an access that would have been a miss without the prefetcher in
+ * the history tables, and prefetch based on the updated history. */
+static void prefetcher_predict(struct mod_stack_t *stack, struct mod_t *target_mod)
 {
 	int it_index;
 
-	if (target_mod->kind != mod_kind_cache || !target_mod->cache->prefetcher)
-		return;
-
 	it_index = prefetcher_update_tables(stack, target_mod);
-
 	if (it_index < 0)
-		    return;
+		return;
 
 	if (target_mod->cache->prefetcher->type == prefetcher_type_ghb_pc_cs)
 	{
@@ -395,40 +550,98 @@ void prefetcher_access_miss(struct mod_stack_t *stack, struct mod_t *target_mod)
 	}
 }
 
+void prefetcher_access_miss(struct mod_stack_t *stack, struct mod_t *target_mod)
+{
+	struct prefetcher_t *pref;
+	unsigned int index;
+
+	if (target_mod->kind != mod_kind_cache || !target_mod->cache->prefetcher)
+		return;
+
+	pref = target_mod->cache->prefetcher;
+	prefetcher_throttle_update(target_mod);
+
+	/* A demand miss on a block evicted by a prefetch is cache pollution */
+	index = prefetcher_pollution_filter_index(target_mod, stack->addr);
+	pref->interval_misses++;
+	if (bit_map_get(pref->pollution_filter, index, 1))
+	{
+		pref->pollution++;
+		pref->interval_pollution++;
+		bit_map_set(pref->pollution_filter, index, 1, 0);
+	}
+
+	prefetcher_predict(stack, target_mod);
+}
+
 void prefetcher_access_hit(struct mod_stack_t *stack, struct mod_t *target_mod)
 {
-	int it_index;
+	struct prefetcher_t *pref;
 
 	if (target_mod->kind != mod_kind_cache || !target_mod->cache->prefetcher)
 		return;
 
+	pref = target_mod->cache->prefetcher;
+	prefetcher_throttle_update(target_mod);
+
 	if (mod_block_get_prefetched(target_mod, stack->addr))
 	{
-		/* This block was prefetched. Now it has a real access. For the purposes
-		 * of the prefetcher heuristic, this is still a miss. Hence, update
-		 * the prefetcher tables. */
-		it_index = prefetcher_update_tables(stack, target_mod);
+		/* First demand access to a prefetched block */
+		pref->useful++;
+		pref->interval_useful++;
 
 		/* Clear the prefetched flag since we have a real access now */
-		mem_debug ("  addr 0x%x %s : clearing \"prefetched\" flag\n", 
+		mem_debug ("  addr 0x%llx %s : clearing \"prefetched\" flag\n", 
 			   stack->addr, target_mod->name);
 		mod_block_set_prefetched(target_mod, stack->addr, 0);
 
-		if (it_index < 0)
-			return;
+		/* This block was prefetched. Now it has a real access. For the purposes
+		 * of the prefetcher heuristic, this is still a miss. Hence, update
+		 * the prefetcher tables. */
+		prefetcher_predict(stack, target_mod);
+	}
+}
 
-		if (target_mod->cache->prefetcher->type == prefetcher_type_ghb_pc_cs)
-		{
-			/* Perform ghb based PC/CS prefetching
-			 * (Program Counter based index, Constant Stride) */
-			prefetcher_ghb_pc_cs(target_mod, stack, it_index);
-		}
-		else
-		{
-			assert(target_mod->cache->prefetcher->type == prefetcher_type_ghb_pc_dc);
-			/* Perform ghb based PC/DC prefetching
-			 * (Program Counter based index, Delta Correlation) */
-			prefetcher_ghb_pc_dc(target_mod, stack, it_index);
-		}
+/* A demand access in 'stack' was coalesced with the in-flight prefetch in
+ * 'master_stack'. The prefetch is useful, but it was issued too late. */
+void prefetcher_access_late(struct mod_stack_t *stack, struct mod_t *target_mod,
+	struct mod_stack_t *master_stack)
+{
+	struct prefetcher_t *pref;
+
+	if (target_mod->kind != mod_kind_cache || !target_mod->cache->prefetcher)
+		return;
+
+	pref = target_mod->cache->prefetcher;
+	prefetcher_throttle_update(target_mod);
+
+	/* The demand access consumes the prefetch, so the block must not be
+	 * marked as prefetched when it arrives. A prefetch is counted once,
+	 * even if several accesses wait for it. */
+	if (!master_stack->late_prefetch)
+	{
+		pref->useful++;
+		pref->late++;
+		pref->interval_useful++;
+		pref->interval_late++;
+		master_stack->late_prefetch = 1;
 	}
+
+	/* The access is still a miss as far as the prefetcher heuristic is
+	 * concerned. */
+	prefetcher_predict(stack, target_mod);
+}
+
+/* Block at 'block_addr' was evicted to make room for a prefetched block */
+void prefetcher_evict(struct mod_t *mod, unsigned long long block_addr)
+{
+	struct prefetcher_t *pref;
+	unsigned int index;
+
+	if (mod->kind != mod_kind_cache || !mod->cache->prefetcher)
+		return;
+
+	pref = mod->cache->prefetcher;
+	index = prefetcher_pollution_filter_index(mod, block_addr);
+	bit_map_set(pref->pollution_filter, index, 1, 1);
 }
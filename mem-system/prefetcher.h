@@ -20,6 +20,8 @@
 #ifndef MEM_SYSTEM_PREFETCHER_H
 #define MEM_SYSTEM_PREFETCHER_H
 
+#include <stdio.h>
+
 
 /* 
  * This file implements a global history buffer
@@ -39,11 +41,29 @@ enum prefetcher_type_t
 /* Doesn't really make sense to have a big lookup depth */
 #define PREFETCHER_LOOKUP_DEPTH_MAX 4
 
+/* Feedback-directed throttling. The prefetcher aggressiveness is one of
+ * the levels below, going from very conservative (level 0) to very
+ * aggressive. At the end of every interval, the level is updated based on
+ * the accuracy, lateness, and cache pollution caused by the prefetches
+ * issued during the interval (Srinath et al., HPCA 2007). */
+#define PREFETCHER_THROTTLE_LEVELS  5
+#define PREFETCHER_THROTTLE_LEVEL_INIT  2
+
+/* Thresholds for accuracy (useful / issued), lateness (late / useful), and
+ * pollution (demand misses caused by prefetches / demand misses). */
+#define PREFETCHER_THROTTLE_ACCURACY_HIGH  0.75
+#define PREFETCHER_THROTTLE_ACCURACY_LOW  0.40
+#define PREFETCHER_THROTTLE_LATENESS  0.01
+#define PREFETCHER_THROTTLE_POLLUTION  0.005
+
+/* Number of bits in the filter recording blocks evicted by prefetches */
+#define PREFETCHER_POLLUTION_FILTER_SIZE  4096
+
 /* Global history buffer. */
 struct prefetcher_ghb_t
 {
 	/* The global address miss this entry corresponds to */
-	unsigned int addr;
+	unsigned long long addr;
 	/* Next element in the linked list : -1 implies none */
 	int next;
 	/* Previous element in the linked list : -1 implies none */
@@ -78,16 +98,51 @@ struct prefetcher_t
 	struct prefetcher_it_t *index_table;
 
 	int ghb_head;
+
+	/* Aggressiveness. Every time a pattern is detected, 'degree' prefetches
+	 * are issued, starting 'distance' strides away from the missed address. */
+	int distance;
+	int degree;
+
+	/* Throttling interval in cycles. A value of 0 disables throttling. */
+	int throttle_interval;
+	int throttle_level;
+	long long throttle_interval_end;
+
+	/* Feedback counters for the current interval. Values are halved at the
+	 * end of each interval, so that past intervals keep some weight. */
+	long long interval_issued;
+	long long interval_useful;
+	long long interval_late;
+	long long interval_misses;
+	long long interval_pollution;
+
+	/* Hashed set of blocks evicted by prefetches. A demand miss on one of
+	 * these blocks is accounted as cache pollution. */
+	struct bit_map_t *pollution_filter;
+
+	/* Statistics */
+	long long issued;
+	long long useful;
+	long long late;
+	long long pollution;
+	long long throttle_level_intervals[PREFETCHER_THROTTLE_LEVELS];
 };
 
 struct mod_stack_t;
 struct mod_t;
 
 struct prefetcher_t *prefetcher_create(int prefetcher_ghb_size, int prefetcher_it_size,
-				       int prefetcher_lookup_depth, enum prefetcher_type_t type);
+				       int prefetcher_lookup_depth, enum prefetcher_type_t type,
+				       int prefetcher_throttle_interval);
 void prefetcher_free(struct prefetcher_t *pref);
 
 void prefetcher_access_miss(struct mod_stack_t *stack, struct mod_t *mod);
 void prefetcher_access_hit(struct mod_stack_t *stack, struct mod_t *mod);
+void prefetcher_access_late(struct mod_stack_t *stack, struct mod_t *mod,
+	struct mod_stack_t *master_stack);
+void prefetcher_evict(struct mod_t *mod, unsigned long long block_addr);
+
+void prefetcher_dump_report(struct prefetcher_t *pref, FILE *f);
 
 #endif
@@ -24,6 +24,7 @@
 #include <lib/util/debug.h>
 #include <lib/util/linked-list.h>
 #include <lib/util/list.h>
+#include <lib/util/misc.h>
 
 #include "buffer.h"
 #include "net-system.h"
@@ -112,9 +113,18 @@ void net_buffer_insert(struct net_buffer_t *buffer, struct net_msg_t *msg)
 	struct net_t *net = buffer->net;
 	struct net_node_t *node = buffer->node;
 
-	if (buffer->count + msg->size > buffer->size)
+	int free_bytes;
+
+	/* Reserve space. With wormhole switching, the message takes as many
+	 * whole flits as available if it does not fit completely. */
+	if (!net_buffer_can_insert(buffer, msg->size))
 		panic("%s: not enough space in buffer", __FUNCTION__);
-	buffer->count += msg->size;
+	free_bytes = buffer->size - buffer->count;
+	msg->reserved = msg->size;
+	if (net->switching == net_switching_wormhole && msg->size > free_bytes)
+		msg->reserved = free_bytes / net->flit_size * net->flit_size;
+	assert(msg->reserved > 0);
+	buffer->count += msg->reserved;
 	list_enqueue(buffer->msg_list, msg);
 
 	/* Update occupancy stat */
@@ -139,8 +149,15 @@ void net_buffer_extract(struct net_buffer_t *buffer, struct net_msg_t *msg)
 	struct net_t *net = buffer->net;
 	struct net_node_t *node = buffer->node;
 
-	assert(buffer->count >= msg->size);
-	buffer->count -= msg->size;
+	/* With store-and-forward switching, the space is released as soon as
+	 * the message leaves. Otherwise, the caller releases it once the tail
+	 * flit has left, with 'net_buffer_return_credits'. */
+	if (net->switching == net_switching_store_and_forward)
+	{
+		assert(buffer->count >= msg->reserved);
+		buffer->count -= msg->reserved;
+		msg->reserved = 0;
+	}
 
 	/* Extract message from list */
 	if (!list_count(buffer->msg_list))
@@ -168,6 +185,81 @@ void net_buffer_extract(struct net_buffer_t *buffer, struct net_msg_t *msg)
 }
 
 
+/* Return true if a message of 'size' bytes fits in an empty buffer. With
+ * wormhole switching, one flit is enough. */
+int net_buffer_can_hold(struct net_buffer_t *buffer, int size)
+{
+	struct net_t *net = buffer->net;
+
+	if (net->switching == net_switching_wormhole)
+		size = MIN(size, net->flit_size);
+	return size <= buffer->size;
+}
+
+
+/* Return true if a message of 'size' bytes can be inserted in the buffer
+ * given its current occupancy. */
+int net_buffer_can_insert(struct net_buffer_t *buffer, int size)
+{
+	struct net_t *net = buffer->net;
+
+	if (net->switching == net_switching_wormhole)
+		size = MIN(size, net->flit_size);
+	return buffer->count + size <= buffer->size;
+}
+
+
+/* Release 'bytes' bytes of buffer space in 'delay' cycles, waking up events
+ * waiting for space. Used with flit-level switching, where the space of a
+ * message is released when its tail flit leaves the buffer. */
+void net_buffer_return_credits(struct net_buffer_t *buffer, int bytes,
+	int delay)
+{
+	struct net_buffer_credit_t *credit;
+
+	/* Nothing to release */
+	assert(bytes >= 0 && delay >= 0);
+	if (!bytes)
+		return;
+
+	/* Schedule event */
+	credit = xcalloc(1, sizeof(struct net_buffer_credit_t));
+	credit->buffer = buffer;
+	credit->bytes = bytes;
+	if (delay)
+		esim_schedule_event(EV_NET_CREDIT, credit, delay);
+	else
+		net_buffer_credit_handler(EV_NET_CREDIT, credit);
+}
+
+
+void net_buffer_credit_handler(int event, void *data)
+{
+	struct net_buffer_credit_t *credit = data;
+	struct net_buffer_t *buffer = credit->buffer;
+
+	/* Release space */
+	assert(event == EV_NET_CREDIT);
+	assert(buffer->count >= credit->bytes);
+	buffer->count -= credit->bytes;
+	net_buffer_update_occupancy(buffer);
+	free(credit);
+
+	/* Debug */
+	net_debug("buf "
+		"a=\"credit\" "
+		"net=\"%s\" "
+		"node=\"%s\" "
+		"buf=\"%s\"\n",
+		buffer->net->name,
+		buffer->node->name,
+		buffer->name);
+
+	/* Schedule events waiting for space in buffer */
+	net_buffer_wakeup(buffer);
+}
+
+
 /* Schedule an event to be called when the buffer releases some space. */
 void net_buffer_wait(struct net_buffer_t *buffer, int event, void *stack)
 {
@@ -33,6 +33,13 @@ struct net_buffer_wakeup_t
 
 };
 
+/* Space released in a buffer after some delay */
+struct net_buffer_credit_t
+{
+	struct net_buffer_t *buffer;
+	int bytes;
+};
+
 enum net_buffer_kind_t
 {
 	net_buffer_invalid= 0,
@@ -46,6 +53,7 @@ struct net_buffer_t
 	struct net_node_t *node;	/* Node where it belongs */
 	char *name;		/* String identifier */
 	int index;		/* Index in input/output buffer list of node */
+	int vc;			/* Virtual channel in link */
 	int size;		/* Total size */
 	int count;		/* Occupied buffer size */
 	enum net_buffer_kind_t kind;
@@ -92,6 +100,12 @@ void net_buffer_dump_report(struct net_buffer_t *buffer, FILE *f);
 void net_buffer_insert(struct net_buffer_t *buffer, struct net_msg_t *msg);
 void net_buffer_extract(struct net_buffer_t *buffer, struct net_msg_t *msg);
 
+int net_buffer_can_hold(struct net_buffer_t *buffer, int size);
+int net_buffer_can_insert(struct net_buffer_t *buffer, int size);
+void net_buffer_return_credits(struct net_buffer_t *buffer, int bytes,
+	int delay);
+void net_buffer_credit_handler(int event, void *data);
+
 void net_buffer_wait(struct net_buffer_t *buffer, int event, void *stack);
 void net_buffer_wakeup(struct net_buffer_t *buffer);
 
@@ -58,6 +58,8 @@ struct net_link_t *net_link_create(struct net_t *net,
 		src_buffer->kind = net_buffer_link;
 		dst_buffer = net_node_add_input_buffer(dst_node, link_dst_bsize);
 		dst_buffer->kind = net_buffer_link;
+		src_buffer->vc = i;
+		dst_buffer->vc = i;
 
 		if (i == 0)
 		{
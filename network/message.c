@@ -23,6 +23,7 @@
 #include <lib/mhandle/mhandle.h>
 #include <lib/util/debug.h>
 #include <lib/util/list.h>
+#include <lib/util/misc.h>
 
 #include "buffer.h"
 #include "bus.h"
@@ -71,6 +72,82 @@ void net_msg_free(struct net_msg_t *msg)
 
 
 
+/* Transfer a message from 'buffer' into 'next_buffer' at 'bandwidth' bytes
+ * per cycle, occupying both buffers and, if given, the link or bus whose busy
+ * cycle is pointed to by 'busy_ptr'. The function returns the number of
+ * cycles until the message can be processed in 'next_buffer'. */
+static int net_msg_forward(struct net_msg_t *msg, struct net_buffer_t *buffer,
+	struct net_buffer_t *next_buffer, int bandwidth, long long *busy_ptr)
+{
+	struct net_t *net = msg->net;
+
+	long long tail_busy;
+	long long cycle;
+
+	int head_lat;
+	int reserved;
+	int delay;
+
+	/* Get current cycle */
+	cycle = esim_domain_cycle(net_domain_index);
+
+	/* With store-and-forward switching, the whole message must arrive
+	 * before being processed. Otherwise, only the head flit needs to,
+	 * and the tail flit cannot leave before arriving from upstream. */
+	head_lat = (msg->size - 1) / bandwidth + 1;
+	tail_busy = cycle + head_lat - 1;
+	if (net->switching != net_switching_store_and_forward)
+	{
+		head_lat = (MIN(msg->size, net->flit_size) - 1) / bandwidth + 1;
+		tail_busy = MAX(tail_busy, msg->tail_busy + head_lat);
+	}
+	assert(head_lat > 0);
+
+	/* Occupy resources until the tail flit is transferred */
+	buffer->read_busy = tail_busy;
+	next_buffer->write_busy = tail_busy;
+	if (busy_ptr)
+		*busy_ptr = tail_busy;
+
+	/* Transfer message */
+	assert(msg->busy < cycle);
+	reserved = msg->reserved;
+	net_buffer_extract(buffer, msg);
+	net_buffer_insert(next_buffer, msg);
+	msg->buffer = next_buffer;
+	msg->busy = cycle + head_lat - 1;
+	msg->tail_busy = tail_busy;
+
+	/* With flit-level switching, release the source buffer once the tail
+	 * flit has left. If the message did not fit completely in the next
+	 * buffer, its tail keeps the source buffer occupied until the
+	 * message moves on. */
+	if (net->switching != net_switching_store_and_forward)
+	{
+		delay = tail_busy - cycle + 1;
+		if (msg->hold_buffer)
+			net_buffer_return_credits(msg->hold_buffer,
+				msg->hold_bytes, delay);
+		msg->hold_buffer = NULL;
+		msg->hold_bytes = 0;
+		if (msg->reserved < msg->size)
+		{
+			msg->hold_buffer = buffer;
+			msg->hold_bytes = reserved;
+		}
+		else
+		{
+			net_buffer_return_credits(buffer, reserved, delay);
+		}
+	}
+
+	/* Return latency */
+	return head_lat;
+}
+
+
+
+
 /* 
  * Event-driven Simulation
  */
@@ -151,11 +228,11 @@ void net_event_handler(int event, void *data)
 			panic("%s: output buffer busy.\n%s", __FUNCTION__,
 				net_err_can_send);
 
-		if (msg->size > output_buffer->size)
+		if (!net_buffer_can_hold(output_buffer, msg->size))
 			panic("%s: message does not fit in buffer.\n%s",
 				__FUNCTION__, net_err_can_send);
 
-		if (output_buffer->count + msg->size > output_buffer->size)
+		if (!net_buffer_can_insert(output_buffer, msg->size))
 			panic("%s: output buffer full.\n%s", __FUNCTION__,
 				net_err_can_send);
 
@@ -165,6 +242,7 @@ void net_event_handler(int event, void *data)
 		msg->node = src_node;
 		msg->buffer = output_buffer;
 		msg->busy = cycle;
+		msg->tail_busy = cycle;
 
 		/* Schedule next event */
 		esim_schedule_event(EV_NET_OUTPUT_BUFFER, stack, 1);
@@ -174,6 +252,7 @@ void net_event_handler(int event, void *data)
 	else if (event == EV_NET_OUTPUT_BUFFER)
 	{
 		struct net_buffer_t *input_buffer;
+		int delay;
 		int lat;
 
 		/* Debug */
@@ -279,10 +358,9 @@ void net_event_handler(int event, void *data)
 			}
 
 			/* If destination input buffer is full, wait */
-			if (msg->size > input_buffer->size)
+			if (!net_buffer_can_hold(input_buffer, msg->size))
 				fatal("%s: message does not fit in buffer.\n%s", net->name, net_err_large_message);
-			if (input_buffer->count + msg->size >
-				input_buffer->size)
+			if (!net_buffer_can_insert(input_buffer, msg->size))
 			{
 				net_debug("msg "
 					"a=\"stall\" "
@@ -297,17 +375,11 @@ void net_event_handler(int event, void *data)
 			/* Calculate latency and occupy resources */
 			lat = (msg->size - 1) / link->bandwidth + 1;
 			assert(lat > 0);
-			buffer->read_busy = cycle + lat - 1;
-			link->busy = cycle + lat - 1;
-			input_buffer->write_busy = cycle + lat - 1;
 
 			/* Transfer message to next input buffer */
-			assert(msg->busy < cycle);
-			net_buffer_extract(buffer, msg);
-			net_buffer_insert(input_buffer, msg);
+			delay = net_msg_forward(msg, buffer, input_buffer,
+				link->bandwidth, &link->busy);
 			msg->node = input_buffer->node;
-			msg->buffer = input_buffer;
-			msg->busy = cycle + lat - 1;
 
 			/* Stats */
 			link->busy_cycles += lat;
@@ -367,11 +439,11 @@ void net_event_handler(int event, void *data)
 			}
 
 			/* 2. Check the destination buffer is full or not */
-			if (msg->size > input_buffer->size)
+			if (!net_buffer_can_hold(input_buffer, msg->size))
 				fatal("%s: message does not fit in buffer.\n%s",
 					net->name, net_err_large_message);
 
-			if (input_buffer->count + msg->size > input_buffer->size)
+			if (!net_buffer_can_insert(input_buffer, msg->size))
 			{
 				net_buffer_wait(input_buffer, event, stack);
 				net_debug("msg "
@@ -417,17 +489,11 @@ void net_event_handler(int event, void *data)
 			/* Calculate latency and occupy resources */
 			lat = (msg->size - 1) / bus->bandwidth + 1;
 			assert(lat > 0);
-			buffer->read_busy = cycle + lat - 1;
-			bus->busy = cycle + lat - 1;
-			input_buffer->write_busy = cycle + lat - 1;
 
 			/* Transfer message to next input buffer */
-			assert(msg->busy < cycle);
-			net_buffer_extract(buffer, msg);
-			net_buffer_insert(input_buffer, msg);
+			delay = net_msg_forward(msg, buffer, input_buffer,
+				bus->bandwidth, &bus->busy);
 			msg->node = input_buffer->node;
-			msg->buffer = input_buffer;
-			msg->busy = cycle + lat - 1;
 
 			/* Stats */
 			bus->busy_cycles += lat;
@@ -440,12 +506,11 @@ void net_event_handler(int event, void *data)
 
 		}
 		/* Schedule next event */
-		esim_schedule_event(EV_NET_INPUT_BUFFER, stack, lat);
+		esim_schedule_event(EV_NET_INPUT_BUFFER, stack, delay);
 	}
 
 	else if (event == EV_NET_INPUT_BUFFER)
 	{
-		struct net_routing_table_entry_t *entry;
 		struct net_buffer_t *output_buffer;
 
 		int lat;
@@ -476,10 +541,12 @@ void net_event_handler(int event, void *data)
 			return;
 		}
 
-		/* If this is the destination node, finish */
+		/* If this is the destination node, finish once the tail flit
+		 * has arrived */
 		if (node == msg->dst_node)
 		{
-			esim_schedule_event(EV_NET_RECEIVE, stack, 0);
+			esim_schedule_event(EV_NET_RECEIVE, stack,
+				MAX(msg->tail_busy - cycle + 1, 0));
 			return;
 		}
 
@@ -499,9 +566,8 @@ void net_event_handler(int event, void *data)
 		}
 
 		/* Get output buffer */
-		entry = net_routing_table_lookup(routing_table, node,
-			dst_node);
-		output_buffer = entry->output_buffer;
+		output_buffer = net_routing_table_route(routing_table, node,
+			msg);
 		if (!output_buffer)
 			fatal("%s: no route from %s to %s.\n%s", net->name,
 				node->name, dst_node->name, net_err_no_route);
@@ -522,12 +588,12 @@ void net_event_handler(int event, void *data)
 		}
 
 		/* If destination output buffer is full, wait */
-		if (msg->size > output_buffer->size)
+		if (!net_buffer_can_hold(output_buffer, msg->size))
 			fatal("%s: message does not fit in buffer.\n%s",
 				net->name, net_err_large_message);
 
 
-		if (output_buffer->count + msg->size > output_buffer->size)
+		if (!net_buffer_can_insert(output_buffer, msg->size))
 		{
 			net_debug("msg "
 				"a=\"stall\" "
@@ -557,17 +623,8 @@ void net_event_handler(int event, void *data)
 		/* Calculate latency and occupy resources */
 		assert(node->kind != net_node_end);
 		assert(node->bandwidth > 0);
-		lat = (msg->size - 1) / node->bandwidth + 1;
-		assert(lat > 0);
-		buffer->read_busy = cycle + lat - 1;
-		output_buffer->write_busy = cycle + lat - 1;
-
-		/* Transfer message to next output buffer */
-		assert(msg->busy < cycle);
-		net_buffer_extract(buffer, msg);
-		net_buffer_insert(output_buffer, msg);
-		msg->buffer = output_buffer;
-		msg->busy = cycle + lat - 1;
+		lat = net_msg_forward(msg, buffer, output_buffer,
+			node->bandwidth, NULL);
 
 		/* Schedule next event */
 		esim_schedule_event(EV_NET_OUTPUT_BUFFER, stack, lat);
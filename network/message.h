@@ -28,6 +28,7 @@ struct net_msg_t
 	long long id;
 	long long send_cycle;	/* Cycle when it was sent */
 	long long busy;		/* In transit until cycle */
+	long long tail_busy;	/* Tail flit in transit until cycle */
 	int size;
 	void *data;
 
@@ -35,6 +36,18 @@ struct net_msg_t
 	struct net_node_t *node;
 	struct net_buffer_t *buffer;
 
+	/* Space occupied by the message in 'buffer', and in an upstream buffer
+	 * still holding its tail. Message space is only split across buffers
+	 * with wormhole switching. */
+	int reserved;
+	struct net_buffer_t *hold_buffer;
+	int hold_bytes;
+
+	/* Output buffer chosen by adaptive routing in the current node, and
+	 * cycle when the decision was made */
+	struct net_buffer_t *route_buffer;
+	long long route_when;
+
 	/* Information for in-transit messages. Messages always travel from
 	 * buffers to buffers (or end-nodes) */
 	struct net_buffer_t *src_buffer;	/* Original source buffer */
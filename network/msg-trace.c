@@ -0,0 +1,200 @@
+/* 
+ *  Multi2Sim
+ *  Copyright (C) 2012  Rafael Ubal (ubal@ece.neu.edu)
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include <assert.h>
+#include <string.h>
+
+#include <lib/esim/esim.h>
+#include <lib/mhandle/mhandle.h>
+#include <lib/util/debug.h>
+#include <lib/util/string.h>
+
+#include "message.h"
+#include "msg-trace.h"
+#include "net-system.h"
+#include "network.h"
+#include "node.h"
+
+
+/* Trace being captured, or NULL */
+static gzFile net_msg_trace_file;
+
+/* Capture state */
+static int net_msg_trace_node_count;
+static long long net_msg_trace_cycle;
+
+
+
+
+/* 
+ * Private Functions
+ */
+
+static void net_msg_trace_write_int(long long value)
+{
+	unsigned long long v = value;
+
+	assert(value >= 0);
+	while (v >= 0x80)
+	{
+		gzputc(net_msg_trace_file, (v & 0x7f) | 0x80);
+		v >>= 7;
+	}
+	gzputc(net_msg_trace_file, v);
+}
+
+
+static void net_msg_trace_write_str(char *str)
+{
+	int len;
+
+	len = strlen(str);
+	net_msg_trace_write_int(len);
+	gzwrite(net_msg_trace_file, str, len);
+}
+
+
+/* Dump a node record the first time a node appears in the trace */
+static void net_msg_trace_write_node(struct net_node_t *node)
+{
+	if (node->trace_id)
+		return;
+	node->trace_id = ++net_msg_trace_node_count;
+	gzputc(net_msg_trace_file, net_msg_trace_record_node);
+	net_msg_trace_write_int(node->trace_id);
+	net_msg_trace_write_str(node->net->name);
+	net_msg_trace_write_str(node->name);
+}
+
+
+
+
+/* 
+ * Public Functions
+ */
+
+void net_msg_trace_init(void)
+{
+	if (!*net_msg_trace_file_name)
+		return;
+	assert(!net_msg_trace_file);
+	net_msg_trace_file = gzopen(net_msg_trace_file_name, "wb");
+	if (!net_msg_trace_file)
+		fatal("%s: cannot write network message trace",
+			net_msg_trace_file_name);
+	gzwrite(net_msg_trace_file, NET_MSG_TRACE_MAGIC,
+		NET_MSG_TRACE_MAGIC_SIZE);
+}
+
+
+void net_msg_trace_done(void)
+{
+	if (!net_msg_trace_file)
+		return;
+	if (gzclose(net_msg_trace_file) != Z_OK)
+		warning("%s: error writing network message trace",
+			net_msg_trace_file_name);
+	net_msg_trace_file = NULL;
+}
+
+
+/* Record a message injected into the network */
+void net_msg_trace_send(struct net_msg_t *msg)
+{
+	struct net_node_t *src_node = msg->src_node;
+	long long cycle;
+
+	if (!net_msg_trace_file)
+		return;
+
+	/* Nodes */
+	net_msg_trace_write_node(src_node);
+	net_msg_trace_write_node(msg->dst_node);
+
+	/* Message */
+	cycle = esim_domain_cycle(net_domain_index);
+	assert(cycle >= net_msg_trace_cycle);
+	gzputc(net_msg_trace_file, net_msg_trace_record_msg);
+	net_msg_trace_write_int(cycle - net_msg_trace_cycle);
+	net_msg_trace_write_int(src_node->trace_id);
+	net_msg_trace_write_int(msg->dst_node->trace_id);
+	net_msg_trace_write_int(msg->size);
+	if (src_node->trace_recv_msg_id)
+	{
+		net_msg_trace_write_int(msg->id - src_node->trace_recv_msg_id);
+		net_msg_trace_write_int(cycle - src_node->trace_recv_cycle);
+	}
+	else
+	{
+		net_msg_trace_write_int(0);
+		net_msg_trace_write_int(0);
+	}
+	net_msg_trace_cycle = cycle;
+}
+
+
+/* Record the reception of a message by its destination node, which later
+ * messages sent by the node are assumed to depend on. */
+void net_msg_trace_receive(struct net_msg_t *msg)
+{
+	if (!net_msg_trace_file)
+		return;
+	msg->dst_node->trace_recv_msg_id = msg->id;
+	msg->dst_node->trace_recv_cycle = esim_domain_cycle(net_domain_index);
+}
+
+
+/* Read an integer from a trace. The function returns false at the end of the
+ * file, or if the integer is truncated. */
+int net_msg_trace_read_int(gzFile f, long long *value_ptr)
+{
+	unsigned long long value = 0;
+	int shift = 0;
+	int c;
+
+	do
+	{
+		c = gzgetc(f);
+		if (c < 0 || shift > 56)
+			return 0;
+		value |= (unsigned long long) (c & 0x7f) << shift;
+		shift += 7;
+	} while (c & 0x80);
+	*value_ptr = value;
+	return 1;
+}
+
+
+/* Read a string from a trace, returning a newly allocated string, or NULL if
+ * the string is truncated. */
+char *net_msg_trace_read_str(gzFile f)
+{
+	long long len;
+	char *str;
+
+	if (!net_msg_trace_read_int(f, &len) || len >= MAX_STRING_SIZE)
+		return NULL;
+	str = xcalloc(1, len + 1);
+	if (gzread(f, str, len) != len)
+	{
+		free(str);
+		return NULL;
+	}
+	return str;
+}
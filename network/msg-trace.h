@@ -0,0 +1,71 @@
+/* 
+ *  Multi2Sim
+ *  Copyright (C) 2012  Rafael Ubal (ubal@ece.neu.edu)
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef NETWORK_MSG_TRACE_H
+#define NETWORK_MSG_TRACE_H
+
+#include <zlib.h>
+
+
+/*
+ * Binary trace of network messages, compressed with gzip. The file starts
+ * with 'NET_MSG_TRACE_MAGIC', followed by records starting with a byte
+ * indicating the record kind. Integers are stored as unsigned variable-length
+ * quantities (7 bits per byte, least significant first), and strings as their
+ * length followed by their characters.
+ *
+ * Node record:
+ *	<id> <network name> <node name>
+ * Dumped the first time a node is used by a message, with consecutive node
+ * identifiers starting at 1.
+ *
+ * Message record:
+ *	<cycle> <source id> <destination id> <size> <dependence> <gap>
+ * Field <cycle> is the difference with the cycle of the previous message.
+ * The message is assumed to depend on the last message received by its
+ * source node before it was sent. Field <dependence> is the difference
+ * between the identifiers of both messages within their network, or 0 if
+ * there is no such message, and <gap> is the number of cycles between the
+ * reception of that message and the transmission of this one.
+ */
+
+#define NET_MSG_TRACE_MAGIC  "M2S-NMT1"
+#define NET_MSG_TRACE_MAGIC_SIZE  8
+
+enum net_msg_trace_record_t
+{
+	net_msg_trace_record_invalid = 0,
+	net_msg_trace_record_node,
+	net_msg_trace_record_msg
+};
+
+struct net_msg_t;
+
+void net_msg_trace_init(void);
+void net_msg_trace_done(void);
+
+void net_msg_trace_send(struct net_msg_t *msg);
+void net_msg_trace_receive(struct net_msg_t *msg);
+
+int net_msg_trace_read_int(gzFile f, long long *value_ptr);
+char *net_msg_trace_read_str(gzFile f);
+
+
+#endif
+
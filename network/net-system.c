@@ -17,8 +17,6 @@
  *  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
  */
 
-#include <math.h>
-
 #include <lib/esim/esim.h>
 #include <lib/mhandle/mhandle.h>
 #include <lib/util/debug.h>
@@ -28,9 +26,12 @@
 #include <lib/util/misc.h>
 #include <lib/util/string.h>
 
+#include "buffer.h"
+#include "msg-trace.h"
 #include "net-system.h"
 #include "network.h"
 #include "node.h"
+#include "traffic.h"
 #include "visual.h"
 
 /* 
@@ -66,6 +67,49 @@ char *net_config_help =
 		"      Default bandwidth for links in the network, specified in number of\n"
 		"      bytes per cycle. If a link's bandwidth is not specified, this value\n"
 		"      will be used.\n"
+		"  Switching = {StoreAndForward|VirtualCutThrough|Wormhole}\n"
+		"      (Default = StoreAndForward)\n"
+		"      Switching technique. With store-and-forward switching, a message\n"
+		"      is forwarded only after it has completely arrived. Otherwise, the\n"
+		"      message is split into flits, and it is forwarded as soon as its\n"
+		"      head flit arrives. Virtual cut-through requires space for the whole\n"
+		"      message in the next buffer, while wormhole switching only requires\n"
+		"      space for one flit. Flit-level switching cannot be used in networks\n"
+		"      with buses.\n"
+		"  FlitSize = <size> (Default = <network>.DefaultBandwidth)\n"
+		"      Size of a flit in bytes, used for virtual cut-through and wormhole\n"
+		"      switching.\n"
+		"  Routing = {ShortestPath|DimensionOrder|WestFirst}\n"
+		"      (Default = ShortestPath)\n"
+		"      Routing algorithm. Shortest-path routing uses a fixed next hop for\n"
+		"      each pair of nodes. Dimension-order routing forwards packets along\n"
+		"      the X dimension first, and then along the Y dimension. West-first\n"
+		"      routing is a minimal adaptive turn-model algorithm that routes\n"
+		"      packets west first, and then chooses among the remaining minimal\n"
+		"      directions the output buffer with most free space. On links with\n"
+		"      more than one virtual channel, channel 0 is reserved as a\n"
+		"      dimension-order escape channel. Both algorithms require switch\n"
+		"      coordinates, and cannot be combined with buses or a Routes section.\n"
+		"  Topology = {Custom|Ring|Mesh2D|Torus2D|FatTree|Dragonfly}\n"
+		"      (Default = Custom)\n"
+		"      Generate the nodes and links of a network automatically. Switches\n"
+		"      are named 's<pos>' and end nodes 'n<pos>', where <pos> is the\n"
+		"      position of the node in the topology. Node and Link sections can\n"
+		"      still be used to extend a generated topology.\n"
+		"        Ring: <Size> switches 's<i>' with end nodes 'n<i>'.\n"
+		"        Mesh2D, Torus2D: <Width> x <Height> switches 's<x>_<y>' with\n"
+		"          end nodes 'n<x>_<y>'. Switch coordinates are set, so\n"
+		"          dimension-order and west-first routing can be used.\n"
+		"        FatTree: k-ary n-tree with k = <Radix> and n = <Levels>, with\n"
+		"          k^n end nodes 'n<i>' and switches 's<level>_<i>'.\n"
+		"        Dragonfly: groups of <GroupSize> fully connected routers\n"
+		"          's<group>_<r>', each with <Terminals> end nodes\n"
+		"          'n<group>_<r>_<t>' and <GlobalLinks> links to other groups.\n"
+		"  Size, Width, Height, Radix, Levels = <value>\n"
+		"  GroupSize, Terminals, GlobalLinks = <value> (Default = 1)\n"
+		"      Parameters of the generated topology, as described above.\n"
+		"  VC = <virtual channels> (Default = 1)\n"
+		"      Number of virtual channels on generated links between switches.\n"
 		"\n"
 		"Sections '[ Network.<network>.Node.<node> ]' are used to define nodes in\n"
 		"network '<network>'.\n"
@@ -81,6 +125,9 @@ char *net_config_help =
 		"  Bandwidth = <bandwidth> (Default = <network>.DefaultBandwidth)\n"
 		"      For switches, bandwidth of internal crossbar communicating input\n"
 		"      with output buffers. For end nodes, this variable is ignored.\n"
+		"  X = <coordinate>, Y = <coordinate>\n"
+		"      Coordinates of a switch in a 2D mesh or torus, required for\n"
+		"      dimension-order and west-first routing. X grows eastwards.\n"
 		"\n"
 		"Sections '[ Network.<network>.Link.<link> ]' are used to define links in\n"
 		"network <network>. A link connects an output buffer of a source node with\n"
@@ -163,6 +210,7 @@ int EV_NET_SEND;
 int EV_NET_OUTPUT_BUFFER;
 int EV_NET_INPUT_BUFFER;
 int EV_NET_RECEIVE;
+int EV_NET_CREDIT;
 
 /* List of networks */
 static struct hash_table_t *net_table;
@@ -182,6 +230,13 @@ char *net_sim_network_name = "";
 long long net_max_cycles = 1000000;	/* 1M cycles default */
 double net_injection_rate = 0.001;	/* 1 packet every 1000 cycles */
 int net_msg_size = 1;			/* Message size in bytes */
+int net_routing_threads = 1;		/* Threads calculating routes */
+double net_hotspot_fraction = 0.1;	/* Fraction of traffic to hotspot */
+char *net_hotspot_node_name = "";
+char *net_traffic_trace_file_name = "";
+char *net_injection_sweep = "";		/* '<first>:<last>:<step>' */
+char *net_traffic_trace_deps = "";	/* 'relaxed' or 'preserved' */
+char *net_msg_trace_file_name = "";	/* Message trace to capture */
 
 /* Frequency of the network system, and frequency domain, as returned by
  * function 'esim_new_domain'. */
@@ -194,64 +249,6 @@ int net_domain_index;
  * Private Functions
  */
 
-static double exp_random(double lambda)
-{
-	double x = (double) random() / RAND_MAX;
-
-	return log(1 - x) / -lambda;
-}
-
-
-static void net_traffic_uniform(struct net_t *net, double *inject_time)
-{
-	while (1)
-	{
-		struct net_node_t *node;
-		struct net_node_t *dst_node;
-		long long cycle;
-		int i;
-
-		/* Get current cycle */
-		cycle = esim_domain_cycle(net_domain_index);
-		if (cycle >= net_max_cycles)
-			break;
-
-		/* Inject messages */
-		for (i = 0; i < net->node_count; i++)
-		{
-			/* Get end node */
-			node = list_get(net->node_list, i);
-			if (node->kind != net_node_end)
-				continue;
-
-			/* Turn for next injection? */
-			if (inject_time[i] > cycle)
-				continue;
-
-			/* Get a random destination node */
-			do
-			{
-				dst_node = list_get(net->node_list, random() %
-						list_count(net->node_list));
-			} while (dst_node->kind != net_node_end
-					|| dst_node == node);
-
-			/* Inject */
-			while (inject_time[i] < cycle)
-			{
-				inject_time[i] += exp_random(net_injection_rate);
-				if (net_can_send(net, node, dst_node, net_msg_size))
-					net_send(net, node, dst_node, net_msg_size);
-			}
-		}
-		/* Next cycle */
-		net_debug("___ cycle %lld ___\n", cycle);
-		esim_process_events(TRUE);
-	}
-
-}
-
-
 /*
  * Public Functions
  */
@@ -343,6 +340,7 @@ void net_read_config(void)
 
 		net_name = list_get(net_name_list, i);
 		network = net_create_from_config(config, net_name);
+		net_register_stats(network);
 
 		hash_table_insert(net_table, net_name, network);
 	}
@@ -369,6 +367,14 @@ void net_init(void)
 			net_domain_index, "net_input_buffer");
 	EV_NET_RECEIVE = esim_register_event_with_name(net_event_handler,
 			net_domain_index, "net_receive");
+	EV_NET_CREDIT = esim_register_event_with_name(net_buffer_credit_handler,
+			net_domain_index, "net_credit");
+	EV_NET_TRAFFIC_RECEIVE = esim_register_event_with_name(
+			net_traffic_receive_handler, net_domain_index,
+			"net_traffic_receive");
+
+	/* Message trace */
+	net_msg_trace_init();
 
 	/* Report file */
 	if (*net_report_file_name)
@@ -420,6 +426,9 @@ void net_done(void)
 		hash_table_free(net_table);
 	}
 
+	/* Close message trace */
+	net_msg_trace_done();
+
 	/* Close report file */
 	file_close(net_report_file);
 
@@ -470,7 +479,9 @@ struct net_t *net_find_next(void)
 void net_sim(char *debug_file_name)
 {
 	struct net_t *net;
-	double *inject_time;	/* Next injection time (one per node) */
+	struct net_traffic_t *traffic;
+	int pattern;
+	int err;
 
 	/* Initialize */
 	debug_init();
@@ -484,42 +495,32 @@ void net_sim(char *debug_file_name)
 	net = net_find(net_sim_network_name);
 	if (!net)
 		fatal("%s: network does not exist", net_sim_network_name);
-	/* Initialize */
-	inject_time = xcalloc(net->node_count, sizeof(double));
 
-	/* FIXME: error for no dest node in network */
-
-	/* Simulation loop */
-	esim_process_events(TRUE);
-	if (!strcmp(net_traffic_pattern, "") ||
-			(!strcmp(net_traffic_pattern, "uniform")))
+	/* Traffic pattern */
+	pattern = net_traffic_pattern_uniform;
+	if (*net_traffic_pattern)
 	{
-		net_traffic_uniform(net, inject_time);
+		pattern = str_map_string_err(&net_traffic_pattern_map,
+				net_traffic_pattern, &err);
+		if (err)
+			fatal("Network %s: unknown traffic pattern (%s). \n",
+					net->name, net_traffic_pattern);
 	}
-	else if (!strcmp(net_traffic_pattern, "command"))
-	{
-		while(1)
-		{
-			long long cycle;
+	traffic = net_traffic_create(net, pattern);
 
-			cycle = esim_domain_cycle(net_domain_index);
-			if (cycle >= net_max_cycles)
-				break;
-
-			net_debug("___cycle %lld___ \n", cycle);
-			esim_process_events(TRUE);
-		}
-	}
+	/* Simulation loop */
+	esim_process_events(TRUE);
+	if (*net_injection_sweep)
+		net_traffic_sweep(traffic, net_injection_sweep,
+				net_report_file ? net_report_file : stdout);
 	else
-		fatal("Network %s: unknown traffic pattern (%s). \n", net->name
-				,net_traffic_pattern);
-
+		net_traffic_run(traffic, net_max_cycles, net_injection_rate);
 
 	/* Drain events */
 	esim_process_all_events();
 
 	/* Free */
-	free(inject_time);
+	net_traffic_free(traffic);
 
 	/* Finalize */
 	net_done();
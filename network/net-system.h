@@ -49,6 +49,13 @@ extern char *net_traffic_pattern;
 extern long long net_max_cycles;
 extern double net_injection_rate;
 extern int net_msg_size;
+extern int net_routing_threads;
+extern double net_hotspot_fraction;
+extern char *net_hotspot_node_name;
+extern char *net_traffic_trace_file_name;
+extern char *net_injection_sweep;
+extern char *net_traffic_trace_deps;
+extern char *net_msg_trace_file_name;
 
 /* Frequency and frequency domain */
 extern int net_frequency;
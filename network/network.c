@@ -20,6 +20,7 @@
 #include <assert.h>
 
 #include <lib/esim/esim.h>
+#include <lib/esim/stats.h>
 #include <lib/mhandle/mhandle.h>
 #include <lib/util/debug.h>
 #include <lib/util/list.h>
@@ -28,14 +29,33 @@
 #include "buffer.h"
 #include "bus.h"
 #include "link.h"
+#include "msg-trace.h"
 #include "net-system.h"
 #include "network.h"
 #include "node.h"
 #include "routing-table.h"
+#include "topology.h"
 #include "visual.h"
 #include "command.h"
 
 
+char *net_switching_map[] =
+{
+	"StoreAndForward",
+	"VirtualCutThrough",
+	"Wormhole"
+};
+
+char *net_routing_map[] =
+{
+	"ShortestPath",
+	"DimensionOrder",
+	"WestFirst"
+};
+
+
+
+
 /* 
  * Private Functions
  */
@@ -247,6 +267,8 @@ struct net_t *net_create_from_config(struct config_t *config, char *name)
 	int def_input_buffer_size;
 	int def_output_buffer_size;
 	int def_bandwidth;
+	int switching;
+	int flit_size;
 
 	/* Create network */
 	net = net_create(name);
@@ -276,6 +298,21 @@ struct net_t *net_create_from_config(struct config_t *config, char *name)
 					net->name, section, net_err_config);
 		def_output_buffer_size = net->def_output_buffer_size;
 		def_input_buffer_size = net->def_input_buffer_size;
+
+		/* Switching */
+		switching = config_read_enum(config, section, "Switching",
+				net_switching_store_and_forward, net_switching_map, 3);
+		flit_size = config_read_int(config, section, "FlitSize",
+				def_bandwidth);
+		net_set_switching(net, switching, flit_size);
+
+		/* Routing algorithm */
+		net->routing = config_read_enum(config, section, "Routing",
+				net_routing_shortest_path, net_routing_map, 3);
+
+		/* Generated topology */
+		net_topology_create_from_config(net, config, section,
+				def_bandwidth);
 	}
 
 	/* Nodes */
@@ -292,6 +329,10 @@ struct net_t *net_create_from_config(struct config_t *config, char *name)
 		int output_buffer_size;
 		int bandwidth;
 		int lanes;	/* BUS lanes */
+		int x;
+		int y;
+
+		struct net_node_t *node;
 
 		/* First token must be 'Network' */
 		snprintf(section_str, sizeof section_str, "%s", section);
@@ -325,14 +366,23 @@ struct net_t *net_create_from_config(struct config_t *config, char *name)
 		bandwidth = config_read_int(config, section,
 				"BandWidth", def_bandwidth);
 		lanes = config_read_int(config, section, "Lanes", 1);
+		x = config_read_int(config, section, "X", -1);
+		y = config_read_int(config, section, "Y", -1);
+		if ((x < 0) != (y < 0))
+			fatal("%s:%s: both X and Y coordinates must be given.\n%s",
+					net->name, section, net_err_config);
 
 		/* Create node */
 		if (!strcasecmp(node_type, "EndNode"))
 			net_add_end_node(net, input_buffer_size,
 					output_buffer_size, node_name, NULL);
 		else if (!strcasecmp(node_type, "Switch"))
-			net_add_switch(net, input_buffer_size,
+		{
+			node = net_add_switch(net, input_buffer_size,
 					output_buffer_size, bandwidth, node_name);
+			node->x = x;
+			node->y = y;
+		}
 		else if (!strcasecmp(node_type, "Bus"))
 		{
 			/* Right now we ignore the size of buffers. But we
@@ -566,10 +616,21 @@ struct net_t *net_create_from_config(struct config_t *config, char *name)
 		net_config_command_create(net, config, section);
 		config_check(config);
 	}
-	/* If there is no route section, Floyd-Warshall calculates the
-	 * shortest path for all the nodes in the network */
+	/* If there is no route section, calculate the shortest paths from all
+	 * nodes to all end nodes in the network */
 	if (routing_type == 0)
-		net_routing_table_floyd_warshall(net->routing_table);
+		net_routing_table_calculate(net->routing_table);
+
+	/* Coordinate-based routing replaces shortest paths between switches
+	 * and end nodes */
+	if (net->routing != net_routing_shortest_path)
+	{
+		if (routing_type)
+			fatal("%s: routing algorithm cannot be combined with a "
+					"Routes section.\n%s", net->name,
+					net_err_config);
+		net_routing_table_dimension_order(net->routing_table);
+	}
 
 	/* Return */
 	return net;
@@ -642,6 +703,8 @@ void net_dump_report(struct net_t *net, FILE *f)
 			(double) net->msg_size_acc / net->transfers : 0.0);
 	fprintf(f, "AverageLatency = %.4f\n", net->transfers ?
 			(double) net->lat_acc / net->transfers : 0.0);
+	fprintf(f, "Switching = %s\n", net_switching_map[net->switching]);
+	fprintf(f, "Routing = %s\n", net_routing_map[net->routing]);
 	fprintf(f, "\n");
 
 	/* Links */
@@ -663,6 +726,66 @@ void net_dump_report(struct net_t *net, FILE *f)
 	}
 }
 
+
+void net_register_stats(struct net_t *net)
+{
+	struct net_link_t *link;
+	struct net_node_t *node;
+
+	int i;
+
+	/* General stats */
+	stats_register(&net->transfers, "net.%s.transfers", net->name);
+	stats_register(&net->lat_acc, "net.%s.lat_acc", net->name);
+	stats_register(&net->msg_size_acc, "net.%s.msg_size_acc", net->name);
+
+	/* Links */
+	for (i = 0; i < list_count(net->link_list); i++)
+	{
+		link = list_get(net->link_list, i);
+		stats_register(&link->transferred_bytes, "net.%s.%s.transferred_bytes",
+				net->name, link->name);
+		stats_register(&link->busy_cycles, "net.%s.%s.busy_cycles",
+				net->name, link->name);
+	}
+
+	/* Nodes */
+	for (i = 0; i < list_count(net->node_list); i++)
+	{
+		node = list_get(net->node_list, i);
+		stats_register(&node->bytes_sent, "net.%s.%s.bytes_sent",
+				net->name, node->name);
+		stats_register(&node->bytes_received, "net.%s.%s.bytes_received",
+				net->name, node->name);
+	}
+}
+
+
+void net_set_switching(struct net_t *net, enum net_switching_t switching,
+		int flit_size)
+{
+	struct net_node_t *node;
+	int i;
+
+	/* Check flit size */
+	if (flit_size < 1)
+		fatal("%s: invalid flit size.\n%s", net->name, net_err_config);
+
+	/* Buses transfer whole messages */
+	for (i = 0; i < list_count(net->node_list); i++)
+	{
+		node = list_get(net->node_list, i);
+		if (node->kind == net_node_bus &&
+				switching != net_switching_store_and_forward)
+			fatal("%s: %s: buses require store-and-forward switching.\n%s",
+					net->name, node->name, net_err_config);
+	}
+
+	/* Set */
+	net->switching = switching;
+	net->flit_size = flit_size;
+}
+
 void net_dump_visual(struct net_graph_t *graph, FILE *f)
 {
 	int i;
@@ -811,6 +934,12 @@ struct net_node_t *net_add_end_node(struct net_t *net,
 struct net_node_t *net_add_bus(struct net_t *net, int bandwidth, char *name, int lanes)	
 {
 	struct net_node_t *node;
+
+	/* Buses transfer whole messages */
+	if (net->switching != net_switching_store_and_forward)
+		fatal("%s: %s: buses require store-and-forward switching.\n%s",
+				net->name, name, net_err_config);
+
 	/* Create node */
 	node = net_node_create(net,
 			net_node_bus,  /* kind */
@@ -1037,7 +1166,7 @@ int net_can_send(struct net_t *net, struct net_node_t *src_node,
 		return 0;
 
 	/* Message does not fit in output buffer */
-	if (output_buffer->count + size > output_buffer->size)
+	if (!net_buffer_can_insert(output_buffer, size))
 		return 0;
 
 	/* All conditions satisfied, can send */
@@ -1073,7 +1202,7 @@ int net_can_send_ev(struct net_t *net, struct net_node_t *src_node,
 				net_err_no_route);
 
 	/* Message is too long */
-	if (size > output_buffer->size)
+	if (!net_buffer_can_hold(output_buffer, size))
 		fatal("%s: message too long.\n%s", net->name,
 				net_err_large_message);
 
@@ -1086,7 +1215,7 @@ int net_can_send_ev(struct net_t *net, struct net_node_t *src_node,
 	}
 
 	/* Message does not fit in output buffer */
-	if (output_buffer->count + size > output_buffer->size)
+	if (!net_buffer_can_insert(output_buffer, size))
 	{
 		net_buffer_wait(output_buffer, retry_event, retry_stack);
 		return 0;
@@ -1133,6 +1262,9 @@ struct net_msg_t *net_send_ev(struct net_t *net, struct net_node_t *src_node,
 	/* Insert message into hash table of in-flight messages */
 	net_msg_table_insert(net, msg);
 
+	/* Record message in trace */
+	net_msg_trace_send(msg);
+
 	/* Start event-driven simulation */
 	stack = net_stack_create(net, ESIM_EV_NONE, NULL);
 	stack->msg = msg;
@@ -1195,8 +1327,16 @@ void net_receive(struct net_t *net, struct net_node_t *node,
 	if (list_get(buffer->msg_list, 0) != msg)
 		panic("%s: message not at input buffer head", __FUNCTION__);
 
-	/* Extract and free message */
+	/* Extract message, releasing the space taken by its flits */
 	net_buffer_extract(buffer, msg);
+	net_buffer_return_credits(buffer, msg->reserved, 0);
+	if (msg->hold_buffer)
+		net_buffer_return_credits(msg->hold_buffer, msg->hold_bytes, 0);
+
+	/* Record reception in trace */
+	net_msg_trace_receive(msg);
+
+	/* Free message */
 	net_msg_table_extract(net, msg->id);
 	net_msg_free(msg);
 }
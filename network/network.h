@@ -22,12 +22,15 @@
 
 #include <lib/util/config.h>
 
+#include "topology.h"
+
 
 /* Events */
 extern int EV_NET_SEND;
 extern int EV_NET_OUTPUT_BUFFER;
 extern int EV_NET_INPUT_BUFFER;
 extern int EV_NET_RECEIVE;
+extern int EV_NET_CREDIT;
 
 /* Stack */
 struct net_stack_t
@@ -52,6 +55,35 @@ void net_event_handler(int event, void *data);
 
 #define NET_MSG_TABLE_SIZE 32
 
+/* Switching technique. With store-and-forward switching, a message is
+ * forwarded only after it has been completely received in a buffer. With
+ * virtual cut-through and wormhole switching, messages are split into flits,
+ * and the head flit is forwarded as soon as it arrives, while the rest of
+ * the message follows it in a pipelined fashion. Virtual cut-through needs
+ * space for the whole message in the next buffer, while wormhole switching
+ * only needs space for one flit, leaving the tail of the message stretched
+ * along the upstream buffers. */
+extern char *net_switching_map[];
+enum net_switching_t
+{
+	net_switching_store_and_forward = 0,
+	net_switching_virtual_cut_through,
+	net_switching_wormhole
+};
+
+/* Routing algorithm. Shortest-path routing uses one fixed next hop for each
+ * pair of nodes. Dimension-order routing (XY) and west-first adaptive routing
+ * require switches to have coordinates in a 2D mesh or torus. With
+ * west-first routing, virtual channel 0 of links with several virtual
+ * channels is reserved as a dimension-order escape channel. */
+extern char *net_routing_map[];
+enum net_routing_t
+{
+	net_routing_shortest_path = 0,
+	net_routing_dimension_order,
+	net_routing_west_first
+};
+
 /* Network */
 struct net_t
 {
@@ -61,6 +93,16 @@ struct net_t
 	int def_output_buffer_size;
 	int def_input_buffer_size;
 
+	/* Switching */
+	enum net_switching_t switching;
+	int flit_size;		/* Flit size in bytes */
+
+	/* Routing */
+	enum net_routing_t routing;
+
+	/* Generated topology, or 'net_topology_custom' */
+	enum net_topology_t topology;
+
 	/* Nodes */
 	struct list_t *node_list;
 	int node_count;
@@ -91,6 +133,12 @@ void net_dump(struct net_t *net, FILE *f);
 
 void net_dump_report(struct net_t *net, FILE *f);
 
+/* Register counters for interval statistics, once the network is complete */
+void net_register_stats(struct net_t *net);
+
+void net_set_switching(struct net_t *net, enum net_switching_t switching,
+	int flit_size);
+
 struct net_node_t *net_add_end_node(struct net_t *net,
 	int input_buffer_size, int output_buffer_size,
 	char *name, void *user_data);
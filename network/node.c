@@ -54,6 +54,8 @@ struct net_node_t *net_node_create(struct net_t *net,
 	node->bandwidth = bandwidth;
 	node->input_buffer_size = input_buffer_size;
 	node->output_buffer_size = output_buffer_size;
+	node->x = -1;
+	node->y = -1;
 	if (kind != net_node_end && bandwidth < 1)
 		panic("%s: invalid bandwidth", __FUNCTION__);
 	if (net_get_node_by_name(net, name))
@@ -249,7 +251,6 @@ struct net_buffer_t *net_node_schedule(struct net_node_t *node,
 	struct net_t *net = node->net;
 	struct net_routing_table_t *routing_table = net->routing_table;
 
-	struct net_routing_table_entry_t *entry;
 	struct net_buffer_t *input_buffer;
 	struct net_msg_t *msg;
 
@@ -309,14 +310,12 @@ struct net_buffer_t *net_node_schedule(struct net_node_t *node,
 			continue;
 
 		/* Message must target this output buffer */
-		entry = net_routing_table_lookup(routing_table, node,
-			msg->dst_node);
-		assert(entry->output_buffer);
-		if (entry->output_buffer != output_buffer)
+		if (net_routing_table_route(routing_table, node, msg) !=
+				output_buffer)
 			continue;
 
 		/* Message must fit in this output buffer */
-		if (output_buffer->count + msg->size > output_buffer->size)
+		if (!net_buffer_can_insert(output_buffer, msg->size))
 			continue;
 
 		/* All conditions satisfied - schedule */
@@ -42,6 +42,11 @@ struct net_node_t
 	char *name;
 	void *user_data;
 
+	/* Coordinates of a switch in a mesh or torus, used by dimension-order
+	 * and adaptive routing. Negative if not given. */
+	int x;
+	int y;
+
 	/* Switch crossbar or bus */
 	int bandwidth;
 	/* long long bus_busy; */
@@ -58,6 +63,12 @@ struct net_node_t
 	struct list_t *dst_buffer_list;	/* elements are of type struct net_buffer_t */
 	int last_node_index;
 
+	/* Message trace capture. Identifier of the node in the trace (0 if not
+	 * dumped yet), and last message received by the node. */
+	int trace_id;
+	long long trace_recv_msg_id;
+	long long trace_recv_cycle;
+
 	/* Stats */
 	long long bytes_received;
 	long long msgs_received;
@@ -18,14 +18,18 @@
  */
 
 #include <assert.h>
+#include <pthread.h>
 
+#include <lib/esim/esim.h>
 #include <lib/mhandle/mhandle.h>
 #include <lib/util/debug.h>
 #include <lib/util/list.h>
+#include <lib/util/misc.h>
 
 #include "buffer.h"
 #include "bus.h"
 #include "link.h"
+#include "message.h"
 #include "net-system.h"
 #include "network.h"
 #include "node.h"
@@ -37,157 +41,446 @@
  */
 
 
-#define NET_NODE_COLOR_WHITE ((void *) 1)
-#define NET_NODE_COLOR_GRAY ((void *) 2)
-#define NET_NODE_COLOR_BLACK ((void *) 3)
+/* Link graph of a network in compressed form. The out-edges of node 'i' are
+ * elements 'out_first[i]' to 'out_first[i + 1] - 1' of arrays 'out_node' and
+ * 'out_buffer', in the order of the node's output buffers. A bus output
+ * buffer produces one edge for each node reachable through the bus. In-edges
+ * are stored the same way in 'in_first' and 'in_node'. Only arrays are
+ * accessed while routes are calculated, so that destinations can be
+ * processed in parallel. */
+struct net_routing_graph_t
+{
+	int node_count;
+	int *out_first;
+	int *out_node;
+	struct net_buffer_t **out_buffer;
+	int *in_first;
+	int *in_node;
+};
+
+
+/* Count the edges leaving 'node', starting at position 'pos' of the edge
+ * arrays, and record them if the arrays are allocated. The function returns
+ * the position following the last edge. */
+static int net_routing_graph_visit_out_edges(struct net_node_t *node,
+	struct net_routing_graph_t *graph, int pos)
+{
+	struct net_buffer_t *buffer;
+	struct net_buffer_t *dst_buffer;
+	struct net_node_t *bus_node;
+
+	int i;
+	int j;
 
+	for (i = 0; i < list_count(node->output_buffer_list); i++)
+	{
+		buffer = list_get(node->output_buffer_list, i);
+
+		/* Link. Only the first virtual channel is used. */
+		if (buffer->kind == net_buffer_link)
+		{
+			assert(buffer->link);
+			if (buffer->vc)
+				continue;
+			if (graph->out_node)
+			{
+				graph->out_node[pos] = buffer->link->dst_node->index;
+				graph->out_buffer[pos] = buffer;
+			}
+			pos++;
+		}
 
-/* This algorithm will be recursively called to do the backtracking of DFS
- * algorithm. */
-/* Theoretically we shouldn't encounter any problem with the cycle detection
- * when BUSes exist since they are not connected to any output buffers and
- * cycles are based on the output buffers. --> more thorough examinations may 
- * be required. */
-static void routing_table_cycle_detection_dfs_visit(struct net_routing_table_t
-	*routing_table, struct list_t *buffer_list, struct list_t *color_list,
-	struct list_t *parent_list, int list_elem, int buffer_count)
+		/* Bus, connecting to all other nodes in the bus */
+		else if (buffer->kind == net_buffer_bus)
+		{
+			assert(buffer->bus);
+			bus_node = buffer->bus->node;
+			for (j = 0; j < list_count(bus_node->dst_buffer_list); j++)
+			{
+				dst_buffer = list_get(bus_node->dst_buffer_list, j);
+				if (dst_buffer->node == node)
+					continue;
+				if (graph->out_node)
+				{
+					graph->out_node[pos] = dst_buffer->node->index;
+					graph->out_buffer[pos] = buffer;
+				}
+				pos++;
+			}
+		}
+	}
+
+	/* Return next position */
+	return pos;
+}
+
+
+static struct net_routing_graph_t *net_routing_graph_create(struct net_t *net)
 {
-	struct net_t *net = routing_table->net;
+	struct net_routing_graph_t *graph;
+	struct net_node_t *node;
 
+	int *in_pos;
+	int count;
+	int i;
 	int j;
 
-	struct net_buffer_t *parent_index;
-	struct net_node_t *buffer_color;
-	struct net_node_t *node_elem;
-	struct net_buffer_t *buffer_elem;
+	/* Initialize */
+	graph = xcalloc(1, sizeof(struct net_routing_graph_t));
+	graph->node_count = net->node_count;
+	graph->out_first = xcalloc(net->node_count + 1, sizeof(int));
+	graph->in_first = xcalloc(net->node_count + 1, sizeof(int));
 
-	list_set(color_list, list_elem, NET_NODE_COLOR_GRAY);
+	/* Count out-edges */
+	count = 0;
+	for (i = 0; i < net->node_count; i++)
+	{
+		node = list_get(net->node_list, i);
+		graph->out_first[i] = count;
+		count = net_routing_graph_visit_out_edges(node, graph, count);
+	}
+	graph->out_first[net->node_count] = count;
+
+	/* Record out-edges */
+	graph->out_node = xcalloc(count + 1, sizeof(int));
+	graph->out_buffer = xcalloc(count + 1, sizeof(struct net_buffer_t *));
+	for (i = 0; i < net->node_count; i++)
+	{
+		node = list_get(net->node_list, i);
+		net_routing_graph_visit_out_edges(node, graph,
+			graph->out_first[i]);
+	}
+
+	/* In-edges */
+	graph->in_node = xcalloc(count + 1, sizeof(int));
+	for (i = 0; i < count; i++)
+		graph->in_first[graph->out_node[i] + 1]++;
+	for (i = 0; i < net->node_count; i++)
+		graph->in_first[i + 1] += graph->in_first[i];
+	in_pos = xcalloc(net->node_count, sizeof(int));
+	for (i = 0; i < net->node_count; i++)
+		in_pos[i] = graph->in_first[i];
+	for (i = 0; i < net->node_count; i++)
+		for (j = graph->out_first[i]; j < graph->out_first[i + 1]; j++)
+			graph->in_node[in_pos[graph->out_node[j]]++] = i;
+	free(in_pos);
 
-	buffer_elem = list_get(buffer_list, list_elem);
+	/* Return */
+	return graph;
+}
 
-	node_elem = buffer_elem->node;
 
-	for (j = 0; j < routing_table->dim && !routing_table->has_cycle; j++)
-	{
-		struct net_node_t *node_adj;
-		struct net_routing_table_entry_t *entry;
+static void net_routing_graph_free(struct net_routing_graph_t *graph)
+{
+	free(graph->out_first);
+	free(graph->out_node);
+	free(graph->out_buffer);
+	free(graph->in_first);
+	free(graph->in_node);
+	free(graph);
+}
 
-		node_adj = list_get(net->node_list, j);
-		entry = net_routing_table_lookup(routing_table, node_elem,
-			node_adj);
 
-		if (entry->output_buffer == buffer_elem)
-		{
-			struct net_routing_table_entry_t *entry_adj;
+/* Calculate the routes from all nodes to end node 'dst' with a breadth-first
+ * search over the in-edges of the link graph. The next hop of each node is
+ * its first out-edge leading to a node one hop closer to the destination.
+ * Array 'queue' has one element per node. */
+static void net_routing_table_calculate_dst(struct net_routing_table_t
+	*routing_table, struct net_routing_graph_t *graph, struct net_node_t
+	**nodes, int dst, int *queue)
+{
+	struct net_routing_table_entry_t *entries;
+	struct net_routing_table_entry_t *entry;
 
-			entry_adj =
-				net_routing_table_lookup(routing_table,
-				entry->next_node, node_adj);
+	int dst_dim = routing_table->dst_dim;
+	int head;
+	int tail;
+	int cost;
+	int i;
+	int j;
 
-			for (int i = 0; i < buffer_count; i++)
-			{
-				struct net_buffer_t *buffer_adj;
+	/* Column of the table */
+	assert(routing_table->dst_index[dst] >= 0);
+	entries = &routing_table->entries[routing_table->dst_index[dst]];
 
-				buffer_adj = list_get(buffer_list, i);
+	/* Initialize with infinite costs */
+	for (i = 0; i < graph->node_count; i++)
+	{
+		entry = &entries[i * dst_dim];
+		entry->cost = i == dst ? 0 : routing_table->dim;
+		entry->next_node = NULL;
+		entry->output_buffer = NULL;
+	}
 
-				if (buffer_adj == entry_adj->output_buffer)
-				{
+	/* Calculate costs */
+	head = 0;
+	tail = 0;
+	queue[tail++] = dst;
+	while (head < tail)
+	{
+		i = queue[head++];
+		cost = entries[i * dst_dim].cost + 1;
+		for (j = graph->in_first[i]; j < graph->in_first[i + 1]; j++)
+		{
+			entry = &entries[graph->in_node[j] * dst_dim];
+			if (entry->cost <= cost)
+				continue;
+			entry->cost = cost;
+			queue[tail++] = graph->in_node[j];
+		}
+	}
 
-					buffer_color =
-						list_get(color_list, i);
-					if (buffer_color ==
-						NET_NODE_COLOR_WHITE)
-					{
-						list_set(parent_list, i,
-							buffer_elem);
-						routing_table_cycle_detection_dfs_visit
-							(routing_table,
-							buffer_list,
-							color_list,
-							parent_list, i,
-							buffer_count);
-					}
-
-					buffer_color =
-						list_get(color_list, i);
-					parent_index =
-						list_get(parent_list, i);
-
-					if (buffer_color ==
-						NET_NODE_COLOR_GRAY
-						&& parent_index !=
-						buffer_elem)
-					{
-						warning("network %s: cycle found in routing table.\n%s", 
-							net->name, net_err_cycle);
-						routing_table->has_cycle = 1;
-					}
-				}
+	/* Next hops */
+	for (i = 0; i < graph->node_count; i++)
+	{
+		entry = &entries[i * dst_dim];
+		if (i == dst || entry->cost == routing_table->dim)
+			continue;
+		for (j = graph->out_first[i]; j < graph->out_first[i + 1]; j++)
+		{
+			if (entries[graph->out_node[j] * dst_dim].cost ==
+					entry->cost - 1)
+			{
+				entry->next_node = nodes[graph->out_node[j]];
+				entry->output_buffer = graph->out_buffer[j];
+				break;
 			}
 		}
+		assert(entry->output_buffer);
 	}
-	list_set(color_list, list_elem, NET_NODE_COLOR_BLACK);
 }
 
 
-/* cycle-dectection - This algorithm uses two lists, one for node color and
- * the * other for node parent of all nodes at the beginning are white. Each 
- * * node is its own parent. algorithm starts from the first node and runs a
- * * depth-first-search and creates the connection between nodes. Every node
- * that * is checked becomes gray. The breaking condition is when algorithm
- * meet a node* that is gray but not based on algorithm sequence that is, its 
- * parent differs * from the node that called the algorithm ---Order =
- * O(|E|+|V|) */
+/* Work assigned to a thread calculating routes */
+struct net_routing_table_worker_t
+{
+	struct net_routing_table_t *routing_table;
+	struct net_routing_graph_t *graph;
+	struct net_node_t **nodes;
+	int *dst_list;
+	int dst_count;
+	int *queue;
+};
+
+
+static void *net_routing_table_worker(void *data)
+{
+	struct net_routing_table_worker_t *worker = data;
+	int i;
+
+	for (i = 0; i < worker->dst_count; i++)
+		net_routing_table_calculate_dst(worker->routing_table,
+			worker->graph, worker->nodes, worker->dst_list[i],
+			worker->queue);
+	return NULL;
+}
+
+
+/* Look for cycles in the channel dependency graph induced by the routing
+ * table. There is a dependency between output buffers 'a' and 'b' if some
+ * message leaving through 'a' continues through 'b' in the next node. The
+ * search is an iterative depth-first search, with cost O(V * D), where V is
+ * the number of nodes and D the number of end nodes. */
 static void net_routing_table_cycle_detection(struct net_routing_table_t
 	*routing_table)
 {
-	int i, j, buffer_count = 0;
 	struct net_t *net = routing_table->net;
+	struct net_node_t *node;
+	struct net_routing_table_entry_t *entry;
+	struct net_routing_table_entry_t *next_entry;
+
+	int *buffer_first;
+	int *edge_first;
+	int *edge_dst;
+	int *edge_pos;
+	int *color;
+	int *stack;
+
+	int buffer_count;
+	int edge_count;
+	int pass;
+	int top;
+	int src;
+	int dst;
+	int i;
+	int j;
 
-	struct list_t *color_list;
-	struct list_t *parent_list;
-	struct list_t *buffer_list;
-	struct net_node_t *buffer_color;
-	struct net_buffer_t *buffer_i;
-	struct net_node_t *node_i;
-
-	buffer_list = list_create();
-	color_list = list_create();
-	parent_list = list_create();
-
-	for (i = 0; i < routing_table->dim; i++)
+	/* Assign a global identifier to each output buffer */
+	buffer_first = xcalloc(net->node_count + 1, sizeof(int));
+	for (i = 0; i < net->node_count; i++)
 	{
-		node_i = list_get(net->node_list, i);
-		if (node_i->kind != net_node_bus)
-			for (j = 0; j < list_count(node_i->output_buffer_list); j++)
+		node = list_get(net->node_list, i);
+		buffer_first[i + 1] = buffer_first[i] +
+			list_count(node->output_buffer_list);
+	}
+	buffer_count = buffer_first[net->node_count];
+
+	/* Dependencies, counted in the first pass and recorded in the
+	 * second */
+	edge_first = xcalloc(buffer_count + 1, sizeof(int));
+	edge_pos = xcalloc(buffer_count + 1, sizeof(int));
+	edge_dst = NULL;
+	edge_count = 0;
+	for (pass = 0; pass < 2; pass++)
+	{
+		for (i = 0; i < net->node_count; i++)
+		{
+			node = list_get(net->node_list, i);
+			if (node->kind == net_node_bus)
+				continue;
+			for (j = 0; j < routing_table->dst_dim; j++)
 			{
-
-				buffer_i = list_get(node_i->output_buffer_list,j);
-
-				list_add(color_list, NET_NODE_COLOR_WHITE);
-				list_add(parent_list, buffer_i);
-				list_add(buffer_list, buffer_i);
+				entry = &routing_table->entries[i *
+					routing_table->dst_dim + j];
+				if (!entry->output_buffer || !entry->next_node)
+					continue;
+				next_entry = &routing_table->entries[
+					entry->next_node->index *
+					routing_table->dst_dim + j];
+				if (!next_entry->output_buffer)
+					continue;
+				src = buffer_first[i] + entry->output_buffer->index;
+				dst = buffer_first[entry->next_node->index] +
+					next_entry->output_buffer->index;
+				if (pass)
+					edge_dst[edge_pos[src]++] = dst;
+				else
+					edge_first[src + 1]++;
 			}
-	}
+		}
 
-	buffer_count = list_count(color_list);
+		/* Prefix sums after first pass */
+		if (!pass)
+		{
+			for (i = 0; i < buffer_count; i++)
+				edge_first[i + 1] += edge_first[i];
+			for (i = 0; i < buffer_count; i++)
+				edge_pos[i] = edge_first[i];
+			edge_count = edge_first[buffer_count];
+			edge_dst = xcalloc(edge_count + 1, sizeof(int));
+		}
+	}
 
+	/* Depth-first search. Color 0 is white, 1 is gray, 2 is black. The
+	 * position of the next edge to explore is kept in 'edge_pos'. */
+	color = xcalloc(buffer_count + 1, sizeof(int));
+	stack = xcalloc(buffer_count + 1, sizeof(int));
+	for (i = 0; i < buffer_count; i++)
+		edge_pos[i] = edge_first[i];
 	for (i = 0; i < buffer_count && !routing_table->has_cycle; i++)
 	{
-		buffer_color = list_get(color_list, i);
-		if (buffer_color == NET_NODE_COLOR_WHITE)
+		if (color[i])
+			continue;
+		top = 0;
+		stack[top++] = i;
+		color[i] = 1;
+		while (top && !routing_table->has_cycle)
 		{
-			routing_table_cycle_detection_dfs_visit(routing_table,
-				buffer_list, color_list, parent_list, i,
-				buffer_count);
+			src = stack[top - 1];
+			if (edge_pos[src] == edge_first[src + 1])
+			{
+				color[src] = 2;
+				top--;
+				continue;
+			}
+			dst = edge_dst[edge_pos[src]++];
+			if (color[dst] == 1)
+			{
+				warning("network %s: cycle found in routing table.\n%s", 
+					net->name, net_err_cycle);
+				routing_table->has_cycle = 1;
+			}
+			else if (!color[dst])
+			{
+				color[dst] = 1;
+				stack[top++] = dst;
+			}
 		}
 	}
-	list_free(color_list);
-	list_free(parent_list);
-	list_free(buffer_list);
+
+	/* Free */
+	free(buffer_first);
+	free(edge_first);
+	free(edge_pos);
+	free(edge_dst);
+	free(color);
+	free(stack);
 }
 
 
+
+/* Return true if moving from 'node' to its neighbor 'next_node' goes west,
+ * including wrap-around links of a torus. */
+static int net_routing_table_is_west(struct net_node_t *node,
+	struct net_node_t *next_node)
+{
+	int dx;
+
+	if (next_node->x < 0 || next_node->y != node->y)
+		return 0;
+	dx = next_node->x - node->x;
+	return dx == -1 || dx > 1;
+}
+
+
+/* Return true if 'next_node' is a neighbor of 'node' on a minimal path to
+ * 'dst_node', based on the shortest-path costs of the routing table. */
+static int net_routing_table_is_minimal(struct net_routing_table_t
+	*routing_table, struct net_node_t *node, struct net_node_t *next_node,
+	struct net_node_t *dst_node)
+{
+	struct net_routing_table_entry_t *entry;
+	struct net_routing_table_entry_t *next_entry;
+
+	entry = net_routing_table_lookup(routing_table, node, dst_node);
+	next_entry = net_routing_table_lookup(routing_table, next_node,
+		dst_node);
+	return next_entry->cost < entry->cost;
+}
+
+
+/* Return the first output buffer of 'node' connected through a link to a
+ * neighbor on a dimension-order path to 'dst_node'. Dimension X is traversed
+ * first, then dimension Y, and finally the link to the end node. */
+static struct net_buffer_t *net_routing_table_dimension_order_buffer(
+	struct net_routing_table_t *routing_table, struct net_node_t *node,
+	struct net_node_t *dst_node)
+{
+	struct net_buffer_t *buffer;
+	struct net_buffer_t *x_buffer = NULL;
+	struct net_buffer_t *y_buffer = NULL;
+	struct net_node_t *next_node;
+
+	int i;
+
+	for (i = 0; i < list_count(node->output_buffer_list); i++)
+	{
+		buffer = list_get(node->output_buffer_list, i);
+		if (buffer->kind != net_buffer_link || buffer->vc)
+			continue;
+
+		/* Link to destination */
+		next_node = buffer->link->dst_node;
+		if (next_node == dst_node)
+			return buffer;
+
+		/* Minimal hop in one dimension */
+		if (next_node->x < 0 || !net_routing_table_is_minimal(
+				routing_table, node, next_node, dst_node))
+			continue;
+		if (next_node->y == node->y && !x_buffer)
+			x_buffer = buffer;
+		else if (next_node->x == node->x && !y_buffer)
+			y_buffer = buffer;
+	}
+
+	/* Return */
+	return x_buffer ? x_buffer : y_buffer;
+}
+
+
+
+
 /* 
  * Public Functions
  */
@@ -207,262 +500,154 @@ struct net_routing_table_t *net_routing_table_create(struct net_t *net)
 
 void net_routing_table_free(struct net_routing_table_t *routing_table)
 {
-	if (routing_table->entries)
-		free(routing_table->entries);
+	free(routing_table->entries);
+	free(routing_table->dst_index);
 	free(routing_table);
 }
 
 
-/* Create contents of routing table */
+/* Create contents of routing table, with 1-hop routes only */
 void net_routing_table_initiate(struct net_routing_table_t *routing_table)
 {
 	struct net_t *net = routing_table->net;
-	int i, j;
-	struct net_node_t *src_node, *dst_node;
-	struct net_buffer_t *buffer;
+	struct net_node_t *node;
+	struct net_routing_graph_t *graph;
 	struct net_routing_table_entry_t *entry;
 
-	/* Allocate routing table entries */
+	int i;
+	int j;
+
+	/* Allocate routing table entries. There is one column per end node,
+	 * since messages are always sent to end nodes. */
 	if (routing_table->entries)
 		panic("%s: network \"%s\": routing table already allocated",
 			__FUNCTION__, net->name);
-	routing_table->dim = list_count(net->node_list);
-	routing_table->entries =
-		xcalloc(routing_table->dim * routing_table->dim,
+	routing_table->dim = net->node_count;
+	routing_table->dst_index = xcalloc(net->node_count, sizeof(int));
+	routing_table->dst_dim = 0;
+	for (i = 0; i < net->node_count; i++)
+	{
+		node = list_get(net->node_list, i);
+		routing_table->dst_index[i] = node->kind == net_node_end ?
+			routing_table->dst_dim++ : -1;
+	}
+	routing_table->entries = xcalloc((long) routing_table->dim *
+		MAX(routing_table->dst_dim, 1),
 		sizeof(struct net_routing_table_entry_t));
 
 	/* Initialize table with infinite costs */
 	for (i = 0; i < net->node_count; i++)
 	{
-		for (j = 0; j < net->node_count; j++)
+		for (j = 0; j < routing_table->dst_dim; j++)
 		{
-			src_node = list_get(net->node_list, i);
-			dst_node = list_get(net->node_list, j);
-			entry = net_routing_table_lookup(routing_table,
-				src_node, dst_node);
-			entry->cost = i == j ? 0 : routing_table->dim;  /* Infinity or 0 */
-			entry->next_node = NULL;
-			entry->output_buffer = NULL;
+			entry = &routing_table->entries[i *
+				routing_table->dst_dim + j];
+			entry->cost = routing_table->dim;
 		}
+		if (routing_table->dst_index[i] >= 0)
+			routing_table->entries[i * routing_table->dst_dim +
+				routing_table->dst_index[i]].cost = 0;
 	}
 
-	/* Set 1-hop connections */
+	/* Set 1-hop connections to end nodes */
+	graph = net_routing_graph_create(net);
 	for (i = 0; i < net->node_count; i++)
 	{
-		src_node = list_get(net->node_list, i);
-		for (j = 0; j < list_count(src_node->output_buffer_list); j++)
+		for (j = graph->out_first[i]; j < graph->out_first[i + 1]; j++)
 		{
-			buffer = list_get(src_node->output_buffer_list, j);
-			/* For each buffer of each node we check to see if it 
-			 * is connected to a link or a BUS. If it is
-			 * connected to the link we update the table by
-			 * getting the destination node of the Link */
-			if (buffer->kind == net_buffer_link)
-			{
-				struct net_link_t *link;
-
-				assert(!buffer->bus);
-				link = buffer->link;
-				assert(link);
-				entry = net_routing_table_lookup
-					(routing_table, src_node,
-					link->dst_node);
-				entry->cost = 1;
-				entry->next_node = link->dst_node;
-				entry->output_buffer = buffer;
-			}
-
-			/* If it is connected to a BUS we create a connection 
-			 * between this node and all the nodes that are
-			 * connected to the BUS */
-			else if (buffer->kind == net_buffer_bus)
-			{
-				int k;
-
-				struct net_node_t *bus_node;
-				struct net_bus_t *bus;
-
-				assert(!buffer->link);
-				assert(buffer->bus);
-				bus = buffer->bus;
-				bus_node = bus->node;
-				for (k = 0; k < list_count(bus_node->dst_buffer_list); k++)
-				{
-					struct net_buffer_t *dst_buffer;
-					dst_buffer = list_get(bus_node->dst_buffer_list, k);
-					if (src_node != dst_buffer->node)
-					{
-						entry = net_routing_table_lookup(routing_table, src_node, dst_buffer->node);
-						entry->cost = 1;
-						entry->next_node = dst_buffer->node;
-						entry->output_buffer = buffer;
-					}
-					/*For BUS. Even though we never get to BUS in the routing table (no routes path
-					 * through BUS node. They all pass through BUS node's buffer) we still provide a
-					 * Path from BUS nodes to all the nodes. There is no path from nodes that ends in
-					 * BUS. Next buffer is still NULL*/
-					entry = net_routing_table_lookup(routing_table, bus_node, dst_buffer->node);
-					entry->cost = 1;
-					entry->next_node = dst_buffer->node;
-
-				}
-			}
+			node = list_get(net->node_list, graph->out_node[j]);
+			if (node->kind != net_node_end)
+				continue;
+			entry = net_routing_table_lookup(routing_table,
+				list_get(net->node_list, i), node);
+			if (entry->cost == 1)
+				continue;
+			entry->cost = 1;
+			entry->next_node = node;
+			entry->output_buffer = graph->out_buffer[j];
 		}
 	}
+	net_routing_graph_free(graph);
 }
 
-/* Calculate shortest paths Floyd-Warshall algorithm.*/
-void net_routing_table_floyd_warshall(struct net_routing_table_t *routing_table)
+
+/* Calculate shortest paths to all end nodes, with one breadth-first search
+ * per destination. The cost is O(D * (V + E)) for D end nodes, V nodes, and
+ * E links. Destinations are distributed among 'net_routing_threads'
+ * threads. */
+void net_routing_table_calculate(struct net_routing_table_t *routing_table)
 {
-	int i, j, k ;
 	struct net_t *net = routing_table->net;
+	struct net_routing_graph_t *graph;
+	struct net_routing_table_worker_t *workers;
+	struct net_routing_table_worker_t *worker;
+	struct net_node_t **nodes;
 
-	struct net_node_t *next_node;
-	struct net_buffer_t *buffer;
-	struct net_link_t *link;
-
-	struct net_routing_table_entry_t *entry;
-
-	/* The 'routing_table_entry->next_node' values do
-	 * not necessarily point to the immediate next hop after this. */
-	for (k = 0; k < net->node_count; k++)
-	{
-		for (i = 0; i < net->node_count; i++)
-		{
-			for (j = 0; j < net->node_count; j++)
-			{
-				struct net_node_t *node_i;
-				struct net_node_t *node_j;
-				struct net_node_t *node_k;
-
-				struct net_routing_table_entry_t *entry_i_k;
-				struct net_routing_table_entry_t *entry_k_j;
-				struct net_routing_table_entry_t *entry_i_j;
+	pthread_t *threads;
 
-				node_i = list_get(net->node_list, i);
-				node_j = list_get(net->node_list, j);
-				node_k = list_get(net->node_list, k);
+	int *dst_list;
+	int num_threads;
+	int i;
 
-				entry_i_k = net_routing_table_lookup(routing_table, node_i, node_k);
-				entry_k_j = net_routing_table_lookup(routing_table, node_k, node_j);
-				entry_i_j = net_routing_table_lookup(routing_table, node_i, node_j);
-
-				if (entry_i_k->cost + entry_k_j->cost < entry_i_j->cost)
-				{
-					entry_i_j->cost = entry_i_k->cost + entry_k_j->cost;
-					entry_i_j->next_node = node_k;
-				}
-			}
-		}
-	}
+	/* Node array and link graph */
+	assert(routing_table->entries);
+	graph = net_routing_graph_create(net);
+	nodes = xcalloc(net->node_count + 1, sizeof(struct net_node_t *));
+	for (i = 0; i < net->node_count; i++)
+		nodes[i] = list_get(net->node_list, i);
 
-	/* Calculate output buffers */
+	/* List of destinations */
+	dst_list = xcalloc(routing_table->dst_dim + 1, sizeof(int));
 	for (i = 0; i < net->node_count; i++)
+		if (routing_table->dst_index[i] >= 0)
+			dst_list[routing_table->dst_index[i]] = i;
+
+	/* Split destinations into contiguous chunks */
+	num_threads = MAX(1, MIN(net_routing_threads, routing_table->dst_dim));
+	workers = xcalloc(num_threads, sizeof(struct net_routing_table_worker_t));
+	threads = xcalloc(num_threads, sizeof(pthread_t));
+	for (i = 0; i < num_threads; i++)
 	{
-		for (j = 0; j < net->node_count; j++)
-		{
-			struct net_node_t *node_i;
-			struct net_node_t *node_j;
-			struct net_routing_table_entry_t *entry_i_j;
-
-			node_i = list_get(net->node_list, i);
-
-			node_j = list_get(net->node_list, j);
-			entry_i_j = net_routing_table_lookup(routing_table, node_i, node_j);
-			next_node = entry_i_j->next_node;
-
-			/* No route to node */
-			if (!next_node)
-			{
-				entry_i_j->output_buffer = NULL;
-				continue;
-			}
-
-			/* Follow path */
-			for (;;)
-			{
-				entry = net_routing_table_lookup(routing_table, node_i, next_node);
-				if (entry->cost <= 1)
-					break;
-				next_node = entry->next_node;
-			}
-
-			/* Look for output buffer */
-			buffer = NULL;
-			if (node_i->kind != net_node_bus)
-			{
-				struct net_buffer_t *bus_dst_buffer;
-				assert(list_count(node_i->output_buffer_list));
-				for (k = 0; k < list_count(node_i->output_buffer_list); k++)
-				{
-					buffer = list_get(node_i->output_buffer_list, k);
-					if (buffer->link)
-					{
-						link = buffer->link;
-						assert(link);
-						if (link->dst_node == next_node)
-							break;
-					}
-					else if (buffer->bus)
-					{
-						int l;
-						int check = 0;
-						struct net_node_t *bus_node;
-						struct net_bus_t *bus;
-
-						bus = buffer->bus;
-						assert(bus);
-						bus_node = bus->node;
-						for (l = 0; l < list_count(bus_node->dst_buffer_list); l++)
-						{
-							bus_dst_buffer = list_get(bus_node->dst_buffer_list, l);
-							if (bus_dst_buffer->node == next_node)
-							{
-								check = 1;
-								entry_i_j->next_node = bus_dst_buffer->node;
-								break;
-							}
-						}
-						if (check == 1)
-							break;
-
-					}
-				}
-				assert(k < list_count(node_i->output_buffer_list));
-				entry_i_j->output_buffer = buffer;
-
-
-			}
-		}
+		worker = &workers[i];
+		worker->routing_table = routing_table;
+		worker->graph = graph;
+		worker->nodes = nodes;
+		worker->dst_list = dst_list + (long) routing_table->dst_dim *
+			i / num_threads;
+		worker->dst_count = (long) routing_table->dst_dim * (i + 1) /
+			num_threads - (worker->dst_list - dst_list);
+		worker->queue = xcalloc(net->node_count + 1, sizeof(int));
 	}
 
-	/* Update routing table entries to point to the next hop */
-	for (i = 0; i < net->node_count; i++)
+	/* Run workers */
+	if (num_threads == 1)
 	{
-		for (j = 0; j < net->node_count; j++)
-		{
-			struct net_node_t *node_i;
-			struct net_node_t *node_j;
-			struct net_routing_table_entry_t *entry_i_j;
-
-			node_i = list_get(net->node_list, i);
-			node_j = list_get(net->node_list, j);
-			entry_i_j = net_routing_table_lookup(routing_table, node_i, node_j);
-
-			buffer = entry_i_j->output_buffer;
-			if (buffer && buffer->link)
-			{
-				link = buffer->link;
-				assert(link);
-				entry_i_j->next_node = link->dst_node;
-			}
-		}
+		net_routing_table_worker(&workers[0]);
+	}
+	else
+	{
+		for (i = 0; i < num_threads; i++)
+			if (pthread_create(&threads[i], NULL,
+					net_routing_table_worker, &workers[i]))
+				fatal("%s: could not create thread", __FUNCTION__);
+		for (i = 0; i < num_threads; i++)
+			pthread_join(threads[i], NULL);
 	}
 
+	/* Free */
+	for (i = 0; i < num_threads; i++)
+		free(workers[i].queue);
+	free(workers);
+	free(threads);
+	free(dst_list);
+	free(nodes);
+	net_routing_graph_free(graph);
+
 	/* Find cycle in routing table */
 	net_routing_table_cycle_detection(routing_table);
 }
 
+
 void net_routing_table_dump(struct net_routing_table_t *routing_table, FILE *f)
 {
 	int i, j;
@@ -470,12 +655,14 @@ void net_routing_table_dump(struct net_routing_table_t *routing_table, FILE *f)
 	struct net_t *net = routing_table->net;
 	struct net_node_t *next_node;
 	struct net_node_t *node_l;
-	/* Routing table */
+
+	/* Routing table. Columns are end nodes. */
 	fprintf(f, "         ");
 	for (i = 0; i < net->node_count; i++)
 	{
 		node_l = list_get(net->node_list, i);
-		fprintf(f, "\t%s \t\t", node_l->name);
+		if (node_l->kind == net_node_end)
+			fprintf(f, "\t%s \t\t", node_l->name);
 	}
 
 	fprintf(f, "\n");
@@ -491,6 +678,8 @@ void net_routing_table_dump(struct net_routing_table_t *routing_table, FILE *f)
 			struct net_buffer_t *buffer;
 			node_i = list_get(net->node_list, i);
 			node_j = list_get(net->node_list, j);
+			if (node_j->kind != net_node_end)
+				continue;
 			entry_i_j = net_routing_table_lookup(routing_table, node_i, node_j);
 			next_node = entry_i_j->next_node;
 			buffer = entry_i_j->output_buffer;
@@ -512,44 +701,6 @@ void net_routing_table_dump(struct net_routing_table_t *routing_table, FILE *f)
 
 	}
 	fprintf(f, "\n");
-
-	/* Node combinations */
-	/*
-	int k;
-	for (i = 0; i < net->node_count; i++)
-	{
-		for (j = 0; j < net->node_count; j++)
-		{
-			struct net_node_t *node_i;
-			struct net_node_t *node_j;
-
-			node_i = list_get(net->node_list, i);
-			node_j = list_get(net->node_list, j);
-
-			fprintf(f, "from %s to %s: ", node_i->name, node_j->name);
-			k = i;
-			while (k != j)
-			{
-				struct net_node_t *node_k;
-				struct net_routing_table_entry_t *entry_k_j;
-
-				node_k = list_get(net->node_list, k);
-				entry_k_j = net_routing_table_lookup(routing_table, node_k, node_j);
-				next_node = entry_k_j->next_node;
-
-				if (!next_node)
-				{
-					fprintf(f, "x ");
-					break;
-				}
-				fprintf(f, "%s ", next_node->name);
-				k = next_node->index;
-			}
-			fprintf(f, "\n");
-		}
-		fprintf(f, "\n");
-	}
-	 */
 }
 
 
@@ -561,10 +712,10 @@ struct net_routing_table_entry_t *net_routing_table_lookup(struct
 
 	assert(src_node->index < routing_table->dim);
 	assert(dst_node->index < routing_table->dim);
-	assert(routing_table->dim > 0);
+	assert(routing_table->dst_index[dst_node->index] >= 0);
 
-	entry = &routing_table->entries[src_node->index * routing_table->dim +
-		dst_node->index];
+	entry = &routing_table->entries[src_node->index * routing_table->dst_dim +
+		routing_table->dst_index[dst_node->index]];
 	return entry;
 }
 
@@ -583,6 +734,12 @@ void net_routing_table_route_update(struct net_routing_table_t *routing_table,
 	struct net_bus_t *bus;
 	struct net_routing_table_entry_t *entry;
 
+	/* Routes lead to end nodes */
+	if (dst_node->kind != net_node_end)
+		fatal("Network %s: route %s.to.%s: destination is not an end node.\n%s",
+			routing_table->net->name, src_node->name,
+			dst_node->name, net_err_config);
+
 	entry = net_routing_table_lookup(routing_table, src_node, dst_node);
 	entry->next_node = next_node;
 	entry->output_buffer = NULL;
@@ -690,3 +847,156 @@ void net_routing_table_route_create(struct net_routing_table_t *routing_table,
 		}
 	}
 }
+
+
+/* Replace the routes from switches to end nodes with dimension-order routes.
+ * All switches must have coordinates. */
+void net_routing_table_dimension_order(struct net_routing_table_t
+	*routing_table)
+{
+	struct net_t *net = routing_table->net;
+	struct net_node_t *node;
+	struct net_node_t *dst_node;
+	struct net_buffer_t *buffer;
+	struct net_routing_table_entry_t *entry;
+
+	int i;
+	int j;
+
+	/* Check nodes */
+	for (i = 0; i < net->node_count; i++)
+	{
+		node = list_get(net->node_list, i);
+		if (node->kind == net_node_bus)
+			fatal("%s: %s routing not supported with buses.\n%s",
+				net->name, net_routing_map[net->routing],
+				net_err_config);
+		if (node->kind == net_node_switch && node->x < 0)
+			fatal("%s: %s: switch coordinates required for %s "
+				"routing.\n%s", net->name, node->name,
+				net_routing_map[net->routing], net_err_config);
+	}
+
+	/* Routes */
+	for (i = 0; i < net->node_count; i++)
+	{
+		node = list_get(net->node_list, i);
+		if (node->kind != net_node_switch)
+			continue;
+
+		for (j = 0; j < net->node_count; j++)
+		{
+			dst_node = list_get(net->node_list, j);
+			if (dst_node->kind != net_node_end)
+				continue;
+
+			/* No route */
+			entry = net_routing_table_lookup(routing_table, node,
+				dst_node);
+			if (!entry->output_buffer)
+				continue;
+
+			/* Dimension-order hop */
+			buffer = net_routing_table_dimension_order_buffer(
+				routing_table, node, dst_node);
+			if (!buffer)
+				fatal("%s: no dimension-order route from %s to "
+					"%s.\n%s", net->name, node->name,
+					dst_node->name, net_err_no_route);
+			entry->next_node = buffer->link->dst_node;
+			entry->output_buffer = buffer;
+		}
+	}
+}
+
+
+/* Return the output buffer where a message in an input buffer of 'node'
+ * should be forwarded to. With west-first routing, the output buffer is
+ * chosen among all minimal directions allowed by the turn model, preferring
+ * the one with the most free space. Packets going west can only use the
+ * westward link. If no adaptive output buffer has space, the escape
+ * virtual channel of the dimension-order route is used. The decision is kept
+ * for the rest of the cycle, so that the switch scheduler sees it too. */
+struct net_buffer_t *net_routing_table_route(struct net_routing_table_t
+	*routing_table, struct net_node_t *node, struct net_msg_t *msg)
+{
+	struct net_t *net = routing_table->net;
+	struct net_node_t *dst_node = msg->dst_node;
+	struct net_node_t *next_node;
+	struct net_routing_table_entry_t *entry;
+
+	struct net_buffer_t *buffer;
+	struct net_buffer_t *escape_buffer;
+	struct net_buffer_t *best_buffer;
+
+	long long cycle;
+
+	int best_fits;
+	int fits;
+	int west;
+	int i;
+
+	/* Static routing */
+	entry = net_routing_table_lookup(routing_table, node, dst_node);
+	if (net->routing != net_routing_west_first ||
+			node->kind != net_node_switch ||
+			!entry->output_buffer ||
+			entry->next_node == dst_node)
+		return entry->output_buffer;
+
+	/* Decision already made in this cycle */
+	cycle = esim_domain_cycle(net_domain_index);
+	if (msg->route_when == cycle && msg->route_buffer &&
+			msg->route_buffer->node == node)
+		return msg->route_buffer;
+
+	/* Escape channel */
+	escape_buffer = entry->output_buffer;
+	if (escape_buffer->link->virtual_channel < 2)
+		escape_buffer = NULL;
+
+	/* Choose among adaptive output buffers */
+	west = net_routing_table_is_west(node, entry->next_node);
+	best_buffer = NULL;
+	best_fits = 0;
+	for (i = 0; i < list_count(node->output_buffer_list); i++)
+	{
+		buffer = list_get(node->output_buffer_list, i);
+		if (buffer->kind != net_buffer_link)
+			continue;
+
+		/* Virtual channel 0 is reserved for escape */
+		if (buffer->vc == 0 && buffer->link->virtual_channel > 1)
+			continue;
+
+		/* Minimal direction allowed by the turn model */
+		next_node = buffer->link->dst_node;
+		if (next_node->x < 0 || !net_routing_table_is_minimal(
+				routing_table, node, next_node, dst_node))
+			continue;
+		if (west && !net_routing_table_is_west(node, next_node))
+			continue;
+
+		/* Keep buffer with most free space */
+		fits = buffer->write_busy < cycle &&
+			net_buffer_can_insert(buffer, msg->size);
+		if (!best_buffer || fits > best_fits || (fits == best_fits &&
+				buffer->size - buffer->count > best_buffer->size -
+				best_buffer->count))
+		{
+			best_buffer = buffer;
+			best_fits = fits;
+		}
+	}
+
+	/* Fall back to escape channel */
+	if (escape_buffer && !best_fits)
+		best_buffer = escape_buffer;
+	if (!best_buffer)
+		best_buffer = entry->output_buffer;
+
+	/* Return */
+	msg->route_when = cycle;
+	msg->route_buffer = best_buffer;
+	return best_buffer;
+}
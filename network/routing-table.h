@@ -34,8 +34,11 @@ struct net_routing_table_t
 {
 	struct net_t *net;	/* Associated network */
 
-	/* 2D array containing routing table */
-	int dim;		/* Array dimensions ('dim' x 'dim') */
+	/* 2D array containing routing table. There is one row per node, and
+	 * one column per end node. */
+	int dim;		/* Number of nodes */
+	int dst_dim;		/* Number of end nodes */
+	int *dst_index;		/* Column for each node, -1 if not end node */
 	struct net_routing_table_entry_t *entries;
 
 	/* Flag set when a cycle was detected */
@@ -47,7 +50,7 @@ void net_routing_table_free(struct net_routing_table_t *routing_table);
 
 void net_routing_table_initiate(struct net_routing_table_t *routing_table);
 
-void net_routing_table_floyd_warshall(struct net_routing_table_t
+void net_routing_table_calculate(struct net_routing_table_t
 	*routing_table);
 void net_routing_table_dump(struct net_routing_table_t *routing_table,
 	FILE *f);
@@ -63,6 +66,11 @@ struct net_routing_table_entry_t *net_routing_table_lookup(struct
 	net_routing_table_t *routing_table, struct net_node_t *src_node,
 	struct net_node_t *dst_node);
 
+void net_routing_table_dimension_order(struct net_routing_table_t
+	*routing_table);
+struct net_buffer_t *net_routing_table_route(struct net_routing_table_t
+	*routing_table, struct net_node_t *node, struct net_msg_t *msg);
+
 
 #endif
 
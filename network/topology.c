@@ -0,0 +1,416 @@
+/* 
+ *  Multi2Sim
+ *  Copyright (C) 2012  Rafael Ubal (ubal@ece.neu.edu)
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include <stdarg.h>
+
+#include <lib/mhandle/mhandle.h>
+#include <lib/util/debug.h>
+#include <lib/util/list.h>
+#include <lib/util/string.h>
+
+#include "net-system.h"
+#include "network.h"
+#include "node.h"
+#include "topology.h"
+
+
+char *net_topology_map[] =
+{
+	"Custom",
+	"Ring",
+	"Mesh2D",
+	"Torus2D",
+	"FatTree",
+	"Dragonfly"
+};
+
+
+
+
+/* 
+ * Private Functions
+ */
+
+static struct net_node_t *net_topology_add_switch(struct net_t *net,
+	int bandwidth, int x, int y, char *fmt, ...)
+	__attribute__ ((format (printf, 5, 6)));
+static struct net_node_t *net_topology_add_switch(struct net_t *net,
+	int bandwidth, int x, int y, char *fmt, ...)
+{
+	struct net_node_t *node;
+	char name[MAX_STRING_SIZE];
+	va_list va;
+
+	va_start(va, fmt);
+	vsnprintf(name, sizeof name, fmt, va);
+	va_end(va);
+	node = net_add_switch(net, net->def_input_buffer_size,
+		net->def_output_buffer_size, bandwidth, name);
+	node->x = x;
+	node->y = y;
+	return node;
+}
+
+
+/* Add an end node connected to 'switch_node' */
+static struct net_node_t *net_topology_add_end_node(struct net_t *net,
+	struct net_node_t *switch_node, int bandwidth, char *fmt, ...)
+	__attribute__ ((format (printf, 4, 5)));
+static struct net_node_t *net_topology_add_end_node(struct net_t *net,
+	struct net_node_t *switch_node, int bandwidth, char *fmt, ...)
+{
+	struct net_node_t *node;
+	char name[MAX_STRING_SIZE];
+	va_list va;
+
+	va_start(va, fmt);
+	vsnprintf(name, sizeof name, fmt, va);
+	va_end(va);
+	node = net_add_end_node(net, net->def_input_buffer_size,
+		net->def_output_buffer_size, name, NULL);
+	net_add_bidirectional_link(net, node, switch_node, bandwidth, 0, 0, 1);
+	return node;
+}
+
+
+
+
+/* 
+ * Public Functions
+ */
+
+/* Generate the nodes and links of the topology given in variable 'Topology'
+ * of the main section of a network, if any. */
+void net_topology_create_from_config(struct net_t *net,
+	struct config_t *config, char *section, int bandwidth)
+{
+	enum net_topology_t topology;
+
+	int vc_count;
+	int width;
+	int height;
+	int radix;
+	int levels;
+	int group_size;
+	int terminals;
+	int global_links;
+
+	/* Topology */
+	topology = config_read_enum(config, section, "Topology",
+		net_topology_custom, net_topology_map, 6);
+	net->topology = topology;
+	if (topology == net_topology_custom)
+		return;
+
+	/* Virtual channels on links between switches */
+	vc_count = config_read_int(config, section, "VC", 1);
+	if (vc_count < 1)
+		fatal("%s:%s: VC: invalid value.\n%s",
+			net->name, section, net_err_config);
+
+	/* Generate */
+	switch (topology)
+	{
+
+	case net_topology_ring:
+
+		width = config_read_int(config, section, "Size", 0);
+		if (width < 2)
+			fatal("%s:%s: Size: invalid/missing value.\n%s",
+				net->name, section, net_err_config);
+		net_topology_create_ring(net, width, bandwidth, vc_count);
+		break;
+
+	case net_topology_mesh_2d:
+	case net_topology_torus_2d:
+
+		width = config_read_int(config, section, "Width", 0);
+		height = config_read_int(config, section, "Height", 0);
+		if (width < 1 || height < 1)
+			fatal("%s:%s: Width/Height: invalid/missing value.\n%s",
+				net->name, section, net_err_config);
+		net_topology_create_mesh(net, width, height,
+			topology == net_topology_torus_2d, bandwidth, vc_count);
+		break;
+
+	case net_topology_fat_tree:
+
+		radix = config_read_int(config, section, "Radix", 0);
+		levels = config_read_int(config, section, "Levels", 0);
+		if (radix < 2)
+			fatal("%s:%s: Radix: invalid/missing value.\n%s",
+				net->name, section, net_err_config);
+		if (levels < 1)
+			fatal("%s:%s: Levels: invalid/missing value.\n%s",
+				net->name, section, net_err_config);
+		net_topology_create_fat_tree(net, radix, levels, bandwidth,
+			vc_count);
+		break;
+
+	case net_topology_dragonfly:
+
+		group_size = config_read_int(config, section, "GroupSize", 0);
+		terminals = config_read_int(config, section, "Terminals", 1);
+		global_links = config_read_int(config, section, "GlobalLinks", 1);
+		if (group_size < 1)
+			fatal("%s:%s: GroupSize: invalid/missing value.\n%s",
+				net->name, section, net_err_config);
+		if (terminals < 1 || global_links < 1)
+			fatal("%s:%s: Terminals/GlobalLinks: invalid value.\n%s",
+				net->name, section, net_err_config);
+		net_topology_create_dragonfly(net, group_size, terminals,
+			global_links, bandwidth, vc_count);
+		break;
+
+	default:
+		panic("%s: invalid topology", __FUNCTION__);
+	}
+}
+
+
+/* Ring of 'size' switches 's<i>', each with end node 'n<i>'. Switches have
+ * coordinates (i, 0), so that the ring can be routed as a 1D torus. */
+void net_topology_create_ring(struct net_t *net, int size, int bandwidth,
+	int vc_count)
+{
+	struct net_node_t **switches;
+	int i;
+
+	/* Nodes */
+	switches = xcalloc(size, sizeof(struct net_node_t *));
+	for (i = 0; i < size; i++)
+	{
+		switches[i] = net_topology_add_switch(net, bandwidth, i, 0,
+			"s%d", i);
+		net_topology_add_end_node(net, switches[i], bandwidth,
+			"n%d", i);
+	}
+
+	/* Links. A ring of 2 switches only has one link. */
+	for (i = 0; i < size; i++)
+		if (size > 2 || i < size - 1)
+			net_add_bidirectional_link(net, switches[i],
+				switches[(i + 1) % size], bandwidth,
+				0, 0, vc_count);
+
+	/* Free */
+	free(switches);
+}
+
+
+/* Mesh or torus of 'width' x 'height' switches 's<x>_<y>', each with end
+ * node 'n<x>_<y>'. */
+void net_topology_create_mesh(struct net_t *net, int width, int height,
+	int torus, int bandwidth, int vc_count)
+{
+	struct net_node_t **switches;
+	struct net_node_t *node;
+	struct net_node_t *east;
+	struct net_node_t *north;
+
+	int x;
+	int y;
+
+	/* Nodes */
+	switches = xcalloc(width * height, sizeof(struct net_node_t *));
+	for (y = 0; y < height; y++)
+	{
+		for (x = 0; x < width; x++)
+		{
+			node = net_topology_add_switch(net, bandwidth, x, y,
+				"s%d_%d", x, y);
+			net_topology_add_end_node(net, node, bandwidth,
+				"n%d_%d", x, y);
+			switches[y * width + x] = node;
+		}
+	}
+
+	/* Links to east and north neighbors. Wrap-around links are only
+	 * added for dimensions with more than 2 switches. */
+	for (y = 0; y < height; y++)
+	{
+		for (x = 0; x < width; x++)
+		{
+			node = switches[y * width + x];
+			east = NULL;
+			north = NULL;
+			if (x < width - 1)
+				east = switches[y * width + x + 1];
+			else if (torus && width > 2)
+				east = switches[y * width];
+			if (y < height - 1)
+				north = switches[(y + 1) * width + x];
+			else if (torus && height > 2)
+				north = switches[x];
+			if (east)
+				net_add_bidirectional_link(net, node, east,
+					bandwidth, 0, 0, vc_count);
+			if (north)
+				net_add_bidirectional_link(net, node, north,
+					bandwidth, 0, 0, vc_count);
+		}
+	}
+
+	/* Free */
+	free(switches);
+}
+
+
+/* k-ary n-tree with k = 'radix' and n = 'levels'. There are k^n end nodes
+ * 'n<i>', and 'levels' levels of k^(n-1) switches 's<level>_<i>', level 0
+ * being the leaves. End node 'i' is connected to leaf switch 'i / k'. Switch
+ * 'i' in level 'l' is connected to all switches in level 'l + 1' whose index
+ * only differs from 'i' in base-k digit 'l'. */
+void net_topology_create_fat_tree(struct net_t *net, int radix, int levels,
+	int bandwidth, int vc_count)
+{
+	struct net_node_t **switches;
+
+	long long count;
+	int width;
+	int weight;
+	int digit;
+	int level;
+	int i;
+	int j;
+
+	/* Number of switches per level */
+	count = 1;
+	for (i = 0; i < levels - 1; i++)
+	{
+		count *= radix;
+		if (count * radix > 1 << 20)
+			fatal("%s: fat tree too large", net->name);
+	}
+	width = count;
+
+	/* Switches */
+	switches = xcalloc(levels * width, sizeof(struct net_node_t *));
+	for (level = 0; level < levels; level++)
+		for (i = 0; i < width; i++)
+			switches[level * width + i] = net_topology_add_switch(net,
+				bandwidth, -1, -1, "s%d_%d", level, i);
+
+	/* End nodes */
+	for (i = 0; i < width * radix; i++)
+		net_topology_add_end_node(net, switches[i / radix], bandwidth,
+			"n%d", i);
+
+	/* Links between levels */
+	weight = 1;
+	for (level = 0; level < levels - 1; level++)
+	{
+		for (i = 0; i < width; i++)
+		{
+			digit = i / weight % radix;
+			for (j = 0; j < radix; j++)
+				net_add_bidirectional_link(net,
+					switches[level * width + i],
+					switches[(level + 1) * width + i +
+					(j - digit) * weight], bandwidth,
+					0, 0, vc_count);
+		}
+		weight *= radix;
+	}
+
+	/* Free */
+	free(switches);
+}
+
+
+/* Dragonfly with groups of 'group_size' fully connected routers 's<g>_<r>',
+ * each with 'terminals' end nodes 'n<g>_<r>_<t>' and 'global_links' links
+ * to other groups. There are 'group_size * global_links + 1' groups, and
+ * each pair of groups is connected by exactly one global link. Global port
+ * 'p' of group 'g' connects to group '(g + p + 1) mod G', and belongs to
+ * router 'p / global_links'. */
+void net_topology_create_dragonfly(struct net_t *net, int group_size,
+	int terminals, int global_links, int bandwidth, int vc_count)
+{
+	struct net_node_t **routers;
+
+	int group_count;
+	int group;
+	int dst_group;
+	int port;
+	int dst_port;
+	int i;
+	int j;
+
+	/* Routers and end nodes */
+	group_count = group_size * global_links + 1;
+	routers = xcalloc(group_count * group_size, sizeof(struct net_node_t *));
+	for (group = 0; group < group_count; group++)
+	{
+		for (i = 0; i < group_size; i++)
+		{
+			routers[group * group_size + i] = net_topology_add_switch(
+				net, bandwidth, -1, -1, "s%d_%d", group, i);
+			for (j = 0; j < terminals; j++)
+				net_topology_add_end_node(net,
+					routers[group * group_size + i],
+					bandwidth, "n%d_%d_%d", group, i, j);
+		}
+	}
+
+	/* Local links */
+	for (group = 0; group < group_count; group++)
+		for (i = 0; i < group_size; i++)
+			for (j = i + 1; j < group_size; j++)
+				net_add_bidirectional_link(net,
+					routers[group * group_size + i],
+					routers[group * group_size + j],
+					bandwidth, 0, 0, vc_count);
+
+	/* Global links, added once from the lower-numbered group */
+	for (group = 0; group < group_count; group++)
+	{
+		for (port = 0; port < group_size * global_links; port++)
+		{
+			dst_group = (group + port + 1) % group_count;
+			if (dst_group < group)
+				continue;
+			dst_port = group_count - port - 2;
+			net_add_bidirectional_link(net,
+				routers[group * group_size + port / global_links],
+				routers[dst_group * group_size + dst_port /
+				global_links], bandwidth, 0, 0, vc_count);
+		}
+	}
+
+	/* Free */
+	free(routers);
+}
+
+
+/* Return the end node attached to the switch with coordinates (x, y) in a
+ * generated ring, mesh, or torus, or NULL if there is none. */
+struct net_node_t *net_topology_get_end_node(struct net_t *net, int x, int y)
+{
+	char name[MAX_STRING_SIZE];
+
+	if (net->topology == net_topology_ring && !y)
+		snprintf(name, sizeof name, "n%d", x);
+	else if (net->topology == net_topology_mesh_2d ||
+			net->topology == net_topology_torus_2d)
+		snprintf(name, sizeof name, "n%d_%d", x, y);
+	else
+		return NULL;
+	return net_get_node_by_name(net, name);
+}
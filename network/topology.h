@@ -0,0 +1,58 @@
+/* 
+ *  Multi2Sim
+ *  Copyright (C) 2012  Rafael Ubal (ubal@ece.neu.edu)
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef NETWORK_TOPOLOGY_H
+#define NETWORK_TOPOLOGY_H
+
+#include <lib/util/config.h>
+
+
+/* Topologies that can be generated automatically. Generated switches are
+ * named 's<...>', and generated end nodes are named 'n<...>', where '<...>'
+ * is the position of the node in the topology. */
+extern char *net_topology_map[];
+enum net_topology_t
+{
+	net_topology_custom = 0,
+	net_topology_ring,
+	net_topology_mesh_2d,
+	net_topology_torus_2d,
+	net_topology_fat_tree,
+	net_topology_dragonfly
+};
+
+struct net_t;
+
+void net_topology_create_from_config(struct net_t *net,
+	struct config_t *config, char *section, int bandwidth);
+
+void net_topology_create_ring(struct net_t *net, int size, int bandwidth,
+	int vc_count);
+void net_topology_create_mesh(struct net_t *net, int width, int height,
+	int torus, int bandwidth, int vc_count);
+void net_topology_create_fat_tree(struct net_t *net, int radix, int levels,
+	int bandwidth, int vc_count);
+void net_topology_create_dragonfly(struct net_t *net, int group_size,
+	int terminals, int global_links, int bandwidth, int vc_count);
+
+struct net_node_t *net_topology_get_end_node(struct net_t *net, int x, int y);
+
+
+#endif
+
@@ -0,0 +1,827 @@
+/* 
+ *  Multi2Sim
+ *  Copyright (C) 2012  Rafael Ubal (ubal@ece.neu.edu)
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include <assert.h>
+#include <math.h>
+#include <string.h>
+#include <zlib.h>
+
+#include <lib/esim/esim.h>
+#include <lib/mhandle/mhandle.h>
+#include <lib/util/debug.h>
+#include <lib/util/hash-table.h>
+#include <lib/util/list.h>
+#include <lib/util/misc.h>
+#include <lib/util/string.h>
+
+#include "message.h"
+#include "msg-trace.h"
+#include "net-system.h"
+#include "network.h"
+#include "node.h"
+#include "traffic.h"
+
+
+int EV_NET_TRAFFIC_RECEIVE;
+
+struct str_map_t net_traffic_pattern_map =
+{
+	9, {
+		{ "uniform", net_traffic_pattern_uniform },
+		{ "transpose", net_traffic_pattern_transpose },
+		{ "bitcomp", net_traffic_pattern_bit_complement },
+		{ "bitrev", net_traffic_pattern_bit_reverse },
+		{ "tornado", net_traffic_pattern_tornado },
+		{ "neighbor", net_traffic_pattern_neighbor },
+		{ "hotspot", net_traffic_pattern_hotspot },
+		{ "trace", net_traffic_pattern_trace },
+		{ "command", net_traffic_pattern_command }
+	}
+};
+
+struct str_map_t net_traffic_trace_deps_map =
+{
+	2, {
+		{ "preserved", net_traffic_trace_deps_preserved },
+		{ "relaxed", net_traffic_trace_deps_relaxed }
+	}
+};
+
+/* A load point is considered saturated when the accepted traffic is less
+ * than this fraction of the offered traffic, or when its average latency
+ * exceeds this many times the latency of the first load point. */
+#define NET_TRAFFIC_SATURATION_ACCEPTED  0.9
+#define NET_TRAFFIC_SATURATION_LATENCY  2.0
+
+
+
+
+/* 
+ * Private Functions
+ */
+
+static double exp_random(double lambda)
+{
+	double x = (double) random() / RAND_MAX;
+
+	return log(1 - x) / -lambda;
+}
+
+
+static struct net_node_t *net_traffic_uniform_dst_node(
+	struct net_traffic_t *traffic, struct net_node_t *node)
+{
+	struct net_t *net = traffic->net;
+	struct net_node_t *dst_node;
+
+	do
+	{
+		dst_node = list_get(net->node_list, random() %
+				list_count(net->node_list));
+	} while (dst_node->kind != net_node_end
+			|| dst_node == node);
+	return dst_node;
+}
+
+
+/* Return the destination of the next message injected by 'node', or NULL
+ * if the node does not inject messages in the current pattern. */
+static struct net_node_t *net_traffic_dst_node(struct net_traffic_t *traffic,
+	struct net_node_t *node)
+{
+	int width = traffic->width;
+	int height = traffic->height;
+
+	int index;
+	int dst_index;
+	int x;
+	int y;
+	int i;
+
+	/* Position of node */
+	index = traffic->end_node_index[node->index];
+	x = index % width;
+	y = index / width;
+
+	/* Destination */
+	switch (traffic->pattern)
+	{
+
+	case net_traffic_pattern_uniform:
+
+		return net_traffic_uniform_dst_node(traffic, node);
+
+	case net_traffic_pattern_hotspot:
+
+		if (node != traffic->hotspot_node &&
+				random() < net_hotspot_fraction * RAND_MAX)
+			return traffic->hotspot_node;
+		return net_traffic_uniform_dst_node(traffic, node);
+
+	case net_traffic_pattern_transpose:
+
+		dst_index = x * width + y;
+		break;
+
+	case net_traffic_pattern_bit_complement:
+
+		dst_index = ~index & (traffic->end_node_count - 1);
+		break;
+
+	case net_traffic_pattern_bit_reverse:
+
+		dst_index = 0;
+		for (i = 0; i < traffic->log_end_node_count; i++)
+			dst_index |= ((index >> i) & 1) <<
+				(traffic->log_end_node_count - i - 1);
+		break;
+
+	case net_traffic_pattern_tornado:
+
+		dst_index = (y + (height + 1) / 2 - 1) % height * width +
+			(x + (width + 1) / 2 - 1) % width;
+		break;
+
+	case net_traffic_pattern_neighbor:
+
+		dst_index = (y + 1) % height * width + (x + 1) % width;
+		break;
+
+	default:
+		panic("%s: invalid pattern", __FUNCTION__);
+		return NULL;
+	}
+
+	/* Nodes mapped to themselves do not inject */
+	if (dst_index == index)
+		return NULL;
+	return traffic->end_nodes[dst_index];
+}
+
+
+/* Inject messages following a synthetic pattern, with exponentially
+ * distributed inter-arrival times. Messages that cannot be injected because
+ * the source buffer is full are dropped. */
+static void net_traffic_inject(struct net_traffic_t *traffic, long long cycle,
+	double injection_rate)
+{
+	struct net_t *net = traffic->net;
+	struct net_node_t *node;
+	struct net_node_t *dst_node;
+
+	int i;
+
+	for (i = 0; i < net->node_count; i++)
+	{
+		/* Get end node */
+		node = list_get(net->node_list, i);
+		if (node->kind != net_node_end)
+			continue;
+
+		/* Turn for next injection? */
+		if (traffic->inject_time[i] > cycle)
+			continue;
+
+		/* Get destination node */
+		dst_node = net_traffic_dst_node(traffic, node);
+
+		/* Inject */
+		while (traffic->inject_time[i] < cycle)
+		{
+			traffic->inject_time[i] += exp_random(injection_rate);
+			if (!dst_node)
+				continue;
+			traffic->offered++;
+			if (net_can_send(net, node, dst_node, net_msg_size))
+			{
+				net_send(net, node, dst_node, net_msg_size);
+				traffic->injected++;
+			}
+		}
+	}
+}
+
+
+/* Add a message to the trace */
+static void net_traffic_trace_add(struct net_traffic_t *traffic,
+	long long cycle, struct net_node_t *src_node,
+	struct net_node_t *dst_node, int size, int parent, long long gap)
+{
+	struct net_traffic_msg_t *msg;
+
+	/* Grow array */
+	if (traffic->trace_msg_count == traffic->trace_msg_size)
+	{
+		traffic->trace_msg_size = MAX(1024, traffic->trace_msg_size * 2);
+		traffic->trace_msgs = xrealloc(traffic->trace_msgs,
+			traffic->trace_msg_size *
+			sizeof(struct net_traffic_msg_t));
+	}
+
+	/* Add message */
+	msg = &traffic->trace_msgs[traffic->trace_msg_count++];
+	msg->cycle = cycle;
+	msg->src_node = src_node;
+	msg->dst_node = dst_node;
+	msg->size = size;
+	msg->parent = parent;
+	msg->gap = gap;
+	msg->receive_cycle = -1;
+	msg->msg = NULL;
+}
+
+
+/* Load a text trace. Each line has format '<cycle> <source> <destination>
+ * <size>', where cycles are relative to the beginning of the simulation, and
+ * source and destination are end node names. Empty lines and lines starting
+ * with '#' are ignored. */
+static void net_traffic_trace_load_text(struct net_traffic_t *traffic,
+	gzFile f, char *file_name, struct hash_table_t *node_table)
+{
+	struct net_node_t *src_node;
+	struct net_node_t *dst_node;
+	struct list_t *token_list;
+
+	char line[MAX_STRING_SIZE];
+	char *token;
+
+	long long cycle;
+	long long prev_cycle = 0;
+	int line_num = 0;
+	int size;
+	int err;
+
+	while (gzgets(f, line, sizeof line))
+	{
+		/* Skip empty lines and comments */
+		line_num++;
+		token_list = str_token_list_create(line, " \t\r\n");
+		token = str_token_list_first(token_list);
+		if (!*token || *token == '#')
+		{
+			str_token_list_free(token_list);
+			continue;
+		}
+
+		/* Parse message */
+		if (list_count(token_list) != 4)
+			fatal("%s: line %d: invalid format", file_name, line_num);
+		cycle = str_to_llint(list_get(token_list, 0), &err);
+		if (err || cycle < prev_cycle)
+			fatal("%s: line %d: invalid cycle", file_name, line_num);
+		src_node = hash_table_get(node_table, list_get(token_list, 1));
+		dst_node = hash_table_get(node_table, list_get(token_list, 2));
+		if (!src_node || !dst_node || src_node == dst_node)
+			fatal("%s: line %d: invalid source or destination node",
+				file_name, line_num);
+		size = str_to_int(list_get(token_list, 3), &err);
+		if (err || size < 1)
+			fatal("%s: line %d: invalid message size",
+				file_name, line_num);
+
+		/* Add message */
+		net_traffic_trace_add(traffic, cycle, src_node, dst_node,
+			size, -1, 0);
+		prev_cycle = cycle;
+		str_token_list_free(token_list);
+	}
+}
+
+
+/* Load the messages of the simulated network from a binary trace, as
+ * captured with option '--net-msg-trace'. Nodes are matched by name. */
+static void net_traffic_trace_load_binary(struct net_traffic_t *traffic,
+	gzFile f, char *file_name, struct hash_table_t *node_table)
+{
+	struct net_t *net = traffic->net;
+	struct net_node_t **nodes = NULL;
+	struct net_node_t *src_node;
+	struct net_node_t *dst_node;
+
+	char *net_name;
+	char *node_name;
+
+	long long cycle = 0;
+	long long value[6];
+	long long id;
+
+	int node_count = 0;
+	int kind;
+	int i;
+
+	while ((kind = gzgetc(f)) >= 0)
+	{
+		switch (kind)
+		{
+
+		case net_msg_trace_record_node:
+
+			/* Read node */
+			net_name = NULL;
+			node_name = NULL;
+			if (!net_msg_trace_read_int(f, &id) ||
+					!(net_name = net_msg_trace_read_str(f)) ||
+					!(node_name = net_msg_trace_read_str(f)) ||
+					id != node_count + 1)
+				fatal("%s: corrupted node record", file_name);
+
+			/* Nodes of other networks are mapped to NULL */
+			nodes = xrealloc(nodes, (node_count + 1) *
+				sizeof(struct net_node_t *));
+			nodes[node_count] = NULL;
+			if (!strcasecmp(net_name, net->name))
+			{
+				nodes[node_count] = hash_table_get(node_table,
+					node_name);
+				if (!nodes[node_count])
+					fatal("%s: %s: end node not found in "
+						"network %s", file_name,
+						node_name, net->name);
+			}
+			node_count++;
+			free(net_name);
+			free(node_name);
+			break;
+
+		case net_msg_trace_record_msg:
+
+			/* Read message */
+			for (i = 0; i < 6; i++)
+				if (!net_msg_trace_read_int(f, &value[i]))
+					fatal("%s: corrupted message record",
+						file_name);
+			if (value[1] < 1 || value[1] > node_count ||
+					value[2] < 1 || value[2] > node_count)
+				fatal("%s: invalid node in message record",
+					file_name);
+			cycle += value[0];
+			src_node = nodes[value[1] - 1];
+			dst_node = nodes[value[2] - 1];
+			if (!src_node || !dst_node)
+				break;
+
+			/* Dependence on a previous message of the network */
+			if (value[4] > traffic->trace_msg_count)
+				fatal("%s: invalid message dependence",
+					file_name);
+			net_traffic_trace_add(traffic, cycle, src_node,
+				dst_node, value[3], value[4] ?
+				traffic->trace_msg_count - value[4] : -1,
+				value[5]);
+			break;
+
+		default:
+			fatal("%s: invalid record in message trace",
+				file_name);
+		}
+	}
+
+	/* Free */
+	free(nodes);
+}
+
+
+/* Load trace given in option '--net-traffic-trace', and build a queue of
+ * messages for each end node. */
+static void net_traffic_trace_load(struct net_traffic_t *traffic)
+{
+	struct net_t *net = traffic->net;
+	struct net_traffic_msg_t *msg;
+	struct hash_table_t *node_table;
+
+	char magic[NET_MSG_TRACE_MAGIC_SIZE];
+	char *file_name;
+	gzFile f;
+
+	int count;
+	int index;
+	int err;
+	int i;
+
+	/* Dependences */
+	file_name = net_traffic_trace_file_name;
+	if (!*file_name)
+		fatal("%s: trace traffic requires option "
+			"'--net-traffic-trace'", net->name);
+	traffic->trace_deps = net_traffic_trace_deps_preserved;
+	if (*net_traffic_trace_deps)
+	{
+		traffic->trace_deps = str_map_string_err(
+			&net_traffic_trace_deps_map, net_traffic_trace_deps,
+			&err);
+		if (err)
+			fatal("%s: invalid trace dependences",
+				net_traffic_trace_deps);
+	}
+
+	/* End nodes by name */
+	count = traffic->end_node_count;
+	node_table = hash_table_create(count, 0);
+	for (i = 0; i < count; i++)
+		hash_table_insert(node_table, traffic->end_nodes[i]->name,
+			traffic->end_nodes[i]);
+
+	/* Open trace, which can be compressed */
+	f = gzopen(file_name, "rb");
+	if (!f)
+		fatal("%s: cannot open trace file", file_name);
+	if (gzread(f, magic, sizeof magic) == sizeof magic &&
+			!memcmp(magic, NET_MSG_TRACE_MAGIC, sizeof magic))
+	{
+		net_traffic_trace_load_binary(traffic, f, file_name,
+			node_table);
+	}
+	else
+	{
+		gzrewind(f);
+		net_traffic_trace_load_text(traffic, f, file_name, node_table);
+	}
+	gzclose(f);
+	hash_table_free(node_table);
+	if (!traffic->trace_msg_count)
+		warning("%s: no messages for network %s", file_name,
+			net->name);
+
+	/* Queues */
+	traffic->trace_queue = xcalloc(count, sizeof(int *));
+	traffic->trace_queue_head = xcalloc(count, sizeof(int));
+	traffic->trace_queue_size = xcalloc(count, sizeof(int));
+	for (i = 0; i < traffic->trace_msg_count; i++)
+	{
+		msg = &traffic->trace_msgs[i];
+		traffic->trace_queue_size[traffic->end_node_index[
+			msg->src_node->index]]++;
+	}
+	for (i = 0; i < count; i++)
+	{
+		traffic->trace_queue[i] = xcalloc(traffic->trace_queue_size[i],
+			sizeof(int));
+		traffic->trace_queue_size[i] = 0;
+	}
+	for (i = 0; i < traffic->trace_msg_count; i++)
+	{
+		msg = &traffic->trace_msgs[i];
+		index = traffic->end_node_index[msg->src_node->index];
+		traffic->trace_queue[index][traffic->trace_queue_size[index]++] = i;
+	}
+	traffic->trace_queue_count = traffic->trace_msg_count;
+}
+
+
+/* Return true if a message of the trace can be injected in 'cycle' */
+static int net_traffic_trace_ready(struct net_traffic_t *traffic,
+	struct net_traffic_msg_t *msg, long long cycle)
+{
+	struct net_traffic_msg_t *parent;
+
+	/* Messages without dependences are injected at their cycle, counted
+	 * from the beginning of the simulation as in the captured one */
+	if (msg->parent < 0 || traffic->trace_deps ==
+			net_traffic_trace_deps_relaxed)
+		return msg->cycle <= cycle;
+
+	/* Other messages wait for their parent */
+	parent = &traffic->trace_msgs[msg->parent];
+	return parent->receive_cycle >= 0 &&
+		parent->receive_cycle + msg->gap <= cycle;
+}
+
+
+/* Inject messages from the trace in order for each source node. The function
+ * returns false when all messages in the trace have been injected. */
+static int net_traffic_trace_inject(struct net_traffic_t *traffic,
+	long long cycle)
+{
+	struct net_t *net = traffic->net;
+	struct net_traffic_msg_t *msg;
+
+	int head;
+	int i;
+
+	for (i = 0; i < traffic->end_node_count; i++)
+	{
+		while ((head = traffic->trace_queue_head[i]) <
+				traffic->trace_queue_size[i])
+		{
+			msg = &traffic->trace_msgs[traffic->trace_queue[i][head]];
+			if (!net_traffic_trace_ready(traffic, msg, cycle) ||
+					!net_can_send(net, msg->src_node,
+					msg->dst_node, msg->size))
+				break;
+			msg->msg = net_send_ev(net, msg->src_node,
+				msg->dst_node, msg->size,
+				EV_NET_TRAFFIC_RECEIVE, msg);
+			traffic->trace_queue_head[i]++;
+			traffic->trace_queue_count--;
+			traffic->offered++;
+			traffic->injected++;
+		}
+	}
+
+	/* Continue while there are messages left */
+	return traffic->trace_queue_count;
+}
+
+
+/* Return true if there are messages in flight in the network */
+static int net_traffic_in_flight(struct net_t *net)
+{
+	int i;
+
+	for (i = 0; i < NET_MSG_TABLE_SIZE; i++)
+		if (net->msg_table[i])
+			return 1;
+	return 0;
+}
+
+
+
+
+/* 
+ * Public Functions
+ */
+
+/* Reception of a message injected from a trace */
+void net_traffic_receive_handler(int event, void *data)
+{
+	struct net_traffic_msg_t *msg = data;
+
+	assert(event == EV_NET_TRAFFIC_RECEIVE);
+	assert(msg->receive_cycle < 0);
+	msg->receive_cycle = esim_domain_cycle(net_domain_index);
+	net_receive(msg->msg->net, msg->dst_node, msg->msg);
+	msg->msg = NULL;
+}
+
+
+struct net_traffic_t *net_traffic_create(struct net_t *net,
+	enum net_traffic_pattern_t pattern)
+{
+	struct net_traffic_t *traffic;
+	struct net_node_t *node;
+
+	int count;
+	int i;
+
+	/* Initialize */
+	traffic = xcalloc(1, sizeof(struct net_traffic_t));
+	traffic->net = net;
+	traffic->pattern = pattern;
+	traffic->inject_time = xcalloc(net->node_count, sizeof(double));
+
+	/* End nodes */
+	traffic->end_nodes = xcalloc(net->end_node_count,
+		sizeof(struct net_node_t *));
+	traffic->end_node_index = xcalloc(net->node_count, sizeof(int));
+	for (i = 0; i < net->node_count; i++)
+	{
+		node = list_get(net->node_list, i);
+		traffic->end_node_index[i] = -1;
+		if (node->kind != net_node_end)
+			continue;
+		traffic->end_node_index[i] = traffic->end_node_count;
+		traffic->end_nodes[traffic->end_node_count++] = node;
+	}
+	count = traffic->end_node_count;
+	if (count < 2 && pattern != net_traffic_pattern_command)
+		fatal("%s: at least 2 end nodes needed for synthetic traffic",
+			net->name);
+
+	/* Arrange end nodes in a square grid if possible */
+	traffic->width = count;
+	traffic->height = 1;
+	for (i = 1; i * i <= count; i++)
+	{
+		if (i * i == count)
+		{
+			traffic->width = i;
+			traffic->height = i;
+		}
+	}
+	traffic->log_end_node_count = -1;
+	for (i = 0; i < 31; i++)
+		if (count == 1 << i)
+			traffic->log_end_node_count = i;
+
+	/* Check pattern */
+	if (pattern == net_traffic_pattern_transpose && traffic->height == 1)
+		fatal("%s: transpose traffic requires a square number of end "
+			"nodes", net->name);
+	if ((pattern == net_traffic_pattern_bit_complement ||
+			pattern == net_traffic_pattern_bit_reverse) &&
+			traffic->log_end_node_count < 0)
+		fatal("%s: %s traffic requires a power of 2 end nodes",
+			net->name, str_map_value(&net_traffic_pattern_map,
+			pattern));
+
+	/* Hotspot node */
+	if (pattern == net_traffic_pattern_hotspot)
+	{
+		traffic->hotspot_node = traffic->end_nodes[0];
+		if (*net_hotspot_node_name)
+			traffic->hotspot_node = net_get_node_by_name(net,
+				net_hotspot_node_name);
+		if (!traffic->hotspot_node ||
+				traffic->hotspot_node->kind != net_node_end)
+			fatal("%s: %s: invalid hotspot end node", net->name,
+				net_hotspot_node_name);
+	}
+
+	/* Trace */
+	if (pattern == net_traffic_pattern_trace)
+		net_traffic_trace_load(traffic);
+
+	/* Return */
+	return traffic;
+}
+
+
+void net_traffic_free(struct net_traffic_t *traffic)
+{
+	int i;
+
+	/* Trace */
+	if (traffic->trace_queue)
+		for (i = 0; i < traffic->end_node_count; i++)
+			free(traffic->trace_queue[i]);
+	free(traffic->trace_queue);
+	free(traffic->trace_queue_head);
+	free(traffic->trace_queue_size);
+	free(traffic->trace_msgs);
+
+	/* Free */
+	free(traffic->end_nodes);
+	free(traffic->end_node_index);
+	free(traffic->inject_time);
+	free(traffic);
+}
+
+
+/* Run the simulation for 'cycles' cycles, injecting messages at rate
+ * 'injection_rate' per end node. For trace-driven traffic, the injection rate
+ * is ignored, and the simulation also stops when the trace ends. */
+void net_traffic_run(struct net_traffic_t *traffic, long long cycles,
+	double injection_rate)
+{
+	long long end_cycle;
+	long long cycle;
+
+	/* Simulation loop */
+	cycle = esim_domain_cycle(net_domain_index);
+	end_cycle = cycle + cycles;
+	traffic->offered = 0;
+	traffic->injected = 0;
+	while (1)
+	{
+		/* Get current cycle */
+		cycle = esim_domain_cycle(net_domain_index);
+		if (cycle >= end_cycle)
+			break;
+
+		/* Inject messages */
+		if (traffic->pattern == net_traffic_pattern_trace)
+		{
+			if (!net_traffic_trace_inject(traffic, cycle))
+				break;
+		}
+		else if (traffic->pattern != net_traffic_pattern_command)
+		{
+			net_traffic_inject(traffic, cycle, injection_rate);
+		}
+
+		/* Next cycle */
+		net_debug("___ cycle %lld ___\n", cycle);
+		esim_process_events(TRUE);
+	}
+}
+
+
+/* Simulate without injecting new messages until all messages in flight are
+ * received, or up to 'max_cycles' cycles. The function returns false if
+ * there are messages still in flight, which typically indicates a deadlock. */
+int net_traffic_drain(struct net_traffic_t *traffic, long long max_cycles)
+{
+	struct net_t *net = traffic->net;
+	long long cycle;
+
+	cycle = esim_domain_cycle(net_domain_index);
+	while (net_traffic_in_flight(net))
+	{
+		if (esim_domain_cycle(net_domain_index) >= cycle + max_cycles)
+			return 0;
+		net_debug("___ cycle %lld ___\n",
+			esim_domain_cycle(net_domain_index));
+		esim_process_events(TRUE);
+	}
+	return 1;
+}
+
+
+/* Run one simulation of 'net_max_cycles' cycles for each injection rate in
+ * 'sweep', given as '<first>:<last>:<step>', draining the network in between.
+ * The latency-throughput curve and the saturation point are dumped in 'f'. */
+void net_traffic_sweep(struct net_traffic_t *traffic, char *sweep, FILE *f)
+{
+	struct net_t *net = traffic->net;
+
+	double first;
+	double last;
+	double step;
+	double rate;
+	double offered;
+	double accepted;
+	double latency;
+	double zero_load_latency = 0.0;
+	double saturation_rate = 0.0;
+
+	long long transfers;
+	long long lat_acc;
+	long long cycle;
+
+	int point;
+	int i;
+
+	/* Parse rates */
+	if (sscanf(sweep, "%lf:%lf:%lf", &first, &last, &step) != 3 ||
+			first <= 0.0 || step <= 0.0 || last < first)
+		fatal("%s: invalid injection rate sweep, '<first>:<last>:"
+			"<step>' expected", sweep);
+
+	/* Header */
+	fprintf(f, "[ Network.%s.Sweep ]\n", net->name);
+	fprintf(f, "Pattern = %s\n", str_map_value(&net_traffic_pattern_map,
+		traffic->pattern));
+	fprintf(f, "Cycles = %lld\n", net_max_cycles);
+	fprintf(f, "; Point.<n> = <rate> <offered> <accepted> <latency>\n");
+	fprintf(f, ";   Offered and accepted traffic in messages per end node"
+		" per cycle\n");
+
+	/* Load points */
+	for (point = 0; (rate = first + point * step) <= last + step / 2;
+			point++)
+	{
+		/* Start injecting from current cycle */
+		cycle = esim_domain_cycle(net_domain_index);
+		for (i = 0; i < net->node_count; i++)
+			traffic->inject_time[i] = cycle;
+		transfers = net->transfers;
+		lat_acc = net->lat_acc;
+
+		/* Simulate and drain */
+		net_traffic_run(traffic, net_max_cycles, rate);
+		if (!net_traffic_drain(traffic, net_max_cycles))
+		{
+			warning("%s: network not drained after %lld cycles at "
+				"injection rate %g, possibly deadlocked - sweep "
+				"stopped", net->name, net_max_cycles, rate);
+			if (!saturation_rate)
+				saturation_rate = rate;
+			break;
+		}
+
+		/* Statistics */
+		transfers = net->transfers - transfers;
+		lat_acc = net->lat_acc - lat_acc;
+		offered = (double) traffic->offered / traffic->end_node_count /
+			net_max_cycles;
+		accepted = (double) transfers / traffic->end_node_count /
+			net_max_cycles;
+		latency = transfers ? (double) lat_acc / transfers : 0.0;
+		fprintf(f, "Point.%d = %g %.6f %.6f %.4f\n", point, rate,
+			offered, accepted, latency);
+
+		/* Saturation */
+		if (!point)
+			zero_load_latency = latency;
+		if (!saturation_rate && (accepted < offered *
+				NET_TRAFFIC_SATURATION_ACCEPTED ||
+				latency > zero_load_latency *
+				NET_TRAFFIC_SATURATION_LATENCY))
+			saturation_rate = rate;
+	}
+
+	/* Summary */
+	fprintf(f, "Points = %d\n", point);
+	fprintf(f, "ZeroLoadLatency = %.4f\n", zero_load_latency);
+	if (saturation_rate)
+		fprintf(f, "SaturationRate = %g\n", saturation_rate);
+	else
+		fprintf(f, "SaturationRate = None\n");
+	fprintf(f, "\n");
+}
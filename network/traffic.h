@@ -0,0 +1,125 @@
+/* 
+ *  Multi2Sim
+ *  Copyright (C) 2012  Rafael Ubal (ubal@ece.neu.edu)
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef NETWORK_TRAFFIC_H
+#define NETWORK_TRAFFIC_H
+
+#include <stdio.h>
+
+
+/* Events */
+extern int EV_NET_TRAFFIC_RECEIVE;
+
+
+/* Synthetic traffic patterns for stand-alone network simulation. Patterns
+ * based on the position of a node in the network number end nodes in the
+ * order they were created. If the number of end nodes is a perfect square,
+ * they are arranged in a 2D grid in row-major order. Otherwise, they are
+ * arranged in a 1D ring. */
+extern struct str_map_t net_traffic_pattern_map;
+enum net_traffic_pattern_t
+{
+	net_traffic_pattern_uniform = 0,
+	net_traffic_pattern_transpose,
+	net_traffic_pattern_bit_complement,
+	net_traffic_pattern_bit_reverse,
+	net_traffic_pattern_tornado,
+	net_traffic_pattern_neighbor,
+	net_traffic_pattern_hotspot,
+	net_traffic_pattern_trace,
+	net_traffic_pattern_command
+};
+
+/* Dependences between messages of a trace */
+extern struct str_map_t net_traffic_trace_deps_map;
+enum net_traffic_trace_deps_t
+{
+	net_traffic_trace_deps_preserved = 0,
+	net_traffic_trace_deps_relaxed
+};
+
+/* Message read from a traffic trace */
+struct net_traffic_msg_t
+{
+	long long cycle;
+	struct net_node_t *src_node;
+	struct net_node_t *dst_node;
+	int size;
+
+	/* Index of the message that must be received by the source node before
+	 * this message is sent, or -1, and number of cycles in between */
+	int parent;
+	long long gap;
+
+	/* Cycle when the message was received, or -1 */
+	long long receive_cycle;
+	struct net_msg_t *msg;
+};
+
+struct net_traffic_t
+{
+	struct net_t *net;
+	enum net_traffic_pattern_t pattern;
+
+	/* End nodes, and index of each node among end nodes, or -1 */
+	int end_node_count;
+	struct net_node_t **end_nodes;
+	int *end_node_index;
+
+	/* Logical arrangement of end nodes as a 'width' x 'height' grid */
+	int width;
+	int height;
+	int log_end_node_count;	/* For bit permutations, or -1 */
+
+	/* Hotspot */
+	struct net_node_t *hotspot_node;
+
+	/* Next injection time, one per node */
+	double *inject_time;
+
+	/* Trace-driven traffic. Messages of the trace are loaded in
+	 * 'trace_msgs', and queued in their source node until injected. */
+	enum net_traffic_trace_deps_t trace_deps;
+	struct net_traffic_msg_t *trace_msgs;
+	int trace_msg_count;
+	int trace_msg_size;	/* Allocated elements in 'trace_msgs' */
+	int **trace_queue;	/* Message indices, per end node */
+	int *trace_queue_head;
+	int *trace_queue_size;
+	int trace_queue_count;	/* Messages not injected yet */
+
+	/* Messages offered and injected in the current run */
+	long long offered;
+	long long injected;
+};
+
+struct net_traffic_t *net_traffic_create(struct net_t *net,
+	enum net_traffic_pattern_t pattern);
+void net_traffic_free(struct net_traffic_t *traffic);
+
+void net_traffic_receive_handler(int event, void *data);
+
+void net_traffic_run(struct net_traffic_t *traffic, long long cycles,
+	double injection_rate);
+int net_traffic_drain(struct net_traffic_t *traffic, long long max_cycles);
+void net_traffic_sweep(struct net_traffic_t *traffic, char *sweep, FILE *f);
+
+
+#endif
+
@@ -0,0 +1,529 @@
+/*
+ *  Multi2Sim
+ *  Copyright (C) 2012  Rafael Ubal (ubal@ece.neu.edu)
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+
+#include <dirent.h>
+#include <fcntl.h>
+#include <string.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include <arch/x86/emu/context.h>
+#include <arch/x86/emu/emu.h>
+#include <arch/x86/emu/file-desc.h>
+#include <arch/x86/timing/cpu.h>
+#include <lib/esim/esim.h>
+#include <lib/mhandle/mhandle.h>
+#include <lib/util/config.h>
+#include <lib/util/debug.h>
+#include <lib/util/file.h>
+#include <lib/util/list.h>
+#include <lib/util/misc.h>
+#include <lib/util/string.h>
+#include <mem-system/config.h>
+#include <mem-system/mem-system.h>
+
+#include "sweep.h"
+
+
+/*
+ * Global Variables
+ */
+
+char *sweep_file_name = "";
+char *sweep_report_file_name = "";
+char *sweep_summary_file_name = "";
+
+
+
+
+/*
+ * Private Variables
+ */
+
+struct sweep_config_t
+{
+	char *name;
+	char *x86_config_file_name;
+	char *mem_config_file_name;
+
+	/* Child process */
+	pid_t pid;
+	int status;
+	long long start_time;
+	long long end_time;
+};
+
+/* List of configurations, of type 'struct sweep_config_t' */
+static struct list_t *sweep_config_list;
+
+/* Host file open by a guest program at the fork point. Children share the
+ * open file descriptions of the parent, and thus their offsets, so each child
+ * opens the file again and places it on the same host descriptor. */
+struct sweep_file_t
+{
+	int host_fd;
+	int flags;
+	off_t offset;
+
+	/* Path to open the file again, or NULL for a redirected guest
+	 * standard output, which gets a separate file for each child. */
+	char *path;
+};
+
+/* List of files, of type 'struct sweep_file_t' */
+static struct list_t *sweep_file_list;
+
+static long long sweep_fast_forward;
+static int sweep_jobs;
+
+/* Directory for the summaries, reports, and output of the children */
+static char sweep_dir[MAX_PATH_SIZE];
+
+
+
+
+/*
+ * Private Functions
+ */
+
+static void sweep_read_config(void)
+{
+	struct sweep_config_t *sweep_config;
+	struct config_t *config;
+
+	char *section;
+	char *name;
+
+	char name_trimmed[MAX_STRING_SIZE];
+
+	/* Open file */
+	config = config_create(sweep_file_name);
+	if (!file_can_open_for_read(sweep_file_name))
+		fatal("%s: cannot open sweep file", sweep_file_name);
+	config_load(config);
+
+	/* General section */
+	section = "General";
+	sweep_fast_forward = config_read_llint(config, section, "FastForward", 0);
+	if (sweep_fast_forward < 0)
+		fatal("%s: invalid value for 'FastForward'", sweep_file_name);
+	sweep_jobs = config_read_int(config, section, "Jobs",
+			sysconf(_SC_NPROCESSORS_ONLN));
+	if (sweep_jobs < 1)
+		fatal("%s: invalid value for 'Jobs'", sweep_file_name);
+
+	/* Configurations */
+	sweep_config_list = list_create();
+	for (section = config_section_first(config); section;
+			section = config_section_next(config))
+	{
+		/* Discard if not a configuration section */
+		if (!strcasecmp(section, "General"))
+			continue;
+		if (strncasecmp(section, "Config ", 7))
+			fatal("%s: invalid section [%s]", sweep_file_name, section);
+
+		/* Name, used in file names and section names of the summary */
+		name = section + 7;
+		str_trim(name_trimmed, sizeof name_trimmed, name);
+		if (!name_trimmed[0] || strpbrk(name_trimmed, "/[]. \t"))
+			fatal("%s: section [%s]: invalid configuration name",
+					sweep_file_name, section);
+
+		/* Create */
+		sweep_config = xcalloc(1, sizeof(struct sweep_config_t));
+		sweep_config->name = xstrdup(name_trimmed);
+		sweep_config->x86_config_file_name = xstrdup(config_read_string(config,
+				section, "X86Config", x86_config_file_name));
+		sweep_config->mem_config_file_name = xstrdup(config_read_string(config,
+				section, "MemConfig", mem_config_file_name));
+		list_add(sweep_config_list, sweep_config);
+	}
+	if (!list_count(sweep_config_list))
+		fatal("%s: no [Config <name>] sections", sweep_file_name);
+
+	/* Close */
+	config_check(config);
+	config_free(config);
+}
+
+
+/* Path of a file of a child process */
+static char *sweep_path(struct sweep_config_t *sweep_config, char *suffix)
+{
+	static char path[MAX_PATH_SIZE];
+
+	snprintf(path, sizeof path, "%s/%s.%s", sweep_dir,
+			sweep_config->name, suffix);
+	return path;
+}
+
+
+/* Record the host files open by the guest programs, with their current
+ * offsets. Files that cannot be made private to each child are rejected. */
+static void sweep_save_files(void)
+{
+	struct x86_file_desc_table_t *table;
+	struct x86_file_desc_t *desc;
+	struct sweep_file_t *file;
+	X86Context *ctx;
+
+	char path[MAX_PATH_SIZE];
+	int i;
+	int j;
+
+	sweep_file_list = list_create();
+	for (ctx = x86_emu->context_list_head; ctx; ctx = ctx->context_list_next)
+	{
+		table = ctx->file_desc_table;
+		LIST_FOR_EACH(table->file_desc_list, i)
+		{
+			/* Host standard input and output are shared with the
+			 * parent, except that children write to their log. */
+			desc = list_get(table->file_desc_list, i);
+			if (!desc || desc->host_fd < 0 || (desc->kind == file_desc_std &&
+					desc->host_fd == desc->guest_fd))
+				continue;
+
+			/* Pipes and sockets cannot be duplicated */
+			if (desc->kind == file_desc_pipe || desc->kind == file_desc_socket)
+				fatal("%s: guest file descriptor %d of context %d is a "
+					"pipe or socket.\n\tConfiguration sweeps do not "
+					"support them at the fast-forward point.",
+					sweep_file_name, desc->guest_fd, ctx->pid);
+
+			/* Contents written by one child would be visible to the
+			 * others. */
+			if (desc->kind == file_desc_regular &&
+					(desc->flags & O_ACCMODE) != O_RDONLY)
+				fatal("%s: file '%s' is open for writing by context %d.\n"
+					"\tConfiguration sweeps do not support it at the "
+					"fast-forward point.", sweep_file_name,
+					desc->path, ctx->pid);
+
+			/* Descriptor already recorded for another context sharing
+			 * the table, or for the guest standard error. */
+			LIST_FOR_EACH(sweep_file_list, j)
+			{
+				file = list_get(sweep_file_list, j);
+				if (file->host_fd == desc->host_fd)
+					break;
+			}
+			if (j < list_count(sweep_file_list))
+				continue;
+
+			/* Record file. A redirected guest standard input has no
+			 * path in its descriptor, and is opened through '/proc'. */
+			file = xcalloc(1, sizeof(struct sweep_file_t));
+			file->host_fd = desc->host_fd;
+			file->flags = desc->flags & ~(O_CREAT | O_EXCL | O_NOCTTY | O_TRUNC);
+			file->offset = lseek(desc->host_fd, 0, SEEK_CUR);
+			if (desc->kind == file_desc_std && desc->guest_fd)
+				file->path = NULL;
+			else if (desc->kind == file_desc_std)
+			{
+				snprintf(path, sizeof path, "/proc/self/fd/%d", desc->host_fd);
+				file->path = xstrdup(path);
+				file->flags = O_RDONLY;
+			}
+			else
+				file->path = xstrdup(desc->path);
+			if (file->path && file->offset < 0)
+				fatal("%s: cannot get offset of guest file '%s'",
+					sweep_file_name, file->path);
+			list_add(sweep_file_list, file);
+		}
+	}
+}
+
+
+/* Open again the files recorded in 'sweep_file_list' on their host file
+ * descriptors, so that the child does not share their offsets. */
+static void sweep_open_files(struct sweep_config_t *sweep_config)
+{
+	struct sweep_file_t *file;
+
+	int fd;
+	int i;
+
+	LIST_FOR_EACH(sweep_file_list, i)
+	{
+		file = list_get(sweep_file_list, i);
+		if (!file->path)
+		{
+			fd = open(sweep_path(sweep_config, "stdout"), O_WRONLY |
+					O_CREAT | O_TRUNC, 0644);
+			if (fd < 0)
+				fatal("%s: cannot create file",
+					sweep_path(sweep_config, "stdout"));
+		}
+		else
+		{
+			fd = open(file->path, file->flags);
+			if (fd < 0)
+				fatal("%s: cannot open guest file again", file->path);
+			if (lseek(fd, file->offset, SEEK_SET) != file->offset)
+				fatal("%s: cannot restore offset of guest file",
+					file->path);
+		}
+		if (dup2(fd, file->host_fd) < 0)
+			fatal("%s: cannot duplicate file descriptor", __FUNCTION__);
+		close(fd);
+	}
+}
+
+
+/* Child process. Output goes to a log file, files open by the guest programs
+ * are made private, and the file names of the configuration and reports are
+ * set. */
+static void sweep_child(struct sweep_config_t *sweep_config)
+{
+	int fd;
+
+	fd = open(sweep_path(sweep_config, "log"), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+	if (fd < 0)
+		fatal("%s: cannot create file", sweep_path(sweep_config, "log"));
+	dup2(fd, 1);
+	dup2(fd, 2);
+	close(fd);
+	sweep_open_files(sweep_config);
+
+	x86_config_file_name = sweep_config->x86_config_file_name;
+	mem_config_file_name = sweep_config->mem_config_file_name;
+	x86_cpu_report_file_name = xstrdup(sweep_path(sweep_config, "x86"));
+	mem_report_file_name = xstrdup(sweep_path(sweep_config, "mem"));
+	sweep_summary_file_name = xstrdup(sweep_path(sweep_config, "summary"));
+}
+
+
+/* Copy a report of a child into the summary, adding a prefix to the name of
+ * every section. Missing reports are skipped. */
+static void sweep_copy_report(FILE *f, char *file_name, char *prefix)
+{
+	FILE *report;
+
+	char line[MAX_LONG_STRING_SIZE];
+	char section[MAX_LONG_STRING_SIZE];
+	char *end;
+
+	report = fopen(file_name, "r");
+	if (!report)
+		return;
+	while (fgets(line, sizeof line, report))
+	{
+		end = strchr(line, ']');
+		if (line[0] != '[' || !end)
+		{
+			fputs(line, f);
+			continue;
+		}
+		*end = '\0';
+		str_trim(section, sizeof section, line + 1);
+		fprintf(f, "[ %s.%s ]\n", prefix, section);
+	}
+	fclose(report);
+	fprintf(f, "\n");
+}
+
+
+static void sweep_dump_summary(FILE *f, long long fast_forward_time)
+{
+	struct sweep_config_t *sweep_config;
+
+	char prefix[MAX_STRING_SIZE];
+	int i;
+
+	/* General */
+	fprintf(f, ";\n");
+	fprintf(f, "; Configuration Sweep Summary\n");
+	fprintf(f, ";\n");
+	fprintf(f, "\n");
+	fprintf(f, "[ Sweep ]\n");
+	fprintf(f, "File = %s\n", sweep_file_name);
+	fprintf(f, "Configurations = %d\n", list_count(sweep_config_list));
+	fprintf(f, "FastForwardInstructions = %lld\n", asEmu(x86_emu)->instructions);
+	fprintf(f, "FastForwardTime = %.2f [s]\n", fast_forward_time / 1.0e6);
+	fprintf(f, "RealTime = %.2f [s]\n", esim_real_time() / 1.0e6);
+	fprintf(f, "\n");
+
+	/* Configurations */
+	LIST_FOR_EACH(sweep_config_list, i)
+	{
+		sweep_config = list_get(sweep_config_list, i);
+		fprintf(f, "[ %s ]\n", sweep_config->name);
+		fprintf(f, "X86Config = %s\n", sweep_config->x86_config_file_name);
+		fprintf(f, "MemConfig = %s\n", sweep_config->mem_config_file_name);
+		fprintf(f, "Succeeded = %s\n", sweep_config->status ? "f" : "t");
+		fprintf(f, "RealTime = %.2f [s]\n", (sweep_config->end_time -
+				sweep_config->start_time) / 1.0e6);
+		fprintf(f, "\n");
+
+		snprintf(prefix, sizeof prefix, "%s.Summary", sweep_config->name);
+		sweep_copy_report(f, sweep_path(sweep_config, "summary"), prefix);
+		snprintf(prefix, sizeof prefix, "%s.X86Report", sweep_config->name);
+		sweep_copy_report(f, sweep_path(sweep_config, "x86"), prefix);
+		snprintf(prefix, sizeof prefix, "%s.MemReport", sweep_config->name);
+		sweep_copy_report(f, sweep_path(sweep_config, "mem"), prefix);
+	}
+}
+
+
+
+
+/*
+ * Public Functions
+ */
+
+void sweep_run(void)
+{
+	struct sweep_config_t *sweep_config;
+	struct sweep_file_t *file;
+	struct dirent *entry;
+	DIR *dir;
+	FILE *f;
+
+	long long fast_forward_time;
+
+	int num_running;
+	int num_failed;
+	int status;
+	int next;
+	int i;
+
+	pid_t pid;
+
+	/* Read sweep file */
+	sweep_read_config();
+
+	/* Summary file, checked before simulating */
+	f = stderr;
+	if (*sweep_report_file_name)
+	{
+		f = file_open_for_write(sweep_report_file_name);
+		if (!f)
+			fatal("%s: cannot open sweep report", sweep_report_file_name);
+	}
+
+	/* Fast-forward emulation, shared by all configurations */
+	while (asEmu(x86_emu)->instructions < sweep_fast_forward && !esim_finish &&
+			X86EmuRun(asEmu(x86_emu)))
+		;
+	if (esim_finish)
+		warning("x86 emulation finished before the end of the "
+				"fast-forward in the configuration sweep");
+	fast_forward_time = esim_real_time();
+	sweep_save_files();
+
+	/* Directory for files of children */
+	snprintf(sweep_dir, sizeof sweep_dir, "/tmp/m2s-sweep-XXXXXX");
+	if (!mkdtemp(sweep_dir))
+		fatal("%s: cannot create directory", sweep_dir);
+
+	/* Run children, with up to 'sweep_jobs' at a time */
+	next = 0;
+	num_running = 0;
+	num_failed = 0;
+	while (next < list_count(sweep_config_list) || num_running)
+	{
+		/* Start child */
+		if (next < list_count(sweep_config_list) && num_running < sweep_jobs)
+		{
+			sweep_config = list_get(sweep_config_list, next++);
+			sweep_config->start_time = esim_real_time();
+			fflush(NULL);
+			pid = fork();
+			if (pid < 0)
+				fatal("%s: cannot create process", __FUNCTION__);
+			if (!pid)
+			{
+				sweep_child(sweep_config);
+				return;
+			}
+			sweep_config->pid = pid;
+			num_running++;
+			continue;
+		}
+
+		/* Wait for a child */
+		pid = wait(&status);
+		if (pid < 0)
+			fatal("%s: error waiting for child process", __FUNCTION__);
+		LIST_FOR_EACH(sweep_config_list, i)
+		{
+			sweep_config = list_get(sweep_config_list, i);
+			if (sweep_config->pid != pid)
+				continue;
+			sweep_config->end_time = esim_real_time();
+			sweep_config->status = !WIFEXITED(status) || WEXITSTATUS(status);
+			if (sweep_config->status)
+			{
+				warning("configuration '%s' failed.\n"
+					"\tPlease see the output of its simulation in '%s'.",
+					sweep_config->name, sweep_path(sweep_config, "log"));
+				num_failed++;
+			}
+			num_running--;
+		}
+	}
+
+	/* Summary */
+	sweep_dump_summary(f, fast_forward_time);
+	if (f != stderr)
+		file_close(f);
+
+	/* Remove files of children, unless any failed */
+	if (!num_failed)
+	{
+		dir = opendir(sweep_dir);
+		while (dir && (entry = readdir(dir)))
+		{
+			if (entry->d_name[0] == '.')
+				continue;
+			snprintf(sweep_dir + strlen(sweep_dir), sizeof sweep_dir -
+					strlen(sweep_dir), "/%s", entry->d_name);
+			unlink(sweep_dir);
+			*strrchr(sweep_dir, '/') = '\0';
+		}
+		if (dir)
+			closedir(dir);
+		rmdir(sweep_dir);
+	}
+
+	/* Free */
+	while (list_count(sweep_config_list))
+	{
+		sweep_config = list_pop(sweep_config_list);
+		free(sweep_config->name);
+		free(sweep_config->x86_config_file_name);
+		free(sweep_config->mem_config_file_name);
+		free(sweep_config);
+	}
+	list_free(sweep_config_list);
+	while (list_count(sweep_file_list))
+	{
+		file = list_pop(sweep_file_list);
+		free(file->path);
+		free(file);
+	}
+	list_free(sweep_file_list);
+
+	/* End */
+	exit(num_failed ? 1 : 0);
+}
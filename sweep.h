@@ -0,0 +1,73 @@
+/*
+ *  Multi2Sim
+ *  Copyright (C) 2012  Rafael Ubal (ubal@ece.neu.edu)
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+
+#ifndef SWEEP_H
+#define SWEEP_H
+
+
+/*
+ * Configuration sweep, run with option '--sweep <file>'. The x86 programs are
+ * loaded (or a checkpoint restored) and emulated up to the fast-forward point
+ * only once. The process is then forked into one child per configuration,
+ * which continues with the detailed simulation of the warmed-up state. The
+ * parent process waits for all children and collects their statistics
+ * summaries and reports into a single file.
+ *
+ * The sweep file follows the IniFile format:
+ *
+ *	[ General ]
+ *	FastForward = <num_inst>  (Default = 0)
+ *	Jobs = <num>  (Default = number of host processors)
+ *
+ *	[ Config <name> ]
+ *	X86Config = <file>  (Default = file given in option '--x86-config')
+ *	MemConfig = <file>  (Default = file given in option '--mem-config')
+ *
+ * Since the programs are loaded before forking, all configurations must use
+ * the number of x86 cores and threads of the file given in option
+ * '--x86-config', and the default MMU page size. The fast-forward of a configuration is the
+ * largest of 'FastForward' in the sweep file and in its x86 configuration.
+ *
+ * Files open by the x86 programs at the fork point are opened again by each
+ * child at the same offset. A redirected standard output of a program goes to
+ * a separate file for each child. Files open for writing, pipes, and sockets
+ * are not supported at the fork point.
+ *
+ * In the summary, each configuration has a section '[ <name> ]', and the
+ * sections of its statistics summary, x86 pipeline report, and memory
+ * hierarchy report are prefixed with '<name>.Summary.', '<name>.X86Report.',
+ * and '<name>.MemReport.', respectively.
+ */
+
+extern char *sweep_file_name;
+extern char *sweep_report_file_name;
+
+/* In a child process, file for the statistics summary of the simulation */
+extern char *sweep_summary_file_name;
+
+/* Emulate up to the fast-forward point and fork the children. This function
+ * returns only in the child processes, with the configuration and report
+ * files of the x86 pipeline and the memory hierarchy set for their
+ * configuration. The parent process writes the summary and exits. */
+void sweep_run(void);
+
+
+#endif
+
@@ -59,7 +59,7 @@ static void vi_cycle_bar_go_to_cycle(long long cycle)
 
 	/* Adjust cycle range */
 	num_cycles = vi_state_get_num_cycles();
-	cycle = MAX(0, cycle);
+	cycle = MAX(vi_state_get_first_cycle(), cycle);
 	cycle = MIN(cycle, num_cycles);
 
 	/* Write new cycle in text entry */
@@ -208,7 +208,8 @@ void vi_cycle_bar_init(vi_cycle_bar_refresh_func_t refresh_func, void *user_data
 
 	/* Scale */
 	long long num_cycles = vi_state_get_num_cycles();
-	GtkWidget *scale = gtk_scale_new_with_range(GTK_ORIENTATION_HORIZONTAL, 0, num_cycles, 1);
+	GtkWidget *scale = gtk_scale_new_with_range(GTK_ORIENTATION_HORIZONTAL,
+		vi_state_get_first_cycle(), num_cycles, 1);
 	gtk_widget_set_size_request(scale, 100, 32);
 	gtk_scale_set_draw_value(GTK_SCALE(scale), FALSE);
 	g_signal_connect(G_OBJECT(scale), "change-value", G_CALLBACK(vi_cycle_bar_change_value_event), vi_cycle_bar);
@@ -18,6 +18,7 @@
  */
 
 #include <gtk/gtk.h>
+#include <unistd.h>
 
 #include <lib/mhandle/mhandle.h>
 #include <lib/util/debug.h>
@@ -43,20 +44,22 @@ struct vi_state_checkpoint_t
 	long long cycle;
 
 	/* Position in files */
-	long int unzipped_trace_file_offset;
+	int chunk;
+	long int chunk_offset;
 	long int checkpoint_file_offset;
 };
 
 
 struct vi_state_checkpoint_t *vi_state_checkpoint_create(long long cycle,
-	long int unzipped_trace_file_offset, long int checkpoint_file_offset)
+	int chunk, long int chunk_offset, long int checkpoint_file_offset)
 {
 	struct vi_state_checkpoint_t *checkpoint;
 
 	/* Initialize */
 	checkpoint = xcalloc(1, sizeof(struct vi_state_checkpoint_t));
 	checkpoint->cycle = cycle;
-	checkpoint->unzipped_trace_file_offset = unzipped_trace_file_offset;
+	checkpoint->chunk = chunk;
+	checkpoint->chunk_offset = chunk_offset;
 	checkpoint->checkpoint_file_offset = checkpoint_file_offset;
 	
 	/* Return */
@@ -155,18 +158,47 @@ void vi_state_category_free(struct vi_state_category_t *category)
  * State File
  */
 
+/* Number of uncompressed chunks of an indexed trace kept in temporary files */
+#define VI_STATE_CHUNK_CACHE_SIZE  4
+
+struct vi_state_chunk_file_t
+{
+	/* Index of the uncompressed chunk, or -1 if empty */
+	int chunk;
+
+	/* Value of 'chunk_access' on the last access, used to evict the least
+	 * recently used chunk. */
+	long long last_access;
+
+	char *name;
+	FILE *f;
+};
+
 struct vi_state_t
 {
-	/* Uncompressed trace file */
-	char *unzipped_trace_file_name;
-	FILE *unzipped_trace_file;
+	/* Trace. Indexed traces are kept open to load chunks on demand. */
+	struct vi_trace_t *trace;
+	int num_chunks;
+
+	/* Uncompressed lines of recently used chunks of an indexed trace, or
+	 * of the whole trace in the first entry otherwise (one single chunk).
+	 * Field 'chunk_file' points to the file of the last loaded chunk. */
+	struct vi_state_chunk_file_t chunk_file_cache[VI_STATE_CHUNK_CACHE_SIZE];
+	long long chunk_access;
+	FILE *chunk_file;
+
+	/* Position of the next trace line to process */
+	int chunk;
+	long int chunk_offset;
 
 	/* Checkpoint file */
 	char *checkpoint_file_name;
 	FILE *checkpoint_file;
 
-	/* Cycles */
+	/* Cycles. The trace may start at a cycle other than 0 if it was
+	 * generated with trace windows. */
 	long long cycle;
+	long long first_cycle;
 	long long num_cycles;
 
 	/* List of categories */
@@ -185,6 +217,7 @@ struct vi_state_t
 
 	/* Enumeration of body trace lines */
 	struct vi_trace_line_t *body_trace_line;
+	int body_trace_line_chunk;
 	long int body_trace_line_offset;
 };
 
@@ -192,6 +225,31 @@ struct vi_state_t
 static struct vi_state_t *vi_state;
 
 
+/* Return the index of the last checkpoint taken at or before 'cycle', or the
+ * first checkpoint if 'cycle' precedes all of them. */
+static int vi_state_find_checkpoint(long long cycle)
+{
+	struct vi_state_checkpoint_t *checkpoint;
+
+	int low;
+	int high;
+	int mid;
+
+	low = 0;
+	high = list_count(vi_state->checkpoint_list) - 1;
+	while (low < high)
+	{
+		mid = (low + high + 1) / 2;
+		checkpoint = list_get(vi_state->checkpoint_list, mid);
+		if (checkpoint->cycle <= cycle)
+			low = mid;
+		else
+			high = mid - 1;
+	}
+	return low;
+}
+
+
 static void vi_state_read_checkpoint(int index)
 {
 	struct vi_state_checkpoint_t *checkpoint;
@@ -205,7 +263,8 @@ static void vi_state_read_checkpoint(int index)
 
 	/* Set file positions */
 	fseek(vi_state->checkpoint_file, checkpoint->checkpoint_file_offset, SEEK_SET);
-	fseek(vi_state->unzipped_trace_file, checkpoint->unzipped_trace_file_offset, SEEK_SET);
+	vi_state->chunk = checkpoint->chunk;
+	vi_state->chunk_offset = checkpoint->chunk_offset;
 	vi_state->cycle = checkpoint->cycle;
 
 	/* Read checkpoint for every category */
@@ -218,11 +277,20 @@ static void vi_state_read_checkpoint(int index)
 }
 
 
-static void vi_state_write_checkpoint(void)
+/* Store the current state as a checkpoint for 'cycle', taken before the trace
+ * line at position 'chunk' and 'chunk_offset'. */
+static void vi_state_write_checkpoint(long long cycle, int chunk, long int chunk_offset)
 {
+	struct vi_state_checkpoint_t *checkpoint;
 	struct vi_state_category_t *category;
 	int i;
 
+	/* Checkpoints are appended to the checkpoint file */
+	fseek(vi_state->checkpoint_file, 0, SEEK_END);
+	checkpoint = vi_state_checkpoint_create(cycle, chunk, chunk_offset,
+		ftell(vi_state->checkpoint_file));
+	list_add(vi_state->checkpoint_list, checkpoint);
+
 	/* Write checkpoint for every category */
 	LIST_FOR_EACH(vi_state->category_list, i)
 	{
@@ -233,6 +301,97 @@ static void vi_state_write_checkpoint(void)
 }
 
 
+/* Make the uncompressed lines of a chunk available in 'vi_state->chunk_file'.
+ * Chunks of an indexed trace are uncompressed into the temporary file of the
+ * least recently used entry of the chunk cache, unless they are cached. */
+static void vi_state_load_chunk(int chunk)
+{
+	struct vi_state_chunk_file_t *chunk_file;
+	struct vi_state_chunk_file_t *lru_chunk_file;
+	struct vi_trace_line_t *trace_line;
+
+	char buf[MAX_STRING_SIZE];
+	int i;
+
+	if (chunk < 0 || chunk >= vi_state->num_chunks)
+		panic("%s: invalid chunk", __FUNCTION__);
+
+	/* Already loaded */
+	lru_chunk_file = NULL;
+	vi_state->chunk_access++;
+	for (i = 0; i < VI_STATE_CHUNK_CACHE_SIZE; i++)
+	{
+		chunk_file = &vi_state->chunk_file_cache[i];
+		if (chunk_file->chunk == chunk)
+		{
+			chunk_file->last_access = vi_state->chunk_access;
+			vi_state->chunk_file = chunk_file->f;
+			return;
+		}
+		if (!lru_chunk_file || chunk_file->last_access < lru_chunk_file->last_access)
+			lru_chunk_file = chunk_file;
+	}
+
+	/* Create the temporary file of the evicted entry on first use, or
+	 * empty it otherwise. */
+	chunk_file = lru_chunk_file;
+	if (!chunk_file->f)
+	{
+		chunk_file->f = file_create_temp(buf, sizeof buf);
+		chunk_file->name = xstrdup(buf);
+	}
+	else
+	{
+		fflush(chunk_file->f);
+		if (ftruncate(fileno(chunk_file->f), 0))
+			fatal("%s: cannot truncate temporary file", __FUNCTION__);
+		rewind(chunk_file->f);
+	}
+
+	/* Copy lines up to the first line of the next chunk */
+	vi_trace_seek_chunk(vi_state->trace, chunk);
+	while ((trace_line = vi_trace_line_create_from_trace(vi_state->trace)))
+	{
+		if (vi_trace_get_chunk(vi_state->trace) != chunk)
+		{
+			vi_trace_line_free(trace_line);
+			break;
+		}
+		vi_trace_line_dump(trace_line, chunk_file->f);
+		vi_trace_line_free(trace_line);
+	}
+	chunk_file->chunk = chunk;
+	chunk_file->last_access = vi_state->chunk_access;
+	vi_state->chunk_file = chunk_file->f;
+}
+
+
+/* Read the trace line at position 'chunk' and 'offset', and update the
+ * position to that of the next line. Return NULL at the end of the trace. */
+static struct vi_trace_line_t *vi_state_read_trace_line(int *chunk, long int *offset)
+{
+	struct vi_trace_line_t *trace_line;
+
+	for (;;)
+	{
+		vi_state_load_chunk(*chunk);
+		fseek(vi_state->chunk_file, *offset, SEEK_SET);
+		trace_line = vi_trace_line_create_from_file(vi_state->chunk_file);
+		if (trace_line)
+		{
+			*offset = ftell(vi_state->chunk_file);
+			return trace_line;
+		}
+
+		/* End of chunk */
+		if (*chunk + 1 >= vi_state->num_chunks)
+			return NULL;
+		++*chunk;
+		*offset = 0;
+	}
+}
+
+
 void vi_state_init(char *trace_file_name)
 {
 	struct vi_trace_t *trace_file;
@@ -241,13 +400,14 @@ void vi_state_init(char *trace_file_name)
 	int num_trace_lines;
 
 	char buf[MAX_STRING_SIZE];
+	int i;
 
 	/* Create */
 	vi_state = xcalloc(1, sizeof(struct vi_state_t));
-	
-	/* Create uncompressed trace file */
-	vi_state->unzipped_trace_file = file_create_temp(buf, sizeof buf);
-	vi_state->unzipped_trace_file_name = xstrdup(buf);
+
+	/* Empty chunk cache. Temporary files are created on first use. */
+	for (i = 0; i < VI_STATE_CHUNK_CACHE_SIZE; i++)
+		vi_state->chunk_file_cache[i].chunk = -1;
 
 	/* Create checkpoint file */
 	vi_state->checkpoint_file = file_create_temp(buf, sizeof buf);
@@ -258,15 +418,38 @@ void vi_state_init(char *trace_file_name)
 	vi_state->category_list = list_create();
 	vi_state->command_table = hash_table_create(0, FALSE);
 
-	/* Unpack trace */
-	num_trace_lines = 0;
+	/* Indexed trace. Chunks are uncompressed when first accessed. */
 	trace_file = vi_trace_create(trace_file_name);
+	vi_state->num_chunks = vi_trace_get_num_chunks(trace_file);
+	if (vi_state->num_chunks)
+	{
+		vi_state->trace = trace_file;
+		vi_state->first_cycle = MAX(vi_trace_get_chunk_cycle(trace_file, 0), 0);
+		vi_state->num_cycles = MAX(vi_trace_get_last_cycle(trace_file), 0);
+		printf("Trace index loaded (%d chunks, %lld cycles)\n",
+			vi_state->num_chunks, vi_state->num_cycles);
+		fflush(stdout);
+		return;
+	}
+
+	/* Unpack trace with no index as one single chunk */
+	num_trace_lines = 0;
+	vi_state->num_chunks = 1;
+	vi_state->first_cycle = -1;
+	vi_state->chunk_file = file_create_temp(buf, sizeof buf);
+	vi_state->chunk_file_cache[0].chunk = 0;
+	vi_state->chunk_file_cache[0].name = xstrdup(buf);
+	vi_state->chunk_file_cache[0].f = vi_state->chunk_file;
 	while ((trace_line = vi_trace_line_create_from_trace(trace_file)))
 	{
 		/* Copy trace */
-		vi_trace_line_dump(trace_line, vi_state->unzipped_trace_file);
+		vi_trace_line_dump(trace_line, vi_state->chunk_file);
 		if (!strcmp(vi_trace_line_get_command(trace_line), "c"))
+		{
 			vi_state->num_cycles = vi_trace_line_get_symbol_long_long(trace_line, "clk");
+			if (vi_state->first_cycle < 0)
+				vi_state->first_cycle = vi_state->num_cycles;
+		}
 		vi_trace_line_free(trace_line);
 
 		/* Show progress */
@@ -274,15 +457,16 @@ void vi_state_init(char *trace_file_name)
 		if (num_trace_lines % VI_STATE_PROGRESS_INTERVAL == 1)
 		{
 			printf("Uncompressing trace (%.1fMB, %lld cycles)   \r",
-				ftell(vi_state->unzipped_trace_file) / 1.048e6, vi_state->num_cycles);
+				ftell(vi_state->chunk_file) / 1.048e6, vi_state->num_cycles);
 			fflush(stdout);
 		}
 	}
 	vi_trace_free(trace_file);
+	vi_state->first_cycle = MAX(vi_state->first_cycle, 0);
 
 	/* Final progress */
 	printf("Uncompressing trace (%.1fMB, %lld cycles)   \n",
-		ftell(vi_state->unzipped_trace_file) / 1.048e6, vi_state->num_cycles);
+		ftell(vi_state->chunk_file) / 1.048e6, vi_state->num_cycles);
 	fflush(stdout);
 }
 
@@ -297,9 +481,19 @@ void vi_state_done(void)
 
 	int i;
 
-	/* Close and delete uncompressed trace file */
-	fclose(vi_state->unzipped_trace_file);
-	unlink(vi_state->unzipped_trace_file_name);
+	/* Close trace */
+	if (vi_state->trace)
+		vi_trace_free(vi_state->trace);
+
+	/* Close and delete chunk files */
+	for (i = 0; i < VI_STATE_CHUNK_CACHE_SIZE; i++)
+	{
+		if (!vi_state->chunk_file_cache[i].f)
+			continue;
+		fclose(vi_state->chunk_file_cache[i].f);
+		unlink(vi_state->chunk_file_cache[i].name);
+		free(vi_state->chunk_file_cache[i].name);
+	}
 
 	/* Close and detele checkpoint file */
 	fclose(vi_state->checkpoint_file);
@@ -335,7 +529,6 @@ void vi_state_done(void)
 		vi_trace_line_free(vi_state->body_trace_line);
 
 	/* Free */
-	free(vi_state->unzipped_trace_file_name);
 	free(vi_state->checkpoint_file_name);
 	free(vi_state);
 }
@@ -347,6 +540,12 @@ long long vi_state_get_num_cycles(void)
 }
 
 
+long long vi_state_get_first_cycle(void)
+{
+	return vi_state->first_cycle;
+}
+
+
 long long vi_state_get_current_cycle(void)
 {
 	return vi_state->cycle;
@@ -357,80 +556,32 @@ void vi_state_create_checkpoints(void)
 {
 	struct vi_trace_line_t *trace_line;
 
-	long long last_checkpoint_cycle;
-	long unzipped_trace_file_size;
-
-	int num_trace_lines;
-
-	/* Get unzipped trace file size */
-	fseek(vi_state->unzipped_trace_file, 0, SEEK_END);
-	unzipped_trace_file_size = ftell(vi_state->unzipped_trace_file);
+	long long cycle;
 
-	/* Initialize */
-	last_checkpoint_cycle = -VI_STATE_CHECKPOINT_INTERVAL;
-	fseek(vi_state->unzipped_trace_file, 0, SEEK_SET);
+	int chunk;
+	long int offset;
+	long int line_offset;
 
-	/* Parse uncompressed trace file */
-	num_trace_lines = 0;
-	vi_state->cycle = 0;
-	while ((trace_line = vi_trace_line_create_from_file(vi_state->unzipped_trace_file)))
+	/* Skip header. Checkpoints are created as the trace is processed in
+	 * 'vi_state_go_to_cycle', and the first one precedes the first cycle. */
+	chunk = 0;
+	offset = 0;
+	for (;;)
 	{
-		struct vi_state_checkpoint_t *checkpoint;
-		struct vi_state_command_t *state_command;
-
-		char *command;
-
-		/* Get command */
-		command = vi_trace_line_get_command(trace_line);
-
-		/* New cycle command */
-		if (!strcasecmp(command, "c"))
-		{
-			vi_state->cycle = atoll(vi_trace_line_get_symbol(trace_line, "clk"));
-			while (vi_state->cycle >= last_checkpoint_cycle + VI_STATE_CHECKPOINT_INTERVAL)
-			{
-				last_checkpoint_cycle += VI_STATE_CHECKPOINT_INTERVAL;
-				checkpoint = vi_state_checkpoint_create(last_checkpoint_cycle,
-					vi_trace_line_get_offset(trace_line),
-					ftell(vi_state->checkpoint_file));
-				list_add(vi_state->checkpoint_list, checkpoint);
-				vi_state_write_checkpoint();
-			}
-		}
-
-		/* Process trace line if it is not a header  */
-		else if (last_checkpoint_cycle >= 0)
-		{
-			state_command = hash_table_get(vi_state->command_table, command);
-			if (!state_command)
-				fatal("%s: unknown command '%s'", __FUNCTION__, command);
-			state_command->process_trace_line_func(state_command->user_data, trace_line);
-		}
-
-		/* Progress */
-		num_trace_lines++;
-		if (num_trace_lines % VI_STATE_PROGRESS_INTERVAL == 1)
-		{
-			printf("Creating checkpoints (%.1fMB, %.1f%%)   \r",
-				ftell(vi_state->checkpoint_file) / 1.048e6,
-				unzipped_trace_file_size ?
-				(double) ftell(vi_state->unzipped_trace_file) * 100.0 /
-				unzipped_trace_file_size : 0.0);
-			fflush(stdout);
-		}
-
-		/* Free trace line */
+		line_offset = offset;
+		trace_line = vi_state_read_trace_line(&chunk, &offset);
+		if (!trace_line)
+			fatal("empty trace");
+		if (!strcmp(vi_trace_line_get_command(trace_line), "c"))
+			break;
 		vi_trace_line_free(trace_line);
 	}
 
-	/* Progress */
-	printf("Creating checkpoints (%.1fMB, 100%%)   \n",
-		ftell(vi_state->checkpoint_file) / 1.048e6);
-	fflush(stdout);
-
-	/* No checkpoint created - assume trace file empty */
-	if (!list_count(vi_state->checkpoint_list))
-		fatal("empty trace");
+	/* First checkpoint */
+	cycle = vi_trace_line_get_symbol_long_long(trace_line, "clk");
+	vi_trace_line_free(trace_line);
+	vi_state_write_checkpoint(cycle - cycle % VI_STATE_CHECKPOINT_INTERVAL,
+		chunk, line_offset);
 
 	/* Load first checkpoint */
 	vi_state_read_checkpoint(0);
@@ -484,9 +635,10 @@ struct vi_trace_line_t *vi_state_header_next(void)
 	if (vi_state->header_trace_line_offset < 0)
 		return NULL;
 
-	/* Read trace line */
-	fseek(vi_state->unzipped_trace_file, vi_state->header_trace_line_offset, SEEK_SET);
-	trace_line = vi_trace_line_create_from_file(vi_state->unzipped_trace_file);
+	/* Read trace line. All header lines are in the first chunk. */
+	vi_state_load_chunk(0);
+	fseek(vi_state->chunk_file, vi_state->header_trace_line_offset, SEEK_SET);
+	trace_line = vi_trace_line_create_from_file(vi_state->chunk_file);
 	if (!trace_line)
 	{
 		vi_state->header_trace_line_offset = -1;
@@ -503,15 +655,13 @@ struct vi_trace_line_t *vi_state_header_next(void)
 
 	/* Save trace line and return */
 	vi_state->header_trace_line = trace_line;
-	vi_state->header_trace_line_offset = ftell(vi_state->unzipped_trace_file);
+	vi_state->header_trace_line_offset = ftell(vi_state->chunk_file);
 	return trace_line;
 }
 
 
 struct vi_trace_line_t *vi_state_trace_line_first(long long cycle)
 {
-	long int trace_file_offset;
-
 	int checkpoint_index;
 
 	long long checkpoint_cycle;
@@ -529,25 +679,23 @@ struct vi_trace_line_t *vi_state_trace_line_first(long long cycle)
 	if (cycle > vi_state->num_cycles)
 		return NULL;
 
-	/* Store current position in trace file */
-	trace_file_offset = ftell(vi_state->unzipped_trace_file);
-
 	/* Get closest checkpoint */
-	checkpoint_index = cycle / VI_STATE_CHECKPOINT_INTERVAL;
-	checkpoint_cycle = (long long) checkpoint_index * VI_STATE_CHECKPOINT_INTERVAL;
+	checkpoint_index = vi_state_find_checkpoint(cycle);
 	checkpoint = list_get(vi_state->checkpoint_list, checkpoint_index);
 	if (!checkpoint)
 		panic("%s: invalid checkpoint index", __FUNCTION__);
+	checkpoint_cycle = checkpoint->cycle;
 
-	/* Set position in trace file */
-	fseek(vi_state->unzipped_trace_file, checkpoint->unzipped_trace_file_offset, SEEK_SET);
-	vi_state->body_trace_line_offset = checkpoint->unzipped_trace_file_offset;
+	/* Set position in trace */
+	vi_state->body_trace_line_chunk = checkpoint->chunk;
+	vi_state->body_trace_line_offset = checkpoint->chunk_offset;
 	for (;;)
 	{
 		/* Read trace line */
-		vi_state->body_trace_line = vi_trace_line_create_from_file(vi_state->unzipped_trace_file);
-		vi_state->body_trace_line_offset = checkpoint->unzipped_trace_file_offset;
-		if (!vi_state->body_trace_line || checkpoint_cycle == cycle)
+		vi_state->body_trace_line = vi_state_read_trace_line(
+			&vi_state->body_trace_line_chunk,
+			&vi_state->body_trace_line_offset);
+		if (!vi_state->body_trace_line || checkpoint_cycle >= cycle)
 			break;
 
 		/* Check if target cycle is exceeded */
@@ -560,19 +708,13 @@ struct vi_trace_line_t *vi_state_trace_line_first(long long cycle)
 		vi_state->body_trace_line = NULL;
 	}
 
-	/* Return to original position in trace file */
-	fseek(vi_state->unzipped_trace_file, trace_file_offset, SEEK_SET);
+	/* Return */
 	return vi_state->body_trace_line;
 }
 
 
 struct vi_trace_line_t *vi_state_trace_line_next(void)
 {
-	long long trace_file_offset;
-
-	/* Store current position in trace file */
-	trace_file_offset = ftell(vi_state->unzipped_trace_file);
-
 	/* Release previous body trace line if any */
 	if (vi_state->body_trace_line)
 	{
@@ -581,18 +723,17 @@ struct vi_trace_line_t *vi_state_trace_line_next(void)
 	}
 
 	/* Get next trace line */
-	fseek(vi_state->unzipped_trace_file, vi_state->body_trace_line_offset, SEEK_SET);
-	vi_state->body_trace_line = vi_trace_line_create_from_file(vi_state->unzipped_trace_file);
-	vi_state->body_trace_line_offset = ftell(vi_state->unzipped_trace_file);
-
-	/* Return to original position in trace file */
-	fseek(vi_state->unzipped_trace_file, trace_file_offset, SEEK_SET);
+	vi_state->body_trace_line = vi_state_read_trace_line(
+		&vi_state->body_trace_line_chunk,
+		&vi_state->body_trace_line_offset);
 	return vi_state->body_trace_line;
 }
 
 
 void vi_state_go_to_cycle(long long cycle)
 {
+	struct vi_state_checkpoint_t *checkpoint;
+
 	long long checkpoint_cycle;
 	int checkpoint_index;
 
@@ -601,8 +742,9 @@ void vi_state_go_to_cycle(long long cycle)
 		return;
 
 	/* Load a checkpoint */
-	checkpoint_index = cycle / VI_STATE_CHECKPOINT_INTERVAL;
-	checkpoint_cycle = (long long) checkpoint_index * VI_STATE_CHECKPOINT_INTERVAL;
+	checkpoint_index = vi_state_find_checkpoint(cycle);
+	checkpoint = list_get(vi_state->checkpoint_list, checkpoint_index);
+	checkpoint_cycle = checkpoint->cycle;
 	if (cycle < vi_state->cycle || checkpoint_cycle > vi_state->cycle)
 		vi_state_read_checkpoint(checkpoint_index);
 
@@ -611,12 +753,15 @@ void vi_state_go_to_cycle(long long cycle)
 	{
 		struct vi_trace_line_t *trace_line;
 		struct vi_state_command_t *state_command;
-		long int unzipped_trace_file_pos;
+		long int chunk_offset;
+		int chunk;
 		char *command;
 
 		/* Read a trace line */
-		unzipped_trace_file_pos = ftell(vi_state->unzipped_trace_file);
-		trace_line = vi_trace_line_create_from_file(vi_state->unzipped_trace_file);
+		chunk = vi_state->chunk;
+		chunk_offset = vi_state->chunk_offset;
+		trace_line = vi_state_read_trace_line(&vi_state->chunk,
+			&vi_state->chunk_offset);
 		if (!trace_line)
 			break;
 
@@ -629,10 +774,21 @@ void vi_state_go_to_cycle(long long cycle)
 			/* Get new cycle number */
 			new_cycle = vi_trace_line_get_symbol_long_long(trace_line, "clk");
 
+			/* Checkpoint the state the first time the trace is
+			 * processed this far. Cycles without trace lines, such
+			 * as those outside of trace windows, share one
+			 * checkpoint. */
+			checkpoint = list_get(vi_state->checkpoint_list,
+				list_count(vi_state->checkpoint_list) - 1);
+			if (new_cycle >= checkpoint->cycle + VI_STATE_CHECKPOINT_INTERVAL)
+				vi_state_write_checkpoint(new_cycle - new_cycle %
+					VI_STATE_CHECKPOINT_INTERVAL, chunk, chunk_offset);
+
 			/* If we passed the target cycle, done */
 			if (new_cycle > cycle)
 			{
-				fseek(vi_state->unzipped_trace_file, unzipped_trace_file_pos, SEEK_SET);
+				vi_state->chunk = chunk;
+				vi_state->chunk_offset = chunk_offset;
 				vi_trace_line_free(trace_line);
 				break;
 			}
@@ -34,6 +34,7 @@ typedef void (*vi_state_process_trace_line_func_t)(void *user_data, struct vi_tr
 void vi_state_init(char *trace_file_name);
 void vi_state_done(void);
 
+long long vi_state_get_first_cycle(void);
 long long vi_state_get_num_cycles(void);
 long long vi_state_get_current_cycle(void);
 
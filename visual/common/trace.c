@@ -19,8 +19,8 @@
 
 #include <ctype.h>
 #include <gtk/gtk.h>
-#include <zlib.h>
 
+#include <lib/esim/trace.h>
 #include <lib/mhandle/mhandle.h>
 #include <lib/util/debug.h>
 #include <lib/util/hash-table.h>
@@ -33,7 +33,7 @@
 struct vi_trace_t
 {
 	char *name;
-	gzFile f;
+	struct trace_reader_t *reader;
 
 	/* Last line number read from zip file with a call to
 	 * 'vi_trace_line_create_from_trace'. */
@@ -150,8 +150,8 @@ struct vi_trace_line_t *vi_trace_line_create_from_trace(struct vi_trace_t *trace
 	char *buf_ptr;
 
 	/* Read line from trace file */
-	offset = gztell(trace->f);
-	buf_ptr = gzgets(trace->f, buf, sizeof buf);
+	offset = trace_reader_tell(trace->reader);
+	buf_ptr = trace_reader_gets(trace->reader, buf, sizeof buf);
 
 	/* Empty line */
 	if (!buf_ptr)
@@ -367,9 +367,7 @@ struct vi_trace_t *vi_trace_create(char *file_name)
 	trace->name = xstrdup(file_name);
 
 	/* Open */
-	trace->f = gzopen(file_name, "r");
-	if (!trace->f)
-		fatal("%s: cannot open trace file or invalid format", file_name);
+	trace->reader = trace_reader_create(file_name);
 
 	/* Return */
 	return trace;
@@ -378,8 +376,38 @@ struct vi_trace_t *vi_trace_create(char *file_name)
 
 void vi_trace_free(struct vi_trace_t *trace)
 {
-	gzclose(trace->f);
+	trace_reader_free(trace->reader);
 	free(trace->name);
 	free(trace);
 }
 
+
+int vi_trace_get_num_chunks(struct vi_trace_t *trace)
+{
+	return trace_reader_get_num_chunks(trace->reader);
+}
+
+
+long long vi_trace_get_chunk_cycle(struct vi_trace_t *trace, int chunk)
+{
+	return trace_reader_get_chunk_cycle(trace->reader, chunk);
+}
+
+
+long long vi_trace_get_last_cycle(struct vi_trace_t *trace)
+{
+	return trace_reader_get_last_cycle(trace->reader);
+}
+
+
+void vi_trace_seek_chunk(struct vi_trace_t *trace, int chunk)
+{
+	trace_reader_seek_chunk(trace->reader, chunk);
+}
+
+
+int vi_trace_get_chunk(struct vi_trace_t *trace)
+{
+	return trace_reader_get_chunk(trace->reader);
+}
+
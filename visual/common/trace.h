@@ -28,6 +28,14 @@ struct vi_trace_t;
 struct vi_trace_t *vi_trace_create(char *file_name);
 void vi_trace_free(struct vi_trace_t *trace);
 
+/* Chunks of an indexed trace. The number of chunks is 0 if the trace has no
+ * index, and it must then be read sequentially. */
+int vi_trace_get_num_chunks(struct vi_trace_t *trace);
+long long vi_trace_get_chunk_cycle(struct vi_trace_t *trace, int chunk);
+long long vi_trace_get_last_cycle(struct vi_trace_t *trace);
+void vi_trace_seek_chunk(struct vi_trace_t *trace, int chunk);
+int vi_trace_get_chunk(struct vi_trace_t *trace);
+
 
 struct vi_trace_line_t;
 
@@ -117,7 +117,7 @@ static void vi_evg_gpu_unmap_work_group(struct vi_evg_gpu_t *gpu,
 	snprintf(work_group_name, sizeof work_group_name, "wg-%d", work_group_id);
 	work_group = hash_table_remove(compute_unit->work_group_table, work_group_name);
 	if (!work_group)
-		panic("%s: invalid work-group", __FUNCTION__);
+		return;
 	vi_evg_work_group_free(work_group);
 }
 
@@ -221,7 +221,7 @@ static void vi_evg_gpu_inst(struct vi_evg_gpu_t *gpu, struct vi_trace_line_t *tr
 	snprintf(inst_name, sizeof inst_name, "i-%lld", inst_id);
 	inst = hash_table_get(compute_unit->inst_table, inst_name);
 	if (!inst)
-		panic("%s: invalid instruction", __FUNCTION__);
+		return;
 
 	/* Update stage */
 	inst->stage = stage;
@@ -256,7 +256,7 @@ static void vi_evg_gpu_end_inst(struct vi_evg_gpu_t *gpu, struct vi_trace_line_t
 	snprintf(inst_name, sizeof inst_name, "i-%lld", inst_id);
 	inst = hash_table_remove(compute_unit->inst_table, inst_name);
 	if (!inst)
-		panic("%s: invalid instruction", __FUNCTION__);
+		return;
 	vi_evg_inst_free(inst);
 }
 
@@ -217,10 +217,10 @@ static void vi_mem_system_end_access(struct vi_mem_system_t *system,
 	/* Read fields */
 	name = vi_trace_line_get_symbol(trace_line, "name");
 
-	/* Find access */
+	/* Find access. It may have started outside of a trace window. */
 	access = hash_table_remove(vi_mem_system->access_table, name);
 	if (!access)
-		panic("%s: access not found", __FUNCTION__);
+		return;
 
 	/* Free access */
 	vi_mod_access_free(access);
@@ -292,11 +292,11 @@ static void vi_mem_system_end_access_block(struct vi_mem_system_t *system,
 	if (!mod)
 		panic("%s: %s: invalid module", __FUNCTION__, mod_name);
 
-	/* Find access in module */
+	/* Find access in module. It may have started outside of a trace
+	 * window. */
 	access = hash_table_get(mod->access_table, access_name);
 	if (!access)
-		panic("%s: module %s: access %s: invalid access",
-			__FUNCTION__, mod_name, access_name);
+		return;
 
 	/* If access has more than one reference, just decrease it.
 	 * Otherwise, remove it. */
@@ -331,10 +331,10 @@ static void vi_mem_system_access(struct vi_mem_system_t *system,
 	name = vi_trace_line_get_symbol(trace_line, "name");
 	state = vi_trace_line_get_symbol(trace_line, "state");
 
-	/* Find access */
+	/* Find access. It may have started outside of a trace window. */
 	access = hash_table_get(vi_mem_system->access_table, name);
 	if (!access)
-		panic("%s: %s: access not found", __FUNCTION__, name);
+		return;
 
 	/* Update access */
 	vi_mod_access_set_state(access, state);
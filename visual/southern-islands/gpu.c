@@ -117,7 +117,7 @@ static void vi_si_gpu_unmap_work_group(struct vi_si_gpu_t *gpu,
 	snprintf(work_group_name, sizeof work_group_name, "wg-%d", work_group_id);
 	work_group = hash_table_remove(compute_unit->work_group_table, work_group_name);
 	if (!work_group)
-		panic("%s: invalid work-group", __FUNCTION__);
+		return;
 	vi_si_work_group_free(work_group);
 }
 
@@ -206,10 +206,7 @@ static void vi_si_gpu_inst(struct vi_si_gpu_t *gpu, struct vi_trace_line_t *trac
 	snprintf(inst_name, sizeof inst_name, "i-%lld", inst_id);
 	inst = hash_table_get(compute_unit->inst_table, inst_name);
 	if (!inst)
-	{
-		printf("cu = %d, inst name = %s\n", compute_unit_id, inst_name);
-		panic("%s: invalid instruction", __FUNCTION__);
-	}
+		return;
 
 	/* Update stage */
 	inst->stage = stage;
@@ -244,7 +241,7 @@ static void vi_si_gpu_end_inst(struct vi_si_gpu_t *gpu, struct vi_trace_line_t *
 	snprintf(inst_name, sizeof inst_name, "i-%lld", inst_id);
 	inst = hash_table_remove(compute_unit->inst_table, inst_name);
 	if (!inst)
-		panic("%s: invalid instruction", __FUNCTION__);
+		return;
 	vi_si_inst_free(inst);
 }
 
@@ -82,9 +82,9 @@ static void vi_x86_cpu_map_context(struct vi_x86_cpu_t *cpu,
 	if (!core)
 		panic("%s: invalid core", __FUNCTION__);
 
-	/* Add to core */
-	if (!hash_table_insert(core->context_table, context_name, VI_X86_CONTEXT_EMPTY))
-		panic("%s: invalid context", __FUNCTION__);
+	/* Add to core. The context may already be there if it was unmapped
+	 * outside of a trace window. */
+	hash_table_insert(core->context_table, context_name, VI_X86_CONTEXT_EMPTY);
 }
 
 
@@ -115,16 +115,14 @@ static void vi_x86_cpu_unmap_context(struct vi_x86_cpu_t *cpu,
 	if (!core)
 		panic("%s: invalid core", __FUNCTION__);
 
-	/* Get context */
+	/* Get context. It may have been mapped outside of a trace window. */
 	snprintf(context_name, sizeof context_name, "ctx-%d", context_id);
 	context = hash_table_get(vi_x86_cpu->context_table, context_name);
 	if (!context || context->core_id != core_id || context->thread_id != thread_id)
-		panic("%s: invalid context", __FUNCTION__);
+		return;
 
 	/* Remove from core */
-	if (!hash_table_remove(core->context_table, context_name))
-		panic("%s: invalid context", __FUNCTION__);
-
+	hash_table_remove(core->context_table, context_name);
 }
 
 
@@ -143,11 +141,12 @@ static void vi_x86_cpu_end_context(struct vi_x86_cpu_t *cpu,
 	/* Get fields */
 	context_id = vi_trace_line_get_symbol_int(trace_line, "ctx");
 
-	/* Remove and free context */
+	/* Remove and free context. It may have been mapped outside of a trace
+	 * window. */
 	snprintf(context_name, sizeof context_name, "ctx-%d", context_id);
 	context = hash_table_remove(vi_x86_cpu->context_table, context_name);
 	if (!context)
-		panic("%s: invalid context", __FUNCTION__);
+		return;
 	vi_x86_context_free(context);
 }
 
@@ -231,11 +230,12 @@ static void vi_x86_cpu_inst(struct vi_x86_cpu_t *cpu,
 	if (!core)
 		panic("%s: invalid core", __FUNCTION__);
 
-	/* Get instruction */
+	/* Get instruction. It may have been created outside of a trace
+	 * window. */
 	snprintf(name, sizeof name, "i-%lld", id);
 	inst = hash_table_get(core->inst_table, name);
 	if (!inst)
-		panic("%s: invalid instruction - %s", __FUNCTION__, name);
+		return;
 
 	/* Update stage */
 	inst->stage = stage;
@@ -267,11 +267,12 @@ static void vi_x86_cpu_end_inst(struct vi_x86_cpu_t *cpu,
 	if (!core)
 		panic("%s: invalid core", __FUNCTION__);
 
-	/* Free instruction */
+	/* Free instruction. It may have been created outside of a trace
+	 * window. */
 	snprintf(name, sizeof name, "i-%lld", id);
 	inst = hash_table_remove(core->inst_table, name);
 	if (!inst)
-		panic("%s: invalid instruction - %s", __FUNCTION__, name);
+		return;
 	vi_x86_inst_free(inst);
 }
 